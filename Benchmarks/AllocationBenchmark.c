@@ -0,0 +1,174 @@
+
+//
+// Compares the runtime's allocators (Runtime/AddaatRuntime.h) against malloc() and free(), on the
+// allocation patterns generated code has:
+//   churn:        random sizes (16 to 256 bytes) deleted in random order, a window of them live.
+//   binary-trees: trees built and dropped whole, freed node by node, or left to the collector.
+//
+// Usage: AllocationBenchmark [scale]
+//
+// Stand-alone (plain C), built with the runtime.
+//
+// The 18th of October, 2026.
+//
+
+#include <AddaatRuntime.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CHURN_WINDOW 8192
+#define CHURN_OPERATIONS 20000000
+#define TREE_DEPTH 16
+#define TREES_COUNT 200
+
+struct TreeNode {
+    struct TreeNode *left, *right;
+    int64_t value;
+};
+
+// xorshift64*, so that both sides see the same sizes,
+static uint64_t randomState;
+
+static uint32_t nextRandom() {
+    uint64_t x = randomState;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    randomState = x;
+    return (uint32_t) ((x * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+static double getSeconds() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Churn
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void* mallocAllocate(size_t size) { return malloc(size); }
+static void  mallocRelease(void* object) { free(object); }
+static void* newAllocate(size_t size) { return addaatNew(size, 1); }
+static void  newRelease(void* object) { addaatDelete(object); }
+
+static double runChurn(int64_t operationsCount, void* (*allocate)(size_t), void (*release)(void*)) {
+
+    static char* objects[CHURN_WINDOW];
+    randomState = 1;
+    int64_t checksum = 0;
+
+    double startTime = getSeconds();
+    for (int64_t i=0; i<operationsCount; i++) {
+        uint32_t random = nextRandom();
+        char** object = &objects[random % CHURN_WINDOW];
+        if (*object) {
+            checksum += (*object)[0];
+            release(*object);
+        }
+        *object = allocate(16 + (random >> 16) % 241);
+        (*object)[0] = (char) i;
+    }
+    for (int32_t i=0; i<CHURN_WINDOW; i++) {
+        if (objects[i]) release(objects[i]);
+        objects[i] = 0;
+    }
+    double seconds = getSeconds() - startTime;
+
+    if (checksum == 1) printf(" "); // Keeps the loop from being optimized out.
+    return seconds;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Binary trees
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static struct TreeNode* buildMallocTree(int32_t depth) {
+    struct TreeNode* node = malloc(sizeof(struct TreeNode));
+    node->value = depth;
+    node->left  = depth ? buildMallocTree(depth-1) : 0;
+    node->right = depth ? buildMallocTree(depth-1) : 0;
+    return node;
+}
+
+static void freeMallocTree(struct TreeNode* node) {
+    if (!node) return;
+    freeMallocTree(node->left);
+    freeMallocTree(node->right);
+    free(node);
+}
+
+static struct TreeNode* buildManagedTree(int32_t depth) {
+    struct TreeNode* node = addaatManaged(sizeof(struct TreeNode), 1);
+    node->value = depth;
+    if (depth) {
+        node->left  = buildManagedTree(depth-1);
+        node->right = buildManagedTree(depth-1);
+    }
+    return node;
+}
+
+static int64_t sumTree(struct TreeNode* node) {
+    return node ? node->value + sumTree(node->left) + sumTree(node->right) : 0;
+}
+
+static double runMallocTrees(int32_t treesCount) {
+    int64_t checksum = 0;
+    double startTime = getSeconds();
+    struct TreeNode* longLived = buildMallocTree(TREE_DEPTH);
+    for (int32_t i=0; i<treesCount; i++) {
+        struct TreeNode* tree = buildMallocTree(TREE_DEPTH);
+        checksum += sumTree(tree);
+        freeMallocTree(tree);
+    }
+    checksum += sumTree(longLived);
+    freeMallocTree(longLived);
+    double seconds = getSeconds() - startTime;
+    if (checksum == 1) printf(" ");
+    return seconds;
+}
+
+static double runManagedTrees(int32_t treesCount) {
+    int64_t checksum = 0;
+    double startTime = getSeconds();
+    struct TreeNode* longLived = buildManagedTree(TREE_DEPTH);
+    for (int32_t i=0; i<treesCount; i++) checksum += sumTree(buildManagedTree(TREE_DEPTH));
+    checksum += sumTree(longLived);
+    double seconds = getSeconds() - startTime;
+    if (checksum == 1) printf(" ");
+    return seconds;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Main
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void report(const char* name, double baselineSeconds, double seconds) {
+    printf("%-13s malloc/free: %7.3fs   runtime: %7.3fs   (%.2fx)\n", name, baselineSeconds, seconds, baselineSeconds / seconds);
+}
+
+int main(int argumentsCount, char** arguments) {
+
+    double scale = (argumentsCount > 1) ? atof(arguments[1]) : 1.0;
+    if (scale <= 0) {
+        fprintf(stderr, "Usage: %s [scale]\n", arguments[0]);
+        return 1;
+    }
+
+    int64_t operationsCount = (int64_t) (CHURN_OPERATIONS * scale);
+    double mallocSeconds = runChurn(operationsCount, mallocAllocate, mallocRelease);
+    double newSeconds = runChurn(operationsCount, newAllocate, newRelease);
+    report("churn", mallocSeconds, newSeconds);
+
+    int32_t treesCount = (int32_t) (TREES_COUNT * scale);
+    if (treesCount < 1) treesCount = 1;
+    mallocSeconds = runMallocTrees(treesCount);
+    double managedSeconds = runManagedTrees(treesCount);
+    report("binary-trees", mallocSeconds, managedSeconds);
+
+    return 0;
+}
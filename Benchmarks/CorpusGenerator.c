@@ -0,0 +1,272 @@
+
+//
+// Generates synthetic Addaat code for benchmarking. The same kind, size and seed always produce
+// the same file.
+//
+// Usage: CorpusGenerator <kind> <size in bytes> <seed> <output file>
+// Kinds: deep-expressions, long-statement-lists, many-globals, big-classes, long-strings,
+//        heavy-comments, deep-nesting, mixed.
+//
+// Stand-alone (plain C and stdio), so it builds without NOMone.
+//
+// The 18th of October, 2026.
+//
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EXPRESSION_DEPTH 48
+#define NESTING_DEPTH 40
+#define STATEMENTS_PER_FUNCTION 2000
+#define FIELDS_PER_CLASS 400
+#define STRING_LITERAL_LENGTH 4096
+
+struct Generator {
+    FILE* file;
+    int64_t writtenBytes, targetSize;
+    uint64_t randomState;
+    int32_t unitsCount;     // Keeps every top-level name unique.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper functions
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// xorshift64*, deterministic across platforms,
+static uint32_t nextRandom(struct Generator* generator) {
+    uint64_t x = generator->randomState;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    generator->randomState = x;
+    return (uint32_t) ((x * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+static int32_t randomBelow(struct Generator* generator, int32_t limit) {
+    return (int32_t) (nextRandom(generator) % (uint32_t) limit);
+}
+
+static void emit(struct Generator* generator, const char* text) {
+    size_t length = strlen(text);
+    fwrite(text, 1, length, generator->file);
+    generator->writtenBytes += length;
+}
+
+static void emitFormatted(struct Generator* generator, const char* format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    int written = vfprintf(generator->file, format, arguments);
+    va_end(arguments);
+    if (written > 0) generator->writtenBytes += written;
+}
+
+// Inner loops stop early once the target size is reached, so small files don't overshoot much.
+// Units are always closed, so the file still translates,
+static int32_t isFull(struct Generator* generator) {
+    return generator->writtenBytes >= generator->targetSize;
+}
+
+static void emitIndentation(struct Generator* generator, int32_t depth) {
+    for (int32_t i=0; i<depth; i++) emit(generator, "    ");
+}
+
+static const char* binaryOperators[] = { "+", "-", "*", "/", "<<", ">>", "<", ">", "<=", ">=", "==", "!=", "&", "^", "|", "&&", "||" };
+
+static void emitOperand(struct Generator* generator) {
+    switch (randomBelow(generator, 4)) {
+        case 0: emit(generator, "a"); break;
+        case 1: emit(generator, "b"); break;
+        case 2: emitFormatted(generator, "%d", randomBelow(generator, 1000)); break;
+        default: emitFormatted(generator, "c[%d]", randomBelow(generator, 16)); break;
+    }
+}
+
+// Nests on either side, so both left and right heavy trees show up,
+static void emitExpression(struct Generator* generator, int32_t depth) {
+    if (!depth) {
+        emitOperand(generator);
+        return;
+    }
+    const char* operator = binaryOperators[randomBelow(generator, sizeof(binaryOperators) / sizeof(binaryOperators[0]))];
+    emit(generator, "(");
+    if (randomBelow(generator, 2)) {
+        emitExpression(generator, depth-1);
+        emitFormatted(generator, " %s ", operator);
+        emitOperand(generator);
+    } else {
+        emitOperand(generator);
+        emitFormatted(generator, " %s ", operator);
+        emitExpression(generator, depth-1);
+    }
+    emit(generator, ")");
+}
+
+static void emitFunctionBegin(struct Generator* generator, const char* kind) {
+    emitFormatted(generator, "void %s%d(int a, int b) {\n    int[] c;\n    int d, e;\n", kind, generator->unitsCount);
+}
+
+static void emitSimpleStatement(struct Generator* generator, int32_t depth) {
+    emitIndentation(generator, depth);
+    switch (randomBelow(generator, 6)) {
+        case 0: emit(generator, "d = a + b * 3;\n"); break;
+        case 1: emit(generator, "e += d - 1;\n"); break;
+        case 2: emit(generator, "c[d] = e;\n"); break;
+        case 3: emitFormatted(generator, "printf(\"%%d\\n\", d + %d);\n", randomBelow(generator, 100)); break;
+        case 4: emit(generator, "d++;\n"); break;
+        default: emit(generator, "if (a < b) e = a; else e = b;\n"); break;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Units (each is one or more complete external declarations)
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void emitDeepExpressions(struct Generator* generator) {
+    emitFunctionBegin(generator, "deepExpressions");
+    for (int32_t i=0; (i<4) && !isFull(generator); i++) {
+        emit(generator, "    d = ");
+        emitExpression(generator, EXPRESSION_DEPTH);
+        emit(generator, ";\n");
+    }
+    emit(generator, "}\n\n");
+}
+
+static void emitLongStatementList(struct Generator* generator) {
+    emitFunctionBegin(generator, "longStatementList");
+    for (int32_t i=0; (i<STATEMENTS_PER_FUNCTION) && !isFull(generator); i++) emitSimpleStatement(generator, 1);
+    emit(generator, "}\n\n");
+}
+
+static void emitManyGlobals(struct Generator* generator) {
+    static const char* types[] = { "int", "char", "short", "long", "float", "double", "int[]", "double[][]" };
+    for (int32_t i=0; (i<64) && !isFull(generator); i++) {
+        const char* type = types[randomBelow(generator, sizeof(types) / sizeof(types[0]))];
+        if (randomBelow(generator, 2)) {
+            emitFormatted(generator, "%s global%d_%d;\n", type, generator->unitsCount, i);
+        } else {
+            emitFormatted(generator, "static %s global%d_%d, other%d_%d;\n", type, generator->unitsCount, i, generator->unitsCount, i);
+        }
+    }
+    emit(generator, "\n");
+}
+
+static void emitBigClass(struct Generator* generator) {
+    static const char* types[] = { "int", "float", "double", "char", "int[]", "float[][]" };
+    emitFormatted(generator, "class BigClass%d {\n", generator->unitsCount);
+    for (int32_t i=0; (i<FIELDS_PER_CLASS) && !isFull(generator); i++) {
+        const char* type = types[randomBelow(generator, sizeof(types) / sizeof(types[0]))];
+        emitFormatted(generator, "    %s%s field%d;\n", randomBelow(generator, 8) ? "" : "static ", type, i);
+    }
+    emit(generator, "}\n\n");
+}
+
+static void emitLongStrings(struct Generator* generator) {
+    static const char* escapes[] = { "\\n", "\\t", "\\\"", "\\\\", "\\x41" };
+    emitFunctionBegin(generator, "longStrings");
+    for (int32_t i=0; (i<4) && !isFull(generator); i++) {
+        emit(generator, "    printf(\"");
+        for (int32_t j=0; (j<STRING_LITERAL_LENGTH) && ((j<64) || !isFull(generator)); j++) {
+            int32_t choice = randomBelow(generator, 40);
+            if (choice == 0) {
+                emit(generator, escapes[randomBelow(generator, sizeof(escapes) / sizeof(escapes[0]))]);
+            } else {
+                char character[2] = { (char) ((choice < 27) ? 'a' + choice - 1 : ' '), 0 };
+                emit(generator, character);
+            }
+        }
+        emit(generator, "\" \"concatenated\");\n");
+    }
+    emit(generator, "}\n\n");
+}
+
+static void emitHeavyComments(struct Generator* generator) {
+    emit(generator, "/*\n");
+    for (int32_t i=0; (i<32) && !isFull(generator); i++) emitFormatted(generator, " * Block comment line %d, describing nothing in particular { } ; \" ' //\n", i);
+    emit(generator, " */\n");
+    for (int32_t i=0; (i<16) && !isFull(generator); i++) emitFormatted(generator, "// Line comment %d with code-like text: int x; void f() { }\n", i);
+    emitFormatted(generator, "int commented%d; // Trailing comment.\n", generator->unitsCount);
+    emitFormatted(generator, "void commentedFunction%d() { /* inline */ int a; // Trailing.\n    a = 1; /* more */ }\n\n", generator->unitsCount);
+}
+
+static void emitDeepNesting(struct Generator* generator) {
+    emitFunctionBegin(generator, "deepNesting");
+    for (int32_t depth=1; depth<=NESTING_DEPTH; depth++) {
+        emitIndentation(generator, depth);
+        switch (randomBelow(generator, 4)) {
+            case 0: emit(generator, "if (a < b) {\n"); break;
+            case 1: emit(generator, "while (a > b) {\n"); break;
+            case 2: emit(generator, "for (d=0; d<a; d++) {\n"); break;
+            default: emit(generator, "{\n"); break;
+        }
+        if (!isFull(generator)) emitSimpleStatement(generator, depth+1);
+    }
+    for (int32_t depth=NESTING_DEPTH; depth>=1; depth--) {
+        emitIndentation(generator, depth);
+        emit(generator, "}\n");
+    }
+    emit(generator, "}\n\n");
+}
+
+typedef void (*UnitEmitter)(struct Generator*);
+
+static const struct Kind {
+    const char* name;
+    UnitEmitter emitter;
+} kinds[] = {
+    { "deep-expressions"    , emitDeepExpressions   },
+    { "long-statement-lists", emitLongStatementList },
+    { "many-globals"        , emitManyGlobals       },
+    { "big-classes"         , emitBigClass          },
+    { "long-strings"        , emitLongStrings       },
+    { "heavy-comments"      , emitHeavyComments     },
+    { "deep-nesting"        , emitDeepNesting       },
+    { "mixed"               , 0                     }
+};
+#define KINDS_COUNT ((int32_t) (sizeof(kinds) / sizeof(kinds[0])))
+
+int main(int argumentsCount, char** arguments) {
+
+    if (argumentsCount != 5) {
+        fprintf(stderr, "Usage: %s <kind> <size in bytes> <seed> <output file>\nKinds:", arguments[0]);
+        for (int32_t i=0; i<KINDS_COUNT; i++) fprintf(stderr, " %s", kinds[i].name);
+        fprintf(stderr, "\n");
+        return EXIT_FAILURE;
+    }
+
+    int32_t kindIndex;
+    for (kindIndex=0; kindIndex<KINDS_COUNT; kindIndex++) {
+        if (!strcmp(kinds[kindIndex].name, arguments[1])) break;
+    }
+    int64_t size = strtoll(arguments[2], 0, 10);
+    if ((kindIndex == KINDS_COUNT) || (size <= 0)) {
+        fprintf(stderr, "Unknown kind or invalid size.\n");
+        return EXIT_FAILURE;
+    }
+
+    struct Generator generator;
+    generator.file = fopen(arguments[4], "wb");
+    if (!generator.file) {
+        fprintf(stderr, "Couldn't open: %s\n", arguments[4]);
+        return EXIT_FAILURE;
+    }
+    generator.writtenBytes = 0;
+    generator.targetSize = size;
+    generator.randomState = strtoull(arguments[3], 0, 10) * 0x9e3779b97f4a7c15ull + 1;
+    generator.unitsCount = 0;
+
+    // Whole units only, so the file always translates. It stops at the first unit that reaches the
+    // size (at least one unit is written),
+    emitFormatted(&generator, "// %s, %lld bytes, seed %s.\n\n", kinds[kindIndex].name, (long long) size, arguments[3]);
+    while (generator.writtenBytes < size) {
+        UnitEmitter emitter = kinds[kindIndex].emitter;
+        if (!emitter) emitter = kinds[randomBelow(&generator, KINDS_COUNT-1)].emitter;
+        emitter(&generator);
+        generator.unitsCount++;
+    }
+
+    fclose(generator.file);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,702 @@
+
+//
+// Addaat runtime (see AddaatRuntime.h). Every object starts with a 16 byte header.
+//
+// New objects come from size-class pools: a free list per class, refilled a slab at a time. Deleting
+// pushes the object back onto its class's list, so a steady state of allocations and deletions
+// never reaches malloc().
+//
+// Managed objects are bump allocated in 64KB aligned regions, divided into 256 byte lines (as in
+// Immix). A collection marks what's reachable, then frees whole lines: the unmarked lines of every
+// region are bump allocated through again, so a region with any dead space gets reused. Nothing
+// moves, so pointers can be found conservatively, and the object any pointer points into is found
+// through its region's object start bits. Objects too big for regions are allocated on their own.
+//
+// Stand-alone (plain C), so that it builds with the generated code. Linux (and Android) only, for
+// finding the stack and the global variables.
+//
+// The 18th of October, 2026.
+//
+
+#define _GNU_SOURCE
+
+#include <AddaatRuntime.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <link.h>
+#include <pthread.h>
+
+#define GRANULE_SIZE 16
+#define REGION_SIZE (64*1024)
+#define LINE_SIZE 256
+#define GRANULES_PER_REGION (REGION_SIZE / GRANULE_SIZE)
+#define LINES_PER_REGION (REGION_SIZE / LINE_SIZE)
+#define LARGE_MANAGED_OBJECT_SIZE (8*1024) // Including the header.
+#define MINIMUM_COLLECTION_THRESHOLD (16*1024*1024)
+
+#define SLAB_SIZE (64*1024)
+#define SMALL_SIZE_CLASSES_COUNT 64 // Up to 1KB, in 16 byte steps.
+#define SIZE_CLASSES_COUNT 69       // Then 2, 4, 8, 16 and 32KB.
+#define LARGEST_SIZE_CLASS (32*1024)
+
+#define KIND_FREE          0
+#define KIND_NEW           1
+#define KIND_LARGE_NEW     2
+#define KIND_MANAGED       3
+#define KIND_LARGE_MANAGED 4
+
+#define HEADER_MAGIC 0xAD
+
+struct Header {
+    uint64_t size;     // Of the object, without the header.
+    uint32_t weakSlot; // 0 until it's weakly referenced.
+    uint8_t kind;
+    uint8_t sizeClass;
+    uint8_t marked;    // Large managed objects only, the rest are marked in their regions.
+    uint8_t magic;     // HEADER_MAGIC, to tell objects from pointers that aren't to objects.
+};
+
+// Allocated (and freed) on their own, kept in a list to be scanned or swept,
+struct LargeObject {
+    struct LargeObject *previous, *next;
+    struct Header header;
+};
+
+// At the start of every region, and its first lines. A bit per granule, set where objects start
+// (and where marked ones start, while collecting), and a mark per line, set where live objects are,
+struct Region {
+    uint64_t objectStarts[GRANULES_PER_REGION / 64];
+    uint64_t marks[GRANULES_PER_REGION / 64];
+    uint8_t lineMarks[LINES_PER_REGION];
+    uint8_t hasWeakObjects; // Objects with weak slots, to release if they die.
+};
+
+#define FIRST_REGION_LINE ((int32_t) ((sizeof(struct Region) + LINE_SIZE - 1) / LINE_SIZE))
+
+static struct Region* getRegion(void* address) {
+    return (struct Region*) ((uintptr_t) address & ~(uintptr_t) (REGION_SIZE - 1));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void fail(const char* message) {
+    fprintf(stderr, "Addaat runtime: %s\n", message);
+    abort();
+}
+
+static void* allocate(size_t size) {
+    void* memory = malloc(size);
+    if (!memory) fail("Out of memory.");
+    return memory;
+}
+
+static void* reallocate(void* memory, size_t size) {
+    memory = realloc(memory, size);
+    if (!memory) fail("Out of memory.");
+    return memory;
+}
+
+static size_t getObjectSize(size_t size, size_t count) {
+    if (count && (size > SIZE_MAX / count)) fail("Allocation size overflows.");
+    return size * count;
+}
+
+// With the header, rounded up to whole granules. Objects get at least one granule, so that a
+// pointer to an empty object still points into it (and a free list link fits in it),
+static size_t getTotalSize(size_t objectSize) {
+    if (objectSize > SIZE_MAX - 2*GRANULE_SIZE) fail("Allocation size overflows.");
+    if (!objectSize) objectSize = 1;
+    return sizeof(struct Header) + ((objectSize + GRANULE_SIZE - 1) & ~(size_t) (GRANULE_SIZE - 1));
+}
+
+static struct Header* allocateLargeObject(size_t objectSize, size_t totalSize, uint8_t kind, struct LargeObject** list) {
+    struct LargeObject* largeObject = allocate(totalSize - sizeof(struct Header) + sizeof(struct LargeObject));
+    largeObject->previous = 0;
+    largeObject->next = *list;
+    if (*list) (*list)->previous = largeObject;
+    *list = largeObject;
+
+    struct Header* header = &largeObject->header;
+    header->size = objectSize;
+    header->weakSlot = 0;
+    header->kind = kind;
+    header->marked = 0;
+    header->magic = HEADER_MAGIC;
+    return header;
+}
+
+static void freeLargeObject(struct Header* header, struct LargeObject** list) {
+    struct LargeObject* largeObject = (struct LargeObject*) ((char*) header - offsetof(struct LargeObject, header));
+    if (largeObject->previous) {
+        largeObject->previous->next = largeObject->next;
+    } else {
+        *list = largeObject->next;
+    }
+    if (largeObject->next) largeObject->next->previous = largeObject->previous;
+    free(largeObject);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Weak references
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Slot 0 is the null reference. Freed slots are chained through nextFreeSlot (0 ends the chain),
+static struct AddaatWeakSlot nullWeakSlot;
+struct AddaatWeakSlot* addaatWeakSlots = &nullWeakSlot;
+uint32_t addaatWeakSlotsCount = 1;
+static uint32_t weakSlotsCapacity = 1;
+static uint32_t firstFreeWeakSlot = 0;
+
+static uint32_t acquireWeakSlot(void* object) {
+
+    uint32_t slotIndex = firstFreeWeakSlot;
+    if (slotIndex) {
+        firstFreeWeakSlot = addaatWeakSlots[slotIndex].nextFreeSlot;
+    } else {
+        if (addaatWeakSlotsCount == UINT32_MAX) fail("Too many weakly referenced objects.");
+        if (addaatWeakSlotsCount == weakSlotsCapacity) {
+            weakSlotsCapacity = (weakSlotsCapacity < UINT32_MAX/2) ? weakSlotsCapacity * 2 : UINT32_MAX;
+            if (addaatWeakSlots == &nullWeakSlot) {
+                addaatWeakSlots = allocate(weakSlotsCapacity * sizeof(struct AddaatWeakSlot));
+                addaatWeakSlots[0] = nullWeakSlot;
+            } else {
+                addaatWeakSlots = reallocate(addaatWeakSlots, weakSlotsCapacity * sizeof(struct AddaatWeakSlot));
+            }
+        }
+        slotIndex = addaatWeakSlotsCount++;
+        addaatWeakSlots[slotIndex].generation = 0;
+    }
+
+    addaatWeakSlots[slotIndex].object = object;
+    return slotIndex;
+}
+
+// Once the object is gone. The new generation tells the references to it apart from the ones to
+// whatever gets the slot next,
+static void releaseWeakSlot(struct Header* header) {
+    if (!header->weakSlot) return;
+    struct AddaatWeakSlot* slot = &addaatWeakSlots[header->weakSlot];
+    slot->object = 0;
+    slot->generation++;
+    slot->nextFreeSlot = firstFreeWeakSlot;
+    firstFreeWeakSlot = header->weakSlot;
+    header->weakSlot = 0;
+}
+
+static int containsRegion(uintptr_t region);
+
+// Pointers to static data, to memory allocated elsewhere, or into the middle of objects have no
+// header before them. Whatever is there is checked before it's trusted: the magic and the kind,
+// and for managed objects in regions, that an object starts there,
+static int isLiveObject(struct Header* header) {
+    if ((header->magic != HEADER_MAGIC) || (header->kind == KIND_FREE) || (header->kind > KIND_LARGE_MANAGED)) return 0;
+    if (header->kind != KIND_MANAGED) return 1;
+    struct Region* region = getRegion(header);
+    if (((uintptr_t) header & (GRANULE_SIZE - 1)) || !containsRegion((uintptr_t) region)) return 0;
+    int32_t granule = (int32_t) (((char*) header - (char*) region) / GRANULE_SIZE);
+    return (int) ((region->objectStarts[granule >> 6] >> (granule & 63)) & 1);
+}
+
+void* addaatSetWeak(AddaatWeak* weak, void* object) {
+    if (!object) {
+        weak->slot = 0;
+        weak->generation = 0;
+        return 0;
+    }
+
+    struct Header* header = (struct Header*) object - 1;
+    if (!isLiveObject(header)) fail("Weak references are only to live objects from new or managed.");
+    if (!header->weakSlot) {
+        header->weakSlot = acquireWeakSlot(object);
+        if (header->kind == KIND_MANAGED) getRegion(header)->hasWeakObjects = 1;
+    }
+    weak->slot = header->weakSlot;
+    weak->generation = addaatWeakSlots[header->weakSlot].generation;
+    return object;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// New and delete
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Slots are carved from the newest slab, and the older ones are full. Their slots are free or not
+// by their headers' kinds,
+struct Slab {
+    struct Slab* next;
+    char* end; // Of the carved slots, once it's not the newest anymore.
+};
+
+struct Pool {
+    struct Header* freeList; // Linked through the objects' first words.
+    char *cursor, *limit;    // In the newest slab.
+    struct Slab* slabs;
+};
+
+static struct Pool pools[SIZE_CLASSES_COUNT];
+static struct LargeObject* largeNewObjects;
+
+static int32_t getSizeClass(size_t totalSize) {
+    if (totalSize <= SMALL_SIZE_CLASSES_COUNT * GRANULE_SIZE) return (int32_t) (totalSize / GRANULE_SIZE) - 1;
+    int32_t sizeClass = SMALL_SIZE_CLASSES_COUNT;
+    for (size_t classSize = 2048; classSize < totalSize; classSize *= 2) sizeClass++;
+    return sizeClass;
+}
+
+static size_t getSizeClassSize(int32_t sizeClass) {
+    if (sizeClass < SMALL_SIZE_CLASSES_COUNT) return (size_t) (sizeClass + 1) * GRANULE_SIZE;
+    return (size_t) 2048 << (sizeClass - SMALL_SIZE_CLASSES_COUNT);
+}
+
+static void addSlab(struct Pool* pool, size_t classSize) {
+    size_t slabSize = (classSize * 8 > SLAB_SIZE) ? classSize * 8 : SLAB_SIZE;
+    struct Slab* slab = allocate(sizeof(struct Slab) + slabSize);
+    if (pool->slabs) pool->slabs->end = pool->cursor;
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    pool->cursor = (char*) (slab + 1);
+    pool->limit = pool->cursor + slabSize;
+}
+
+void* addaatNew(size_t size, size_t count) {
+
+    size_t objectSize = getObjectSize(size, count);
+    size_t totalSize = getTotalSize(objectSize);
+    if (totalSize > LARGEST_SIZE_CLASS) return allocateLargeObject(objectSize, totalSize, KIND_LARGE_NEW, &largeNewObjects) + 1;
+
+    int32_t sizeClass = getSizeClass(totalSize);
+    struct Pool* pool = &pools[sizeClass];
+    struct Header* header = pool->freeList;
+    if (header) {
+        pool->freeList = *(struct Header**) (header + 1);
+    } else {
+        size_t classSize = getSizeClassSize(sizeClass);
+        if ((size_t) (pool->limit - pool->cursor) < classSize) addSlab(pool, classSize);
+        header = (struct Header*) pool->cursor;
+        pool->cursor += classSize;
+    }
+
+    header->size = objectSize;
+    header->weakSlot = 0;
+    header->kind = KIND_NEW;
+    header->sizeClass = (uint8_t) sizeClass;
+    header->magic = HEADER_MAGIC;
+    return header + 1;
+}
+
+void* addaatNewCleared(size_t size, size_t count) {
+    void* object = addaatNew(size, count);
+    memset(object, 0, ((struct Header*) object - 1)->size);
+    return object;
+}
+
+void* addaatNewArrays(void* container, const size_t* sizes, size_t arraysCount, size_t count) {
+    void** arrays = container;
+    for (size_t i=0; i<arraysCount; i++) arrays[i] = addaatNew(sizes[i], count);
+    return container;
+}
+
+void addaatDelete(void* object) {
+
+    if (!object) return;
+    struct Header* header = (struct Header*) object - 1;
+    if (header->magic != HEADER_MAGIC) fail("Only objects from new can be deleted.");
+    switch (header->kind) {
+        case KIND_NEW: {
+            releaseWeakSlot(header);
+            header->kind = KIND_FREE;
+            struct Pool* pool = &pools[header->sizeClass];
+            *(struct Header**) object = pool->freeList;
+            pool->freeList = header;
+            return;
+        }
+        case KIND_LARGE_NEW:
+            releaseWeakSlot(header);
+            freeLargeObject(header, &largeNewObjects);
+            return;
+        default:
+            fail((header->kind == KIND_FREE) ? "Object deleted twice." : "Managed objects can't be deleted.");
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Managed
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Every region, and a hash set of them (open addressing) to tell which addresses are in them,
+static struct Region** regions;
+static int32_t regionsCount, regionsCapacity;
+static uintptr_t* regionsSet;
+static int32_t regionsSetCapacity;
+static uintptr_t lowestRegion = UINTPTR_MAX, highestRegion;
+
+// Allocation goes through the regions in order, then adds new ones,
+static int32_t allocationRegionIndex;
+static int32_t nextLine = FIRST_REGION_LINE;
+static char *managedCursor, *managedLimit;
+
+static struct LargeObject* largeManagedObjects;
+
+static size_t allocatedBytes; // Since the last collection.
+static size_t collectionThreshold = MINIMUM_COLLECTION_THRESHOLD;
+
+static int32_t getRegionsSetIndex(uintptr_t region, int32_t capacity) {
+    return (int32_t) ((region / REGION_SIZE) * 0x9E3779B97F4A7C15ull >> 32) & (capacity - 1);
+}
+
+static void insertIntoRegionsSet(uintptr_t region) {
+    int32_t index = getRegionsSetIndex(region, regionsSetCapacity);
+    while (regionsSet[index]) index = (index + 1) & (regionsSetCapacity - 1);
+    regionsSet[index] = region;
+}
+
+static int containsRegion(uintptr_t region) {
+    if ((region < lowestRegion) || (region > highestRegion)) return 0;
+    int32_t index = getRegionsSetIndex(region, regionsSetCapacity);
+    while (regionsSet[index]) {
+        if (regionsSet[index] == region) return 1;
+        index = (index + 1) & (regionsSetCapacity - 1);
+    }
+    return 0;
+}
+
+static void addRegion() {
+
+    void* memory;
+    if (posix_memalign(&memory, REGION_SIZE, REGION_SIZE)) fail("Out of memory.");
+    struct Region* region = memory;
+    memset(region, 0, sizeof(struct Region));
+
+    if (regionsCount == regionsCapacity) {
+        regionsCapacity = regionsCapacity ? regionsCapacity * 2 : 16;
+        regions = reallocate(regions, regionsCapacity * sizeof(struct Region*));
+    }
+    regions[regionsCount++] = region;
+
+    // Kept at most half full,
+    if (regionsCount * 2 > regionsSetCapacity) {
+        free(regionsSet);
+        regionsSetCapacity = regionsCapacity * 2;
+        regionsSet = allocate(regionsSetCapacity * sizeof(uintptr_t));
+        memset(regionsSet, 0, regionsSetCapacity * sizeof(uintptr_t));
+        for (int32_t i=0; i<regionsCount-1; i++) insertIntoRegionsSet((uintptr_t) regions[i]);
+    }
+    insertIntoRegionsSet((uintptr_t) region);
+    if ((uintptr_t) region < lowestRegion) lowestRegion = (uintptr_t) region;
+    if ((uintptr_t) region > highestRegion) highestRegion = (uintptr_t) region;
+}
+
+// Moves the cursor to the next run of free lines the size fits in,
+static void findFreeLines(size_t totalSize) {
+    while (1) {
+        if (allocationRegionIndex == regionsCount) addRegion();
+        struct Region* region = regions[allocationRegionIndex];
+        while (nextLine < LINES_PER_REGION) {
+            if (region->lineMarks[nextLine]) {
+                nextLine++;
+                continue;
+            }
+            int32_t firstLine = nextLine;
+            while ((nextLine < LINES_PER_REGION) && !region->lineMarks[nextLine]) nextLine++;
+            if ((size_t) (nextLine - firstLine) * LINE_SIZE >= totalSize) {
+                managedCursor = (char*) region + firstLine * LINE_SIZE;
+                managedLimit  = (char*) region +  nextLine * LINE_SIZE;
+                return;
+            }
+        }
+        allocationRegionIndex++;
+        nextLine = FIRST_REGION_LINE;
+    }
+}
+
+void* addaatManaged(size_t size, size_t count) {
+
+    size_t objectSize = getObjectSize(size, count);
+    size_t totalSize = getTotalSize(objectSize);
+    if (allocatedBytes >= collectionThreshold) addaatCollect();
+    allocatedBytes += totalSize;
+
+    struct Header* header;
+    if (totalSize > LARGE_MANAGED_OBJECT_SIZE) {
+        header = allocateLargeObject(objectSize, totalSize, KIND_LARGE_MANAGED, &largeManagedObjects);
+    } else {
+        if ((size_t) (managedLimit - managedCursor) < totalSize) findFreeLines(totalSize);
+        header = (struct Header*) managedCursor;
+        managedCursor += totalSize;
+
+        struct Region* region = getRegion(header);
+        int32_t granule = (int32_t) (((char*) header - (char*) region) / GRANULE_SIZE);
+        region->objectStarts[granule >> 6] |= 1ull << (granule & 63);
+        header->size = objectSize;
+        header->weakSlot = 0;
+        header->kind = KIND_MANAGED;
+        header->magic = HEADER_MAGIC;
+    }
+
+    memset(header + 1, 0, totalSize - sizeof(struct Header));
+    return header + 1;
+}
+
+// The container is the caller's, so the arrays allocated so far are reachable (from the stack) if
+// allocating the next ones collects,
+void* addaatManagedArrays(void* container, const size_t* sizes, size_t arraysCount, size_t count) {
+    void** arrays = container;
+    for (size_t i=0; i<arraysCount; i++) arrays[i] = addaatManaged(sizes[i], count);
+    return container;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Collection
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Roots {
+    char *start, *end;
+};
+
+static struct Roots* roots;
+static int32_t rootsCount, rootsCapacity;
+static char* stackTop;
+
+// Marked objects, yet to be scanned,
+static struct Header** pendingObjects;
+static int32_t pendingObjectsCount, pendingObjectsCapacity;
+
+// The large managed objects, sorted by address while collecting,
+static struct Header** sortedLargeObjects;
+static int32_t largeObjectsCount, largeObjectsCapacity;
+
+void addaatAddRoots(void* start, void* end) {
+    if (rootsCount == rootsCapacity) {
+        rootsCapacity = rootsCapacity ? rootsCapacity * 2 : 8;
+        roots = reallocate(roots, rootsCapacity * sizeof(struct Roots));
+    }
+    roots[rootsCount].start = start;
+    roots[rootsCount].end = end;
+    rootsCount++;
+}
+
+// The program's writable segments (its global variables). The program is always listed first,
+static int addGlobalVariablesRoots(struct dl_phdr_info* info, size_t infoSize, void* data) {
+    (void) infoSize;
+    (void) data;
+    for (int32_t i=0; i<info->dlpi_phnum; i++) {
+        const ElfW(Phdr)* segment = &info->dlpi_phdr[i];
+        if ((segment->p_type != PT_LOAD) || !(segment->p_flags & PF_W)) continue;
+        char* start = (char*) (info->dlpi_addr + segment->p_vaddr);
+        addaatAddRoots(start, start + segment->p_memsz);
+    }
+    return 1;
+}
+
+static void findRoots() {
+    dl_iterate_phdr(addGlobalVariablesRoots, 0);
+
+    pthread_attr_t attributes;
+    void* stackAddress;
+    size_t stackSize;
+    if (pthread_getattr_np(pthread_self(), &attributes) || pthread_attr_getstack(&attributes, &stackAddress, &stackSize)) fail("Couldn't find the stack.");
+    pthread_attr_destroy(&attributes);
+    stackTop = (char*) stackAddress + stackSize;
+}
+
+static void pushMarked(struct Header* header) {
+    if (pendingObjectsCount == pendingObjectsCapacity) {
+        pendingObjectsCapacity = pendingObjectsCapacity ? pendingObjectsCapacity * 2 : 1024;
+        pendingObjects = reallocate(pendingObjects, pendingObjectsCapacity * sizeof(struct Header*));
+    }
+    pendingObjects[pendingObjectsCount++] = header;
+}
+
+static void markRegionObject(struct Region* region, uintptr_t pointer) {
+
+    int32_t granule = (int32_t) ((pointer - (uintptr_t) region) / GRANULE_SIZE);
+    if (granule < FIRST_REGION_LINE * (LINE_SIZE / GRANULE_SIZE)) return;
+
+    // The object it points into is the closest to start at or before it,
+    int32_t word = granule >> 6;
+    uint64_t starts = region->objectStarts[word] & (~0ull >> (63 - (granule & 63)));
+    while (!starts) {
+        if (--word < 0) return;
+        starts = region->objectStarts[word];
+    }
+    int32_t startGranule = (word << 6) + 63 - __builtin_clzll(starts);
+    struct Header* header = (struct Header*) ((char*) region + startGranule * GRANULE_SIZE);
+    if (pointer >= (uintptr_t) header + getTotalSize(header->size)) return;
+
+    uint64_t markBit = 1ull << (startGranule & 63);
+    if (region->marks[startGranule >> 6] & markBit) return;
+    region->marks[startGranule >> 6] |= markBit;
+    pushMarked(header);
+}
+
+static void markLargeObject(uintptr_t pointer) {
+
+    // The last one that starts at or before it,
+    int32_t low = 0, high = largeObjectsCount - 1, found = -1;
+    while (low <= high) {
+        int32_t middle = (low + high) / 2;
+        if ((uintptr_t) sortedLargeObjects[middle] <= pointer) {
+            found = middle;
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+    if (found < 0) return;
+
+    struct Header* header = sortedLargeObjects[found];
+    if ((pointer >= (uintptr_t) header + getTotalSize(header->size)) || header->marked) return;
+    header->marked = 1;
+    pushMarked(header);
+}
+
+// Scans whole ranges, the stack's unused gaps and sanitizer red zones included,
+static __attribute__((no_sanitize_address)) void markRange(char* start, char* end) {
+    uintptr_t lowestLargeObject = largeObjectsCount ? (uintptr_t) sortedLargeObjects[0] : UINTPTR_MAX;
+    uintptr_t lastRegion = 1; // Neighboring pointers tend to point into the same region (no region is at 1).
+    uintptr_t word = ((uintptr_t) start + sizeof(uintptr_t) - 1) & ~(uintptr_t) (sizeof(uintptr_t) - 1);
+    for (; word + sizeof(uintptr_t) <= (uintptr_t) end; word += sizeof(uintptr_t)) {
+        uintptr_t pointer = *(uintptr_t*) word;
+        uintptr_t region = pointer & ~(uintptr_t) (REGION_SIZE - 1);
+        if ((region == lastRegion) || containsRegion(region)) {
+            lastRegion = region;
+            markRegionObject((struct Region*) region, pointer);
+        } else if (pointer >= lowestLargeObject) {
+            markLargeObject(pointer);
+        }
+    }
+}
+
+// Not inlined, so that its frame is below the caller's (where the registers were spilled),
+static __attribute__((noinline)) void markStack() {
+    char* stackBottom = __builtin_frame_address(0);
+    markRange(stackBottom, stackTop);
+}
+
+static void markNewObjects() {
+
+    for (int32_t i=0; i<SIZE_CLASSES_COUNT; i++) {
+        struct Pool* pool = &pools[i];
+        size_t classSize = getSizeClassSize(i);
+        for (struct Slab* slab=pool->slabs; slab; slab=slab->next) {
+            char* end = (slab == pool->slabs) ? pool->cursor : slab->end;
+            for (char* slot=(char*) (slab + 1); slot + classSize <= end; slot += classSize) {
+                struct Header* header = (struct Header*) slot;
+                if (header->kind == KIND_NEW) markRange((char*) (header + 1), (char*) (header + 1) + header->size);
+            }
+        }
+    }
+
+    for (struct LargeObject* largeObject=largeNewObjects; largeObject; largeObject=largeObject->next) {
+        struct Header* header = &largeObject->header;
+        markRange((char*) (header + 1), (char*) (header + 1) + header->size);
+    }
+}
+
+static int compareAddresses(const void* address1, const void* address2) {
+    uintptr_t value1 = (uintptr_t) *(void* const*) address1;
+    uintptr_t value2 = (uintptr_t) *(void* const*) address2;
+    return (value1 > value2) - (value1 < value2);
+}
+
+static void sortLargeObjects() {
+    largeObjectsCount = 0;
+    for (struct LargeObject* largeObject=largeManagedObjects; largeObject; largeObject=largeObject->next) {
+        if (largeObjectsCount == largeObjectsCapacity) {
+            largeObjectsCapacity = largeObjectsCapacity ? largeObjectsCapacity * 2 : 64;
+            sortedLargeObjects = reallocate(sortedLargeObjects, largeObjectsCapacity * sizeof(struct Header*));
+        }
+        sortedLargeObjects[largeObjectsCount++] = &largeObject->header;
+    }
+    if (largeObjectsCount > 1) qsort(sortedLargeObjects, largeObjectsCount, sizeof(struct Header*), compareAddresses);
+}
+
+// Frees the unmarked objects, and clears the marks. Returns the bytes that remain,
+static size_t sweep() {
+
+    size_t liveBytes = 0;
+    for (int32_t i=0; i<regionsCount; i++) {
+        struct Region* region = regions[i];
+        memset(region->lineMarks, 0, sizeof(region->lineMarks));
+        uint8_t hasWeakObjects = region->hasWeakObjects;
+        region->hasWeakObjects = 0;
+        for (int32_t word=0; word<GRANULES_PER_REGION/64; word++) {
+
+            // The dead release their weak slots,
+            if (hasWeakObjects) {
+                uint64_t dead = region->objectStarts[word] & ~region->marks[word];
+                for (; dead; dead &= dead - 1) {
+                    int32_t granule = (word << 6) + __builtin_ctzll(dead);
+                    releaseWeakSlot((struct Header*) ((char*) region + granule * GRANULE_SIZE));
+                }
+            }
+
+            // The live keep their lines,
+            uint64_t live = region->marks[word];
+            for (; live; live &= live - 1) {
+                int32_t granule = (word << 6) + __builtin_ctzll(live);
+                struct Header* header = (struct Header*) ((char*) region + granule * GRANULE_SIZE);
+                if (header->weakSlot) region->hasWeakObjects = 1;
+                size_t totalSize = getTotalSize(header->size);
+                int32_t firstLine = (granule * GRANULE_SIZE) / LINE_SIZE;
+                int32_t lastLine = (int32_t) ((granule * GRANULE_SIZE + totalSize - 1) / LINE_SIZE);
+                memset(&region->lineMarks[firstLine], 1, lastLine - firstLine + 1);
+                liveBytes += totalSize;
+            }
+
+            region->objectStarts[word] = region->marks[word];
+            region->marks[word] = 0;
+        }
+    }
+
+    struct LargeObject* largeObject = largeManagedObjects;
+    while (largeObject) {
+        struct LargeObject* next = largeObject->next;
+        struct Header* header = &largeObject->header;
+        if (header->marked) {
+            header->marked = 0;
+            liveBytes += getTotalSize(header->size);
+        } else {
+            releaseWeakSlot(header);
+            freeLargeObject(header, &largeManagedObjects);
+        }
+        largeObject = next;
+    }
+
+    return liveBytes;
+}
+
+void addaatCollect() {
+
+    if (!stackTop) findRoots();
+
+    // Spill the registers onto the stack, where they're scanned with the rest of it,
+    jmp_buf registers;
+    __builtin_unwind_init();
+    setjmp(registers);
+
+    // Mark,
+    sortLargeObjects();
+    markStack();
+    for (int32_t i=0; i<rootsCount; i++) markRange(roots[i].start, roots[i].end);
+    markNewObjects();
+    while (pendingObjectsCount) {
+        struct Header* header = pendingObjects[--pendingObjectsCount];
+        markRange((char*) (header + 1), (char*) (header + 1) + header->size);
+    }
+
+    // Sweep. The next collection comes once twice what's live is allocated, so that marking costs
+    // at most half as much as allocating,
+    size_t liveBytes = sweep();
+    allocatedBytes = 0;
+    collectionThreshold = (liveBytes * 2 > MINIMUM_COLLECTION_THRESHOLD) ? liveBytes * 2 : MINIMUM_COLLECTION_THRESHOLD;
+
+    // Allocate through the freed lines, from the first region on,
+    allocationRegionIndex = 0;
+    nextLine = FIRST_REGION_LINE;
+    managedCursor = managedLimit = 0;
+}
@@ -0,0 +1,62 @@
+/////////////////////////////////////////////////////////
+// Addaat runtime. The generated code includes this when
+// it allocates: new and delete go through size-class
+// pools, managed objects are collected once they're
+// unreachable, and weak references are checked against
+// their objects' slots. Plain C, single threaded.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// A weak reference names a slot rather than the object. The slot's generation changes when its
+// object is deleted or collected, so a stale reference reads as 0. Zero initialized references
+// are null (slot 0 never holds an object),
+typedef struct AddaatWeak {
+    uint32_t slot, generation;
+} AddaatWeak;
+
+struct AddaatWeakSlot {
+    void* object;
+    uint32_t generation;
+    uint32_t nextFreeSlot;
+};
+
+extern struct AddaatWeakSlot* addaatWeakSlots;
+extern uint32_t addaatWeakSlotsCount;
+
+// Count objects of the size. New objects aren't cleared, and live until they're deleted. Deleting
+// 0 does nothing, deleting twice, deleting a managed object or anything that isn't an object
+// aborts,
+void* addaatNew(size_t size, size_t count);
+void addaatDelete(void* object);
+
+// As addaatNew(), but cleared. For objects that hold weak references, which can't start undefined,
+void* addaatNewCleared(size_t size, size_t count);
+
+// Managed objects are cleared, and live as long as they're reachable from the stack, the global
+// variables, the registered roots, or new or managed objects. Pointers are found conservatively
+// (any word that points into an object keeps it), so nothing else needs to be known about them.
+// Memory allocated elsewhere (malloc) isn't scanned, unless it's registered as roots,
+void* addaatManaged(size_t size, size_t count);
+void addaatCollect();
+void addaatAddRoots(void* start, void* end);
+
+// Arrays of structure-of-arrays classes are containers with a pointer per member. These allocate
+// count elements of each size into the container's pointers, in order. Return the container,
+void* addaatNewArrays(void* container, const size_t* sizes, size_t arraysCount, size_t count);
+void* addaatManagedArrays(void* container, const size_t* sizes, size_t arraysCount, size_t count);
+
+// Only for live objects from addaatNew() or addaatManaged(). Anything else (string literals, C
+// arrays, pointers into the middle of objects) aborts. Returns the object,
+void* addaatSetWeak(AddaatWeak* weak, void* object);
+
+// The object, or 0 if it's gone. A slot that was never handed out (the reference is garbage) reads
+// as 0 too, rather than reading past the slots,
+static inline void* addaatGetWeak(AddaatWeak weak) {
+    if (weak.slot >= addaatWeakSlotsCount) return 0;
+    struct AddaatWeakSlot* slot = &addaatWeakSlots[weak.slot];
+    return (slot->generation == weak.generation) ? slot->object : 0;
+}
@@ -0,0 +1,343 @@
+
+//
+// Compact binary AST files. Nodes, child ranges and strings are laid out in flat sections that
+// are usable right from a memory mapping.
+//
+// The 18th of October, 2026.
+//
+
+#include <ASTSerialization.h>
+
+#include <NCC.h>
+#include <NSystemUtils.h>
+#include <NString.h>
+#include <NVector.h>
+#include <NCString.h>
+#include <NError.h>
+#include <AllocationProfiler.h> // After NSystemUtils.h, to reroute NMALLOC/NFREE.
+
+#ifdef DESKTOP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+struct ByteBuffer {
+    char* data;
+    int32_t size, capacity;
+};
+
+struct ASTWriter {
+    struct ByteBuffer nodes, children, strings;
+
+    // Open addressing string set. Slots hold string offsets plus one (zero is empty),
+    uint32_t* stringSlots;
+    int32_t stringSlotsCount, stringsCount;
+
+    struct NVector treeNodeIndices; // uint32_t.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper functions
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void initializeByteBuffer(struct ByteBuffer* buffer, int32_t capacity) {
+    buffer->data = NMALLOC(capacity, "ASTSerialization.initializeByteBuffer() buffer->data");
+    buffer->size = 0;
+    buffer->capacity = capacity;
+}
+
+static void destroyByteBuffer(struct ByteBuffer* buffer) {
+    NFREE(buffer->data, "ASTSerialization.destroyByteBuffer() buffer->data");
+}
+
+// Returns the offset of the reserved bytes. Pointers into the buffer don't survive this,
+static int32_t reserveBytes(struct ByteBuffer* buffer, int32_t size) {
+    if (buffer->size + size > buffer->capacity) {
+        int32_t newCapacity = buffer->capacity * 2;
+        while (buffer->size + size > newCapacity) newCapacity *= 2;
+        char* newData = NMALLOC(newCapacity, "ASTSerialization.reserveBytes() newData");
+        NSystemUtils.memcpy(newData, buffer->data, buffer->size);
+        NFREE(buffer->data, "ASTSerialization.reserveBytes() buffer->data");
+        buffer->data = newData;
+        buffer->capacity = newCapacity;
+    }
+    int32_t offset = buffer->size;
+    buffer->size += size;
+    return offset;
+}
+
+static uint32_t hashString(const char* text, int32_t length) {
+    uint32_t hash = 2166136261u;
+    for (int32_t i=0; i<length; i++) hash = (hash ^ (uint8_t) text[i]) * 16777619u;
+    return hash;
+}
+
+static boolean stringEquals(struct ASTWriter* writer, uint32_t offset, const char* text, int32_t length) {
+    const char* storedText = &writer->strings.data[offset];
+    for (int32_t i=0; i<length; i++) if (storedText[i] != text[i]) return False;
+    return storedText[length] == 0;
+}
+
+static void growStringSlots(struct ASTWriter* writer) {
+
+    int32_t oldSlotsCount = writer->stringSlotsCount;
+    uint32_t* oldSlots = writer->stringSlots;
+
+    writer->stringSlotsCount = oldSlotsCount ? oldSlotsCount*2 : 1024;
+    writer->stringSlots = NMALLOC(writer->stringSlotsCount * sizeof(uint32_t), "ASTSerialization.growStringSlots() writer->stringSlots");
+    NSystemUtils.memset(writer->stringSlots, 0, writer->stringSlotsCount * sizeof(uint32_t));
+
+    int32_t mask = writer->stringSlotsCount - 1;
+    for (int32_t i=0; i<oldSlotsCount; i++) {
+        if (!oldSlots[i]) continue;
+        const char* text = &writer->strings.data[oldSlots[i]-1];
+        int32_t slot = hashString(text, NCString.length(text)) & mask;
+        while (writer->stringSlots[slot]) slot = (slot+1) & mask;
+        writer->stringSlots[slot] = oldSlots[i];
+    }
+    if (oldSlots) NFREE(oldSlots, "ASTSerialization.growStringSlots() oldSlots");
+}
+
+static uint32_t addString(struct ASTWriter* writer, const char* text, int32_t length) {
+
+    // Keep the load factor under a half,
+    if ((writer->stringsCount+1)*2 > writer->stringSlotsCount) growStringSlots(writer);
+
+    // Look it up,
+    int32_t mask = writer->stringSlotsCount - 1;
+    int32_t slot = hashString(text, length) & mask;
+    while (writer->stringSlots[slot]) {
+        uint32_t offset = writer->stringSlots[slot] - 1;
+        if (stringEquals(writer, offset, text, length)) return offset;
+        slot = (slot+1) & mask;
+    }
+
+    // Not found, add it,
+    int32_t offset = reserveBytes(&writer->strings, length+1);
+    NSystemUtils.memcpy(&writer->strings.data[offset], text, length);
+    writer->strings.data[offset+length] = 0;
+    writer->stringSlots[slot] = offset + 1;
+    writer->stringsCount++;
+    return offset;
+}
+
+// Returns the index of the new node. Its children get a range that is filled as they are added,
+static uint32_t addNode(struct ASTWriter* writer, const char* name, int32_t nameLength, const char* value, int32_t valueLength, int32_t childrenCount) {
+
+    uint32_t nameOffset = addString(writer, name, nameLength);
+    uint32_t valueOffset = addString(writer, value, valueLength);
+
+    int32_t nodeOffset = reserveBytes(&writer->nodes, sizeof(struct ASTFileNode));
+    int32_t childrenOffset = reserveBytes(&writer->children, childrenCount * sizeof(uint32_t));
+
+    struct ASTFileNode* node = (struct ASTFileNode*) &writer->nodes.data[nodeOffset];
+    node->nameOffset = nameOffset;
+    node->valueOffset = valueOffset;
+    node->valueLength = valueLength;
+    node->firstChildOffset = childrenOffset / sizeof(uint32_t);
+    node->childrenCount = childrenCount;
+
+    return nodeOffset / sizeof(struct ASTFileNode);
+}
+
+static void setChild(struct ASTWriter* writer, uint32_t nodeIndex, int32_t childIndex, uint32_t childNodeIndex) {
+    struct ASTFileNode* node = (struct ASTFileNode*) &writer->nodes.data[nodeIndex * sizeof(struct ASTFileNode)];
+    ((uint32_t*) writer->children.data)[node->firstChildOffset + childIndex] = childNodeIndex;
+}
+
+static uint32_t addTree(struct ASTWriter* writer, struct NCC_ASTNode* tree) {
+
+    int32_t childrenCount = NVector.size(&tree->childNodes);
+    uint32_t nodeIndex = addNode(
+            writer,
+            NString.get(&tree->name ), NString.length(&tree->name ),
+            NString.get(&tree->value), NString.length(&tree->value),
+            childrenCount);
+
+    for (int32_t i=0; i<childrenCount; i++) {
+        struct NCC_ASTNode* child = *(struct NCC_ASTNode**) NVector.get(&tree->childNodes, i);
+        setChild(writer, nodeIndex, i, addTree(writer, child));
+    }
+
+    return nodeIndex;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Writing
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct ASTWriter* createASTWriter() {
+    struct ASTWriter* writer = NMALLOC(sizeof(struct ASTWriter), "ASTSerialization.createASTWriter() writer");
+    initializeByteBuffer(&writer->nodes, 1024 * sizeof(struct ASTFileNode));
+    initializeByteBuffer(&writer->children, 1024 * sizeof(uint32_t));
+    initializeByteBuffer(&writer->strings, 16 * 1024);
+    writer->stringSlots = 0;
+    writer->stringSlotsCount = 0;
+    writer->stringsCount = 0;
+    NVector.initialize(&writer->treeNodeIndices, 0, sizeof(uint32_t));
+    return writer;
+}
+
+void destroyAndDeleteASTWriter(struct ASTWriter* writer) {
+    destroyByteBuffer(&writer->nodes);
+    destroyByteBuffer(&writer->children);
+    destroyByteBuffer(&writer->strings);
+    if (writer->stringSlots) NFREE(writer->stringSlots, "ASTSerialization.destroyAndDeleteASTWriter() writer->stringSlots");
+    NVector.destroy(&writer->treeNodeIndices);
+    NFREE(writer, "ASTSerialization.destroyAndDeleteASTWriter() writer");
+}
+
+void addASTWriterTree(struct ASTWriter* writer, struct NCC_ASTNode* tree) {
+    uint32_t nodeIndex = addTree(writer, tree);
+    NVector.pushBack(&writer->treeNodeIndices, &nodeIndex);
+}
+
+boolean writeASTFile(struct ASTWriter* writer, const char* rootName, const char* filePath) {
+
+    // Find (or create) the root,
+    int32_t treesCount = NVector.size(&writer->treeNodeIndices);
+    uint32_t rootNodeIndex;
+    if (rootName) {
+        rootNodeIndex = addNode(writer, rootName, NCString.length(rootName), "", 0, treesCount);
+        for (int32_t i=0; i<treesCount; i++) setChild(writer, rootNodeIndex, i, *(uint32_t*) NVector.get(&writer->treeNodeIndices, i));
+    } else if (treesCount == 1) {
+        rootNodeIndex = *(uint32_t*) NVector.get(&writer->treeNodeIndices, 0);
+    } else {
+        NERROR("ASTSerialization.writeASTFile()", "Expecting a single tree, found: %d", treesCount);
+        return False;
+    }
+
+    // Lay out the sections,
+    struct ASTFileHeader header;
+    header.magic = AST_FILE_MAGIC;
+    header.version = AST_FILE_VERSION;
+    header.rootNodeIndex = rootNodeIndex;
+    header.nodesCount = writer->nodes.size / sizeof(struct ASTFileNode);
+    header.nodesOffset = sizeof(struct ASTFileHeader);
+    header.childrenCount = writer->children.size / sizeof(uint32_t);
+    header.childrenOffset = header.nodesOffset + writer->nodes.size;
+    header.stringsSize = writer->strings.size;
+    header.stringsOffset = header.childrenOffset + writer->children.size;
+
+    // Write,
+    boolean success =
+            NSystemUtils.writeToFile(filePath, &header, sizeof(struct ASTFileHeader), False) &&
+            NSystemUtils.writeToFile(filePath, writer->nodes.data, writer->nodes.size, True) &&
+            NSystemUtils.writeToFile(filePath, writer->children.data, writer->children.size, True) &&
+            NSystemUtils.writeToFile(filePath, writer->strings.data, writer->strings.size, True);
+    if (!success) NERROR("ASTSerialization.writeASTFile()", "Couldn't write: %s%s%s", NTCOLOR(HIGHLIGHT), filePath, NTCOLOR(STREAM_DEFAULT));
+    return success;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Reading
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static boolean sectionFits(uint32_t offset, uint32_t count, uint32_t elementSize, int32_t dataSize) {
+    return ((uint64_t) offset + (uint64_t) count * elementSize) <= (uint64_t) dataSize;
+}
+
+// Every offset has to land inside its section. Children come after their parents (only the root
+// may have them before it, and it's nobody's child), so that walking the tree always ends,
+static boolean nodesValid(const struct ASTFileHeader* header, const struct ASTFileNode* nodes, const uint32_t* children) {
+    for (uint32_t i=0; i<header->nodesCount; i++) {
+        const struct ASTFileNode* node = &nodes[i];
+        if ((node->nameOffset >= header->stringsSize) ||
+            ((uint64_t) node->valueOffset + node->valueLength >= header->stringsSize) ||
+            ((uint64_t) node->firstChildOffset + node->childrenCount > header->childrenCount)) return False;
+        for (uint32_t j=0; j<node->childrenCount; j++) {
+            uint32_t childIndex = children[node->firstChildOffset + j];
+            if ((childIndex >= header->nodesCount) || (childIndex == header->rootNodeIndex)) return False;
+            if ((i != header->rootNodeIndex) && (childIndex <= i)) return False;
+        }
+    }
+    return True;
+}
+
+boolean loadASTFile(const char* filePath, struct ASTFile* outFile) {
+
+    NSystemUtils.memset(outFile, 0, sizeof(struct ASTFile));
+
+    #ifdef DESKTOP
+    int fileDescriptor = open(filePath, O_RDONLY);
+    struct stat fileStatus;
+    if ((fileDescriptor < 0) || fstat(fileDescriptor, &fileStatus) || (fileStatus.st_size < (off_t) sizeof(struct ASTFileHeader))) {
+        if (fileDescriptor >= 0) close(fileDescriptor);
+        NERROR("ASTSerialization.loadASTFile()", "Couldn't open: %s%s%s", NTCOLOR(HIGHLIGHT), filePath, NTCOLOR(STREAM_DEFAULT));
+        return False;
+    }
+    void* data = mmap(0, fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    close(fileDescriptor);
+    if (data == MAP_FAILED) {
+        NERROR("ASTSerialization.loadASTFile()", "Couldn't map: %s%s%s", NTCOLOR(HIGHLIGHT), filePath, NTCOLOR(STREAM_DEFAULT));
+        return False;
+    }
+    outFile->data = data;
+    outFile->dataSize = (int32_t) fileStatus.st_size;
+    outFile->mapped = True;
+    #else
+    int32_t fileSize = NSystemUtils.getFileSize(filePath, False);
+    if (fileSize < (int32_t) sizeof(struct ASTFileHeader)) {
+        NERROR("ASTSerialization.loadASTFile()", "Couldn't open: %s%s%s", NTCOLOR(HIGHLIGHT), filePath, NTCOLOR(STREAM_DEFAULT));
+        return False;
+    }
+    outFile->data = NMALLOC(fileSize, "ASTSerialization.loadASTFile() outFile->data");
+    NSystemUtils.readFromFile(filePath, False, 0, fileSize, outFile->data);
+    outFile->dataSize = fileSize;
+    #endif
+
+    // Validate,
+    const char* data8 = outFile->data;
+    const struct ASTFileHeader* header = outFile->data;
+    boolean valid =
+            (header->magic == AST_FILE_MAGIC) &&
+            (header->version == AST_FILE_VERSION) &&
+            (header->rootNodeIndex < header->nodesCount) &&
+            sectionFits(header->nodesOffset, header->nodesCount, sizeof(struct ASTFileNode), outFile->dataSize) &&
+            sectionFits(header->childrenOffset, header->childrenCount, sizeof(uint32_t), outFile->dataSize) &&
+            sectionFits(header->stringsOffset, header->stringsSize, 1, outFile->dataSize) &&
+            (header->stringsSize > 0) && (data8[header->stringsOffset + header->stringsSize - 1] == 0) &&
+            !(header->nodesOffset & 3) && !(header->childrenOffset & 3) &&
+            nodesValid(header, (const struct ASTFileNode*) &data8[header->nodesOffset], (const uint32_t*) &data8[header->childrenOffset]);
+    if (!valid) {
+        NERROR("ASTSerialization.loadASTFile()", "Not a valid AST file: %s%s%s", NTCOLOR(HIGHLIGHT), filePath, NTCOLOR(STREAM_DEFAULT));
+        unloadASTFile(outFile);
+        return False;
+    }
+
+    outFile->header = header;
+    outFile->nodes = (const struct ASTFileNode*) &data8[header->nodesOffset];
+    outFile->children = (const uint32_t*) &data8[header->childrenOffset];
+    outFile->strings = &data8[header->stringsOffset];
+    return True;
+}
+
+void unloadASTFile(struct ASTFile* file) {
+    if (!file->data) return;
+    if (file->mapped) {
+        #ifdef DESKTOP
+        munmap(file->data, file->dataSize);
+        #endif
+    } else {
+        NFREE(file->data, "ASTSerialization.unloadASTFile() file->data");
+    }
+    NSystemUtils.memset(file, 0, sizeof(struct ASTFile));
+}
+
+const struct ASTFileNode* getASTFileRoot(const struct ASTFile* file) {
+    return &file->nodes[file->header->rootNodeIndex];
+}
+
+const struct ASTFileNode* getASTFileChild(const struct ASTFile* file, const struct ASTFileNode* node, int32_t childIndex) {
+    return &file->nodes[file->children[node->firstChildOffset + childIndex]];
+}
+
+const char* getASTFileNodeName(const struct ASTFile* file, const struct ASTFileNode* node) {
+    return &file->strings[node->nameOffset];
+}
+
+const char* getASTFileNodeValue(const struct ASTFile* file, const struct ASTFileNode* node) {
+    return &file->strings[node->valueOffset];
+}
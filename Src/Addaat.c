@@ -8,132 +8,1041 @@
 
 #include <LanguageDefinition.h>
 #include <CodeGeneration.h>
+#include <CommandLine.h>
+#include <BatchTranslation.h>
+#include <TranslationCache.h>
+#include <TranslationServer.h>
+#include <StandardStreams.h>
+#include <ASTSerialization.h>
+#include <Timing.h>
+#include <RuleProfiler.h>
+#include <Benchmark.h>
+#include <GrammarAnalyzer.h>
+#include <TreeComparison.h>
+#include <NestingLimits.h>
+#include <PerformanceFuzzer.h>
+#include <Preprocessing.h>
+#include <LazyFunctions.h>
+#include <Utf8.h>
 
 #include <NCC.h>
 #include <NSystemUtils.h>
 #include <NCString.h>
 #include <NError.h>
+#include <AllocationProfiler.h> // After NSystemUtils.h, to reroute NMALLOC/NFREE.
+
+#ifdef DESKTOP
+#include <stdlib.h>
+#endif
+
+#include <errno.h>
+#include <sys/stat.h>
 
 #define PRINT_TREES 1
-#define PRINT_COLORED_TREES 1
 
 #define PERFORM_ERROR_CHECKING_TESTS 0
 #define PERFORM_REGULAR_TESTS 0
 
-static boolean generate(struct NCC* ncc, const char* code, struct NString* outCode);
+// Starts every header written for the symbols alone. A header without it wasn't written by us, and
+// is never overwritten,
+#define SYMBOLS_HEADER_MARKER "// Generated by addaat --symbols-only. Don't edit, it's overwritten on every run.\n"
+
+struct TranslationOptions {
+
+    // Matches, generates and writes one external-declaration at a time instead of the whole
+    // translation-unit at once. Only the symbols are kept between declarations,
+    boolean stream;
+
+    // Reads the code from the standard input and writes the generated code to the standard output
+    // as each external-declaration completes. Implies streaming,
+    boolean pipe;
+
+    // Matches a preprocessed copy of the code, without comments and with at most a space between
+    // tokens (see Preprocessing.h). Errors are still reported at the original lines and columns,
+    boolean preprocess;
+
+    // Generates the symbols alone (extern globals, classes and function declarations) into an
+    // include-guarded .h file, refusing to overwrite one it didn't write. Function bodies are
+    // skipped by a balanced brace scan instead of being matched. Implies streaming,
+    boolean symbolsOnly;
 
-static void test(struct NCC* ncc, const char* code) {
+    boolean printTrees;
+    boolean writeASTFiles; // A binary .ast file next to each generated .c file.
+    boolean logGeneratedCode;
+    boolean colorize;   // Terminal colors in the printed trees and generated code.
+    struct CodeGenerationOptions codeGenerationOptions;
+
+    // Translates all the input files (or directories) over a pool of workers,
+    boolean batch;
+    int32_t workersCount;
+
+    // Skips translating files whose generated code is already cached,
+    struct TranslationCache* cache;
+    struct NString cacheConfiguration; // Everything besides the input that affects the output.
+
+    // If set, generate() measures its stages into it (see Benchmark.h),
+    struct TranslationMeasurements* measurements;
+};
+
+static boolean generate(struct NCC* ncc, const char* code, struct TranslationOptions* options, struct ASTWriter* astWriter, struct NString* outCode);
+
+static void test(struct NCC* ncc, struct TranslationOptions* options, const char* code) {
     NLOGI("", "%sTesting: %s%s", NTCOLOR(GREEN_BRIGHT), NTCOLOR(BLUE_BRIGHT), code);
 
     struct NString generatedCode;
     NString.initialize(&generatedCode, "");
-    generate(ncc, code, &generatedCode);
+    generate(ncc, code, options, 0, &generatedCode);
     NLOGI(0, "%s", NString.get(&generatedCode));
     NString.destroy(&generatedCode);
 }
 
-static boolean generate(struct NCC* ncc, const char* code, struct NString* outCode) {
+// When the code was preprocessed, the offsets are in the preprocessed code, and the preprocessor
+// maps them back. Destroys the error info,
+static void reportTakenMatchingError(struct MatchingErrorInfo* errorInfo, const char* code, const struct Preprocessor* preprocessor, int32_t matchOffset, boolean matched, int32_t matchLength) {
+
+    struct NString errorMessage;
+    NString.initialize(&errorMessage, "Failed! Match: %s, length: %d\n", matched ? "True" : "False", matchLength);
+
+    // Find the line and column numbers,
+    int32_t line=1, column=1;
+    int32_t maxMatchOffset = matchOffset + errorInfo->maxMatchLength;
+    if (preprocessor) {
+        int32_t originalOffset;
+        getOriginalPosition(preprocessor, maxMatchOffset, &originalOffset, &line, &column);
+    } else {
+        for (int32_t i=0; i<maxMatchOffset; i++) {
+            if (code[i] == '\n') {
+                line++;
+                column = 1;
+            } else {
+                column++;
+            }
+        }
+    }
+    NString.append(&errorMessage, "          Max match length: %d, line: %d, column: %d\n", errorInfo->maxMatchLength, line, column);
+
+    // Print parent rules,
+    int32_t rulesCount = NVector.size(&errorInfo->ruleStack);
+    for (int32_t i=0; i<rulesCount; i++) NString.append(&errorMessage, "            %s\n", *(const char**) NVector.get(&errorInfo->ruleStack, i));
+    NVector.destroy(&errorInfo->ruleStack);
+
+    // Print the error message,
+    NERROR(0, "%s", NString.get(&errorMessage));
+    NString.destroy(&errorMessage);
+}
+
+static void reportMatchingError(struct NCC* ncc, const char* code, const struct Preprocessor* preprocessor, int32_t matchOffset, boolean matched, int32_t matchLength) {
+    struct MatchingErrorInfo errorInfo;
+    takeMatchingErrorInfo(ncc, &errorInfo);
+    reportTakenMatchingError(&errorInfo, code, preprocessor, matchOffset, matched, matchLength);
+}
+
+// The whole code at once. Returns the preprocessed code,
+static const char* preprocess(struct Preprocessor* preprocessor, const char* code) {
+    TIMING_BEGIN("preprocess")
+    MEMORY_PHASE_BEGIN("preprocess")
+    initializePreprocessor(preprocessor);
+    preprocessCode(preprocessor, code, NCString.length(code));
+    finishPreprocessing(preprocessor);
+    MEMORY_PHASE_END
+    TIMING_END
+    return preprocessor->code;
+}
+
+static boolean generate(struct NCC* ncc, const char* code, struct TranslationOptions* options, struct ASTWriter* astWriter, struct NString* outCode) {
+
+    struct TranslationMeasurements* measurements = options->measurements;
+    int64_t stageStartTime = 0;
+    if (measurements) {
+        resetPeakResidentSize();
+        stageStartTime = getMonotonicTime();
+    }
+
+    // Too deeply nested code is rejected before the matcher recurses into it, and so are invalid
+    // UTF-8 sequences, which would otherwise be reported as whatever rule failed on them,
+    if (!checkNestingDepth(code, options->codeGenerationOptions.maxNestingDepth)) return False;
+    if (!checkUtf8(code, NCString.length(code))) return False;
+
+    struct Preprocessor preprocessor;
+    if (options->preprocess) code = preprocess(&preprocessor, code);
 
     boolean success = False;
     NCC_MatchingResult matchingResult;
     NCC_ASTNode_Data tree;
     NCC_Rule *rootRule = getRootRule(ncc);
+    TIMING_BEGIN("match")
+    MEMORY_PHASE_BEGIN("parse")
     boolean matched = NCC_match(ncc, rootRule, code, &matchingResult, &tree);
+    MEMORY_PHASE_END
+    TIMING_END
+    if (measurements) {
+        measurements->parseDuration = getMonotonicTime() - stageStartTime;
+        measurements->parsePeakResidentKilobytes = readPeakResidentKilobytes();
+    }
     if (matched && tree.node) {
 
         // Print tree,
-        #if PRINT_TREES
-        NString.set(outCode, "");
-        NCC_ASTTreeToString(tree.node, 0, outCode, PRINT_COLORED_TREES /* should check isatty() */);
-        NLOGI(0, "%s", NString.get(outCode));
-        #endif
+        if (options->printTrees) {
+            TIMING_BEGIN("print-trees")
+            NString.set(outCode, "");
+            NCC_ASTTreeToString(tree.node, 0, outCode, options->colorize);
+            NLOGI(0, "%s", NString.get(outCode));
+            TIMING_END
+        }
+        if (astWriter) {
+            TIMING_BEGIN("serialize-tree")
+            addASTWriterTree(astWriter, tree.node);
+            TIMING_END
+        }
 
         // Generate code,
+        if (measurements) {
+            measurements->astNodesCount = countASTNodes(tree.node);
+            resetPeakResidentSize();
+            stageStartTime = getMonotonicTime();
+        }
+        TIMING_BEGIN("generate-code")
+        MEMORY_PHASE_BEGIN("codegen")
         NString.set(outCode, "");
-        success = generateCode(tree.node, outCode);
+        success = generateCode(tree.node, &options->codeGenerationOptions, outCode);
+        MEMORY_PHASE_END
+        TIMING_END
+        if (measurements) {
+            measurements->codeGenerationDuration = getMonotonicTime() - stageStartTime;
+            measurements->codeGenerationPeakResidentKilobytes = readPeakResidentKilobytes();
+        }
 
         // Cleanup,
+        TIMING_BEGIN("delete-tree")
         NCC_deleteASTNode(&tree, 0);
+        TIMING_END
     }
     int32_t codeLength = NCString.length(code);
     if (matched && matchingResult.matchLength == codeLength) {
         NLOGI(0, "Success!");
     } else {
         success = False;
-        struct NString errorMessage;
-        NString.initialize(&errorMessage, "Failed! Match: %s, length: %d\n", matched ? "True" : "False", matchingResult.matchLength);
+        reportMatchingError(ncc, code, options->preprocess ? &preprocessor : 0, 0, matched, matchingResult.matchLength);
+    }
+    NLOGI("", "");
 
-        // Find the line and column numbers,
-        int32_t line=1, column=1;
-        for (int32_t i=0; i<ncc->maxMatchLength; i++) {
-            if (code[i] == '\n') {
-                line++;
-                column = 1;
+    if (options->preprocess) destroyPreprocessor(&preprocessor);
+    return success;
+}
+
+// The include guard of a header written for the symbols alone, from its file name (foo.h to
+// ADDAAT_FOO_H),
+static void getHeaderGuardName(const char* headerFilePath, struct NString* outName) {
+    const char* fileName = headerFilePath;
+    for (const char* character=headerFilePath; *character; character++) if (*character == '/') fileName = character+1;
+    NString.set(outName, "ADDAAT_");
+    for (; *fileName; fileName++) {
+        char character = *fileName;
+        if ((character >= 'a') && (character <= 'z')) character += 'A' - 'a';
+        if (!(((character >= 'A') && (character <= 'Z')) || ((character >= '0') && (character <= '9')))) character = '_';
+        NString.append(outName, "%c", character);
+    }
+}
+
+// True if there's no such file, or it's a header we wrote before (it starts with the marker),
+static boolean canOverwriteSymbolsHeader(const char* headerFilePath) {
+    struct stat fileStat;
+    if (stat(headerFilePath, &fileStat)) return errno == ENOENT;
+    int32_t markerLength = NCString.length(SYMBOLS_HEADER_MARKER);
+    if (!S_ISREG(fileStat.st_mode) || (fileStat.st_size < markerLength)) return False;
+
+    char* fileStart = NMALLOC(markerLength+1, "Addaat.canOverwriteSymbolsHeader() fileStart");
+    NSystemUtils.readFromFile(headerFilePath, False, 0, markerLength, fileStart);
+    fileStart[markerLength] = 0;
+    boolean generated = NCString.equals(fileStart, SYMBOLS_HEADER_MARKER);
+    NFREE(fileStart, "Addaat.canOverwriteSymbolsHeader() fileStart");
+    return generated;
+}
+
+static boolean generateStreamed(struct NCC* ncc, const char* code, struct TranslationOptions* options, struct ASTWriter* astWriter, const char* outputFilePath) {
+
+    if (!checkNestingDepth(code, options->codeGenerationOptions.maxNestingDepth)) return False;
+    if (!checkUtf8(code, NCString.length(code))) return False;
+
+    struct Preprocessor preprocessor;
+    if (options->preprocess) code = preprocess(&preprocessor, code);
+
+    NCC_Rule* ignorablesRule = getIgnorablesRule(ncc);
+    NCC_Rule* externalDeclarationRule = getExternalDeclarationRule(ncc);
+    struct CodeGenerationData* codeGenerationData = createCodeGenerationData(&options->codeGenerationOptions);
+
+    struct NString generatedCode;
+    NString.initialize(&generatedCode, "");
+
+    // Start with an empty output file. A header starts with the marker and an include guard,
+    if (options->symbolsOnly) {
+        struct NString guardName;
+        NString.initialize(&guardName, "");
+        getHeaderGuardName(outputFilePath, &guardName);
+        NString.set(&generatedCode, "%s#ifndef %s\n#define %s\n\n", SYMBOLS_HEADER_MARKER, NString.get(&guardName), NString.get(&guardName));
+        NString.destroy(&guardName);
+    }
+    NSystemUtils.writeToFile(outputFilePath, NString.get(&generatedCode), NString.length(&generatedCode), False);
+
+    boolean success = True;
+    int32_t codeLength = NCString.length(code);
+    int32_t offset = 0;
+    while (True) {
+
+        // Skip white-spaces and comments,
+        NCC_MatchingResult matchingResult;
+        NCC_ASTNode_Data tree;
+        TIMING_BEGIN("skip-ignorables")
+        if (NCC_match(ncc, ignorablesRule, &code[offset], &matchingResult, &tree)) {
+            if (tree.node) NCC_deleteASTNode(&tree, 0);
+            offset += matchingResult.matchLength;
+        }
+        TIMING_END
+        if (offset >= codeLength) break;
+        TIMING_BEGIN_WITH_ARGUMENT("external-declaration", "offset", offset)
+
+        // Match a single external declaration. For the symbols alone, a function-definition's head
+        // is matched on its own, and the body is left unmatched,
+        TIMING_BEGIN("match")
+        MEMORY_PHASE_BEGIN("parse")
+        struct LazyFunction lazyFunction;
+        boolean lazy = options->symbolsOnly && matchLazyFunction(ncc, code, offset, codeLength, &lazyFunction, &tree);
+        boolean matched = lazy || NCC_match(ncc, externalDeclarationRule, &code[offset], &matchingResult, &tree);
+        if (lazy) matchingResult.matchLength = lazyFunction.length;
+        MEMORY_PHASE_END
+        TIMING_END
+        if (!matched || !tree.node) {
+            TIMING_END
+            reportMatchingError(ncc, code, options->preprocess ? &preprocessor : 0, offset, matched, matchingResult.matchLength);
+            success = False;
+            break;
+        }
+
+        // Print tree,
+        if (options->printTrees) {
+            TIMING_BEGIN("print-trees")
+            NString.set(&generatedCode, "");
+            NCC_ASTTreeToString(tree.node, 0, &generatedCode, options->colorize);
+            NLOGI(0, "%s", NString.get(&generatedCode));
+            TIMING_END
+        }
+        if (astWriter) {
+            TIMING_BEGIN("serialize-tree")
+            addASTWriterTree(astWriter, tree.node);
+            TIMING_END
+        }
+
+        // Generate code, then drop the tree right away,
+        TIMING_BEGIN("generate-code")
+        MEMORY_PHASE_BEGIN("codegen")
+        boolean generated = lazy ?
+                generateFunctionHeadDeclarationCode(tree.node, codeGenerationData, &generatedCode) :
+                generateExternalDeclarationCode    (tree.node, codeGenerationData, &generatedCode);
+        MEMORY_PHASE_END
+        TIMING_END
+        TIMING_BEGIN("delete-tree")
+        NCC_deleteASTNode(&tree, 0);
+        TIMING_END
+        if (!generated) {
+            TIMING_END
+            success = False;
+            break;
+        }
+
+        // Flush,
+        TIMING_BEGIN("write")
+        if (options->logGeneratedCode) NLOGI(0, "%s", NString.get(&generatedCode));
+        NSystemUtils.writeToFile(outputFilePath, NString.get(&generatedCode), NString.length(&generatedCode), True);
+        TIMING_END
+        offset += matchingResult.matchLength;
+        TIMING_END
+    }
+
+    if (success && options->symbolsOnly) NSystemUtils.writeToFile(outputFilePath, "#endif\n", 7, True);
+    if (success) NLOGI(0, "Success!");
+    NLOGI("", "");
+
+    // Clean up,
+    if (options->preprocess) destroyPreprocessor(&preprocessor);
+    NString.destroy(&generatedCode);
+    destroyAndDeleteCodeGenerationData(codeGenerationData);
+    return success;
+}
+
+static boolean generatePiped(struct NCC* ncc, struct TranslationOptions* options, int32_t outputFileDescriptor) {
+
+    NCC_Rule* ignorablesRule = getIgnorablesRule(ncc);
+    NCC_Rule* externalDeclarationRule = getExternalDeclarationRule(ncc);
+    struct CodeGenerationData* codeGenerationData = createCodeGenerationData(&options->codeGenerationOptions);
+
+    struct NString generatedCode;
+    NString.initialize(&generatedCode, "");
+
+    // Everything read is kept, so that errors report the right lines. When preprocessing, the
+    // buffer only holds the last read, and the preprocessor keeps the preprocessed code instead,
+    int32_t capacity = 64 * 1024, size = 0, offset = 0;
+    char* readBuffer = NMALLOC(capacity, "Addaat.generatePiped() readBuffer");
+    readBuffer[0] = 0;
+    char* code = readBuffer;
+    boolean endOfInput = False;
+    struct Preprocessor preprocessor;
+    if (options->preprocess) {
+        initializePreprocessor(&preprocessor);
+        code = preprocessor.code;
+    }
+
+    // Scanned as it's read,
+    struct NestingScanner nestingScanner;
+    initializeNestingScanner(&nestingScanner, options->codeGenerationOptions.maxNestingDepth);
+    struct Utf8Validator utf8Validator;
+    initializeUtf8Validator(&utf8Validator);
+
+    boolean success = True;
+    while (True) {
+
+        // Skip white-spaces and comments. Unless the input has ended, a skip that reaches the end
+        // of what's read so far could be an unfinished comment,
+        NCC_MatchingResult matchingResult;
+        NCC_ASTNode_Data tree;
+        boolean needsMoreInput = False;
+        if ((offset < size) && NCC_match(ncc, ignorablesRule, &code[offset], &matchingResult, &tree)) {
+            if (tree.node) NCC_deleteASTNode(&tree, 0);
+            if (endOfInput || (offset + matchingResult.matchLength < size)) {
+                offset += matchingResult.matchLength;
             } else {
-                column++;
+                needsMoreInput = True;
             }
         }
-        NString.append(&errorMessage, "          Max match length: %d, line: %d, column: %d\n", ncc->maxMatchLength, line, column);
 
-        // Print parent rules,
-        const char* ruleName;
-        while (NVector.popBack(&ncc->maxMatchRuleStack, &ruleName)) NString.append(&errorMessage, "            %s\n", ruleName);
+        // Match a single external declaration. They all end with a ';' or a '}', so a match is
+        // final even if more input is on the way,
+        if (!needsMoreInput && (offset < size)) {
+            TIMING_BEGIN_WITH_ARGUMENT("external-declaration", "offset", offset)
+            TIMING_BEGIN("match")
+            MEMORY_PHASE_BEGIN("parse")
+            boolean matched = NCC_match(ncc, externalDeclarationRule, &code[offset], &matchingResult, &tree);
+            MEMORY_PHASE_END
+            TIMING_END
+            if (matched && tree.node) {
+
+                // Generate code, then drop the tree right away,
+                TIMING_BEGIN("generate-code")
+                MEMORY_PHASE_BEGIN("codegen")
+                boolean generated = generateExternalDeclarationCode(tree.node, codeGenerationData, &generatedCode);
+                MEMORY_PHASE_END
+                TIMING_END
+                TIMING_BEGIN("delete-tree")
+                NCC_deleteASTNode(&tree, 0);
+                TIMING_END
+                if (!generated) {
+                    TIMING_END
+                    success = False;
+                    break;
+                }
+
+                // Flush,
+                TIMING_BEGIN("write")
+                boolean written = writeToFileDescriptor(outputFileDescriptor, NString.get(&generatedCode), NString.length(&generatedCode));
+                TIMING_END
+                TIMING_END
+                if (!written) {
+                    NERROR("Addaat.generatePiped()", "Couldn't write to the standard output.");
+                    success = False;
+                    break;
+                }
+                offset += matchingResult.matchLength;
+                continue;
+            }
+            TIMING_END
+            if (matched) {
+                reportMatchingError(ncc, code, options->preprocess ? &preprocessor : 0, offset, matched, matchingResult.matchLength);
+                success = False;
+                break;
+            }
 
-        // Print the error message,
-        NERROR(0, "%s", NString.get(&errorMessage));
-        NString.destroy(&errorMessage);
+            // The failure is final if the match never got to the end of what's read so far, no
+            // further input can fix what comes before it. Unless all that's left is ignorables
+            // and a '/', which could be the start of a comment,
+            struct MatchingErrorInfo errorInfo;
+            takeMatchingErrorInfo(ncc, &errorInfo);
+            int32_t maxMatchOffset = offset + errorInfo.maxMatchLength;
+            if (!endOfInput && (maxMatchOffset < size) && (code[size-1] == '/')) {
+                NCC_MatchingResult ignorablesMatchingResult;
+                if (NCC_match(ncc, ignorablesRule, &code[maxMatchOffset], &ignorablesMatchingResult, &tree)) {
+                    if (tree.node) NCC_deleteASTNode(&tree, 0);
+                    if (maxMatchOffset + ignorablesMatchingResult.matchLength == size-1) maxMatchOffset = size;
+                }
+                discardMatchingErrorInfo(ncc);
+            }
+            if (endOfInput || (maxMatchOffset < size)) {
+                reportTakenMatchingError(&errorInfo, code, options->preprocess ? &preprocessor : 0, offset, matched, matchingResult.matchLength);
+                success = False;
+                break;
+            }
+            NVector.destroy(&errorInfo.ruleStack);
+        }
+        if (endOfInput && (offset >= size)) break;
+
+        // Read more,
+        int32_t readOffset = options->preprocess ? 0 : size;
+        if (readOffset == capacity - 1) {
+            char* largerReadBuffer = NMALLOC(capacity*2, "Addaat.generatePiped() largerReadBuffer");
+            NSystemUtils.memcpy(largerReadBuffer, readBuffer, size);
+            NFREE(readBuffer, "Addaat.generatePiped() readBuffer 1");
+            readBuffer = code = largerReadBuffer;
+            capacity *= 2;
+        }
+        TIMING_BEGIN("read")
+        int32_t readBytesCount = readStandardInput(&readBuffer[readOffset], capacity - readOffset - 1);
+        TIMING_END
+        if (readBytesCount < 0) {
+            NERROR("Addaat.generatePiped()", "Couldn't read from the standard input.");
+            success = False;
+            break;
+        }
+        if (!readBytesCount) endOfInput = True;
+        if (!scanNesting(&nestingScanner, &readBuffer[readOffset], readBytesCount) ||
+            !validateUtf8(&utf8Validator, &readBuffer[readOffset], readBytesCount) ||
+            (endOfInput && !finishUtf8Validation(&utf8Validator))) {
+            success = False;
+            break;
+        }
+        if (options->preprocess) {
+            TIMING_BEGIN("preprocess")
+            preprocessCode(&preprocessor, readBuffer, readBytesCount);
+            if (endOfInput) finishPreprocessing(&preprocessor);
+            TIMING_END
+            code = preprocessor.code;
+            size = preprocessor.length;
+        } else {
+            size += readBytesCount;
+            code[size] = 0;
+        }
     }
+
+    if (success) NLOGI(0, "Success!");
     NLOGI("", "");
 
+    // Clean up,
+    NFREE(readBuffer, "Addaat.generatePiped() readBuffer 2");
+    destroyNestingScanner(&nestingScanner);
+    if (options->preprocess) destroyPreprocessor(&preprocessor);
+    NString.destroy(&generatedCode);
+    destroyAndDeleteCodeGenerationData(codeGenerationData);
     return success;
 }
 
-static boolean translateSingleFile(struct NCC* ncc, char* filePath) {
+static boolean translateSingleFile(struct NCC* ncc, const char* filePath, struct TranslationOptions* options) {
 
     if (!NCString.endsWith(filePath, ".addaat")) {
         NERROR("Addaat.translateSingleFile()", "Expecting a %s.addaat%s file, found: %s%s%s", NTCOLOR(HIGHLIGHT), NTCOLOR(STREAM_DEFAULT), NTCOLOR(HIGHLIGHT), filePath, NTCOLOR(STREAM_DEFAULT));
         return False;
     }
 
+    TIMING_BEGIN("translate-file")
+
     // Read input file,
+    TIMING_BEGIN("read")
     uint32_t fileSize = NSystemUtils.getFileSize(filePath, False);
     char* code = NMALLOC(fileSize+1, "Addaat.translateSingleFile() code");
     NSystemUtils.readFromFile(filePath, False, 0, 0, code);
     code[fileSize] = 0;
+    TIMING_END
 
-    // Generate code,
-    struct NString generatedCode;
-    NString.initialize(&generatedCode, "");
-    boolean success = generate(ncc, code, &generatedCode);
-    NFREE(code, "Addaat.translateSingleFile() code");
-    NLOGI(0, "%s", NString.get(&generatedCode));
-
-    // Generate output file name (.addaat to .c),
+    // Generate output file name (.addaat to .c, or .h for the symbols alone),
     struct NString* outputFilePath = NString.create("%s", filePath);
     struct NString* tempString = NString.subString(outputFilePath, 0, NCString.length(filePath)-6);
-    NString.set(outputFilePath, "%sc", NString.get(tempString));
+    NString.set(outputFilePath, options->symbolsOnly ? "%sh" : "%sc", NString.get(tempString));
     NString.destroyAndFree(tempString);
 
-    // Write to output file,
-    NSystemUtils.writeToFile(NString.get(outputFilePath), NString.get(&generatedCode), NString.length(&generatedCode), False);
-    NString.destroyAndFree(outputFilePath);
-    NString.destroy(&generatedCode);
+    // Don't clobber a header that someone else wrote,
+    boolean success;
+    struct NString cacheKey;
+    NString.initialize(&cacheKey, "");
+    if (options->symbolsOnly && !canOverwriteSymbolsHeader(NString.get(outputFilePath))) {
+        NERROR("Addaat.translateSingleFile()", "%s%s%s exists and wasn't generated by %s--symbols-only%s, not overwriting it.",
+                NTCOLOR(HIGHLIGHT), NString.get(outputFilePath), NTCOLOR(STREAM_DEFAULT), NTCOLOR(HIGHLIGHT), NTCOLOR(STREAM_DEFAULT));
+        NFREE(code, "Addaat.translateSingleFile() code 0");
+        success = False;
+        goto finish;
+    }
 
+    // Look it up in the cache (unless the tree or the class layouts are needed too). A header's
+    // include guard follows its file name, so the name is part of its key,
+    if (options->cache) {
+        struct NString configuration;
+        NString.initialize(&configuration, "%s", NString.get(&options->cacheConfiguration));
+        if (options->symbolsOnly) {
+            struct NString guardName;
+            NString.initialize(&guardName, "");
+            getHeaderGuardName(NString.get(outputFilePath), &guardName);
+            NString.append(&configuration, "\nguard: %s", NString.get(&guardName));
+            NString.destroy(&guardName);
+        }
+        computeTranslationCacheKey(code, fileSize, NString.get(&configuration), &cacheKey);
+        NString.destroy(&configuration);
+    }
+    if (options->cache && !options->writeASTFiles && !options->codeGenerationOptions.printClassLayouts) {
+        TIMING_BEGIN("cache-lookup")
+        struct NString cachedCode;
+        NString.initialize(&cachedCode, "");
+        success = getCachedTranslation(options->cache, NString.get(&cacheKey), &cachedCode);
+        if (success) {
+            if (options->logGeneratedCode) NLOGI(0, "%s", NString.get(&cachedCode));
+            NSystemUtils.writeToFile(NString.get(outputFilePath), NString.get(&cachedCode), NString.length(&cachedCode), False);
+        }
+        NString.destroy(&cachedCode);
+        TIMING_END
+        if (success) {
+            NFREE(code, "Addaat.translateSingleFile() code 1");
+            goto finish;
+        }
+    }
+
+    struct ASTWriter* astWriter = options->writeASTFiles ? createASTWriter() : 0;
+    if (options->stream || options->symbolsOnly) {
+        success = generateStreamed(ncc, code, options, astWriter, NString.get(outputFilePath));
+        NFREE(code, "Addaat.translateSingleFile() code 2");
+
+        // Cache what was written,
+        if (success && options->cache) {
+            TIMING_BEGIN("cache-store")
+            uint32_t outputFileSize = NSystemUtils.getFileSize(NString.get(outputFilePath), False);
+            char* generatedCode = NMALLOC(outputFileSize+1, "Addaat.translateSingleFile() generatedCode");
+            NSystemUtils.readFromFile(NString.get(outputFilePath), False, 0, 0, generatedCode);
+            putCachedTranslation(options->cache, NString.get(&cacheKey), generatedCode, outputFileSize);
+            NFREE(generatedCode, "Addaat.translateSingleFile() generatedCode");
+            TIMING_END
+        }
+    } else {
+
+        // Generate code,
+        struct NString generatedCode;
+        NString.initialize(&generatedCode, "");
+        success = generate(ncc, code, options, astWriter, &generatedCode);
+        NFREE(code, "Addaat.translateSingleFile() code 3");
+
+        // Write to output file,
+        TIMING_BEGIN("write")
+        if (options->logGeneratedCode) NLOGI(0, "%s", NString.get(&generatedCode));
+        NSystemUtils.writeToFile(NString.get(outputFilePath), NString.get(&generatedCode), NString.length(&generatedCode), False);
+        TIMING_END
+        if (success && options->cache) {
+            TIMING_BEGIN("cache-store")
+            putCachedTranslation(options->cache, NString.get(&cacheKey), NString.get(&generatedCode), NString.length(&generatedCode));
+            TIMING_END
+        }
+        NString.destroy(&generatedCode);
+    }
+
+    // Write the tree (.c to .ast). Streamed declarations are gathered under a single root,
+    if (astWriter) {
+        if (success) {
+            TIMING_BEGIN("write-tree")
+            struct NString* astFilePath = NString.subString(outputFilePath, 0, NString.length(outputFilePath)-1);
+            NString.append(astFilePath, "ast");
+            if (!writeASTFile(astWriter, options->stream ? "translation-unit" : 0, NString.get(astFilePath))) success = False;
+            NString.destroyAndFree(astFilePath);
+            TIMING_END
+        }
+        destroyAndDeleteASTWriter(astWriter);
+    }
+
+    finish:
+    NString.destroy(&cacheKey);
+    NString.destroyAndFree(outputFilePath);
+    TIMING_END
     return success;
 }
 
+static boolean translateBatchFile(struct NCC* ncc, const char* filePath, void* options) {
+    return translateSingleFile(ncc, filePath, options);
+}
+
+// Rejects values that don't fit an int32_t,
+static boolean parseNonNegativeInteger(const char* text, int32_t* outValue) {
+    int32_t value = 0;
+    if (!*text) return False;
+    for (; *text; text++) {
+        if ((*text < '0') || (*text > '9')) return False;
+        int32_t digit = *text - '0';
+        if (value > (INT32_MAX - digit) / 10) return False;
+        value = value*10 + digit;
+    }
+    *outValue = value;
+    return True;
+}
+
+static boolean parsePositiveInteger(const char* text, int32_t* outValue) {
+    return parseNonNegativeInteger(text, outValue) && (*outValue > 0);
+}
+
+// Options that pick what this run does, rather than how files are translated,
+struct RunOptions {
+    const char* cacheDirectory;
+    int32_t cacheSizeInMegabytes;
+
+    const char* serverSocketPath;
+    const char* clientSocketPath;
+    boolean sendSource;
+    int32_t timeoutSeconds;
+
+    // Timing (of the main process only, forked workers aren't included),
+    boolean printTimingSummary;
+    const char* traceFilePath;
+
+    // Per-rule matcher statistics (also of the main process only),
+    boolean profileRules;
+    int32_t profiledRulesCount;
+
+    // NMALLOC allocations by tag, and memory by phase,
+    boolean reportAllocations;
+
+    // Reports the grammar's nullable rules, FIRST sets and re-matching hot spots instead of
+    // translating,
+    boolean analyzeGrammar;
+
+    // Matches the input files with both the ordered-choice grammar and the unordered reference
+    // one, and fails if any of their trees differ,
+    boolean checkOrderedChoices;
+
+    // Matches and generates each input file several times, reporting the throughput as JSON,
+    const char* benchmarkReportPath;
+    struct BenchmarkOptions benchmarkOptions;
+
+    // Mutates the input files looking for the most matcher steps per byte, saving the slowest
+    // inputs to a directory. Or checks the saved ones against their recorded steps,
+    const char* fuzzOutputDirectory;
+    const char* fuzzCheckDirectory;
+    struct PerformanceFuzzerOptions fuzzerOptions;
+};
+
+static const char* getArgumentValue(struct NVector* arguments, int32_t* index) {
+    if (++(*index) >= NVector.size(arguments)) return "";
+    return NString.get(*(struct NString**) NVector.get(arguments, *index));
+}
+
+static boolean parseArguments(struct NVector* arguments, struct RunOptions* runOptions, struct TranslationOptions* options, struct NVector* outInputFiles) {
+
+    int32_t argumentsCount = NVector.size(arguments);
+    for (int32_t i=0; i<argumentsCount; i++) {
+        const char* argument = NString.get(*(struct NString**) NVector.get(arguments, i));
+        const char* value = 0;
+        if (NCString.equals(argument, "--colorize")) {
+            options->colorize = True;
+            options->codeGenerationOptions.colorize = True;
+        } else if (NCString.equals(argument, "--stream")) {
+            options->stream = True;
+        } else if (NCString.equals(argument, "--pipe")) {
+            options->pipe = True;
+        } else if (NCString.equals(argument, "--preprocess")) {
+            options->preprocess = True;
+        } else if (NCString.equals(argument, "--symbols-only")) {
+            options->symbolsOnly = True;
+            options->codeGenerationOptions.externVariables = True;
+        } else if (NCString.equals(argument, "--ast")) {
+            options->writeASTFiles = True;
+        } else if (NCString.equals(argument, "--no-trees")) {
+            options->printTrees = False;
+        } else if (NCString.equals(argument, "--cache")) {
+            value = getArgumentValue(arguments, &i);
+            runOptions->cacheDirectory = value;
+        } else if (NCString.equals(argument, "--cache-size")) {
+            value = getArgumentValue(arguments, &i);
+            if (!parsePositiveInteger(value, &runOptions->cacheSizeInMegabytes)) value = "";
+        } else if (NCString.equals(argument, "--batch")) {
+            options->batch = True;
+        } else if (NCString.equals(argument, "--jobs")) {
+            value = getArgumentValue(arguments, &i);
+            if (!parsePositiveInteger(value, &options->workersCount)) value = "";
+        } else if (NCString.equals(argument, "--server")) {
+            value = getArgumentValue(arguments, &i);
+            runOptions->serverSocketPath = value;
+        } else if (NCString.equals(argument, "--client")) {
+            value = getArgumentValue(arguments, &i);
+            runOptions->clientSocketPath = value;
+        } else if (NCString.equals(argument, "--send-source")) {
+            runOptions->sendSource = True;
+        } else if (NCString.equals(argument, "--timing")) {
+            runOptions->printTimingSummary = True;
+        } else if (NCString.equals(argument, "--trace")) {
+            value = getArgumentValue(arguments, &i);
+            runOptions->traceFilePath = value;
+        } else if (NCString.equals(argument, "--allocation-report")) {
+            runOptions->reportAllocations = True;
+        } else if (NCString.equals(argument, "--analyze-grammar")) {
+            runOptions->analyzeGrammar = True;
+        } else if (NCString.equals(argument, "--check-ordered-choices")) {
+            runOptions->checkOrderedChoices = True;
+        } else if (NCString.equals(argument, "--profile-rules")) {
+            runOptions->profileRules = True;
+        } else if (NCString.equals(argument, "--profile-top")) {
+            value = getArgumentValue(arguments, &i);
+            if (!parsePositiveInteger(value, &runOptions->profiledRulesCount)) value = "";
+        } else if (NCString.equals(argument, "--benchmark")) {
+            value = getArgumentValue(arguments, &i);
+            runOptions->benchmarkReportPath = value;
+        } else if (NCString.equals(argument, "--benchmark-runs")) {
+            value = getArgumentValue(arguments, &i);
+            if (!parsePositiveInteger(value, &runOptions->benchmarkOptions.runsCount)) value = "";
+        } else if (NCString.equals(argument, "--benchmark-baseline")) {
+            value = getArgumentValue(arguments, &i);
+            runOptions->benchmarkOptions.baselineFilePath = value;
+        } else if (NCString.equals(argument, "--benchmark-threshold")) {
+            value = getArgumentValue(arguments, &i);
+            if (!parsePositiveInteger(value, &runOptions->benchmarkOptions.throughputThreshold)) value = "";
+        } else if (NCString.equals(argument, "--benchmark-memory-threshold")) {
+            value = getArgumentValue(arguments, &i);
+            if (!parsePositiveInteger(value, &runOptions->benchmarkOptions.memoryThreshold)) value = "";
+        } else if (NCString.equals(argument, "--max-nesting-depth")) {
+            value = getArgumentValue(arguments, &i);
+            // 0 for unlimited,
+            if (!parseNonNegativeInteger(value, &options->codeGenerationOptions.maxNestingDepth)) value = "";
+        } else if (NCString.equals(argument, "--print-layouts")) {
+            options->codeGenerationOptions.printClassLayouts = True;
+        } else if (NCString.equals(argument, "--codegen-jobs")) {
+            // Experimental, see CodeGenerationOptions.workersCount,
+            value = getArgumentValue(arguments, &i);
+            if (!parsePositiveInteger(value, &options->codeGenerationOptions.workersCount)) value = "";
+        } else if (NCString.equals(argument, "--fuzz-performance")) {
+            value = getArgumentValue(arguments, &i);
+            runOptions->fuzzOutputDirectory = value;
+        } else if (NCString.equals(argument, "--fuzz-check")) {
+            value = getArgumentValue(arguments, &i);
+            runOptions->fuzzCheckDirectory = value;
+        } else if (NCString.equals(argument, "--fuzz-seconds")) {
+            value = getArgumentValue(arguments, &i);
+            if (!parsePositiveInteger(value, &runOptions->fuzzerOptions.durationSeconds)) value = "";
+        } else if (NCString.equals(argument, "--fuzz-seed")) {
+            value = getArgumentValue(arguments, &i);
+            if (!parsePositiveInteger(value, &runOptions->fuzzerOptions.seed)) value = "";
+        } else if (NCString.equals(argument, "--fuzz-max-length")) {
+            value = getArgumentValue(arguments, &i);
+            if (!parsePositiveInteger(value, &runOptions->fuzzerOptions.maxInputLength)) value = "";
+        } else if (NCString.equals(argument, "--fuzz-threshold")) {
+            value = getArgumentValue(arguments, &i);
+            if (!parsePositiveInteger(value, &runOptions->fuzzerOptions.stepsThreshold)) value = "";
+        } else if (NCString.equals(argument, "--timeout")) {
+            value = getArgumentValue(arguments, &i);
+            if (!parsePositiveInteger(value, &runOptions->timeoutSeconds)) value = "";
+        } else if (NCString.startsWith(argument, "--")) {
+            NERROR("Addaat.parseArguments()", "Unknown option: %s%s%s", NTCOLOR(HIGHLIGHT), argument, NTCOLOR(STREAM_DEFAULT));
+            return False;
+        } else {
+            NVector.pushBack(outInputFiles, &argument);
+        }
+
+        // Options that take a value,
+        if (value && !*value) {
+            NERROR("Addaat.parseArguments()", "Missing or invalid value for: %s%s%s", NTCOLOR(HIGHLIGHT), argument, NTCOLOR(STREAM_DEFAULT));
+            return False;
+        }
+    }
+
+    return True;
+}
+
+static boolean translateServerRequest(struct NCC* ncc, const char* code, struct NString* outCode, void* options) {
+    return generate(ncc, code, options, 0, outCode);
+}
+
+static boolean translateBenchmarkRun(struct NCC* ncc, const char* code, struct NString* outCode, struct TranslationMeasurements* outMeasurements, void* options) {
+    struct TranslationOptions measuredOptions = *(struct TranslationOptions*) options;
+    measuredOptions.measurements = outMeasurements;
+    return generate(ncc, code, &measuredOptions, 0, outCode);
+}
+
+// What the translation needs, so that it can run on a stack sized for the nesting limit,
+struct TranslationRun {
+    struct NCC* ncc;
+    struct RunOptions* runOptions;
+    struct TranslationOptions* options;
+    struct NVector* inputFiles;
+    int32_t pipeOutputFileDescriptor;
+    boolean success;
+};
+
+static void translate(void* translationRunData) {
+
+    struct TranslationRun* run = translationRunData;
+    struct RunOptions* runOptions = run->runOptions;
+    struct TranslationOptions* options = run->options;
+
+    boolean success = True;
+    if (runOptions->checkOrderedChoices) {
+        struct NCC referenceNcc;
+        NCC_initializeNCC(&referenceNcc);
+        defineUnorderedLanguage(&referenceNcc);
+        success = compareGrammarTrees(run->ncc, &referenceNcc, run->inputFiles);
+        NCC_destroyNCC(&referenceNcc);
+    } else if (runOptions->fuzzOutputDirectory || runOptions->fuzzCheckDirectory) {
+        runOptions->fuzzerOptions.maxNestingDepth = options->codeGenerationOptions.maxNestingDepth;
+        if (runOptions->fuzzOutputDirectory) {
+            runOptions->fuzzerOptions.outputDirectory = runOptions->fuzzOutputDirectory;
+            success = runPerformanceFuzzer(run->ncc, run->inputFiles, &runOptions->fuzzerOptions);
+        } else {
+            runOptions->fuzzerOptions.outputDirectory = runOptions->fuzzCheckDirectory;
+            success = checkSlowInputs(run->ncc, &runOptions->fuzzerOptions);
+        }
+    } else if (runOptions->benchmarkReportPath) {
+        runOptions->benchmarkOptions.reportFilePath = runOptions->benchmarkReportPath;
+        runOptions->benchmarkOptions.translator = translateBenchmarkRun;
+        runOptions->benchmarkOptions.translatorData = options;
+        success = runBenchmark(run->ncc, run->inputFiles, &runOptions->benchmarkOptions);
+    } else if (options->pipe) {
+        success = generatePiped(run->ncc, options, run->pipeOutputFileDescriptor);
+    } else if (runOptions->serverSocketPath) {
+        success = runTranslationServer(run->ncc, runOptions->serverSocketPath, runOptions->timeoutSeconds, translateServerRequest, options);
+    } else if (options->batch) {
+        success = translateBatch(run->ncc, run->inputFiles, options->workersCount, translateBatchFile, options);
+    } else {
+        int32_t inputFilesCount = NVector.size(run->inputFiles);
+        for (int32_t i=0; i<inputFilesCount; i++) {
+            if (!translateSingleFile(run->ncc, *(const char**) NVector.get(run->inputFiles, i), options)) success = False;
+        }
+    }
+
+    run->success = success;
+}
+
 void NMain() {
 
+    // Parse arguments,
+    struct RunOptions runOptions;
+    NSystemUtils.memset(&runOptions, 0, sizeof(struct RunOptions));
+    runOptions.cacheSizeInMegabytes = 256;
+    runOptions.timeoutSeconds = 30;
+    runOptions.profiledRulesCount = 30;
+    runOptions.benchmarkOptions.runsCount = 5;
+    runOptions.benchmarkOptions.throughputThreshold = 5;
+    runOptions.benchmarkOptions.memoryThreshold = 10;
+    runOptions.fuzzerOptions.durationSeconds = 60;
+    runOptions.fuzzerOptions.seed = 1;
+    runOptions.fuzzerOptions.maxInputLength = 4096;
+    runOptions.fuzzerOptions.slowInputsCount = 10;
+    runOptions.fuzzerOptions.stepsThreshold = 5;
+
+    struct TranslationOptions options;
+    NSystemUtils.memset(&options, 0, sizeof(struct TranslationOptions));
+    options.printTrees = PRINT_TREES;
+    options.logGeneratedCode = True;
+    options.workersCount = getAvailableProcessorsCount();
+    options.codeGenerationOptions.maxNestingDepth = DEFAULT_MAX_NESTING_DEPTH;
+
+    struct NVector arguments, inputFiles;
+    loadCommandLineArguments(&arguments);
+    NVector.initialize(&inputFiles, 0, sizeof(const char*));
+    boolean argumentsValid = parseArguments(&arguments, &runOptions, &options, &inputFiles);
+    if (options.batch || runOptions.serverSocketPath || options.pipe || runOptions.benchmarkReportPath || runOptions.checkOrderedChoices ||
+        runOptions.fuzzOutputDirectory || runOptions.fuzzCheckDirectory) {
+        // Thousands of files (or requests), a pipeline to feed or a stopwatch running, just report
+        // the results,
+        options.printTrees = False;
+        options.logGeneratedCode = False;
+    }
+    if (!NVector.size(&inputFiles)) {
+        const char* defaultInputFile = "testCode.addaat";
+        NVector.pushBack(&inputFiles, &defaultInputFile);
+    }
+
+    // In pipe mode, the standard output carries the generated code only,
+    int32_t pipeOutputFileDescriptor = -1;
+    if (argumentsValid && options.pipe) {
+        pipeOutputFileDescriptor = detachStandardOutput();
+        if (pipeOutputFileDescriptor < 0) argumentsValid = False;
+    }
+
+    // The client only forwards to a server, it doesn't need a grammar (nor a banner polluting
+    // the generated code it writes),
+    if (runOptions.clientSocketPath) {
+        boolean success = argumentsValid && runTranslationClient(runOptions.clientSocketPath, *(const char**) NVector.get(&inputFiles, 0), runOptions.sendSource);
+        NVector.destroy(&inputFiles);
+        destroyCommandLineArguments(&arguments);
+        NError.logAndTerminate();
+        #ifdef DESKTOP
+        if (!success) exit(EXIT_FAILURE);
+        #endif
+        return;
+    }
+
     NSystemUtils.logI("", "besm Allah :)\n\n");
 
-    // Language definition,
+    // Timing,
+    if (argumentsValid && (runOptions.printTimingSummary || runOptions.traceFilePath)) {
+        if (!enableTiming()) argumentsValid = False;
+    }
+
+    // Allocations,
+    if (argumentsValid && runOptions.reportAllocations) {
+        #if ADDAAT_PROFILE_ALLOCATIONS
+        enableMemoryPhases();
+        #else
+        NERROR("Addaat.NMain()", "Allocation profiling was compiled out. Rebuild with %sADDAAT_PROFILE_ALLOCATIONS=1%s.", NTCOLOR(HIGHLIGHT), NTCOLOR(STREAM_DEFAULT));
+        argumentsValid = False;
+        #endif
+    }
+
+    // Language definition. Fuzzing counts the matcher's steps with the rule profiler,
+    boolean profiled = runOptions.profileRules || runOptions.fuzzOutputDirectory || runOptions.fuzzCheckDirectory;
     struct NCC ncc;
     NCC_initializeNCC(&ncc);
-    defineLanguage(&ncc);
+    TIMING_BEGIN("define-language")
+    struct GrammarAnalyzer* grammarAnalyzer = 0;
+    if (runOptions.analyzeGrammar) {
+        grammarAnalyzer = createGrammarAnalyzer();
+        defineAnalyzedLanguage(&ncc, grammarAnalyzer);
+    } else if (profiled) {
+        initializeRuleProfiler();
+        defineProfiledLanguage(&ncc);
+    } else {
+        defineLanguage(&ncc);
+    }
+    TIMING_END
+
+    // Preprocessing only applies to translation. The grammar tools match the code as written,
+    if (options.preprocess) {
+        if (runOptions.analyzeGrammar || runOptions.checkOrderedChoices || runOptions.benchmarkReportPath ||
+            runOptions.fuzzOutputDirectory || runOptions.fuzzCheckDirectory) {
+            NERROR("Addaat.NMain()", "%s--preprocess%s only applies to translation.", NTCOLOR(HIGHLIGHT), NTCOLOR(STREAM_DEFAULT));
+            argumentsValid = False;
+        } else {
+            definePreprocessing(&ncc);
+        }
+    }
+
+    // The symbols alone are written one declaration at a time, to files,
+    if (options.symbolsOnly && (options.pipe || runOptions.serverSocketPath || options.writeASTFiles)) {
+        NERROR("Addaat.NMain()", "%s--symbols-only%s doesn't combine with %s--pipe%s, %s--server%s or %s--ast%s.",
+                NTCOLOR(HIGHLIGHT), NTCOLOR(STREAM_DEFAULT), NTCOLOR(HIGHLIGHT), NTCOLOR(STREAM_DEFAULT), NTCOLOR(HIGHLIGHT), NTCOLOR(STREAM_DEFAULT), NTCOLOR(HIGHLIGHT), NTCOLOR(STREAM_DEFAULT));
+        argumentsValid = False;
+    }
+
+    // Function bodies are generated in parallel once the whole translation-unit is matched,
+    if ((options.codeGenerationOptions.workersCount > 1) && (options.stream || options.pipe || options.symbolsOnly)) {
+        NERROR("Addaat.NMain()", "%s--codegen-jobs%s doesn't combine with %s--stream%s, %s--pipe%s or %s--symbols-only%s.",
+                NTCOLOR(HIGHLIGHT), NTCOLOR(STREAM_DEFAULT), NTCOLOR(HIGHLIGHT), NTCOLOR(STREAM_DEFAULT), NTCOLOR(HIGHLIGHT), NTCOLOR(STREAM_DEFAULT), NTCOLOR(HIGHLIGHT), NTCOLOR(STREAM_DEFAULT));
+        argumentsValid = False;
+    }
+
+    // Translation cache (the generated code doesn't depend on the code generation workers),
+    NString.initialize(&options.cacheConfiguration, "%s\n%s\nstream: %d, preprocess: %d, symbolsOnly: %d, colorize: %d, maxNestingDepth: %d",
+            getLanguageDefinitionVersion(), getCodeGenerationVersion(), options.stream, options.preprocess, options.symbolsOnly, options.codeGenerationOptions.colorize, options.codeGenerationOptions.maxNestingDepth);
+    if (argumentsValid && runOptions.cacheDirectory) {
+        struct NString buildIdentifier;
+        NString.initialize(&buildIdentifier, "");
+        if (getTranslatorBuildIdentifier(&buildIdentifier)) {
+            NString.append(&options.cacheConfiguration, "\nbuild: %s", NString.get(&buildIdentifier));
+            options.cache = createTranslationCache(runOptions.cacheDirectory, (int64_t) runOptions.cacheSizeInMegabytes * 1024 * 1024);
+        } else {
+            NERROR("Addaat.NMain()", "Couldn't read the translator's executable, which the cache is keyed on.");
+        }
+        NString.destroy(&buildIdentifier);
+        if (!options.cache) argumentsValid = False;
+    }
 
     // Test,
     #if PERFORM_ERROR_CHECKING_TESTS
-    test(&ncc, "class MyFirstClass;\n"
+    test(&ncc, &options, "class MyFirstClass;\n"
                "class MyFirstClass;\n"
                "class MyFirstClass {\n"
                "    int a, b;\n"
@@ -144,7 +1053,7 @@ void NMain() {
                "    float c;\n"
                "}\n");
 
-    test(&ncc, "class MyFirstClass;\n"
+    test(&ncc, &options, "class MyFirstClass;\n"
                "class MyFirstClass;\n"
                "class MyFirstClass {\n"
                "    int a, b;\n"
@@ -154,7 +1063,7 @@ void NMain() {
                "    int a;\n"
                "}\n");
 
-    test(&ncc, "class MyFirstClass {\n"
+    test(&ncc, &options, "class MyFirstClass {\n"
                "    static int[] a, b;\n"
                "    static int[][] c, d;\n"
                "    float d;\n"
@@ -162,20 +1071,20 @@ void NMain() {
     #endif
 
     #if PERFORM_REGULAR_TESTS
-    test(&ncc, "class MyFirstClass;");
-    test(&ncc, "class MyFirstClass {}");
-    test(&ncc, "class MyFirstClass {\n"
+    test(&ncc, &options, "class MyFirstClass;");
+    test(&ncc, &options, "class MyFirstClass {}");
+    test(&ncc, &options, "class MyFirstClass {\n"
                "    static int[] a, b;\n"
                "    static double[][] c, d;\n"
                "    float e, f;\n"
                "}");
 
-    test(&ncc, "void main();");
-    test(&ncc, "void main() {\n"
+    test(&ncc, &options, "void main();");
+    test(&ncc, &options, "void main() {\n"
                "    printf(\"besm Allah\\n\");\n"
                "}");
 
-    test(&ncc, "int a;\n"
+    test(&ncc, &options, "int a;\n"
                "int a;\n"
                "void main() {\n"
                "    int a, b, d;\n"
@@ -200,10 +1109,40 @@ void NMain() {
                "}");
     #endif
 
-    // Read test file,
-    translateSingleFile(&ncc, "testCode.addaat");
+    // Translate,
+    boolean success = argumentsValid;
+    if (grammarAnalyzer) {
+        if (argumentsValid) success = analyzeGrammar(grammarAnalyzer);
+        destroyAndDeleteGrammarAnalyzer(grammarAnalyzer);
+    } else if (argumentsValid) {
+        struct TranslationRun run = { &ncc, &runOptions, &options, &inputFiles, pipeOutputFileDescriptor, False };
+        success = runWithNestingStack(translate, &run, options.codeGenerationOptions.maxNestingDepth) && run.success;
+    }
+
+    // Report timing and profiling,
+    if (runOptions.printTimingSummary) logTimingSummary();
+    if (runOptions.traceFilePath && !writeTimingTrace(runOptions.traceFilePath)) success = False;
+    destroyTiming();
+    if (profiled && !runOptions.analyzeGrammar) {
+        if (runOptions.profileRules) logRuleProfile(runOptions.profiledRulesCount);
+        destroyRuleProfiler();
+    }
 
     // Clean up,
+    if (options.cache) {
+        trimTranslationCache(options.cache);
+        logTranslationCacheStatistics(options.cache);
+        destroyAndDeleteTranslationCache(options.cache);
+    }
+    NString.destroy(&options.cacheConfiguration);
+    NVector.destroy(&inputFiles);
+    destroyCommandLineArguments(&arguments);
     NCC_destroyNCC(&ncc);
+    if (runOptions.reportAllocations) logAllocationReport(); // After clean up, what's still live leaked.
     NError.logAndTerminate();
+
+    // Let build systems know,
+    #ifdef DESKTOP
+    if (!success) exit(EXIT_FAILURE);
+    #endif
 }
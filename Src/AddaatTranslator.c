@@ -0,0 +1,310 @@
+
+//
+// Embeddable translator. Keeps a defined grammar around, and translates one external-declaration
+// at a time (as --stream does), so that semantic errors can be located by their declaration. The
+// buffers are kept between translations, and nothing is logged or written to files on the way,
+// errors become diagnostics instead.
+//
+// The 18th of October, 2026.
+//
+
+#include <AddaatTranslator.h>
+#include <LanguageDefinition.h>
+#include <CodeGeneration.h>
+#include <NestingLimits.h>
+#include <Utf8.h>
+
+#include <NCC.h>
+#include <NSystemUtils.h>
+#include <NCString.h>
+#include <NError.h>
+#include <AllocationProfiler.h> // After NSystemUtils.h, to reroute NMALLOC/NFREE.
+
+struct DiagnosticRecord {
+    struct AddaatDiagnostic diagnostic;
+    struct NString message;
+};
+
+struct AddaatTranslator {
+    struct NCC ncc;
+    NCC_Rule* ignorablesRule;
+    NCC_Rule* externalDeclarationRule;
+    int32_t maxNestingDepth;
+
+    // Zero terminated copy of the code, when it isn't terminated already,
+    char* code;
+    int32_t codeCapacity;
+
+    struct NString generatedCode;
+    struct NString declarationCode;
+    boolean lastTranslationSucceeded;
+
+    // Semantic errors are reported at the declaration being generated,
+    struct NVector diagnostics; // struct DiagnosticRecord.
+    const char* translatedCode;
+    int32_t declarationOffset;
+};
+
+struct TranslationRun {
+    struct AddaatTranslator* translator;
+    const char* code;
+    int32_t codeLength;
+    int32_t result;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Diagnostics
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void clearDiagnostics(struct AddaatTranslator* translator) {
+    struct DiagnosticRecord record;
+    while (NVector.popBack(&translator->diagnostics, &record)) NString.destroy(&record.message);
+}
+
+static void findLineAndColumn(const char* code, int32_t offset, int32_t* outLine, int32_t* outColumn) {
+    int32_t line=1, column=1;
+    for (int32_t i=0; i<offset; i++) {
+        if (code[i] == '\n') {
+            line++;
+            column = 1;
+        } else {
+            column++;
+        }
+    }
+    *outLine = line;
+    *outColumn = column;
+}
+
+static int32_t findOffset(const char* code, int32_t codeLength, int32_t line, int32_t column) {
+    int32_t offset = 0;
+    for (; (line > 1) && (offset < codeLength); offset++) {
+        if (code[offset] == '\n') line--;
+    }
+    return offset + column - 1;
+}
+
+static void addDiagnostic(struct AddaatTranslator* translator, int32_t kind, const char* code, int32_t offset, const char* rule, const char* message) {
+
+    struct DiagnosticRecord* record = NVector.emplaceBack(&translator->diagnostics);
+    record->diagnostic.kind = kind;
+    record->diagnostic.offset = offset;
+    findLineAndColumn(code, offset, &record->diagnostic.line, &record->diagnostic.column);
+    record->diagnostic.rule = rule;
+    record->diagnostic.message = 0; // Set when fetched, since the vector may move the records.
+
+    // Copy the message without the terminal colors (escape, '[', parameters, then a letter),
+    int32_t messageLength = NCString.length(message);
+    char* plainMessage = NMALLOC(messageLength + 1, "AddaatTranslator.addDiagnostic() plainMessage");
+    int32_t plainMessageLength = 0;
+    for (int32_t i=0; i<messageLength; i++) {
+        if ((message[i] == '\033') && (message[i+1] == '[')) {
+            for (i+=2; message[i] && !((message[i] >= '@') && (message[i] <= '~')); i++);
+            if (!message[i]) break;
+            continue;
+        }
+        plainMessage[plainMessageLength++] = message[i];
+    }
+    plainMessage[plainMessageLength] = 0;
+    NString.initialize(&record->message, "%s", plainMessage);
+    NFREE(plainMessage, "AddaatTranslator.addDiagnostic() plainMessage");
+}
+
+// Code generation's error reporter,
+static void addSemanticDiagnostic(const char* message, void* data) {
+    struct AddaatTranslator* translator = data;
+    addDiagnostic(translator, ADDAAT_SEMANTIC_ERROR, translator->translatedCode, translator->declarationOffset, 0, message);
+}
+
+static void addSyntaxDiagnostic(struct AddaatTranslator* translator, const char* code, int32_t declarationOffset) {
+
+    // The furthest the matcher got, and the rules it was in (innermost on top),
+    struct MatchingErrorInfo errorInfo;
+    takeMatchingErrorInfo(&translator->ncc, &errorInfo);
+    int32_t errorOffset = declarationOffset + errorInfo.maxMatchLength;
+    const char* innermostRule = NVector.size(&errorInfo.ruleStack) ? *(const char**) NVector.get(&errorInfo.ruleStack, 0) : 0;
+    NVector.destroy(&errorInfo.ruleStack);
+
+    struct NString message;
+    if (innermostRule) {
+        NString.initialize(&message, "Couldn't match %s.", innermostRule);
+    } else {
+        NString.initialize(&message, "Couldn't match an external-declaration.");
+    }
+    addDiagnostic(translator, ADDAAT_SYNTAX_ERROR, code, errorOffset, innermostRule, NString.get(&message));
+    NString.destroy(&message);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Translation
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void translate(void* data) {
+
+    struct TranslationRun* run = data;
+    struct AddaatTranslator* translator = run->translator;
+    const char* code = run->code;
+
+    struct CodeGenerationOptions codeGenerationOptions;
+    NSystemUtils.memset(&codeGenerationOptions, 0, sizeof(struct CodeGenerationOptions));
+    codeGenerationOptions.maxNestingDepth = translator->maxNestingDepth;
+    codeGenerationOptions.reportError = addSemanticDiagnostic;
+    codeGenerationOptions.reportErrorData = translator;
+    struct CodeGenerationData* codeGenerationData = createCodeGenerationData(&codeGenerationOptions);
+
+    run->result = ADDAAT_SUCCESS;
+    int32_t offset = 0;
+    while (True) {
+
+        // Skip white-spaces and comments,
+        NCC_MatchingResult matchingResult;
+        NCC_ASTNode_Data tree;
+        if (NCC_match(&translator->ncc, translator->ignorablesRule, &code[offset], &matchingResult, &tree)) {
+            if (tree.node) NCC_deleteASTNode(&tree, 0);
+            offset += matchingResult.matchLength;
+        }
+        if (offset >= run->codeLength) break;
+
+        // Match a single external declaration,
+        boolean matched = NCC_match(&translator->ncc, translator->externalDeclarationRule, &code[offset], &matchingResult, &tree);
+        if (!matched || !tree.node) {
+            if (tree.node) NCC_deleteASTNode(&tree, 0);
+            addSyntaxDiagnostic(translator, code, offset);
+            run->result = ADDAAT_SYNTAX_ERROR;
+            break;
+        }
+
+        // Generate its code, then drop the tree right away,
+        translator->declarationOffset = offset;
+        int32_t diagnosticsCount = NVector.size(&translator->diagnostics);
+        boolean generated = generateExternalDeclarationCode(tree.node, codeGenerationData, &translator->declarationCode);
+        NCC_deleteASTNode(&tree, 0);
+        if (!generated) {
+            if (NVector.size(&translator->diagnostics) == diagnosticsCount) {
+                addDiagnostic(translator, ADDAAT_INTERNAL_ERROR, code, offset, 0, "Couldn't generate code.");
+                run->result = ADDAAT_INTERNAL_ERROR;
+            } else {
+                run->result = ADDAAT_SEMANTIC_ERROR;
+            }
+            break;
+        }
+        NString.append(&translator->generatedCode, "%s", NString.get(&translator->declarationCode));
+        offset += matchingResult.matchLength;
+    }
+
+    destroyAndDeleteCodeGenerationData(codeGenerationData);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Interface
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct AddaatTranslator* createAddaatTranslator(int32_t maxNestingDepth) {
+
+    struct AddaatTranslator* translator = NMALLOC(sizeof(struct AddaatTranslator), "AddaatTranslator.createAddaatTranslator() translator");
+    NCC_initializeNCC(&translator->ncc);
+    defineLanguage(&translator->ncc);
+    translator->ignorablesRule = getIgnorablesRule(&translator->ncc);
+    translator->externalDeclarationRule = getExternalDeclarationRule(&translator->ncc);
+    translator->maxNestingDepth = maxNestingDepth > 0 ? maxNestingDepth : 0;
+
+    translator->code = 0;
+    translator->codeCapacity = 0;
+
+    NString.initialize(&translator->generatedCode, "");
+    NString.initialize(&translator->declarationCode, "");
+    translator->lastTranslationSucceeded = False;
+
+    NVector.initialize(&translator->diagnostics, 0, sizeof(struct DiagnosticRecord));
+    translator->translatedCode = 0;
+    translator->declarationOffset = 0;
+    return translator;
+}
+
+void destroyAndDeleteAddaatTranslator(struct AddaatTranslator* translator) {
+    if (!translator) return;
+    clearDiagnostics(translator);
+    NVector.destroy(&translator->diagnostics);
+    NString.destroy(&translator->generatedCode);
+    NString.destroy(&translator->declarationCode);
+    if (translator->code) NFREE(translator->code, "AddaatTranslator.destroyAndDeleteAddaatTranslator() translator->code");
+    NCC_destroyNCC(&translator->ncc);
+    NFREE(translator, "AddaatTranslator.destroyAndDeleteAddaatTranslator() translator");
+}
+
+int32_t translateAddaat(struct AddaatTranslator* translator, const char* code, int32_t codeLength, char* outputBuffer, int32_t outputBufferSize, int32_t* outputLength) {
+
+    clearDiagnostics(translator);
+    NString.set(&translator->generatedCode, "");
+    translator->lastTranslationSucceeded = False;
+    if (outputLength) *outputLength = 0;
+
+    // The matcher needs the code zero terminated. Copy it only when it isn't,
+    if (codeLength < 0) codeLength = NCString.length(code);
+    if (code[codeLength]) {
+        if (codeLength + 1 > translator->codeCapacity) {
+            if (translator->code) NFREE(translator->code, "AddaatTranslator.translateAddaat() translator->code");
+            translator->codeCapacity = codeLength + 1 > translator->codeCapacity*2 ? codeLength + 1 : translator->codeCapacity*2;
+            translator->code = NMALLOC(translator->codeCapacity, "AddaatTranslator.translateAddaat() translator->code");
+        }
+        NSystemUtils.memcpy(translator->code, code, codeLength);
+        translator->code[codeLength] = 0;
+        code = translator->code;
+    }
+
+    // Reject what's nested too deeply for the stack before matching it,
+    if (translator->maxNestingDepth) {
+        struct NestingScanner scanner;
+        initializeNestingScanner(&scanner, translator->maxNestingDepth);
+        scanner.logErrors = False;
+        boolean withinLimit = scanNesting(&scanner, code, codeLength);
+        destroyNestingScanner(&scanner);
+        if (!withinLimit) {
+            struct NString message;
+            NString.initialize(&message, "Nesting deeper than %d levels.", translator->maxNestingDepth);
+            addDiagnostic(translator, ADDAAT_NESTING_TOO_DEEP, code, findOffset(code, codeLength, scanner.line, scanner.column), 0, NString.get(&message));
+            NString.destroy(&message);
+            return ADDAAT_NESTING_TOO_DEEP;
+        }
+    }
+
+    // And invalid UTF-8, pointing at the offending sequence,
+    struct Utf8Validator utf8Validator;
+    initializeUtf8Validator(&utf8Validator);
+    utf8Validator.logErrors = False;
+    if (!validateUtf8(&utf8Validator, code, codeLength) || !finishUtf8Validation(&utf8Validator)) {
+        addDiagnostic(translator, ADDAAT_SYNTAX_ERROR, code, utf8Validator.sequenceOffset, 0, "Invalid UTF-8 sequence.");
+        return ADDAAT_SYNTAX_ERROR;
+    }
+
+    translator->translatedCode = code;
+    struct TranslationRun run = { translator, code, codeLength, ADDAAT_INTERNAL_ERROR };
+    boolean ran = runWithNestingStack(translate, &run, translator->maxNestingDepth);
+    if (!ran) {
+        addDiagnostic(translator, ADDAAT_INTERNAL_ERROR, code, 0, 0, "Couldn't reserve a stack for the nesting depth limit.");
+        return ADDAAT_INTERNAL_ERROR;
+    }
+    if (run.result != ADDAAT_SUCCESS) return run.result;
+
+    translator->lastTranslationSucceeded = True;
+    if (outputLength) *outputLength = NString.length(&translator->generatedCode);
+    return copyLastAddaatTranslation(translator, outputBuffer, outputBufferSize);
+}
+
+int32_t copyLastAddaatTranslation(struct AddaatTranslator* translator, char* outputBuffer, int32_t outputBufferSize) {
+    if (!translator->lastTranslationSucceeded) return ADDAAT_INTERNAL_ERROR;
+    int32_t generatedCodeLength = NString.length(&translator->generatedCode);
+    if (!outputBuffer || (generatedCodeLength + 1 > outputBufferSize)) return ADDAAT_OUTPUT_TOO_SMALL;
+    NSystemUtils.memcpy(outputBuffer, NString.get(&translator->generatedCode), generatedCodeLength + 1);
+    return ADDAAT_SUCCESS;
+}
+
+int32_t getAddaatDiagnosticsCount(struct AddaatTranslator* translator) {
+    return NVector.size(&translator->diagnostics);
+}
+
+const struct AddaatDiagnostic* getAddaatDiagnostic(struct AddaatTranslator* translator, int32_t index) {
+    struct DiagnosticRecord* record = NVector.get(&translator->diagnostics, index);
+    if (!record) return 0;
+    record->diagnostic.message = NString.get(&record->message);
+    return &record->diagnostic;
+}
@@ -0,0 +1,447 @@
+
+//
+// Allocation profiling by NMALLOC tag. Every profiled block is recorded by address along with its
+// tag, size and allocation time, so frees can be attributed. Blocks freed through NFREE that
+// weren't profiled (allocated before the reroute, or by the libraries) aren't found, and are
+// passed on as is.
+//
+// The 18th of October, 2026.
+//
+
+#define ALLOCATION_PROFILER_IMPLEMENTATION
+#include <AllocationProfiler.h>
+#include <ReportFormatting.h>
+#include <Timing.h>
+
+#include <NSystemUtils.h>
+#include <NString.h>
+#include <NVector.h>
+#include <NCString.h>
+
+#include <stdlib.h>
+
+#ifdef DESKTOP
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+#define LIFETIME_BUCKETS_COUNT 7
+#define MAX_PHASES_DEPTH 16
+
+struct BlockRecord {
+    void* address;                  // Zero if the slot is empty.
+    int64_t allocationTime;
+    int32_t size;
+    int32_t tagIndex;
+};
+
+struct TagStatistics {
+    const char* tag;
+    int64_t allocationsCount;
+    int64_t allocatedBytes;
+    int64_t liveBytes, peakLiveBytes;
+    int64_t lifetimes[LIFETIME_BUCKETS_COUNT]; // Freed blocks, by lifetime.
+};
+
+struct MemoryPhase {
+    const char* name;
+    int32_t count;
+    int64_t peakLiveBytes;          // Bytes allocated through NMALLOC, above what was live at start.
+    int64_t peakResidentKilobytes;
+};
+
+struct ActivePhase {
+    struct MemoryPhase* phase;
+    int64_t startLiveBytes, peakLiveBytes;
+    int64_t peakResidentKilobytes;
+};
+
+// Lifetime buckets upper bounds (nanoseconds), the last one has none,
+static const int64_t lifetimeBucketsLimits[LIFETIME_BUCKETS_COUNT-1] = { 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+static const char* lifetimeBucketsNames[LIFETIME_BUCKETS_COUNT] = { "<10us", "<100us", "<1ms", "<10ms", "<100ms", "<1s", ">=1s" };
+
+static struct TagStatistics* tags;
+static int32_t tagsCount, tagsCapacity;
+
+// Open addressing, tag pointers to indices plus one (zero is empty). The same tag text could
+// live at different addresses (one per translation unit), so misses fall back to comparing text,
+static const char** tagSlotsKeys;
+static uint16_t* tagSlotsValues;
+static int32_t tagSlotsCount, usedTagSlotsCount;
+
+// Open addressing, live profiled blocks by address,
+static struct BlockRecord* blockSlots;
+static int32_t blockSlotsCount, usedBlockSlotsCount;
+
+static int64_t liveBytes, peakLiveBytes;
+static int64_t untrackedFreesCount;
+
+static struct MemoryPhase* phases;
+static int32_t phasesCount, phasesCapacity;
+static struct ActivePhase activePhases[MAX_PHASES_DEPTH];
+static int32_t activePhasesCount;
+static boolean residentSizeResettable = True;
+
+boolean memoryPhasesEnabled = False;
+static volatile boolean reportRequested;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper functions
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Grows an NMALLOC'ed array, zeroing the new part,
+static void* growArray(void* array, int32_t elementSize, int32_t* capacity, const char* tag) {
+    int32_t newCapacity = *capacity ? *capacity * 2 : 64;
+    char* newArray = NMALLOC(newCapacity * elementSize, tag);
+    NSystemUtils.memset(newArray, 0, newCapacity * elementSize);
+    if (array) {
+        NSystemUtils.memcpy(newArray, array, *capacity * elementSize);
+        NFREE(array, tag);
+    }
+    *capacity = newCapacity;
+    return newArray;
+}
+
+static int32_t getTagSlotIndex(const char* tag) {
+    uint64_t hash = (uint64_t) (uintptr_t) tag * 0x9e3779b97f4a7c15ull;
+    return (int32_t) (hash >> 40) & (tagSlotsCount - 1);
+}
+
+static void insertTagSlot(const char* tag, int32_t tagIndex) {
+
+    // Keep the load factor under a half,
+    if ((usedTagSlotsCount+1)*2 > tagSlotsCount) {
+        int32_t oldSlotsCount = tagSlotsCount;
+        const char** oldKeys = tagSlotsKeys;
+        uint16_t* oldValues = tagSlotsValues;
+
+        tagSlotsCount = oldSlotsCount ? oldSlotsCount*2 : 256;
+        tagSlotsKeys = NMALLOC(tagSlotsCount * sizeof(const char*), "AllocationProfiler.insertTagSlot() tagSlotsKeys");
+        tagSlotsValues = NMALLOC(tagSlotsCount * sizeof(uint16_t), "AllocationProfiler.insertTagSlot() tagSlotsValues");
+        NSystemUtils.memset(tagSlotsValues, 0, tagSlotsCount * sizeof(uint16_t));
+        usedTagSlotsCount = 0;
+        for (int32_t i=0; i<oldSlotsCount; i++) {
+            if (oldValues[i]) insertTagSlot(oldKeys[i], oldValues[i]-1);
+        }
+        if (oldKeys) {
+            NFREE(oldKeys, "AllocationProfiler.insertTagSlot() tagSlotsKeys");
+            NFREE(oldValues, "AllocationProfiler.insertTagSlot() tagSlotsValues");
+        }
+    }
+
+    int32_t slotIndex = getTagSlotIndex(tag);
+    while (tagSlotsValues[slotIndex]) slotIndex = (slotIndex+1) & (tagSlotsCount-1);
+    tagSlotsKeys[slotIndex] = tag;
+    tagSlotsValues[slotIndex] = tagIndex + 1;
+    usedTagSlotsCount++;
+}
+
+static int32_t getTagIndex(const char* tag) {
+
+    // Same address,
+    if (tagSlotsCount) {
+        int32_t slotIndex = getTagSlotIndex(tag);
+        while (tagSlotsValues[slotIndex]) {
+            if (tagSlotsKeys[slotIndex] == tag) return tagSlotsValues[slotIndex] - 1;
+            slotIndex = (slotIndex+1) & (tagSlotsCount-1);
+        }
+    }
+
+    // Same text,
+    int32_t tagIndex;
+    for (tagIndex=0; tagIndex<tagsCount; tagIndex++) {
+        if (NCString.equals(tags[tagIndex].tag, tag)) break;
+    }
+
+    // New tag (the slots only have room for so many),
+    if ((tagIndex == tagsCount) && (tagsCount < 0xffff)) {
+        if (tagsCount == tagsCapacity) tags = growArray(tags, sizeof(struct TagStatistics), &tagsCapacity, "AllocationProfiler.getTagIndex() tags");
+        tags[tagsCount++].tag = tag;
+    }
+    if (tagIndex == tagsCount) tagIndex--;
+
+    insertTagSlot(tag, tagIndex);
+    return tagIndex;
+}
+
+static int32_t getBlockSlotIndex(const void* address) {
+    uint64_t hash = (uint64_t) (uintptr_t) address * 0x9e3779b97f4a7c15ull;
+    return (int32_t) (hash >> 40) & (blockSlotsCount - 1);
+}
+
+static void insertBlockSlot(const struct BlockRecord* block) {
+
+    // Keep the load factor under a half,
+    if ((usedBlockSlotsCount+1)*2 > blockSlotsCount) {
+        int32_t oldSlotsCount = blockSlotsCount;
+        struct BlockRecord* oldSlots = blockSlots;
+
+        blockSlotsCount = oldSlotsCount ? oldSlotsCount*2 : 4096;
+        blockSlots = NMALLOC(blockSlotsCount * sizeof(struct BlockRecord), "AllocationProfiler.insertBlockSlot() blockSlots");
+        NSystemUtils.memset(blockSlots, 0, blockSlotsCount * sizeof(struct BlockRecord));
+        usedBlockSlotsCount = 0;
+        for (int32_t i=0; i<oldSlotsCount; i++) {
+            if (oldSlots[i].address) insertBlockSlot(&oldSlots[i]);
+        }
+        if (oldSlots) NFREE(oldSlots, "AllocationProfiler.insertBlockSlot() blockSlots");
+    }
+
+    int32_t slotIndex = getBlockSlotIndex(block->address);
+    while (blockSlots[slotIndex].address) slotIndex = (slotIndex+1) & (blockSlotsCount-1);
+    blockSlots[slotIndex] = *block;
+    usedBlockSlotsCount++;
+}
+
+// Returns False if the block wasn't profiled,
+static boolean removeBlockSlot(const void* address, struct BlockRecord* outBlock) {
+
+    if (!blockSlotsCount) return False;
+    int32_t mask = blockSlotsCount-1;
+    int32_t slotIndex = getBlockSlotIndex(address);
+    while (blockSlots[slotIndex].address != address) {
+        if (!blockSlots[slotIndex].address) return False;
+        slotIndex = (slotIndex+1) & mask;
+    }
+    *outBlock = blockSlots[slotIndex];
+
+    // Shift back the blocks after it that would no longer be found past the hole,
+    int32_t holeIndex = slotIndex;
+    for (int32_t nextIndex = (holeIndex+1) & mask; blockSlots[nextIndex].address; nextIndex = (nextIndex+1) & mask) {
+        int32_t homeIndex = getBlockSlotIndex(blockSlots[nextIndex].address);
+        if (((nextIndex - homeIndex) & mask) >= ((nextIndex - holeIndex) & mask)) {
+            blockSlots[holeIndex] = blockSlots[nextIndex];
+            holeIndex = nextIndex;
+        }
+    }
+    blockSlots[holeIndex].address = 0;
+    usedBlockSlotsCount--;
+    return True;
+}
+
+static int32_t getLifetimeBucketIndex(int64_t lifetime) {
+    for (int32_t i=0; i<LIFETIME_BUCKETS_COUNT-1; i++) {
+        if (lifetime < lifetimeBucketsLimits[i]) return i;
+    }
+    return LIFETIME_BUCKETS_COUNT-1;
+}
+
+int64_t readPeakResidentKilobytes() {
+    #ifdef DESKTOP
+    int fileDescriptor = open("/proc/self/status", O_RDONLY);
+    if (fileDescriptor < 0) return -1;
+    char status[4096];
+    ssize_t size = read(fileDescriptor, status, sizeof(status)-1);
+    close(fileDescriptor);
+    if (size <= 0) return -1;
+    status[size] = 0;
+
+    // Find the line,
+    const char* text = status;
+    while (*text && !NCString.startsWith(text, "VmHWM:")) text++;
+    if (!*text) return -1;
+    text += 6;
+    while ((*text == ' ') || (*text == '\t')) text++;
+    int64_t kilobytes = 0;
+    while ((*text >= '0') && (*text <= '9')) kilobytes = kilobytes*10 + (*text++ - '0');
+    return kilobytes;
+    #else
+    return -1;
+    #endif
+}
+
+boolean resetPeakResidentSize() {
+    #ifdef DESKTOP
+    if (!residentSizeResettable) return False;
+    int fileDescriptor = open("/proc/self/clear_refs", O_WRONLY);
+    if ((fileDescriptor < 0) || (write(fileDescriptor, "5", 1) != 1)) residentSizeResettable = False;
+    if (fileDescriptor >= 0) close(fileDescriptor);
+    return residentSizeResettable;
+    #else
+    return False;
+    #endif
+}
+
+// Folds the peak resident size so far into all the active phases, before it's reset or read,
+static void collectPeakResidentSize() {
+    int64_t peakResidentKilobytes = readPeakResidentKilobytes();
+    for (int32_t i=0; i<activePhasesCount; i++) {
+        if (peakResidentKilobytes > activePhases[i].peakResidentKilobytes) activePhases[i].peakResidentKilobytes = peakResidentKilobytes;
+    }
+}
+
+static struct MemoryPhase* getPhase(const char* name) {
+    for (int32_t i=0; i<phasesCount; i++) {
+        if (NCString.equals(phases[i].name, name)) return &phases[i];
+    }
+    if (phasesCount == phasesCapacity) phases = growArray(phases, sizeof(struct MemoryPhase), &phasesCapacity, "AllocationProfiler.getPhase() phases");
+    phases[phasesCount].name = name;
+    phases[phasesCount].peakResidentKilobytes = -1;
+    return &phases[phasesCount++];
+}
+
+#ifdef DESKTOP
+static void reportSignalHandler(int signalNumber) {
+    reportRequested = True;
+}
+#endif
+
+static int compareAllocatedBytes(const void* tag1, const void* tag2) {
+    int64_t bytes1 = ((struct TagStatistics*) tag1)->allocatedBytes;
+    int64_t bytes2 = ((struct TagStatistics*) tag2)->allocatedBytes;
+    return (bytes1 < bytes2) ? 1 : (bytes1 > bytes2) ? -1 : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Profiler
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void* profiledMalloc(int32_t size, const char* tag) {
+
+    void* address = NMALLOC(size, tag);
+    if (!address) return 0;
+    struct BlockRecord block = { .address = address, .allocationTime = getMonotonicTime(), .size = size, .tagIndex = getTagIndex(tag) };
+    insertBlockSlot(&block);
+
+    struct TagStatistics* tagStatistics = &tags[block.tagIndex];
+    tagStatistics->allocationsCount++;
+    tagStatistics->allocatedBytes += size;
+    tagStatistics->liveBytes += size;
+    if (tagStatistics->liveBytes > tagStatistics->peakLiveBytes) tagStatistics->peakLiveBytes = tagStatistics->liveBytes;
+
+    liveBytes += size;
+    if (liveBytes > peakLiveBytes) peakLiveBytes = liveBytes;
+    for (int32_t i=0; i<activePhasesCount; i++) {
+        if (liveBytes > activePhases[i].peakLiveBytes) activePhases[i].peakLiveBytes = liveBytes;
+    }
+
+    return address;
+}
+
+void profiledFree(void* address, const char* tag) {
+
+    // Blocks that didn't come from profiledMalloc() are passed as is,
+    struct BlockRecord block;
+    if (!removeBlockSlot(address, &block)) {
+        if (address) untrackedFreesCount++;
+        NFREE(address, tag);
+        return;
+    }
+
+    struct TagStatistics* tagStatistics = &tags[block.tagIndex];
+    tagStatistics->liveBytes -= block.size;
+    tagStatistics->lifetimes[getLifetimeBucketIndex(getMonotonicTime() - block.allocationTime)]++;
+    liveBytes -= block.size;
+
+    NFREE(address, tag);
+}
+
+void beginMemoryPhase(const char* name) {
+    if (activePhasesCount == MAX_PHASES_DEPTH) return;
+    collectPeakResidentSize();
+    resetPeakResidentSize();
+
+    struct ActivePhase* activePhase = &activePhases[activePhasesCount++];
+    activePhase->phase = getPhase(name);
+    activePhase->startLiveBytes = liveBytes;
+    activePhase->peakLiveBytes = liveBytes;
+    activePhase->peakResidentKilobytes = -1;
+}
+
+void endMemoryPhase() {
+    if (!activePhasesCount) return;
+    collectPeakResidentSize();
+
+    struct ActivePhase* activePhase = &activePhases[--activePhasesCount];
+    struct MemoryPhase* phase = activePhase->phase;
+    phase->count++;
+    int64_t phasePeakLiveBytes = activePhase->peakLiveBytes - activePhase->startLiveBytes;
+    if (phasePeakLiveBytes > phase->peakLiveBytes) phase->peakLiveBytes = phasePeakLiveBytes;
+    if (activePhase->peakResidentKilobytes > phase->peakResidentKilobytes) phase->peakResidentKilobytes = activePhase->peakResidentKilobytes;
+
+    if (reportRequested) {
+        reportRequested = False;
+        logAllocationReport();
+    }
+}
+
+void enableMemoryPhases() {
+    memoryPhasesEnabled = True;
+    #ifdef DESKTOP
+    signal(SIGUSR1, reportSignalHandler);
+    #endif
+}
+
+void logAllocationReport() {
+
+    // Sort a copy, so that tag indices stay valid,
+    struct TagStatistics* sortedTags = NMALLOC(sizeof(struct TagStatistics) * (tagsCount ? tagsCount : 1), "AllocationProfiler.logAllocationReport() sortedTags");
+    NSystemUtils.memcpy(sortedTags, tags, sizeof(struct TagStatistics) * tagsCount);
+    qsort(sortedTags, tagsCount, sizeof(struct TagStatistics), compareAllocatedBytes);
+
+    struct NString report, cell;
+    NString.initialize(&report, "Allocations by tag (bytes requested through NMALLOC, lifetimes of the freed blocks):\n");
+    NString.initialize(&cell, "");
+
+    appendPadded(&report, "tag", 64, False);
+    appendPadded(&report, "count", 10, True);
+    appendPadded(&report, "bytes", 12, True);
+    appendPadded(&report, "peak live", 12, True);
+    appendPadded(&report, "live", 10, True);
+    for (int32_t i=0; i<LIFETIME_BUCKETS_COUNT; i++) appendPadded(&report, lifetimeBucketsNames[i], 8, True);
+    NString.append(&report, "\n");
+
+    for (int32_t i=0; i<tagsCount; i++) {
+        struct TagStatistics* tagStatistics = &sortedTags[i];
+        appendPadded(&report, tagStatistics->tag, 64, False);
+        int64_t values[] = { tagStatistics->allocationsCount, tagStatistics->allocatedBytes, tagStatistics->peakLiveBytes, tagStatistics->liveBytes };
+        const int32_t widths[] = { 10, 12, 12, 10 };
+        for (int32_t j=0; j<4; j++) {
+            NString.set(&cell, "");
+            appendInteger64(&cell, values[j]);
+            appendPadded(&report, NString.get(&cell), widths[j], True);
+        }
+        for (int32_t j=0; j<LIFETIME_BUCKETS_COUNT; j++) {
+            NString.set(&cell, "");
+            appendInteger64(&cell, tagStatistics->lifetimes[j]);
+            appendPadded(&report, NString.get(&cell), 8, True);
+        }
+        NString.append(&report, "\n");
+    }
+    NString.append(&report, "Peak live: ");
+    appendInteger64(&report, peakLiveBytes);
+    NString.append(&report, " bytes, live now: ");
+    appendInteger64(&report, liveBytes);
+    NString.append(&report, " bytes, untracked frees: ");
+    appendInteger64(&report, untrackedFreesCount);
+    NString.append(&report, "\n\n");
+
+    // Phases,
+    NString.append(&report, "Memory by phase%s:\n", residentSizeResettable ? "" : " (peak RSS couldn't be reset, it's the peak since start)");
+    appendPadded(&report, "phase", 24, False);
+    appendPadded(&report, "count", 10, True);
+    appendPadded(&report, "peak NMALLOC bytes", 20, True);
+    appendPadded(&report, "peak RSS (KB)", 16, True);
+    NString.append(&report, "\n");
+    for (int32_t i=0; i<phasesCount; i++) {
+        appendPadded(&report, phases[i].name, 24, False);
+        NString.set(&cell, "%d", phases[i].count);
+        appendPadded(&report, NString.get(&cell), 10, True);
+        NString.set(&cell, "");
+        appendInteger64(&cell, phases[i].peakLiveBytes);
+        appendPadded(&report, NString.get(&cell), 20, True);
+        NString.set(&cell, "");
+        if (phases[i].peakResidentKilobytes >= 0) {
+            appendInteger64(&cell, phases[i].peakResidentKilobytes);
+        } else {
+            NString.set(&cell, "n/a");
+        }
+        appendPadded(&report, NString.get(&cell), 16, True);
+        NString.append(&report, "\n");
+    }
+
+    NLOGI("", "%s", NString.get(&report));
+    NString.destroy(&report);
+    NString.destroy(&cell);
+    NFREE(sortedTags, "AllocationProfiler.logAllocationReport() sortedTags");
+}
@@ -0,0 +1,285 @@
+
+//
+// Batch translation over a pool of worker processes.
+//
+// NCC and the standard library keep mutable global state (matching stacks, error and memory
+// tracking), so workers are forked after the grammar is defined instead of being threads. They
+// all share the same grammar pages (copy-on-write, and never written to), and report their
+// results through an anonymous shared mapping.
+//
+// The 18th of October, 2026.
+//
+
+#include <BatchTranslation.h>
+
+#include <NSystemUtils.h>
+#include <NString.h>
+#include <NVector.h>
+#include <NCString.h>
+#include <NError.h>
+#include <AllocationProfiler.h> // After NSystemUtils.h, to reroute NMALLOC/NFREE.
+
+#ifdef DESKTOP
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#endif
+
+#define FILE_STATUS_PENDING     0
+#define FILE_STATUS_IN_PROGRESS 1
+#define FILE_STATUS_SUCCEEDED   2
+#define FILE_STATUS_FAILED      3
+
+struct FileResult {
+    volatile int32_t status;
+    int32_t workerIndex;
+    int64_t durationMicroseconds;
+};
+
+struct BatchSharedData {
+    volatile int32_t nextFileIndex;
+    int32_t filesCount;
+    struct FileResult results[];
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper functions
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static int64_t getMicroseconds() {
+    #ifdef DESKTOP
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (int64_t) time.tv_sec * 1000000 + time.tv_nsec / 1000;
+    #else
+    return 0;
+    #endif
+}
+
+int32_t getAvailableProcessorsCount() {
+    #ifdef DESKTOP
+    long processorsCount = sysconf(_SC_NPROCESSORS_ONLN);
+    if (processorsCount > 0) return (int32_t) processorsCount;
+    #endif
+    return 1;
+}
+
+#ifdef DESKTOP
+static int compareFilePaths(const void* path1, const void* path2) {
+    return strcmp(NString.get(*(struct NString**) path1), NString.get(*(struct NString**) path2));
+}
+
+static void collectDirectoryFiles(const char* directoryPath, struct NVector* outFilePaths) {
+
+    DIR* directory = opendir(directoryPath);
+    if (!directory) {
+        NERROR("BatchTranslation.collectDirectoryFiles()", "Couldn't open directory: %s%s%s", NTCOLOR(HIGHLIGHT), directoryPath, NTCOLOR(STREAM_DEFAULT));
+        return;
+    }
+
+    // Collect this directory's entries first, then sort them so that the order is stable,
+    struct NVector entries;
+    NVector.initialize(&entries, 0, sizeof(struct NString*));
+    struct dirent* entry;
+    while ((entry = readdir(directory))) {
+        if (NCString.equals(entry->d_name, ".") || NCString.equals(entry->d_name, "..")) continue;
+        struct NString* entryPath = NString.create("%s/%s", directoryPath, entry->d_name);
+        NVector.pushBack(&entries, &entryPath);
+    }
+    closedir(directory);
+    qsort(NVector.get(&entries, 0), NVector.size(&entries), sizeof(struct NString*), compareFilePaths);
+
+    int32_t entriesCount = NVector.size(&entries);
+    for (int32_t i=0; i<entriesCount; i++) {
+        struct NString* entryPath = *(struct NString**) NVector.get(&entries, i);
+        struct stat entryStat;
+        if (stat(NString.get(entryPath), &entryStat)) {
+            NString.destroyAndFree(entryPath);
+        } else if (S_ISDIR(entryStat.st_mode)) {
+            collectDirectoryFiles(NString.get(entryPath), outFilePaths);
+            NString.destroyAndFree(entryPath);
+        } else if (NCString.endsWith(NString.get(entryPath), ".addaat")) {
+            NVector.pushBack(outFilePaths, &entryPath);
+        } else {
+            NString.destroyAndFree(entryPath);
+        }
+    }
+    NVector.destroy(&entries);
+}
+#endif
+
+static void collectFiles(struct NVector* inputPaths, struct NVector* outFilePaths) {
+
+    int32_t inputPathsCount = NVector.size(inputPaths);
+    for (int32_t i=0; i<inputPathsCount; i++) {
+        const char* inputPath = *(const char**) NVector.get(inputPaths, i);
+
+        #ifdef DESKTOP
+        struct stat inputStat;
+        if (!stat(inputPath, &inputStat) && S_ISDIR(inputStat.st_mode)) {
+            collectDirectoryFiles(inputPath, outFilePaths);
+            continue;
+        }
+        #endif
+
+        struct NString* filePath = NString.create("%s", inputPath);
+        NVector.pushBack(outFilePaths, &filePath);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Workers
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void runWorker(struct NCC* ncc, struct NVector* filePaths, struct BatchSharedData* sharedData, int32_t workerIndex, BatchFileTranslator translator, void* translatorData) {
+
+    while (True) {
+
+        // Take the next file,
+        int32_t fileIndex = __atomic_fetch_add(&sharedData->nextFileIndex, 1, __ATOMIC_RELAXED);
+        if (fileIndex >= sharedData->filesCount) return;
+        struct FileResult* result = &sharedData->results[fileIndex];
+        result->workerIndex = workerIndex;
+        __atomic_store_n(&result->status, FILE_STATUS_IN_PROGRESS, __ATOMIC_RELEASE);
+
+        // Translate,
+        int64_t startTime = getMicroseconds();
+        const char* filePath = NString.get(*(struct NString**) NVector.get(filePaths, fileIndex));
+        boolean success = translator(ncc, filePath, translatorData);
+        result->durationMicroseconds = getMicroseconds() - startTime;
+        __atomic_store_n(&result->status, success ? FILE_STATUS_SUCCEEDED : FILE_STATUS_FAILED, __ATOMIC_RELEASE);
+    }
+}
+
+static struct BatchSharedData* createSharedData(int32_t filesCount) {
+    int32_t size = sizeof(struct BatchSharedData) + filesCount * sizeof(struct FileResult);
+    struct BatchSharedData* sharedData;
+    #ifdef DESKTOP
+    sharedData = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (sharedData == MAP_FAILED) return 0;
+    #else
+    sharedData = NMALLOC(size, "BatchTranslation.createSharedData() sharedData");
+    #endif
+    NSystemUtils.memset(sharedData, 0, size);
+    sharedData->filesCount = filesCount;
+    return sharedData;
+}
+
+static void deleteSharedData(struct BatchSharedData* sharedData) {
+    #ifdef DESKTOP
+    munmap(sharedData, sizeof(struct BatchSharedData) + sharedData->filesCount * sizeof(struct FileResult));
+    #else
+    NFREE(sharedData, "BatchTranslation.deleteSharedData() sharedData");
+    #endif
+}
+
+static void runWorkers(struct NCC* ncc, struct NVector* filePaths, struct BatchSharedData* sharedData, int32_t workersCount, BatchFileTranslator translator, void* translatorData) {
+
+    #ifdef DESKTOP
+    // Fork the workers (if a fork fails, the remaining workers will just have more to do),
+    int32_t forkedWorkersCount = 0;
+    fflush(stdout);
+    fflush(stderr);
+    for (int32_t i=0; i<workersCount; i++) {
+        pid_t processId = fork();
+        if (processId == 0) {
+            runWorker(ncc, filePaths, sharedData, i, translator, translatorData);
+            fflush(stdout);
+            fflush(stderr);
+            _exit(0);
+        }
+        if (processId > 0) forkedWorkersCount++;
+    }
+
+    // Wait for them. Whatever a worker left in progress died with it,
+    if (forkedWorkersCount) {
+        while (wait(0) > 0);
+        for (int32_t i=0; i<sharedData->filesCount; i++) {
+            if (sharedData->results[i].status == FILE_STATUS_IN_PROGRESS) sharedData->results[i].status = FILE_STATUS_FAILED;
+        }
+        return;
+    }
+    #endif
+
+    // No workers, translate in this process,
+    runWorker(ncc, filePaths, sharedData, 0, translator, translatorData);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Batch translation
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void appendMilliseconds(struct NString* outString, int64_t microseconds) {
+    NString.append(outString, "%d.%d%d ms", (int32_t) (microseconds / 1000), (int32_t) ((microseconds / 100) % 10), (int32_t) ((microseconds / 10) % 10));
+}
+
+boolean translateBatch(struct NCC* ncc, struct NVector* inputPaths, int32_t workersCount, BatchFileTranslator translator, void* translatorData) {
+
+    struct NVector filePaths;
+    NVector.initialize(&filePaths, 0, sizeof(struct NString*));
+    collectFiles(inputPaths, &filePaths);
+    int32_t filesCount = NVector.size(&filePaths);
+    if (workersCount < 1) workersCount = 1;
+    if (workersCount > filesCount) workersCount = filesCount;
+
+    boolean success = False;
+    struct BatchSharedData* sharedData = createSharedData(filesCount);
+    if (!sharedData) {
+        NERROR("BatchTranslation.translateBatch()", "Couldn't allocate the workers' shared data.");
+        goto finish;
+    }
+
+    // Translate,
+    int64_t startTime = getMicroseconds();
+    if (filesCount) runWorkers(ncc, &filePaths, sharedData, workersCount, translator, translatorData);
+    int64_t wallTime = getMicroseconds() - startTime;
+
+    // Report per-file results,
+    int32_t failedFilesCount = 0;
+    int64_t totalTranslationTime = 0;
+    struct NString report;
+    NString.initialize(&report, "");
+    for (int32_t i=0; i<filesCount; i++) {
+        struct FileResult* result = &sharedData->results[i];
+        boolean succeeded = result->status == FILE_STATUS_SUCCEEDED;
+        if (!succeeded) failedFilesCount++;
+        totalTranslationTime += result->durationMicroseconds;
+
+        NString.set(&report, "%s%s%s %s (worker %d, ",
+                succeeded ? NTCOLOR(GREEN_BRIGHT) : NTCOLOR(RED_BRIGHT),
+                succeeded ? "Succeeded:" : "Failed:   ",
+                NTCOLOR(STREAM_DEFAULT),
+                NString.get(*(struct NString**) NVector.get(&filePaths, i)),
+                result->workerIndex);
+        appendMilliseconds(&report, result->durationMicroseconds);
+        NString.append(&report, ")");
+        NLOGI("", "%s", NString.get(&report));
+    }
+
+    // Report summary,
+    NString.set(&report, "Translated %d file(s) on %d worker(s): %d succeeded, %d failed. Wall time: ", filesCount, workersCount, filesCount - failedFilesCount, failedFilesCount);
+    appendMilliseconds(&report, wallTime);
+    NString.append(&report, ", total translation time: ");
+    appendMilliseconds(&report, totalTranslationTime);
+    NString.append(&report, ".");
+    if (failedFilesCount) {
+        NERROR("BatchTranslation.translateBatch()", "%s", NString.get(&report));
+    } else {
+        NLOGI("", "%s", NString.get(&report));
+    }
+    NString.destroy(&report);
+
+    success = !failedFilesCount;
+    deleteSharedData(sharedData);
+
+    finish:
+    for (int32_t i=0; i<filesCount; i++) NString.destroyAndFree(*(struct NString**) NVector.get(&filePaths, i));
+    NVector.destroy(&filePaths);
+    return success;
+}
@@ -0,0 +1,372 @@
+
+//
+// Throughput benchmark. Per file and stage (parse, codegen and both), it reports every run's
+// duration, the median and its confidence interval, MB/s and AST nodes/s at the median, and the
+// peak resident size. Given a baseline report, it also acts as a regression gate. Runs go through
+// the translator's own entry point, so they pay for validation and preprocessing too.
+//
+// The 18th of October, 2026.
+//
+
+#include <Benchmark.h>
+#include <LanguageDefinition.h>
+#include <CodeGeneration.h>
+#include <Timing.h>
+#include <ReportFormatting.h>
+#include <JSON.h>
+
+#include <NCC.h>
+#include <NSystemUtils.h>
+#include <NString.h>
+#include <NVector.h>
+#include <NCString.h>
+#include <NError.h>
+#include <AllocationProfiler.h> // After NSystemUtils.h, to reroute NMALLOC/NFREE.
+
+#include <stdlib.h>
+
+#define STAGES_COUNT 3
+
+struct StageMeasurements {
+    const char* name;
+    int64_t* durations;   // Nanoseconds, one per run.
+    int64_t peakResidentKilobytes;
+};
+
+struct DurationsSummary {
+    int64_t median;
+    int64_t lowerBound, upperBound;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper functions
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int64_t countASTNodes(struct NCC_ASTNode* tree) {
+    int64_t nodesCount = 1;
+    int32_t childrenCount = NVector.size(&tree->childNodes);
+    for (int32_t i=0; i<childrenCount; i++) nodesCount += countASTNodes(*(struct NCC_ASTNode**) NVector.get(&tree->childNodes, i));
+    return nodesCount;
+}
+
+static int compareDurations(const void* duration1, const void* duration2) {
+    int64_t value1 = *(int64_t*) duration1, value2 = *(int64_t*) duration2;
+    return (value1 > value2) - (value1 < value2);
+}
+
+// The median, and its distribution-free 95% confidence interval: the order statistics at ranks
+// (n -/+ 1.96*sqrt(n))/2, which needs no assumption about how the run times are distributed. With
+// few runs it widens to the slowest and fastest runs,
+static void summarizeDurations(int64_t* durations, int32_t runsCount, struct DurationsSummary* outSummary) {
+    int64_t* sortedDurations = NMALLOC(runsCount * sizeof(int64_t), "Benchmark.summarizeDurations() sortedDurations");
+    NSystemUtils.memcpy(sortedDurations, durations, runsCount * sizeof(int64_t));
+    qsort(sortedDurations, runsCount, sizeof(int64_t), compareDurations);
+
+    outSummary->median = (runsCount & 1) ?
+            sortedDurations[runsCount/2] :
+            (sortedDurations[runsCount/2 - 1] + sortedDurations[runsCount/2]) / 2;
+
+    // ceil(1.96*sqrt(n)), without floating point math,
+    int32_t spread = 0;
+    while ((int64_t) spread*spread*10000 < (int64_t) 38416*runsCount) spread++;
+    int32_t lowerRank = (runsCount - spread) / 2;
+    if (lowerRank < 1) lowerRank = 1;
+    outSummary->lowerBound = sortedDurations[lowerRank - 1];
+    outSummary->upperBound = sortedDurations[runsCount - lowerRank];
+
+    NFREE(sortedDurations, "Benchmark.summarizeDurations() sortedDurations");
+    if (outSummary->median < 1) outSummary->median = 1;
+    if (outSummary->lowerBound < 1) outSummary->lowerBound = 1;
+}
+
+static void appendStage(struct NString* outReport, struct StageMeasurements* stage, int32_t runsCount, int64_t fileSize, int64_t nodesCount) {
+
+    NString.append(outReport, "        \"%s\": {\"seconds\": [", stage->name);
+    for (int32_t i=0; i<runsCount; i++) {
+        if (i) NString.append(outReport, ", ");
+        appendFixedPoint(outReport, stage->durations[i], 9);
+    }
+
+    struct DurationsSummary summary;
+    summarizeDurations(stage->durations, runsCount, &summary);
+    int64_t median = summary.median;
+    NString.append(outReport, "], \"medianSeconds\": ");
+    appendFixedPoint(outReport, median, 9);
+    NString.append(outReport, ", \"confidenceInterval\": [");
+    appendFixedPoint(outReport, summary.lowerBound, 9);
+    NString.append(outReport, ", ");
+    appendFixedPoint(outReport, summary.upperBound, 9);
+    NString.append(outReport, "]");
+    NString.append(outReport, ", \"megabytesPerSecond\": ");
+    appendFixedPoint(outReport, fileSize * 1000000 / median, 3);
+    NString.append(outReport, ", \"astNodesPerSecond\": ");
+    appendInteger64(outReport, nodesCount * 1000000000 / median);
+    NString.append(outReport, ", \"peakResidentKilobytes\": ");
+    appendInteger64(outReport, stage->peakResidentKilobytes);
+    NString.append(outReport, "}");
+}
+
+// Returns the number of AST nodes, or -1 on failure,
+static int64_t benchmarkFile(struct NCC* ncc, const char* code, int32_t runsCount, const struct BenchmarkOptions* options, struct StageMeasurements* stages) {
+
+    int64_t nodesCount = -1;
+    struct NString generatedCode;
+    NString.initialize(&generatedCode, "");
+    for (int32_t i=0; i<runsCount; i++) {
+
+        NString.set(&generatedCode, "");
+        struct TranslationMeasurements measurements;
+        NSystemUtils.memset(&measurements, 0, sizeof(struct TranslationMeasurements));
+        if (!options->translator(ncc, code, &generatedCode, &measurements, options->translatorData)) {
+            NERROR("Benchmark.benchmarkFile()", "Translation failed.");
+            nodesCount = -1;
+            break;
+        }
+        nodesCount = measurements.astNodesCount;
+
+        stages[0].durations[i] = measurements.parseDuration;
+        stages[1].durations[i] = measurements.codeGenerationDuration;
+        stages[2].durations[i] = stages[0].durations[i] + stages[1].durations[i];
+        if (measurements.parsePeakResidentKilobytes > stages[0].peakResidentKilobytes) stages[0].peakResidentKilobytes = measurements.parsePeakResidentKilobytes;
+        if (measurements.codeGenerationPeakResidentKilobytes > stages[1].peakResidentKilobytes) stages[1].peakResidentKilobytes = measurements.codeGenerationPeakResidentKilobytes;
+    }
+    if (stages[0].peakResidentKilobytes > stages[1].peakResidentKilobytes) {
+        stages[2].peakResidentKilobytes = stages[0].peakResidentKilobytes;
+    } else {
+        stages[2].peakResidentKilobytes = stages[1].peakResidentKilobytes;
+    }
+
+    NString.destroy(&generatedCode);
+    return nodesCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Baseline comparison
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct BaselineComparison {
+    char* baselineText;
+    struct JSONValue* baseline;
+    struct NString table;
+    int32_t regressionsCount;
+};
+
+#define COMPARISON_COLUMNS_COUNT 9
+static const int32_t comparisonColumnWidths[COMPARISON_COLUMNS_COUNT] = { 48, 9, 14, 14, 9, 12, 12, 9, 10 };
+
+static boolean loadBaseline(const char* baselineFilePath, struct BaselineComparison* comparison) {
+    NSystemUtils.memset(comparison, 0, sizeof(struct BaselineComparison));
+    int32_t fileSize = NSystemUtils.getFileSize(baselineFilePath, False);
+    if (fileSize <= 0) {
+        NERROR("Benchmark.loadBaseline()", "Baseline not found: %s%s%s", NTCOLOR(HIGHLIGHT), baselineFilePath, NTCOLOR(STREAM_DEFAULT));
+        return False;
+    }
+    comparison->baselineText = NMALLOC(fileSize+1, "Benchmark.loadBaseline() comparison->baselineText");
+    NSystemUtils.readFromFile(baselineFilePath, False, 0, 0, comparison->baselineText);
+    comparison->baselineText[fileSize] = 0;
+    comparison->baseline = parseJSON(comparison->baselineText);
+    if (!comparison->baseline || !getJSONMember(comparison->baseline, "files")) {
+        NERROR("Benchmark.loadBaseline()", "Not a benchmark report: %s%s%s", NTCOLOR(HIGHLIGHT), baselineFilePath, NTCOLOR(STREAM_DEFAULT));
+        if (comparison->baseline) deleteJSONValue(comparison->baseline);
+        NFREE(comparison->baselineText, "Benchmark.loadBaseline() comparison->baselineText");
+        return False;
+    }
+
+    const char* headers[COMPARISON_COLUMNS_COUNT] = { "workload", "stage", "base MB/s", "MB/s", "change", "base RSS KB", "RSS KB", "change", "verdict" };
+    NString.initialize(&comparison->table, "Compared to %s (a slower stage only counts if the confidence intervals don't overlap):\n", baselineFilePath);
+    for (int32_t i=0; i<COMPARISON_COLUMNS_COUNT; i++) appendPadded(&comparison->table, headers[i], comparisonColumnWidths[i], (i > 1) && (i < 8));
+    NString.append(&comparison->table, "  \n");
+    return True;
+}
+
+static void destroyBaselineComparison(struct BaselineComparison* comparison) {
+    deleteJSONValue(comparison->baseline);
+    NFREE(comparison->baselineText, "Benchmark.destroyBaselineComparison() comparison->baselineText");
+    NString.destroy(&comparison->table);
+}
+
+static struct JSONValue* findBaselineFile(struct BaselineComparison* comparison, const char* filePath) {
+
+    struct NString baselinePath;
+    NString.initialize(&baselinePath, "");
+    struct JSONValue* files = getJSONMember(comparison->baseline, "files");
+    struct JSONValue* baselineFile = 0;
+    int32_t filesCount = getJSONArraySize(files);
+    for (int32_t i=0; (i<filesCount) && !baselineFile; i++) {
+        struct JSONValue* file = getJSONArrayElement(files, i);
+        struct JSONValue* path = getJSONMember(file, "path");
+        if (!path) continue;
+        getJSONString(path, &baselinePath);
+        if (NCString.equals(NString.get(&baselinePath), filePath)) baselineFile = file;
+    }
+    NString.destroy(&baselinePath);
+    return baselineFile;
+}
+
+// Appends value*10^-decimalsCount as a cell. Changes are signed percentages, other values are "-"
+// if negative (unavailable),
+static void appendComparisonCell(struct BaselineComparison* comparison, int32_t column, int64_t value, int32_t decimalsCount, boolean isChange) {
+    struct NString cell;
+    NString.initialize(&cell, (isChange && (value >= 0)) ? "+" : "");
+    if ((value < 0) && !isChange) {
+        NString.set(&cell, "-");
+    } else if (decimalsCount) {
+        appendFixedPoint(&cell, value, decimalsCount);
+    } else {
+        appendInteger64(&cell, value);
+    }
+    if (isChange) NString.append(&cell, "%s", "%");
+    appendPadded(&comparison->table, NString.get(&cell), comparisonColumnWidths[column], True);
+    NString.destroy(&cell);
+}
+
+static void compareStage(
+        struct BaselineComparison* comparison, const struct BenchmarkOptions* options,
+        const char* filePath, int64_t fileSize, struct StageMeasurements* stage, struct JSONValue* baselineFile) {
+
+    appendPadded(&comparison->table, filePath, comparisonColumnWidths[0], False);
+    appendPadded(&comparison->table, stage->name, comparisonColumnWidths[1], False);
+
+    struct JSONValue* baselineStage = baselineFile ? getJSONMember(baselineFile, stage->name) : 0;
+    struct JSONValue* baselineSeconds = baselineStage ? getJSONMember(baselineStage, "seconds") : 0;
+    int32_t baselineRunsCount = baselineSeconds ? getJSONArraySize(baselineSeconds) : 0;
+    if (!baselineRunsCount) {
+        NString.append(&comparison->table, "  new\n");
+        return;
+    }
+
+    // Throughputs (bytes per second) at the medians and the confidence interval bounds,
+    struct DurationsSummary summary, baselineSummary;
+    summarizeDurations(stage->durations, options->runsCount, &summary);
+    int64_t* baselineDurations = NMALLOC(baselineRunsCount * sizeof(int64_t), "Benchmark.compareStage() baselineDurations");
+    for (int32_t i=0; i<baselineRunsCount; i++) baselineDurations[i] = getJSONFixedPoint(getJSONArrayElement(baselineSeconds, i), 9);
+    summarizeDurations(baselineDurations, baselineRunsCount, &baselineSummary);
+    NFREE(baselineDurations, "Benchmark.compareStage() baselineDurations");
+
+    struct JSONValue* baselineBytes = getJSONMember(baselineFile, "bytes");
+    int64_t baselineFileSize = baselineBytes ? getJSONFixedPoint(baselineBytes, 0) : fileSize;
+    int64_t throughput = fileSize * 1000000000 / summary.median;
+    int64_t fastestThroughput = fileSize * 1000000000 / summary.lowerBound;
+    int64_t baselineThroughput = baselineFileSize * 1000000000 / baselineSummary.median;
+    int64_t slowestBaselineThroughput = baselineFileSize * 1000000000 / baselineSummary.upperBound;
+    if (baselineThroughput < 1) baselineThroughput = 1;
+    int64_t throughputChange = (throughput - baselineThroughput) * 1000 / baselineThroughput; // Per mille.
+
+    // Peak resident sizes (-1 when unavailable),
+    struct JSONValue* baselinePeak = getJSONMember(baselineStage, "peakResidentKilobytes");
+    int64_t baselinePeakResidentKilobytes = baselinePeak ? getJSONFixedPoint(baselinePeak, 0) : -1;
+    boolean peaksAvailable = (baselinePeakResidentKilobytes > 0) && (stage->peakResidentKilobytes > 0);
+    int64_t peakChange = peaksAvailable ?
+            (stage->peakResidentKilobytes - baselinePeakResidentKilobytes) * 1000 / baselinePeakResidentKilobytes : 0;
+
+    // A slowdown only counts if it's past the threshold and not within the noise,
+    boolean slower = throughputChange < -options->throughputThreshold * 10;
+    boolean noisy = slower && (fastestThroughput >= slowestBaselineThroughput);
+    boolean larger = peaksAvailable && (peakChange > options->memoryThreshold * 10);
+    const char* verdict = "ok";
+    if (slower && !noisy && larger) {
+        verdict = "SLOWER+RSS";
+    } else if (slower && !noisy) {
+        verdict = "SLOWER";
+    } else if (larger) {
+        verdict = "RSS";
+    } else if (noisy) {
+        verdict = "noisy";
+    }
+    if ((slower && !noisy) || larger) comparison->regressionsCount++;
+
+    appendComparisonCell(comparison, 2, baselineThroughput / 1000, 3, False);
+    appendComparisonCell(comparison, 3, throughput / 1000, 3, False);
+    appendComparisonCell(comparison, 4, throughputChange, 1, True);
+    appendComparisonCell(comparison, 5, baselinePeakResidentKilobytes, 0, False);
+    appendComparisonCell(comparison, 6, stage->peakResidentKilobytes, 0, False);
+    if (peaksAvailable) {
+        appendComparisonCell(comparison, 7, peakChange, 1, True);
+    } else {
+        appendPadded(&comparison->table, "-", comparisonColumnWidths[7], True);
+    }
+    NString.append(&comparison->table, "  %s\n", verdict);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Benchmark
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boolean runBenchmark(struct NCC* ncc, struct NVector* inputFiles, const struct BenchmarkOptions* options) {
+
+    struct BaselineComparison comparison;
+    if (options->baselineFilePath && !loadBaseline(options->baselineFilePath, &comparison)) return False;
+
+    int32_t runsCount = options->runsCount;
+    struct StageMeasurements stages[STAGES_COUNT] = { { "parse" }, { "codegen" }, { "total" } };
+    for (int32_t i=0; i<STAGES_COUNT; i++) stages[i].durations = NMALLOC(runsCount * sizeof(int64_t), "Benchmark.runBenchmark() stages[i].durations");
+
+    struct NString report;
+    NString.initialize(&report, "{\n    \"languageDefinition\": ");
+    appendJSONString(&report, getLanguageDefinitionVersion());
+    NString.append(&report, ",\n    \"codeGeneration\": ");
+    appendJSONString(&report, getCodeGenerationVersion());
+    NString.append(&report, ",\n    \"runs\": %d,\n    \"files\": [", runsCount);
+
+    boolean success = True;
+    int32_t filesCount = NVector.size(inputFiles);
+    for (int32_t i=0; i<filesCount; i++) {
+        const char* filePath = *(const char**) NVector.get(inputFiles, i);
+        NLOGI("Benchmark", "%s", filePath);
+
+        // Read,
+        int32_t fileSize = NSystemUtils.getFileSize(filePath, False);
+        if (fileSize < 0) fileSize = 0;
+        char* code = NMALLOC(fileSize+1, "Benchmark.runBenchmark() code");
+        NSystemUtils.readFromFile(filePath, False, 0, 0, code);
+        code[fileSize] = 0;
+
+        // Measure,
+        for (int32_t j=0; j<STAGES_COUNT; j++) stages[j].peakResidentKilobytes = -1;
+        int64_t nodesCount = benchmarkFile(ncc, code, runsCount, options, stages);
+        NFREE(code, "Benchmark.runBenchmark() code");
+
+        // Report,
+        NString.append(&report, "%s\n      {\n        \"path\": ", i ? "," : "");
+        appendJSONString(&report, filePath);
+        NString.append(&report, ",\n        \"bytes\": %d,\n        \"success\": %s", fileSize, (nodesCount >= 0) ? "true" : "false");
+        if (nodesCount >= 0) {
+            NString.append(&report, ",\n        \"astNodes\": ");
+            appendInteger64(&report, nodesCount);
+            for (int32_t j=0; j<STAGES_COUNT; j++) {
+                NString.append(&report, ",\n");
+                appendStage(&report, &stages[j], runsCount, fileSize, nodesCount);
+            }
+        } else {
+            success = False;
+        }
+        NString.append(&report, "\n      }");
+
+        // Compare,
+        if (options->baselineFilePath && (nodesCount >= 0)) {
+            struct JSONValue* baselineFile = findBaselineFile(&comparison, filePath);
+            for (int32_t j=0; j<STAGES_COUNT; j++) compareStage(&comparison, options, filePath, fileSize, &stages[j], baselineFile);
+        }
+    }
+    NString.append(&report, "\n    ]\n}\n");
+
+    if (!NSystemUtils.writeToFile(options->reportFilePath, NString.get(&report), NString.length(&report), False)) {
+        NERROR("Benchmark.runBenchmark()", "Couldn't write: %s%s%s", NTCOLOR(HIGHLIGHT), options->reportFilePath, NTCOLOR(STREAM_DEFAULT));
+        success = False;
+    }
+
+    // Gate,
+    if (options->baselineFilePath) {
+        NLOGI("", "%s", NString.get(&comparison.table));
+        if (comparison.regressionsCount) {
+            NERROR("Benchmark.runBenchmark()", "%s%d%s stage(s) regressed past the thresholds (throughput: -%d percent, peak resident size: +%d percent).",
+                    NTCOLOR(HIGHLIGHT), comparison.regressionsCount, NTCOLOR(STREAM_DEFAULT), options->throughputThreshold, options->memoryThreshold);
+            success = False;
+        }
+        destroyBaselineComparison(&comparison);
+    }
+
+    NString.destroy(&report);
+    for (int32_t i=0; i<STAGES_COUNT; i++) NFREE(stages[i].durations, "Benchmark.runBenchmark() stages[i].durations");
+    return success;
+}
@@ -17,21 +17,19 @@
 // TODO: fix arrays are not primitive types...
 // TODO: remove the need to write "class" before declaring a class variable...
 // TODO: Make functions a first class citizen...
-// TODO: Add managed/new/delete/weak keywords to be used for allocations, where:
-//          => new and delete allocate normally, no automatic collection.
-//          => managed is garbage collected. It's a replacement for new/delete.
-//          => weak is a qualifier (like const). A weak reference doesn't influence collection, it's used to test if an object is still alive.
 
 #include <CodeGeneration.h>
+#include <ParallelJobs.h>
+#include <Timing.h>
 
 #include <NCC.h>
 #include <NSystemUtils.h>
 #include <NCString.h>
 #include <NError.h>
-
-#define COLORIZE_CODE 0
+#include <AllocationProfiler.h> // After NSystemUtils.h, to reroute NMALLOC/NFREE.
 
 #define TAB "    "
+#define RUNTIME_INCLUDE "#include <AddaatRuntime.h>\n\n"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Code constructs
@@ -47,10 +45,18 @@
 #define TYPE_FLOAT   7
 #define TYPE_DOUBLE  8
 
+// Class layouts. Unless stated otherwise, members are reordered to minimize the padding,
+#define CLASS_LAYOUT_REORDERED 0
+#define CLASS_LAYOUT_STABLE    1 // Declaration order, naturally aligned.
+#define CLASS_LAYOUT_PACKED    2 // Declaration order, no padding at all.
+
+#define CACHE_LINE_SIZE 64
+
 struct VariableType {
     int32_t type;
     int32_t classIndex;
     int32_t arrayDepth;
+    boolean weak; // A weak reference to the array (an AddaatWeak, see Runtime/AddaatRuntime.h).
 };
 
 struct VariableInfo {
@@ -76,6 +82,20 @@ struct ClassInfo {
     struct NString name;
     struct NVector members; // struct VariableInfo*.
     boolean defined;
+    int32_t layout;
+    boolean structureOfArrays; // Arrays of it keep each member in an array of its own.
+    int32_t size, alignment; // Once defined.
+    boolean holdsWeakReferences; // In its members, or its class members', once defined.
+};
+
+struct DeferredError {
+    struct NString tag, message;
+};
+
+// A weak reference read in a postfix expression, ending after the child at the index,
+struct WeakRead {
+    int32_t childIndex;
+    struct VariableType type; // What it reads as.
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -85,7 +105,7 @@ struct ClassInfo {
 struct CodeGenerationData;
 
 static boolean parseStatement(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData);
-static boolean parseCompoundStatement(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, struct NVector* predefinedLocalVariables);
+static boolean parseFunctionBlock(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData);
 static boolean parseExpression(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData);
 static boolean parseAssignmentExpression(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData);
 static boolean parseCastExpression(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData);
@@ -94,15 +114,43 @@ static void destroyAndDeleteVariableInfo(struct VariableInfo* variableInfo);
 static void destroyAndDeleteVariableInfos(struct NVector* variableInfosVector);
 static void destroyAndDeleteFunctionInfo(struct FunctionInfo* functionInfo);
 static void destroyAndDeleteClassInfo(struct ClassInfo* classInfo);
+static int32_t getClassIndex(struct CodeGenerationData* codeGenerationData, const char* className);
+
+static boolean parseTranslationUnitInParallel(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, int32_t workersCount);
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Code generation data
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Code generation walk tasks (see walkCode()),
+#define TASK_PARSE         0
+#define TASK_APPEND        1
+#define TASK_ELSE          2 // Joins an else to the statement before it.
+#define TASK_CLOSE_BLOCK   3
+#define TASK_POP_SCOPE     4 // Cleanup, run even if the walk fails.
+#define TASK_LEAVE_NESTING 5 // Cleanup, run even if the walk fails.
+
+struct CodeGenerationTask {
+    int32_t type;
+    boolean (*parse)(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData);
+    struct NCC_ASTNode* tree;
+    const char* text; // A literal, a node's value or a symbol's name, all of which outlive the walk.
+};
+
 struct CodeGenerationData {
 
     // Generated code,
     struct NString outString;
+    void (*append)(struct CodeGenerationData* codeGenerationData, const char* text);
+
+    // When the global variables are hoisted, class definitions are written apart, to go before
+    // them (the globals may be of class types),
+    boolean hoistClasses;
+    struct NString classesCode;
+
+    // Allocations and weak references need the runtime (Runtime/AddaatRuntime.h), which is included
+    // once anything uses it,
+    boolean usesRuntime, runtimeIncluded;
 
     // Code coloring,
     struct NVector colorStack; // const char*
@@ -115,18 +163,45 @@ struct CodeGenerationData {
     struct NVector globalVariables; // struct VariableInfo*
     struct NVector functions;       // struct FunctionInfo*
     struct NVector classes;         // struct ClassInfo*
+    int32_t flushedGlobalVariablesCount;
+    boolean externVariables; // Globals and class statics are declared, not defined.
 
     // Context,
     struct ClassInfo* currentClass;
     struct FunctionInfo* currentFunction;
     struct NVector scopesStack; // struct Scope*
     int32_t scopesCount;
+
+    // Walk. Statements and expressions are walked off the heap rather than the stack, and their
+    // nesting is bounded so that deep trees fail cleanly instead of taking up memory without end,
+    struct NVector tasks;       // struct CodeGenerationTask, the next one last.
+    struct NVector queuedTasks; // struct CodeGenerationTask, in order.
+    int32_t nestingDepth;
+    int32_t maxNestingDepth;
+
+    // Reports,
+    boolean printClassLayouts;
+
+    // Errors, logged unless there's a reporter. Held back while function bodies are generated out
+    // of order, so that they're reported as if they weren't,
+    void (*reportError)(const char* message, void* data);
+    void* reportErrorData;
+    boolean deferErrors;
+    struct NVector deferredErrors; // struct DeferredError.
 };
 
-static void initializeCodeGenerationData(struct CodeGenerationData* codeGenerationData) {
+static void plainCodeAppend(struct CodeGenerationData* codeGenerationData, const char* text);
+static void colorizedCodeAppend(struct CodeGenerationData* codeGenerationData, const char* text);
 
-    // Generated code,
+static void initializeCodeGenerationData(struct CodeGenerationData* codeGenerationData, const struct CodeGenerationOptions* options) {
+
+    // Generated code (the emitter is picked once, so that the plain one carries no color logic),
     NString.initialize(&codeGenerationData->outString, "");
+    codeGenerationData->append = (options && options->colorize) ? colorizedCodeAppend : plainCodeAppend;
+    codeGenerationData->hoistClasses = False;
+    NString.initialize(&codeGenerationData->classesCode, "");
+    codeGenerationData->usesRuntime = False;
+    codeGenerationData->runtimeIncluded = False;
 
     // Code coloring,
     NVector.initialize(&codeGenerationData->colorStack, 0, sizeof(const char*));
@@ -139,16 +214,34 @@ static void initializeCodeGenerationData(struct CodeGenerationData* codeGenerati
     NVector.initialize(&codeGenerationData->globalVariables, 0, sizeof(struct VariableInfo*));
     NVector.initialize(&codeGenerationData->functions      , 0, sizeof(struct FunctionInfo*));
     NVector.initialize(&codeGenerationData->classes        , 0, sizeof(struct ClassInfo   *));
+    codeGenerationData->flushedGlobalVariablesCount = 0;
+    codeGenerationData->externVariables = options ? options->externVariables : False;
 
     // Context,
     codeGenerationData->currentClass = 0;
     codeGenerationData->currentFunction = 0;
     NVector.initialize(&codeGenerationData->scopesStack, 0, sizeof(struct Scope*));
     codeGenerationData->scopesCount = 0;
+
+    // Walk,
+    NVector.initialize(&codeGenerationData->tasks, 0, sizeof(struct CodeGenerationTask));
+    NVector.initialize(&codeGenerationData->queuedTasks, 0, sizeof(struct CodeGenerationTask));
+    codeGenerationData->nestingDepth = 0;
+    codeGenerationData->maxNestingDepth = options ? options->maxNestingDepth : 0;
+
+    // Reports,
+    codeGenerationData->printClassLayouts = options ? options->printClassLayouts : False;
+
+    // Errors,
+    codeGenerationData->reportError = options ? options->reportError : 0;
+    codeGenerationData->reportErrorData = options ? options->reportErrorData : 0;
+    codeGenerationData->deferErrors = False;
+    NVector.initialize(&codeGenerationData->deferredErrors, 0, sizeof(struct DeferredError));
 }
 
 static void destroyCodeGenerationData(struct CodeGenerationData* codeGenerationData) {
     NString.destroy(&codeGenerationData->outString);
+    NString.destroy(&codeGenerationData->classesCode);
     NVector.destroy(&codeGenerationData->colorStack);
 
     // Global variables,
@@ -169,35 +262,84 @@ static void destroyCodeGenerationData(struct CodeGenerationData* codeGenerationD
 
     // Context,
     NVector.destroy(&codeGenerationData->scopesStack);
+
+    // Walk,
+    NVector.destroy(&codeGenerationData->tasks);
+    NVector.destroy(&codeGenerationData->queuedTasks);
+
+    // Errors,
+    struct DeferredError deferredError;
+    while (NVector.popBack(&codeGenerationData->deferredErrors, &deferredError)) {
+        NString.destroy(&deferredError.tag);
+        NString.destroy(&deferredError.message);
+    }
+    NVector.destroy(&codeGenerationData->deferredErrors);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Helper functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-static void codeAppend(struct CodeGenerationData* codeGenerationData, const char* text) {
+static void reportFormattedError(struct CodeGenerationData* codeGenerationData, const char* tag, const char* message) {
+    if (codeGenerationData->deferErrors) {
+        struct DeferredError* deferredError = NVector.emplaceBack(&codeGenerationData->deferredErrors);
+        NString.initialize(&deferredError->tag, "%s", tag);
+        NString.initialize(&deferredError->message, "%s", message);
+    } else if (codeGenerationData->reportError) {
+        codeGenerationData->reportError(message, codeGenerationData->reportErrorData);
+    } else {
+        NERROR(tag, "%s", message);
+    }
+}
+
+// Semantic errors. Formatted the same either way, then logged, handed to the reporter or deferred.
+// Needs a codeGenerationData in scope,
+#define REPORT_ERROR(tag, ...) \
+    do { \
+        struct NString errorMessage; \
+        NString.initialize(&errorMessage, __VA_ARGS__); \
+        reportFormattedError(codeGenerationData, tag, NString.get(&errorMessage)); \
+        NString.destroy(&errorMessage); \
+    } while (0)
+
+static boolean outStringEndsWith(struct CodeGenerationData* codeGenerationData, const char* text) {
+
+    // Avoids measuring the whole generated code on every call,
+    int32_t outStringLength = NString.length(&codeGenerationData->outString);
+    int32_t textLength = NCString.length(text);
+    if (textLength > outStringLength) return False;
+    return NCString.equals(&NString.get(&codeGenerationData->outString)[outStringLength - textLength], text);
+}
 
-    // Append indentation,
-    if (NCString.endsWith(NString.get(&codeGenerationData->outString), "\n")) {
+static void appendIndentation(struct CodeGenerationData* codeGenerationData) {
+    if (outStringEndsWith(codeGenerationData, "\n")) {
         for (int32_t i=0; i<codeGenerationData->indentationCount; i++) {
             NString.append(&codeGenerationData->outString, TAB);
         }
     }
+}
+
+static void plainCodeAppend(struct CodeGenerationData* codeGenerationData, const char* text) {
+    appendIndentation(codeGenerationData);
+    NString.append(&codeGenerationData->outString, "%s", text);
+}
+
+static void colorizedCodeAppend(struct CodeGenerationData* codeGenerationData, const char* text) {
+
+    appendIndentation(codeGenerationData);
 
     // Add color,
-    if (COLORIZE_CODE) {
-        if (!(NCString.equals(text, " ") || NCString.equals(text, "\n"))) {
-            const char* color;
-            if (NVector.size(&codeGenerationData->colorStack)) {
-                color = *(const char**) NVector.getLast(&codeGenerationData->colorStack);
-            } else {
-                color = NTCOLOR(STREAM_DEFAULT);
-            }
-            // Print color only if it's different from last color used,
-            if (color != codeGenerationData->lastUsedColor) {
-                NString.append(&codeGenerationData->outString, "%s", color);
-                codeGenerationData->lastUsedColor = color;
-            }
+    if (!(NCString.equals(text, " ") || NCString.equals(text, "\n"))) {
+        const char* color;
+        if (NVector.size(&codeGenerationData->colorStack)) {
+            color = *(const char**) NVector.getLast(&codeGenerationData->colorStack);
+        } else {
+            color = NTCOLOR(STREAM_DEFAULT);
+        }
+        // Print color only if it's different from last color used,
+        if (color != codeGenerationData->lastUsedColor) {
+            NString.append(&codeGenerationData->outString, "%s", color);
+            codeGenerationData->lastUsedColor = color;
         }
     }
 
@@ -231,7 +373,7 @@ static void codeAppend(struct CodeGenerationData* codeGenerationData, const char
     NCString.equals(NString.get(&currentChild->name), text)
 
 #define Append(text) \
-    codeAppend(codeGenerationData, text);
+    codeGenerationData->append(codeGenerationData, text);
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Scopes
@@ -268,6 +410,118 @@ static struct Scope* getCurrentScope(struct CodeGenerationData* codeGenerationDa
     return 0;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Nesting
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Every nesting level in the walk goes through a statement or a cast-expression. Pair each
+// successful call with a TASK_LEAVE_NESTING,
+static boolean enterNesting(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
+    if (codeGenerationData->maxNestingDepth && (codeGenerationData->nestingDepth >= codeGenerationData->maxNestingDepth)) {
+        REPORT_ERROR("CodeGeneration.enterNesting()", "%s%s%s nested deeper than %s%d%s levels.",
+                NTCOLOR(HIGHLIGHT), NString.get(&tree->name), NTCOLOR(STREAM_DEFAULT), NTCOLOR(HIGHLIGHT), codeGenerationData->maxNestingDepth, NTCOLOR(STREAM_DEFAULT));
+        return False;
+    }
+    codeGenerationData->nestingDepth++;
+    return True;
+}
+
+static void leaveNesting(struct CodeGenerationData* codeGenerationData) {
+    codeGenerationData->nestingDepth--;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Walk
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Statements and expressions nest as deeply as the input does, so their code isn't generated
+// recursively. Parsing a node appends what comes before its first child right away, then queues
+// the rest (its children, and the code between and after them). The queued tasks run next, in
+// order, before whatever was pending when the node was parsed. Once a task fails, the remaining
+// ones are dropped, except for the cleanups.
+//
+// A child that comes before anything was queued can be parsed right away instead, as long as
+// doing so can't lead back to a node like its parent (an expression within its own parentheses,
+// a statement within a statement). That's what ParseOrQueue is for, the rest are always queued,
+
+static void queueTask(struct CodeGenerationData* codeGenerationData, int32_t type, boolean (*parse)(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData), struct NCC_ASTNode* tree, const char* text) {
+    struct CodeGenerationTask* task = NVector.emplaceBack(&codeGenerationData->queuedTasks);
+    task->type = type;
+    task->parse = parse;
+    task->tree = tree;
+    task->text = text;
+}
+
+#define QueueParse(function, node) \
+    queueTask(codeGenerationData, TASK_PARSE, function, node, 0);
+
+#define QueueAppend(text) \
+    queueTask(codeGenerationData, TASK_APPEND, 0, 0, text);
+
+#define QueueTask(type) \
+    queueTask(codeGenerationData, type, 0, 0, 0);
+
+static boolean parseOrQueue(boolean (*parse)(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData), struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
+    if (!NVector.size(&codeGenerationData->queuedTasks)) return parse(tree, codeGenerationData);
+    queueTask(codeGenerationData, TASK_PARSE, parse, tree, 0);
+    return True;
+}
+
+#define ParseOrQueue(function, node) \
+    if (!parseOrQueue(function, node, codeGenerationData)) return False;
+
+static boolean runTask(struct CodeGenerationTask* task, struct CodeGenerationData* codeGenerationData) {
+    switch (task->type) {
+        case TASK_PARSE:
+            return task->parse(task->tree, codeGenerationData);
+        case TASK_APPEND:
+            Append(task->text)
+            return True;
+        case TASK_ELSE:
+            // Remove the newline if a compound statement came before the else,
+            if (outStringEndsWith(codeGenerationData, "}\n")) {
+                NString.trimEnd(&codeGenerationData->outString, "\n");
+                Append(" else ")
+            } else {
+                Append("else ")
+            }
+            return True;
+        case TASK_CLOSE_BLOCK:
+            codeGenerationData->indentationCount--;
+            Append("}\n")
+            return True;
+        case TASK_POP_SCOPE:
+            popScope(codeGenerationData);
+            return True;
+        case TASK_LEAVE_NESTING:
+            leaveNesting(codeGenerationData);
+            return True;
+    }
+    return False;
+}
+
+static boolean walkCode(struct NCC_ASTNode* tree, boolean (*parse)(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData), struct CodeGenerationData* codeGenerationData) {
+
+    queueTask(codeGenerationData, TASK_PARSE, parse, tree, 0);
+
+    boolean success = True;
+    struct CodeGenerationTask task;
+    while (True) {
+
+        // Queued tasks are stacked last first, so that they're taken in order,
+        while (NVector.popBack(&codeGenerationData->queuedTasks, &task)) NVector.pushBack(&codeGenerationData->tasks, &task);
+        if (!NVector.popBack(&codeGenerationData->tasks, &task)) break;
+
+        if (success) {
+            success = runTask(&task, codeGenerationData);
+        } else if ((task.type == TASK_POP_SCOPE) || (task.type == TASK_LEAVE_NESTING)) {
+            runTask(&task, codeGenerationData);
+        }
+    }
+
+    return success;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Variables
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -293,11 +547,22 @@ static struct VariableInfo* getVariable(struct NVector* variables, const char* v
     return 0;
 }
 
+// Looks in the scopes, innermost first, then in the globals,
+static struct VariableInfo* findVariable(struct CodeGenerationData* codeGenerationData, const char* variableName) {
+    for (int32_t i=NVector.size(&codeGenerationData->scopesStack)-1; i>=0; i--) {
+        struct Scope* scope = *(struct Scope**) NVector.get(&codeGenerationData->scopesStack, i);
+        struct VariableInfo* variableInfo = getVariable(&scope->localVariables, variableName);
+        if (variableInfo) return variableInfo;
+    }
+    return getVariable(&codeGenerationData->globalVariables, variableName);
+}
+
 static boolean typesEqual(struct VariableType* type1, struct VariableType* type2) {
     return
         (type1->type       == type2->type      ) &&
         (type1->classIndex == type2->classIndex) &&
-        (type1->arrayDepth == type2->arrayDepth);
+        (type1->arrayDepth == type2->arrayDepth) &&
+        (type1->weak       == type2->weak      );
 }
 
 static struct VariableType* parseTypeSpecifier(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
@@ -319,6 +584,8 @@ static struct VariableType* parseTypeSpecifier(struct NCC_ASTNode* tree, struct
     //   {enum-specifier}}
     // {${} ${array-specifier}}^*
 
+    // class-specifier = ${class} ${ } ${identifier}
+
     struct VariableType* variableType = NMALLOC(sizeof(struct VariableType), "CodeGeneration.parseTypeSpecifier() variableType");
     NSystemUtils.memset(variableType, 0, sizeof(struct VariableType));
 
@@ -327,7 +594,7 @@ static struct VariableType* parseTypeSpecifier(struct NCC_ASTNode* tree, struct
         variableType->type = TYPE_VOID;
         NextChild
         if (currentChild) {
-            NERROR("parseTypeSpecifier()", "Can't make arrays of void type.");
+            REPORT_ERROR("parseTypeSpecifier()", "Can't make arrays of void type.");
             return 0;
         }
     }
@@ -337,8 +604,18 @@ static struct VariableType* parseTypeSpecifier(struct NCC_ASTNode* tree, struct
     else if (Equals("long"  )) { variableType->type = TYPE_LONG  ; }
     else if (Equals("float" )) { variableType->type = TYPE_FLOAT ; }
     else if (Equals("double")) { variableType->type = TYPE_DOUBLE; }
-    else {
-        // TODO: enum and class...
+    else if (Equals("class-specifier")) {
+        struct NCC_ASTNode* classNameTree = *(struct NCC_ASTNode**) NVector.getLast(&currentChild->childNodes);
+        const char* className = NString.get(&classNameTree->value);
+        variableType->type = TYPE_CLASS;
+        variableType->classIndex = getClassIndex(codeGenerationData, className);
+        if (variableType->classIndex < 0) {
+            REPORT_ERROR("parseTypeSpecifier()", "Unknown class: %s%s%s.", NTCOLOR(HIGHLIGHT), className, NTCOLOR(STREAM_DEFAULT));
+            NFREE(variableType, "CodeGeneration.parseTypeSpecifier() variableType 1");
+            return 0;
+        }
+    } else {
+        // TODO: enum...
     }
 
     NextChild
@@ -348,10 +625,28 @@ static struct VariableType* parseTypeSpecifier(struct NCC_ASTNode* tree, struct
         NextChild
     }
 
+    // Instances need the whole class, arrays (pointers) don't,
+    if ((variableType->type == TYPE_CLASS) && !variableType->arrayDepth) {
+        struct ClassInfo* classInfo = *(struct ClassInfo**) NVector.get(&codeGenerationData->classes, variableType->classIndex);
+        if (!classInfo->defined || (classInfo == codeGenerationData->currentClass)) {
+            REPORT_ERROR("parseTypeSpecifier()", "Class %s%s%s isn't defined yet.", NTCOLOR(HIGHLIGHT), NString.get(&classInfo->name), NTCOLOR(STREAM_DEFAULT));
+            NFREE(variableType, "CodeGeneration.parseTypeSpecifier() variableType 2");
+            return 0;
+        }
+    }
+
     return variableType;
 }
 
 static void appendVariableTypeCode(struct VariableType* type, struct CodeGenerationData* codeGenerationData) {
+
+    // Weak references are handles, whatever they refer to,
+    if (type->weak) {
+        codeGenerationData->usesRuntime = True;
+        Append("AddaatWeak")
+        return;
+    }
+
     switch (type->type) {
         case TYPE_VOID  : Append("void"   ) break;
         case TYPE_CHAR  : Append("char"   ) break;
@@ -360,8 +655,22 @@ static void appendVariableTypeCode(struct VariableType* type, struct CodeGenerat
         case TYPE_LONG  : Append("int64_t") break;
         case TYPE_FLOAT : Append("float"  ) break;
         case TYPE_DOUBLE: Append("double" ) break;
+        case TYPE_CLASS : {
+            // Arrays of structure-of-arrays classes are containers of member arrays,
+            struct ClassInfo* classInfo = *(struct ClassInfo**) NVector.get(&codeGenerationData->classes, type->classIndex);
+            if (classInfo->structureOfArrays && type->arrayDepth) {
+                Append("struct _")
+                Append(NString.get(&classInfo->name))
+                Append("_soa_")
+                for (int32_t i=1; i<type->arrayDepth; i++) Append("*")
+                return;
+            }
+            Append("struct ")
+            Append(NString.get(&classInfo->name))
+            break;
+        }
         default:
-            // TODO: enum and class...
+            // TODO: enum...
             break;
     }
 
@@ -375,6 +684,41 @@ static struct VariableInfo* cloneVariable(struct VariableInfo* variableToClone,
     return newVariable;
 }
 
+// Weak references can't be left undefined (they're read through the runtime's slots), and neither
+// can instances of classes that hold them, nested or not,
+static boolean holdsWeakReferences(struct VariableType* type, struct CodeGenerationData* codeGenerationData) {
+    if (type->weak) return True;
+    if ((type->type != TYPE_CLASS) || type->arrayDepth) return False;
+    return (*(struct ClassInfo**) NVector.get(&codeGenerationData->classes, type->classIndex))->holdsWeakReferences;
+}
+
+// Weak references are to arrays (that's what new and managed allocate). Arrays of
+// structure-of-arrays classes are containers rather than allocations, so they can't be referred to
+// weakly, and neither can they hold weak references (each member would be an array of them),
+static boolean checkWeakType(struct VariableType* type, struct CodeGenerationData* codeGenerationData) {
+
+    if (!type->arrayDepth) {
+        REPORT_ERROR("checkWeakType()", "Only array references can be weak.");
+        return False;
+    }
+
+    if (type->type == TYPE_CLASS) {
+        struct ClassInfo* classInfo = *(struct ClassInfo**) NVector.get(&codeGenerationData->classes, type->classIndex);
+        if (classInfo->structureOfArrays && (type->arrayDepth == 1)) {
+            REPORT_ERROR("checkWeakType()", "Arrays of %s%s%s can't be referred to weakly.", NTCOLOR(HIGHLIGHT), NString.get(&classInfo->name), NTCOLOR(STREAM_DEFAULT));
+            return False;
+        }
+    }
+
+    struct ClassInfo* currentClass = codeGenerationData->currentClass;
+    if (currentClass && currentClass->structureOfArrays) {
+        REPORT_ERROR("checkWeakType()", "%s%s%s can't have weak members.", NTCOLOR(HIGHLIGHT), NString.get(&currentClass->name), NTCOLOR(STREAM_DEFAULT));
+        return False;
+    }
+
+    return True;
+}
+
 static boolean parseVariableDeclaration(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, struct NVector* outputVector, boolean allowDuplicates) {
 
     // declaration: static int[][] c, d;
@@ -398,6 +742,7 @@ static boolean parseVariableDeclaration(struct NCC_ASTNode* tree, struct CodeGen
     // └─;: ;
 
     // ${declaration-specifiers} ${+ } ${identifier-list} ${} ${;}
+    // declaration-specifiers = {${storage-class-specifier} ${}}|${ε} {${type-qualifier} ${}}|${ε} ${type-specifier}
 
     // Create variable,
     struct VariableInfo* newVariable = NMALLOC(sizeof(struct VariableInfo), "CodeGeneration.parseVariableDeclaration() newVariable");
@@ -412,16 +757,26 @@ static boolean parseVariableDeclaration(struct NCC_ASTNode* tree, struct CodeGen
         newVariable->isStatic = False;
     }
 
+    // Parse type qualifier (we only have weak),
+    boolean weak = Equals("weak");
+    if (weak) NextChild
+
     // Parse type specifier,
     struct VariableType* variableType = parseTypeSpecifier(currentChild, codeGenerationData);
     if (!variableType) {
         NFREE(newVariable, "CodeGeneration.parseVariableDeclaration() newVariable 1");
         return False;
     }
+    if (weak && !checkWeakType(variableType, codeGenerationData)) {
+        NFREE( newVariable, "CodeGeneration.parseVariableDeclaration() newVariable 4");
+        NFREE(variableType, "CodeGeneration.parseVariableDeclaration() variableType 3");
+        return False;
+    }
+    variableType->weak = weak;
 
     // Check for voids,
     if (variableType->type == TYPE_VOID) {
-        NERROR("parseVariableDeclaration()", "Void is not a valid variable type.");
+        REPORT_ERROR("parseVariableDeclaration()", "Void is not a valid variable type.");
         NFREE( newVariable, "CodeGeneration.parseVariableDeclaration() newVariable 2");
         NFREE(variableType, "CodeGeneration.parseVariableDeclaration() variableType 1");
         return False;
@@ -436,7 +791,7 @@ static boolean parseVariableDeclaration(struct NCC_ASTNode* tree, struct CodeGen
     struct VariableInfo* existingVariable = getVariable(outputVector, VALUE);
     if (existingVariable &&
         (!allowDuplicates || !typesEqual(&newVariable->type, &existingVariable->type))) {
-        NERROR("parseVariableDeclaration()", "Variable redefinition: %s%s%s.", NTCOLOR(HIGHLIGHT), VALUE, NTCOLOR(STREAM_DEFAULT));
+        REPORT_ERROR("parseVariableDeclaration()", "Variable redefinition: %s%s%s.", NTCOLOR(HIGHLIGHT), VALUE, NTCOLOR(STREAM_DEFAULT));
         NFREE( newVariable, "CodeGeneration.parseVariableDeclaration() newVariable 3");
         return False;
     }
@@ -452,7 +807,7 @@ static boolean parseVariableDeclaration(struct NCC_ASTNode* tree, struct CodeGen
         existingVariable = getVariable(outputVector, VALUE);
         if (existingVariable &&
             (!allowDuplicates || !typesEqual(&newVariable->type, &existingVariable->type))) {
-            NERROR("parseVariableDeclaration()", "Variable redefinition: %s%s%s.", NTCOLOR(HIGHLIGHT), VALUE, NTCOLOR(STREAM_DEFAULT));
+            REPORT_ERROR("parseVariableDeclaration()", "Variable redefinition: %s%s%s.", NTCOLOR(HIGHLIGHT), VALUE, NTCOLOR(STREAM_DEFAULT));
             return False;
         }
 
@@ -481,7 +836,7 @@ static boolean addLocalVariable(struct VariableInfo* newLocalVariable, struct Co
 
     // Check duplicates within this scope,
     if (getVariable(&scope->localVariables, NString.get(&newLocalVariable->name))) {
-        NERROR("CodeGeneration.addLocalVariable()", "Variable redefinition: %s%s%s.", NTCOLOR(HIGHLIGHT), NString.get(&newLocalVariable->name), NTCOLOR(STREAM_DEFAULT));
+        REPORT_ERROR("CodeGeneration.addLocalVariable()", "Variable redefinition: %s%s%s.", NTCOLOR(HIGHLIGHT), NString.get(&newLocalVariable->name), NTCOLOR(STREAM_DEFAULT));
         return False;
     }
 
@@ -496,7 +851,7 @@ static boolean addLocalVariable(struct VariableInfo* newLocalVariable, struct Co
         NString.destroyAndFree(globalVersionName);
         NVector.pushBack(&codeGenerationData->globalVariables, &globalVersion);
     } else {
-        appendVariableDeclarationCode(newLocalVariable, codeGenerationData, "", "");
+        appendVariableDeclarationCode(newLocalVariable, codeGenerationData, "", holdsWeakReferences(&newLocalVariable->type, codeGenerationData) ? " = {0}" : "");
         Append("\n")
     }
 
@@ -597,6 +952,13 @@ static struct FunctionInfo* parseFunctionHead(struct NCC_ASTNode* tree, struct C
         newFunction->isStatic = False;
     }
 
+    // Weak references are stored, not returned,
+    if (Equals("weak")) {
+        REPORT_ERROR("parseFunctionHead()", "Functions can't return weak references.");
+        NFREE(newFunction, "CodeGeneration.parseFunctionHead() newFunction");
+        return 0;
+    }
+
     // Parse type specifier,
     struct VariableType* returnType = parseTypeSpecifier(currentChild, codeGenerationData);
     if (!returnType) {
@@ -626,7 +988,7 @@ static struct FunctionInfo* parseFunctionHead(struct NCC_ASTNode* tree, struct C
 
         // Check for voids,
         if (parameterType->type == TYPE_VOID) {
-            NERROR("parseFunctionHead()", "Void is not a valid parameter type.");
+            REPORT_ERROR("parseFunctionHead()", "Void is not a valid parameter type.");
             NFREE(parameterType, "CodeGeneration.parseFunctionHead() parameterType 1");
             destroyAndDeleteFunctionInfo(newFunction);
             return 0;
@@ -635,7 +997,7 @@ static struct FunctionInfo* parseFunctionHead(struct NCC_ASTNode* tree, struct C
         // Check for duplicates,
         NextChild
         if (getVariable(&newFunction->parameters, VALUE)) {
-            NERROR("parseFunctionHead()", "Parameter redefinition: %s%s%s.", NTCOLOR(HIGHLIGHT), VALUE, NTCOLOR(STREAM_DEFAULT));
+            REPORT_ERROR("parseFunctionHead()", "Parameter redefinition: %s%s%s.", NTCOLOR(HIGHLIGHT), VALUE, NTCOLOR(STREAM_DEFAULT));
             NFREE(parameterType, "CodeGeneration.parseFunctionHead() parameterType 2");
             destroyAndDeleteFunctionInfo(newFunction);
             return 0;
@@ -683,10 +1045,9 @@ static void appendFunctionDeclarationCode(struct FunctionInfo* function, struct
     Append(";")
 }
 
-static boolean parseGlobalFunctionDeclaration(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
+static boolean declareGlobalFunction(struct NCC_ASTNode* functionHeadTree, struct CodeGenerationData* codeGenerationData) {
 
-    Begin
-    struct FunctionInfo* newFunction = parseFunctionHead(currentChild, codeGenerationData);
+    struct FunctionInfo* newFunction = parseFunctionHead(functionHeadTree, codeGenerationData);
     if (!newFunction) return False;
 
     // If it's new, add it and return,
@@ -703,18 +1064,24 @@ static boolean parseGlobalFunctionDeclaration(struct NCC_ASTNode* tree, struct C
     if (duplicate) {
         appendFunctionDeclarationCode(newFunction, codeGenerationData, "", "");
     } else {
-        NERROR("CodeGeneration.parseGlobalFunctionDeclaration()", "Function %s%s%s redeclared with a different signature.", NTCOLOR(HIGHLIGHT), NString.get(&existingFunction->name), NTCOLOR(STREAM_DEFAULT));
+        REPORT_ERROR("CodeGeneration.parseGlobalFunctionDeclaration()", "Function %s%s%s redeclared with a different signature.", NTCOLOR(HIGHLIGHT), NString.get(&existingFunction->name), NTCOLOR(STREAM_DEFAULT));
     }
     destroyAndDeleteFunctionInfo(newFunction);
 
     return duplicate;
 }
 
-static boolean parseGlobalFunctionDefinition(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
-
+static boolean parseGlobalFunctionDeclaration(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
     Begin
-    struct FunctionInfo* newFunction = parseFunctionHead(currentChild, codeGenerationData);
-    if (!newFunction) return False;
+    return declareGlobalFunction(currentChild, codeGenerationData);
+}
+
+// Everything but the body. Returns the function to generate the body with, which is a temporary
+// (to be deleted once the body is generated) if the function was declared before,
+static struct FunctionInfo* defineGlobalFunction(struct NCC_ASTNode* functionHeadTree, struct NCC_ASTNode* bodyTree, struct CodeGenerationData* codeGenerationData, boolean* outTemporary) {
+
+    struct FunctionInfo* newFunction = parseFunctionHead(functionHeadTree, codeGenerationData);
+    if (!newFunction) return 0;
 
     // Look for an existing declaration,
     struct FunctionInfo* existingFunction = getFunction(&codeGenerationData->functions, NString.get(&newFunction->name));
@@ -722,17 +1089,17 @@ static boolean parseGlobalFunctionDefinition(struct NCC_ASTNode* tree, struct Co
 
         // If it's redefinition, throw,
         if (existingFunction->body) {
-            NERROR("CodeGeneration.parseGlobalFunctionDefinition()", "Function %s%s%s redefinition.", NTCOLOR(HIGHLIGHT), NString.get(&existingFunction->name), NTCOLOR(STREAM_DEFAULT));
+            REPORT_ERROR("CodeGeneration.parseGlobalFunctionDefinition()", "Function %s%s%s redefinition.", NTCOLOR(HIGHLIGHT), NString.get(&existingFunction->name), NTCOLOR(STREAM_DEFAULT));
             destroyAndDeleteFunctionInfo(newFunction);
-            return False;
+            return 0;
         }
 
         // Check if the signature changed,
         // TODO: allow polymorphism...
         if (!sameSignature(newFunction, existingFunction)) {
-            NERROR("CodeGeneration.parseGlobalFunctionDefinition()", "Function %s%s%s defined with a different signature.", NTCOLOR(HIGHLIGHT), NString.get(&existingFunction->name), NTCOLOR(STREAM_DEFAULT));
+            REPORT_ERROR("CodeGeneration.parseGlobalFunctionDefinition()", "Function %s%s%s defined with a different signature.", NTCOLOR(HIGHLIGHT), NString.get(&existingFunction->name), NTCOLOR(STREAM_DEFAULT));
             destroyAndDeleteFunctionInfo(newFunction);
-            return False;
+            return 0;
         }
     } else {
         NVector.pushBack(&codeGenerationData->functions, &newFunction);
@@ -741,16 +1108,32 @@ static boolean parseGlobalFunctionDefinition(struct NCC_ASTNode* tree, struct Co
     appendFunctionHeadCode(newFunction, codeGenerationData, "", "");
     Append(" ")
 
-    // Parse function body,
-    NextChild
-    newFunction->body = currentChild;
-    codeGenerationData->currentFunction = newFunction;
-    boolean success = parseCompoundStatement(currentChild, codeGenerationData, &newFunction->parameters);
+    newFunction->body = bodyTree;
+    *outTemporary = existingFunction != 0;
+    return newFunction;
+}
+
+static boolean parseFunctionBody(struct NCC_ASTNode* tree, struct FunctionInfo* function, struct CodeGenerationData* codeGenerationData) {
+    codeGenerationData->currentFunction = function;
+    boolean success = walkCode(tree, parseFunctionBlock, codeGenerationData);
     codeGenerationData->currentFunction = 0;
+    return success;
+}
 
-    // Clean up,
-    if (existingFunction) destroyAndDeleteFunctionInfo(newFunction);
+static boolean parseGlobalFunctionDefinition(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
+
+    // function-definition = ${function-head} ${} ${compound-statement}
+
+    Begin
+    struct NCC_ASTNode* functionHeadTree = currentChild;
+    NextChild
+
+    boolean temporary;
+    struct FunctionInfo* function = defineGlobalFunction(functionHeadTree, currentChild, codeGenerationData, &temporary);
+    if (!function) return False;
 
+    boolean success = parseFunctionBody(currentChild, function, codeGenerationData);
+    if (temporary) destroyAndDeleteFunctionInfo(function);
     return success;
 }
 
@@ -763,6 +1146,11 @@ static struct ClassInfo* createClass(struct CodeGenerationData* codeGenerationDa
     NString.initialize(&newClass->name, "%s", className);
     NVector.initialize(&newClass->members, 0, sizeof(struct VariableInfo*));
     newClass->defined = False;
+    newClass->layout = CLASS_LAYOUT_REORDERED;
+    newClass->structureOfArrays = False;
+    newClass->size = 0;
+    newClass->alignment = 1;
+    newClass->holdsWeakReferences = False;
 
     NVector.pushBack(&codeGenerationData->classes, &newClass);
     return newClass;
@@ -775,44 +1163,216 @@ static void destroyAndDeleteClassInfo(struct ClassInfo* classInfo) {
     NFREE(classInfo, "CodeGeneration.destroyAndDeleteClassInfo() classInfo");
 }
 
-static struct ClassInfo* getClass(struct CodeGenerationData* codeGenerationData, const char* className) {
+static int32_t getClassIndex(struct CodeGenerationData* codeGenerationData, const char* className) {
     for (int32_t i=NVector.size(&codeGenerationData->classes)-1; i>=0; i--) {
         struct ClassInfo* classInfo = *(struct ClassInfo**) NVector.get(&codeGenerationData->classes, i);
-        if (NCString.equals(className, NString.get(&classInfo->name))) return classInfo;
+        if (NCString.equals(className, NString.get(&classInfo->name))) return i;
     }
-    return 0;
+    return -1;
+}
+
+static struct ClassInfo* getClass(struct CodeGenerationData* codeGenerationData, const char* className) {
+    int32_t classIndex = getClassIndex(codeGenerationData, className);
+    return (classIndex < 0) ? 0 : *(struct ClassInfo**) NVector.get(&codeGenerationData->classes, classIndex);
+}
+
+// Sizes and alignments as the generated code has them: fixed-width integers, natural alignment,
+// and arrays as pointers (the size of this platform's),
+static void getTypeLayout(struct VariableType* type, struct CodeGenerationData* codeGenerationData, int32_t* outSize, int32_t* outAlignment) {
+
+    // Weak references are a slot and a generation,
+    if (type->weak) {
+        *outSize = 8;
+        *outAlignment = 4;
+        return;
+    }
+
+    int32_t size;
+    if (type->type == TYPE_CLASS) {
+        struct ClassInfo* classInfo = *(struct ClassInfo**) NVector.get(&codeGenerationData->classes, type->classIndex);
+        if (!type->arrayDepth) {
+            *outSize = classInfo->size;
+            *outAlignment = classInfo->alignment;
+            return;
+        }
+
+        // A structure-of-arrays container holds a pointer per non-static member,
+        if (classInfo->structureOfArrays && (type->arrayDepth == 1)) {
+            int32_t pointersCount = 0;
+            for (int32_t i=NVector.size(&classInfo->members)-1; i>=0; i--) {
+                if (!(*(struct VariableInfo**) NVector.get(&classInfo->members, i))->isStatic) pointersCount++;
+            }
+            *outSize = pointersCount * (int32_t) sizeof(void*);
+            *outAlignment = pointersCount ? (int32_t) sizeof(void*) : 1;
+            return;
+        }
+        size = (int32_t) sizeof(void*);
+    } else if (type->arrayDepth) {
+        size = (int32_t) sizeof(void*);
+    } else {
+        switch (type->type) {
+            case TYPE_CHAR  : size = 1; break;
+            case TYPE_SHORT : size = 2; break;
+            case TYPE_INT   : size = 4; break;
+            case TYPE_LONG  : size = 8; break;
+            case TYPE_FLOAT : size = 4; break;
+            case TYPE_DOUBLE: size = 8; break;
+            default         : size = 4; break; // Enums.
+        }
+    }
+    *outSize = size;
+    *outAlignment = size;
+}
+
+// Lays the members out in order, as the C compiler would. Sets each member's offset if outOffsets
+// is given. Returns the padding,
+static int32_t layOutMembers(struct NVector* members, boolean packed, struct CodeGenerationData* codeGenerationData, int32_t* outOffsets, int32_t* outSize, int32_t* outAlignment) {
+    int32_t offset = 0, padding = 0, classAlignment = 1;
+    int32_t membersCount = NVector.size(members);
+    for (int32_t i=0; i<membersCount; i++) {
+        struct VariableInfo* member = *(struct VariableInfo**) NVector.get(members, i);
+        int32_t size, alignment;
+        getTypeLayout(&member->type, codeGenerationData, &size, &alignment);
+        if (packed) alignment = 1;
+        int32_t memberPadding = (alignment - (offset % alignment)) % alignment;
+        padding += memberPadding;
+        offset += memberPadding;
+        if (outOffsets) outOffsets[i] = offset;
+        offset += size;
+        if (alignment > classAlignment) classAlignment = alignment;
+    }
+
+    // Trailing padding, so that array elements stay aligned,
+    int32_t tailPadding = (classAlignment - (offset % classAlignment)) % classAlignment;
+    *outSize = offset + tailPadding;
+    *outAlignment = classAlignment;
+    return padding + tailPadding;
+}
+
+// Fills the vector with the non-static members, in the order they should be laid out in,
+static void orderMembers(struct ClassInfo* class, struct CodeGenerationData* codeGenerationData, struct NVector* outOrderedMembers) {
+
+    int32_t membersCount = NVector.size(&class->members);
+    for (int32_t i=0; i<membersCount; i++) {
+        struct VariableInfo* member = *(struct VariableInfo**) NVector.get(&class->members, i);
+        if (!member->isStatic) NVector.pushBack(outOrderedMembers, &member);
+    }
+    if (class->layout != CLASS_LAYOUT_REORDERED) return;
+
+    // Decreasing alignment leaves no padding between members, since sizes are multiples of
+    // alignments. The sort is stable (insertion), so equally aligned members keep their order,
+    int32_t orderedMembersCount = NVector.size(outOrderedMembers);
+    struct VariableInfo** orderedMembers = NVector.get(outOrderedMembers, 0);
+    for (int32_t i=1; i<orderedMembersCount; i++) {
+        struct VariableInfo* member = orderedMembers[i];
+        int32_t size, alignment;
+        getTypeLayout(&member->type, codeGenerationData, &size, &alignment);
+        int32_t j = i;
+        for (; j>0; j--) {
+            int32_t previousSize, previousAlignment;
+            getTypeLayout(&orderedMembers[j-1]->type, codeGenerationData, &previousSize, &previousAlignment);
+            if (previousAlignment >= alignment) break;
+            orderedMembers[j] = orderedMembers[j-1];
+        }
+        orderedMembers[j] = member;
+    }
+}
+
+static void logClassLayout(struct ClassInfo* class, struct NVector* orderedMembers, struct CodeGenerationData* codeGenerationData) {
+
+    int32_t membersCount = NVector.size(orderedMembers);
+    int32_t* offsets = NMALLOC((membersCount ? membersCount : 1) * sizeof(int32_t), "CodeGeneration.logClassLayout() offsets");
+    int32_t size, alignment;
+    int32_t padding = layOutMembers(orderedMembers, class->layout == CLASS_LAYOUT_PACKED, codeGenerationData, offsets, &size, &alignment);
+
+    // An instance starting at a cache line spans the fewest lines. Elsewhere (as in most array
+    // elements), it can straddle one more,
+    int32_t cacheLinesCount = (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE;
+    int32_t unalignedCacheLinesCount = size ? ((size + CACHE_LINE_SIZE - alignment - 1) / CACHE_LINE_SIZE) + 1 : 0;
+
+    const char* layoutName = (class->layout == CLASS_LAYOUT_PACKED) ? "packed" : (class->layout == CLASS_LAYOUT_STABLE) ? "stable" : class->structureOfArrays ? "reordered, arrays are structures of arrays" : "reordered";
+    NLOGI("CodeGeneration", "Class %s%s%s (%s): %d bytes, %d of them padding, aligned to %d, spans %d cache line(s), up to %d unless line aligned.",
+            NTCOLOR(HIGHLIGHT), NString.get(&class->name), NTCOLOR(STREAM_DEFAULT), layoutName, size, padding, alignment, cacheLinesCount, unalignedCacheLinesCount);
+
+    // What reordering saved,
+    if (class->layout == CLASS_LAYOUT_REORDERED) {
+        struct NVector declaredMembers;
+        NVector.initialize(&declaredMembers, 0, sizeof(struct VariableInfo*));
+        for (int32_t i=0; i<NVector.size(&class->members); i++) {
+            struct VariableInfo* member = *(struct VariableInfo**) NVector.get(&class->members, i);
+            if (!member->isStatic) NVector.pushBack(&declaredMembers, &member);
+        }
+        int32_t declaredSize, declaredAlignment;
+        layOutMembers(&declaredMembers, False, codeGenerationData, 0, &declaredSize, &declaredAlignment);
+        NVector.destroy(&declaredMembers);
+        if (declaredSize != size) NLOGI("CodeGeneration", "    %d bytes in declaration order.", declaredSize);
+    }
+
+    for (int32_t i=0; i<membersCount; i++) {
+        struct VariableInfo* member = *(struct VariableInfo**) NVector.get(orderedMembers, i);
+        int32_t memberSize, memberAlignment;
+        getTypeLayout(&member->type, codeGenerationData, &memberSize, &memberAlignment);
+        NLOGI("CodeGeneration", "    %d: %s (%d bytes)", offsets[i], NString.get(&member->name), memberSize);
+    }
+
+    NFREE(offsets, "CodeGeneration.logClassLayout() offsets");
 }
 
 static boolean parseClassDeclaration(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
 
+    // {${class-layout} ${ }}|${ε}
     // ${class} ${+ } ${identifier}
     //   {${} ${;} ${+\n}} |
     //   {${+ } ${OB} {${+\n} ${declaration-list}}|${ε} ${} ${CB} ${+\n}}
     Begin
 
+    // Layout modifier,
+    int32_t layout = CLASS_LAYOUT_REORDERED;
+    boolean structureOfArrays = False;
+    if (Equals("packed") || Equals("stable") || Equals("soa")) {
+        if (Equals("packed")) {
+            layout = CLASS_LAYOUT_PACKED;
+        } else if (Equals("stable")) {
+            layout = CLASS_LAYOUT_STABLE;
+        } else {
+            structureOfArrays = True;
+        }
+        NextChild
+    }
+
     // Skip the "class" keyword,
-    Append("struct ");
     NextChild
 
     // Parse class name, if not and existing one, create new,
     const char* className = VALUE;
     struct ClassInfo* class = getClass(codeGenerationData, className);
     if (!class) class = createClass(codeGenerationData, className);
-    Append(className);
     NextChild
 
     // Return if semi-colon found (forward-declaration),
     if (Equals(";")) {
+        if ((layout != CLASS_LAYOUT_REORDERED) || structureOfArrays) {
+            REPORT_ERROR("parseClassSpecifier()", "Layout modifiers go on the class definition.");
+            return False;
+        }
+        Append("struct ")
+        Append(className)
         Append(";")
         return True;
     }
 
     // Skip open bracket,
     if (class->defined) {
-        NERROR("parseClassSpecifier()", "Class redefinition.");
+        REPORT_ERROR("parseClassSpecifier()", "Class redefinition.");
         return False;
     }
     class->defined = True;
+    class->layout = layout;
+    class->structureOfArrays = structureOfArrays;
+    codeGenerationData->currentClass = class;
+    if (layout == CLASS_LAYOUT_PACKED) Append("#pragma pack(push, 1)\n")
+    Append("struct ")
+    Append(className)
     Append(" {")
     NextChild
     if (!Equals("CB")) Append("\n")
@@ -823,16 +1383,57 @@ static boolean parseClassDeclaration(struct NCC_ASTNode* tree, struct CodeGenera
         // Check if closing bracket reached,
         if (Equals("CB")) {
 
-            // Append non-static variables code,
-            int32_t membersCount = NVector.size(&class->members);
-            for (int32_t i=0; i<membersCount; i++) {
-                struct VariableInfo* currentVariable = *(struct VariableInfo**) NVector.get(&class->members, i);
-                if (currentVariable->isStatic) continue;
+            // Append non-static variables code, in layout order,
+            struct NVector orderedMembers;
+            NVector.initialize(&orderedMembers, 0, sizeof(struct VariableInfo*));
+            orderMembers(class, codeGenerationData, &orderedMembers);
+            int32_t orderedMembersCount = NVector.size(&orderedMembers);
+            for (int32_t i=0; i<orderedMembersCount; i++) {
                 Append(TAB)
-                appendVariableDeclarationCode(currentVariable, codeGenerationData, "", "");
+                appendVariableDeclarationCode(*(struct VariableInfo**) NVector.get(&orderedMembers, i), codeGenerationData, "", "");
                 Append("\n")
             }
             Append("};\n")
+            if (layout == CLASS_LAYOUT_PACKED) Append("#pragma pack(pop)\n")
+
+            layOutMembers(&orderedMembers, layout == CLASS_LAYOUT_PACKED, codeGenerationData, 0, &class->size, &class->alignment);
+            for (int32_t i=NVector.size(&orderedMembers)-1; i>=0; i--) {
+                struct VariableInfo* member = *(struct VariableInfo**) NVector.get(&orderedMembers, i);
+                if (holdsWeakReferences(&member->type, codeGenerationData)) class->holdsWeakReferences = True;
+            }
+            if (codeGenerationData->printClassLayouts) logClassLayout(class, &orderedMembers, codeGenerationData);
+            NVector.destroy(&orderedMembers);
+            codeGenerationData->currentClass = 0;
+
+            // Arrays of structure-of-arrays classes get a container, with an array per non-static
+            // member (in declaration order, they're all pointers),
+            int32_t membersCount = NVector.size(&class->members);
+            if (structureOfArrays) {
+                Append("struct _")
+                Append(className)
+                Append("_soa_ {\n")
+                for (int32_t i=0; i<membersCount; i++) {
+                    struct VariableInfo* currentVariable = *(struct VariableInfo**) NVector.get(&class->members, i);
+                    if (currentVariable->isStatic) continue;
+                    Append(TAB)
+
+                    // Class instance members are kept in plain arrays, their own arrays in containers,
+                    struct VariableInfo arrayVariable = *currentVariable;
+                    arrayVariable.type.arrayDepth++;
+                    if ((currentVariable->type.type == TYPE_CLASS) && !currentVariable->type.arrayDepth) {
+                        struct ClassInfo* memberClass = *(struct ClassInfo**) NVector.get(&codeGenerationData->classes, currentVariable->type.classIndex);
+                        Append("struct ")
+                        Append(NString.get(&memberClass->name))
+                        Append("* ")
+                        Append(NString.get(&currentVariable->name))
+                        Append(";")
+                    } else {
+                        appendVariableDeclarationCode(&arrayVariable, codeGenerationData, "", "");
+                    }
+                    Append("\n")
+                }
+                Append("};\n")
+            }
 
             // Append static variables code,
             struct NString prefix;
@@ -841,6 +1442,7 @@ static boolean parseClassDeclaration(struct NCC_ASTNode* tree, struct CodeGenera
             for (int32_t i=0; i<membersCount; i++) {
                 struct VariableInfo* currentVariable = *(struct VariableInfo**) NVector.get(&class->members, i);
                 if (!currentVariable->isStatic) continue;
+                if (codeGenerationData->externVariables) Append("extern ")
                 appendVariableDeclarationCode(currentVariable, codeGenerationData, prefixCString, "_");
                 Append("\n")
             }
@@ -850,7 +1452,10 @@ static boolean parseClassDeclaration(struct NCC_ASTNode* tree, struct CodeGenera
         }
 
         // Parse variable declaration,
-        if (!parseVariableDeclaration(currentChild, codeGenerationData, &class->members, False)) return False;
+        if (!parseVariableDeclaration(currentChild, codeGenerationData, &class->members, False)) {
+            codeGenerationData->currentClass = 0;
+            return False;
+        }
 
         NextChild
     }
@@ -880,8 +1485,8 @@ static boolean parsePrimaryExpression(struct NCC_ASTNode* tree, struct CodeGener
 
     if (Equals("expression")) {
         Append("(")
-        if (!parseExpression(currentChild, codeGenerationData)) return False;
-        Append(")")
+        QueueParse(parseExpression, currentChild)
+        QueueAppend(")")
         return True;
     }
 
@@ -897,20 +1502,151 @@ static boolean parseArgumentExpressionList(struct NCC_ASTNode* tree, struct Code
 
     Begin
 
-    if (!parseAssignmentExpression(currentChild, codeGenerationData)) return False;
+    ParseOrQueue(parseAssignmentExpression, currentChild)
     NextChild
 
     while (currentChild) {
-        Append(", ")
+        QueueAppend(", ")
         NextChild
 
-        if (!parseAssignmentExpression(currentChild, codeGenerationData)) return False;
+        QueueParse(parseAssignmentExpression, currentChild)
         NextChild
     }
     return True;
 }
 
-static boolean parsePostFixExpression(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
+// The type a postfix-expression chain starts with, if its primary-expression names a variable. If
+// it names a function instead, outFunction is set, for the return type once it's called,
+static boolean getPrimaryExpressionType(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, struct VariableType* outType, struct FunctionInfo** outFunction) {
+    *outFunction = 0;
+    struct NCC_ASTNode** identifierTree = NVector.get(&tree->childNodes, 0);
+    if (!identifierTree || !NCString.equals(NString.get(&(*identifierTree)->name), "identifier")) return False;
+    struct VariableInfo* variable = findVariable(codeGenerationData, NString.get(&(*identifierTree)->value));
+    if (variable) {
+        *outType = variable->type;
+        return True;
+    }
+    *outFunction = getFunction(&codeGenerationData->functions, NString.get(&(*identifierTree)->value));
+    return False;
+}
+
+// Follows the type along a postfix-expression chain, through the operator at the child index (its
+// operands come after it). Returns whether the type is still known,
+static boolean followPostFixType(struct NCC_ASTNode* tree, int32_t childIndex, struct FunctionInfo* function, boolean typeKnown, struct VariableType* type, struct CodeGenerationData* codeGenerationData) {
+
+    const char* operator = NString.get(&(*(struct NCC_ASTNode**) NVector.get(&tree->childNodes, childIndex))->name);
+    if (NCString.equals(operator, "[")) {
+        if (!typeKnown || !type->arrayDepth) return False;
+        type->arrayDepth--;
+        return True;
+    }
+
+    // Functions have their return types, once they're called,
+    if (NCString.equals(operator, "argument-expression-list")) {
+        if (!function || (childIndex != 1)) return False;
+        *type = function->returnType;
+        return True;
+    }
+
+    if (NCString.equals(operator, ".")) {
+        if (!typeKnown || (type->type != TYPE_CLASS) || type->arrayDepth) return False;
+        struct ClassInfo* classInfo = *(struct ClassInfo**) NVector.get(&codeGenerationData->classes, type->classIndex);
+        struct NCC_ASTNode** memberTree = NVector.get(&tree->childNodes, childIndex+1);
+        struct VariableInfo* member = getVariable(&classInfo->members, NString.get(&(*memberTree)->value));
+        if (!member || member->isStatic) return False;
+        *type = member->type;
+        return True;
+    }
+
+    return False;
+}
+
+// The type of a whole postfix-expression, if it can be followed,
+static boolean getPostFixExpressionType(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, struct VariableType* outType) {
+
+    Begin
+    struct FunctionInfo* function;
+    boolean typeKnown = getPrimaryExpressionType(currentChild, codeGenerationData, outType, &function);
+    NextChild
+    while (currentChild) {
+        typeKnown = followPostFixType(tree, currentChildIndex, function, typeKnown, outType, codeGenerationData);
+        if (Equals("[")) {
+            NextChild NextChild // Skip to the ].
+        } else if (Equals(".")) {
+            NextChild
+        }
+        NextChild
+    }
+    return typeKnown;
+}
+
+// The class, if the type is an array of a structure-of-arrays class (a container of member
+// arrays),
+static struct ClassInfo* getStructureOfArraysClass(struct VariableType* type, struct CodeGenerationData* codeGenerationData) {
+    if ((type->type != TYPE_CLASS) || (type->arrayDepth != 1) || type->weak) return 0;
+    struct ClassInfo* classInfo = *(struct ClassInfo**) NVector.get(&codeGenerationData->classes, type->classIndex);
+    return classInfo->structureOfArrays ? classInfo : 0;
+}
+
+// Walks the chain ahead of generating it, tracking the types it can, to find where weak references
+// are read. Fills outWeakReads if given. Returns how many there are, or -1 if a weak reference is
+// misused. Unless they're read, assignees that are weak references set outWeakAssignee,
+static int32_t findWeakReads(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, boolean assignee, struct WeakRead* outWeakReads, boolean* outWeakAssignee) {
+
+    Begin
+    *outWeakAssignee = False;
+
+    // The primary expression's type, if it's a variable,
+    struct VariableType type;
+    struct FunctionInfo* function;
+    boolean typeKnown = getPrimaryExpressionType(currentChild, codeGenerationData, &type, &function);
+
+    int32_t weakReadsCount = 0, lastChildIndex = 0;
+    NextChild
+    while (True) {
+
+        // Weak references are read, unless assigned to,
+        if (typeKnown && type.weak) {
+            if (!currentChild && assignee) {
+                *outWeakAssignee = True;
+                break;
+            }
+            if (currentChild && (Equals("++") || Equals("--"))) {
+                REPORT_ERROR("parsePostFixExpression()", "Weak references can only be read or assigned.");
+                return -1;
+            }
+            type.weak = False;
+            if (outWeakReads) {
+                outWeakReads[weakReadsCount].childIndex = lastChildIndex;
+                outWeakReads[weakReadsCount].type = type;
+            }
+            weakReadsCount++;
+        }
+        if (!currentChild) break;
+
+        typeKnown = followPostFixType(tree, currentChildIndex, function, typeKnown, &type, codeGenerationData);
+        if (Equals("[")) {
+            NextChild NextChild // Skip to the ].
+        } else if (Equals(".")) {
+            NextChild
+        }
+
+        lastChildIndex = currentChildIndex;
+        NextChild
+    }
+
+    return weakReadsCount;
+}
+
+// Queues closing the weak read that ends after the child, if any,
+static void closeWeakRead(int32_t childIndex, struct WeakRead* weakReads, int32_t weakReadsCount, int32_t* nextWeakReadIndex, struct CodeGenerationData* codeGenerationData) {
+    if ((*nextWeakReadIndex < weakReadsCount) && (weakReads[*nextWeakReadIndex].childIndex == childIndex)) {
+        QueueAppend("))")
+        (*nextWeakReadIndex)++;
+    }
+}
+
+static boolean parsePostFixChain(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, struct WeakRead* weakReads, int32_t weakReadsCount) {
 
     // postfix-expression = ${primary-expression} {
     //                         {${} ${[}  ${} ${expression} ${} ${]} } |
@@ -921,61 +1657,224 @@ static boolean parsePostFixExpression(struct NCC_ASTNode* tree, struct CodeGener
     //                      }^*
 
     Begin
+    int32_t nextWeakReadIndex = 0;
+
+    // Elements of structure-of-arrays arrays are only reached through their members, so the
+    // subscript that picks the element moves after the member ("particles[i].x" becomes
+    // "particles.x[i]", "holder.particles[i].x" becomes "holder.particles.x[i]"). The type is
+    // followed along the chain to find them,
+    struct VariableType type;
+    struct FunctionInfo* function;
+    boolean typeKnown = getPrimaryExpressionType(currentChild, codeGenerationData, &type, &function);
 
     if (!parsePrimaryExpression(currentChild, codeGenerationData)) return False;
+    closeWeakRead(currentChildIndex, weakReads, weakReadsCount, &nextWeakReadIndex, codeGenerationData);
     NextChild
 
     while (currentChild) {
 
-        if (Equals("[")) {
-            Append("[")
+        struct ClassInfo* structureOfArraysClass = typeKnown ? getStructureOfArraysClass(&type, codeGenerationData) : 0;
+        typeKnown = followPostFixType(tree, currentChildIndex, function, typeKnown, &type, codeGenerationData);
+        if (Equals("[") && structureOfArraysClass) {
+
+            // [ expression ] . identifier
+            struct NCC_ASTNode** indexTree  = NVector.get(&tree->childNodes, currentChildIndex+1);
+            struct NCC_ASTNode** dotTree    = NVector.get(&tree->childNodes, currentChildIndex+3);
+            struct NCC_ASTNode** memberTree = NVector.get(&tree->childNodes, currentChildIndex+4);
+            if (!dotTree || !NCString.equals(NString.get(&(*dotTree)->name), ".")) {
+                REPORT_ERROR("parsePostFixExpression()", "Elements of %s%s%s arrays are only reached through their members.",
+                        NTCOLOR(HIGHLIGHT), NString.get(&structureOfArraysClass->name), NTCOLOR(STREAM_DEFAULT));
+                return False;
+            }
+            struct VariableInfo* member = getVariable(&structureOfArraysClass->members, NString.get(&(*memberTree)->value));
+            if (!member || member->isStatic) {
+                REPORT_ERROR("parsePostFixExpression()", "%s%s%s has no member named %s%s%s.",
+                        NTCOLOR(HIGHLIGHT), NString.get(&structureOfArraysClass->name), NTCOLOR(STREAM_DEFAULT),
+                        NTCOLOR(HIGHLIGHT), NString.get(&(*memberTree)->value), NTCOLOR(STREAM_DEFAULT));
+                return False;
+            }
+
+            QueueAppend(".")
+            QueueParse(parseIdentifier, *memberTree)
+            QueueAppend("[")
+            QueueParse(parseExpression, *indexTree)
+            QueueAppend("]")
+
+            // Skip to the member,
+            type = member->type;
+            NextChild NextChild NextChild NextChild
+        } else if (Equals("[")) {
+            QueueAppend("[")
             NextChild
 
-            if (!parseExpression(currentChild, codeGenerationData)) return False;
+            QueueParse(parseExpression, currentChild)
             NextChild
 
-            Append("]")
+            QueueAppend("]")
         } else if (Equals("argument-expression-list")) {
-            Append("(")
-            if (!parseArgumentExpressionList(currentChild, codeGenerationData)) return False;
-            Append(")")
+            QueueAppend("(")
+            QueueParse(parseArgumentExpressionList, currentChild)
+            QueueAppend(")")
         } else if (Equals(".")) {
-            Append(".")
+            QueueAppend(".")
             NextChild
 
-            if (!parseIdentifier(currentChild, codeGenerationData)) return False;
+            QueueParse(parseIdentifier, currentChild)
         } else {
-            Append(VALUE)
+            QueueAppend(VALUE)
         }
 
+        closeWeakRead(currentChildIndex, weakReads, weakReadsCount, &nextWeakReadIndex, codeGenerationData);
         NextChild
     }
 
     return True;
 }
 
-static boolean parseUnaryExpression(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
+// Assignees that are weak references have their address written, for the assignment expression to
+// pass to the runtime,
+static boolean parsePostFixExpression(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, boolean assignee) {
+
+    // Weak references read as their arrays, or as 0 once they're gone. Each read wraps the chain
+    // up to it, so the reads are found before anything's written ("a.b[0].c", with b and c weak,
+    // becomes "((T*) addaatGetWeak(((U*) addaatGetWeak(a.b))[0].c))"),
+    boolean weakAssignee;
+    int32_t weakReadsCount = findWeakReads(tree, codeGenerationData, assignee, 0, &weakAssignee);
+    if (weakReadsCount < 0) return False;
+    if (weakAssignee) {
+        codeGenerationData->usesRuntime = True;
+        Append("addaatSetWeak(&")
+    }
+    if (!weakReadsCount) return parsePostFixChain(tree, codeGenerationData, 0, 0);
+
+    struct WeakRead* weakReads = NMALLOC(weakReadsCount * sizeof(struct WeakRead), "CodeGeneration.parsePostFixExpression() weakReads");
+    findWeakReads(tree, codeGenerationData, assignee, weakReads, &weakAssignee);
+    codeGenerationData->usesRuntime = True;
+    for (int32_t i=weakReadsCount-1; i>=0; i--) {
+        Append("((")
+        appendVariableTypeCode(&weakReads[i].type, codeGenerationData);
+        Append(") addaatGetWeak(")
+    }
+
+    boolean success = parsePostFixChain(tree, codeGenerationData, weakReads, weakReadsCount);
+    NFREE(weakReads, "CodeGeneration.parsePostFixExpression() weakReads");
+    return success;
+}
+
+static boolean parseAllocationExpression(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
+
+    // allocation-expression = ${new}|${managed} ${ } ${type-specifier}
+    //                         {${} ${[} ${} ${expression} ${} ${]}}|${ε}
+
+    // "new int[n]" becomes "((int32_t*) addaatNew(sizeof(int32_t), n))", an array of one element
+    // if the count is left out. Managed objects are cleared, and so are new ones that hold weak
+    // references,
+    Begin
+    boolean managed = Equals("managed");
+    NextChild
+
+    struct VariableType* elementType = parseTypeSpecifier(currentChild, codeGenerationData);
+    if (!elementType) return False;
+    if (elementType->type == TYPE_VOID) {
+        REPORT_ERROR("parseAllocationExpression()", "Can't allocate void.");
+        NFREE(elementType, "CodeGeneration.parseAllocationExpression() elementType 1");
+        return False;
+    }
+    codeGenerationData->usesRuntime = True;
+    const char* allocator =
+            managed ? "addaatManaged(sizeof(" :
+            holdsWeakReferences(elementType, codeGenerationData) ? "addaatNewCleared(sizeof(" : "addaatNew(sizeof(";
+
+    // Arrays of structure-of-arrays classes are containers of member arrays. Each member array is
+    // allocated into a new container ("new Particle[n]" becomes "(*(struct _Particle_soa_*)
+    // addaatNewArrays(&(struct _Particle_soa_) {0}, (const size_t[]) {sizeof(float), ...}, 2, n))"),
+    struct VariableType arrayType = *elementType;
+    arrayType.arrayDepth++;
+    struct ClassInfo* structureOfArraysClass = getStructureOfArraysClass(&arrayType, codeGenerationData);
+    if (structureOfArraysClass) {
+        Append("(*(")
+        appendVariableTypeCode(&arrayType, codeGenerationData);
+        Append("*) ")
+        Append(managed ? "addaatManagedArrays(&(" : "addaatNewArrays(&(")
+        appendVariableTypeCode(&arrayType, codeGenerationData);
+        Append(") {0}, (const size_t[]) {")
+        int32_t arraysCount = 0;
+        int32_t membersCount = NVector.size(&structureOfArraysClass->members);
+        for (int32_t i=0; i<membersCount; i++) {
+            struct VariableInfo* member = *(struct VariableInfo**) NVector.get(&structureOfArraysClass->members, i);
+            if (member->isStatic) continue;
+            if (arraysCount++) Append(", ")
+            Append("sizeof(")
+            appendVariableTypeCode(&member->type, codeGenerationData);
+            Append(")")
+        }
+        struct NString arraysCountString;
+        NString.initialize(&arraysCountString, "}, %d, ", arraysCount);
+        Append(NString.get(&arraysCountString))
+        NString.destroy(&arraysCountString);
+    } else {
+        Append("((")
+        appendVariableTypeCode(elementType, codeGenerationData);
+        Append("*) ")
+        Append(allocator)
+        appendVariableTypeCode(elementType, codeGenerationData);
+        Append("), ")
+    }
+    NFREE(elementType, "CodeGeneration.parseAllocationExpression() elementType 2");
+
+    // Count,
+    NextChild
+    if (currentChild) {
+        NextChild // Skip the [.
+        QueueParse(parseExpression, currentChild)
+        QueueAppend("))")
+    } else {
+        Append("1))")
+    }
+    return True;
+}
+
+// Assignees are written as parsePostFixExpression() writes them,
+static boolean parseUnaryExpression(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, boolean assignee) {
 
-    // unary-expression  = ${postfix-expression} |
+    // unary-expression  = ${postfix-expression}    |
+    //                     ${allocation-expression} |
     //                     { ${++}             ${} ${unary-expression} } |
     //                     { ${--}             ${} ${unary-expression} } |
     //                     { ${unary-operator} ${}  ${cast-expression} }
 
-    Begin
-    if (Equals("postfix-expression")) return parsePostFixExpression(currentChild, codeGenerationData);
+    // Prefix operators are walked in a loop, so that long chains of them don't use up the stack,
+    while (True) {
+        Begin
+        if (Equals("postfix-expression")) return parsePostFixExpression(currentChild, codeGenerationData, assignee);
+        if (Equals("allocation-expression")) return parseAllocationExpression(currentChild, codeGenerationData);
 
-    // Parse operator,
-    Append(VALUE)
-    NextChild
+        // Parse operator (what it applies to isn't an assignee),
+        assignee = False;
+        Append(VALUE)
+        NextChild
 
-    boolean success = False;
-    if (Equals("unary-expression")) {
-        success = parseUnaryExpression(currentChild, codeGenerationData);
-    } else if (Equals("cast-expression")) {
-        success = parseCastExpression(currentChild, codeGenerationData);
+        if (Equals("cast-expression")) {
+            QueueParse(parseCastExpression, currentChild)
+            return True;
+        }
+        if (!Equals("unary-expression")) return False;
+        tree = currentChild;
     }
+}
 
-    return success;
+// For queueing,
+static boolean parseAssigneeExpression(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
+    return parseUnaryExpression(tree, codeGenerationData, True);
+}
+
+// Sets outWeakAssignee if the unary-expression is a weak reference being assigned to. Returns False
+// if a weak reference is misused in it,
+static boolean findWeakAssignee(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, boolean* outWeakAssignee) {
+    *outWeakAssignee = False;
+    Begin
+    if (!Equals("postfix-expression")) return True;
+    return findWeakReads(currentChild, codeGenerationData, True, 0, outWeakAssignee) >= 0;
 }
 
 static boolean parseCastExpression(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
@@ -983,16 +1882,22 @@ static boolean parseCastExpression(struct NCC_ASTNode* tree, struct CodeGenerati
     //                   { ${(} ${} ${identifier} ${} ${)} ${} ${cast-expression} }
 
     Begin
+    if (!enterNesting(tree, codeGenerationData)) return False;
 
-    if (Equals("unary-expression")) return parseUnaryExpression(currentChild, codeGenerationData);
-
-    // TODO: make sure the identifier is a valid type name (take care of classes)...
-    Append("(")
-    Append(VALUE)
-    NextChild
-    Append(")")
+    boolean success = True;
+    if (Equals("unary-expression")) {
+        success = parseUnaryExpression(currentChild, codeGenerationData, False);
+    } else {
+        // TODO: make sure the identifier is a valid type name (take care of classes)...
+        Append("(")
+        Append(VALUE)
+        NextChild
+        Append(")")
+        QueueParse(parseCastExpression, currentChild)
+    }
 
-    return parseCastExpression(currentChild, codeGenerationData);
+    QueueTask(TASK_LEAVE_NESTING)
+    return success;
 }
 
 static boolean parseMultiplicativeExpression(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
@@ -1002,16 +1907,16 @@ static boolean parseMultiplicativeExpression(struct NCC_ASTNode* tree, struct Co
 
     Begin
 
-    if (!parseCastExpression(currentChild, codeGenerationData)) return False;
+    ParseOrQueue(parseCastExpression, currentChild)
     NextChild
 
     while (currentChild) {
-        Append(" ")
-        Append(VALUE)
-        Append(" ")
+        QueueAppend(" ")
+        QueueAppend(VALUE)
+        QueueAppend(" ")
         NextChild
 
-        if (!parseCastExpression(currentChild, codeGenerationData)) return False;
+        QueueParse(parseCastExpression, currentChild)
         NextChild
     }
     return True;
@@ -1024,16 +1929,16 @@ static boolean parseAdditiveExpression(struct NCC_ASTNode* tree, struct CodeGene
 
     Begin
 
-    if (!parseMultiplicativeExpression(currentChild, codeGenerationData)) return False;
+    ParseOrQueue(parseMultiplicativeExpression, currentChild)
     NextChild
 
     while (currentChild) {
-        Append(" ")
-        Append(VALUE)
-        Append(" ")
+        QueueAppend(" ")
+        QueueAppend(VALUE)
+        QueueAppend(" ")
         NextChild
 
-        if (!parseMultiplicativeExpression(currentChild, codeGenerationData)) return False;
+        QueueParse(parseMultiplicativeExpression, currentChild)
         NextChild
     }
     return True;
@@ -1046,16 +1951,16 @@ static boolean parseShiftExpression(struct NCC_ASTNode* tree, struct CodeGenerat
 
     Begin
 
-    if (!parseAdditiveExpression(currentChild, codeGenerationData)) return False;
+    ParseOrQueue(parseAdditiveExpression, currentChild)
     NextChild
 
     while (currentChild) {
-        Append(" ")
-        Append(VALUE)
-        Append(" ")
+        QueueAppend(" ")
+        QueueAppend(VALUE)
+        QueueAppend(" ")
         NextChild
 
-        if (!parseAdditiveExpression(currentChild, codeGenerationData)) return False;
+        QueueParse(parseAdditiveExpression, currentChild)
         NextChild
     }
     return True;
@@ -1068,16 +1973,16 @@ static boolean parseRelationalExpression(struct NCC_ASTNode* tree, struct CodeGe
 
     Begin
 
-    if (!parseShiftExpression(currentChild, codeGenerationData)) return False;
+    ParseOrQueue(parseShiftExpression, currentChild)
     NextChild
 
     while (currentChild) {
-        Append(" ")
-        Append(VALUE)
-        Append(" ")
+        QueueAppend(" ")
+        QueueAppend(VALUE)
+        QueueAppend(" ")
         NextChild
 
-        if (!parseShiftExpression(currentChild, codeGenerationData)) return False;
+        QueueParse(parseShiftExpression, currentChild)
         NextChild
     }
     return True;
@@ -1090,16 +1995,16 @@ static boolean parseEqualityExpression(struct NCC_ASTNode* tree, struct CodeGene
 
     Begin
 
-    if (!parseRelationalExpression(currentChild, codeGenerationData)) return False;
+    ParseOrQueue(parseRelationalExpression, currentChild)
     NextChild
 
     while (currentChild) {
-        Append(" ")
-        Append(VALUE)
-        Append(" ")
+        QueueAppend(" ")
+        QueueAppend(VALUE)
+        QueueAppend(" ")
         NextChild
 
-        if (!parseRelationalExpression(currentChild, codeGenerationData)) return False;
+        QueueParse(parseRelationalExpression, currentChild)
         NextChild
     }
     return True;
@@ -1112,14 +2017,14 @@ static boolean parseAndExpression(struct NCC_ASTNode* tree, struct CodeGeneratio
 
     Begin
 
-    if (!parseEqualityExpression(currentChild, codeGenerationData)) return False;
+    ParseOrQueue(parseEqualityExpression, currentChild)
     NextChild
 
     while (currentChild) {
-        Append(" & ")
+        QueueAppend(" & ")
         NextChild
 
-        if (!parseEqualityExpression(currentChild, codeGenerationData)) return False;
+        QueueParse(parseEqualityExpression, currentChild)
         NextChild
     }
     return True;
@@ -1132,14 +2037,14 @@ static boolean parseXorExpression(struct NCC_ASTNode* tree, struct CodeGeneratio
 
     Begin
 
-    if (!parseAndExpression(currentChild, codeGenerationData)) return False;
+    ParseOrQueue(parseAndExpression, currentChild)
     NextChild
 
     while (currentChild) {
-        Append(" ^ ")
+        QueueAppend(" ^ ")
         NextChild
 
-        if (!parseAndExpression(currentChild, codeGenerationData)) return False;
+        QueueParse(parseAndExpression, currentChild)
         NextChild
     }
     return True;
@@ -1152,14 +2057,14 @@ static boolean parseOrExpression(struct NCC_ASTNode* tree, struct CodeGeneration
 
     Begin
 
-    if (!parseXorExpression(currentChild, codeGenerationData)) return False;
+    ParseOrQueue(parseXorExpression, currentChild)
     NextChild
 
     while (currentChild) {
-        Append(" | ")
+        QueueAppend(" | ")
         NextChild
 
-        if (!parseXorExpression(currentChild, codeGenerationData)) return False;
+        QueueParse(parseXorExpression, currentChild)
         NextChild
     }
     return True;
@@ -1172,14 +2077,14 @@ static boolean parseLogicalAndExpression(struct NCC_ASTNode* tree, struct CodeGe
 
     Begin
 
-    if (!parseOrExpression(currentChild, codeGenerationData)) return False;
+    ParseOrQueue(parseOrExpression, currentChild)
     NextChild
 
     while (currentChild) {
-        Append(" && ")
+        QueueAppend(" && ")
         NextChild
 
-        if (!parseOrExpression(currentChild, codeGenerationData)) return False;
+        QueueParse(parseOrExpression, currentChild)
         NextChild
     }
     return True;
@@ -1192,14 +2097,14 @@ static boolean parseLogicalOrExpression(struct NCC_ASTNode* tree, struct CodeGen
 
     Begin
 
-    if (!parseLogicalAndExpression(currentChild, codeGenerationData)) return False;
+    ParseOrQueue(parseLogicalAndExpression, currentChild)
     NextChild
 
     while (currentChild) {
-        Append(" || ")
+        QueueAppend(" || ")
         NextChild
 
-        if (!parseLogicalAndExpression(currentChild, codeGenerationData)) return False;
+        QueueParse(parseLogicalAndExpression, currentChild)
         NextChild
     }
     return True;
@@ -1209,41 +2114,65 @@ static boolean parseConditionalExpression(struct NCC_ASTNode* tree, struct CodeG
     // conditional-expression = ${logical-or-expression} |
     //                          {${logical-or-expression} ${} ${?} ${} ${expression} ${} ${:} ${} ${conditional-expression}}
 
-    Begin
+    // Conditionals nested in else branches are walked in a loop, so that long chains of them don't
+    // use up the stack,
+    while (True) {
+        Begin
 
-    if (!parseLogicalOrExpression(currentChild, codeGenerationData)) return False;
-    NextChild
-    if (!currentChild) return True;
+        ParseOrQueue(parseLogicalOrExpression, currentChild)
+        NextChild
+        if (!currentChild) return True;
 
-    Append(" ? ")
-    if (!parseExpression(currentChild, codeGenerationData)) return False;
-    NextChild
+        QueueAppend(" ? ")
+        QueueParse(parseExpression, currentChild)
+        NextChild
 
-    Append(" : ")
-    return parseConditionalExpression(currentChild, codeGenerationData);
+        QueueAppend(" : ")
+        tree = currentChild;
+    }
 }
 
 static boolean parseAssignmentExpression(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
     // assignment-expression = ${conditional-expression} |
     //                         {${unary-expression} ${} ${assignment-operator} ${} ${assignment-expression}}
 
-    Begin
+    // Chained assignments are walked in a loop, so that they don't use up the stack. Assignments to
+    // weak references are calls ("w = a" becomes "addaatSetWeak(&w, a)"), closed at the end,
+    int32_t weakAssignmentsCount = 0;
+    while (True) {
+        Begin
 
-    // Parse conditional expression,
-    if (Equals("conditional-expression")) return parseConditionalExpression(currentChild, codeGenerationData);
+        // Parse conditional expression,
+        if (Equals("conditional-expression")) {
+            ParseOrQueue(parseConditionalExpression, currentChild)
+            for (int32_t i=0; i<weakAssignmentsCount; i++) QueueAppend(")")
+            return True;
+        }
 
-    // Parse assignee
-    if (!parseUnaryExpression(currentChild, codeGenerationData)) return False;
-    NextChild
+        // Parse assignee (whether it's a weak reference decides the operator's code),
+        boolean weakAssignee;
+        if (!findWeakAssignee(currentChild, codeGenerationData, &weakAssignee)) return False;
+        ParseOrQueue(parseAssigneeExpression, currentChild)
+        NextChild
 
-    // Operator,
-    Append(" ")
-    Append(VALUE)
-    Append(" ")
-    NextChild
+        // Operator,
+        if (weakAssignee) {
+            if (!Equals("=")) {
+                REPORT_ERROR("parseAssignmentExpression()", "Weak references can only be assigned with %s=%s.", NTCOLOR(HIGHLIGHT), NTCOLOR(STREAM_DEFAULT));
+                return False;
+            }
+            QueueAppend(", ")
+            weakAssignmentsCount++;
+        } else {
+            QueueAppend(" ")
+            QueueAppend(VALUE)
+            QueueAppend(" ")
+        }
+        NextChild
 
-    // Parse assignment expression,
-    return parseAssignmentExpression(currentChild, codeGenerationData);
+        // Then the assigned assignment expression,
+        tree = currentChild;
+    }
 }
 
 static boolean parseExpression(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
@@ -1253,12 +2182,12 @@ static boolean parseExpression(struct NCC_ASTNode* tree, struct CodeGenerationDa
 
     Begin
 
-    if (!parseAssignmentExpression(currentChild, codeGenerationData)) return False;
+    ParseOrQueue(parseAssignmentExpression, currentChild)
     NextChild
 
     while (currentChild) {
         NextChild // Skip the comma.
-        if (!parseAssignmentExpression(currentChild, codeGenerationData)) return False;
+        QueueParse(parseAssignmentExpression, currentChild)
         NextChild
     }
     return True;
@@ -1296,7 +2225,8 @@ static boolean parseLabeledStatement(struct NCC_ASTNode* tree, struct CodeGenera
     Append(": ")
     NextChild
 
-    return parseStatement(currentChild, codeGenerationData);
+    QueueParse(parseStatement, currentChild)
+    return True;
 }
 
 static boolean parseCompoundStatement(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, struct NVector* predefinedLocalVariables) {
@@ -1306,8 +2236,6 @@ static boolean parseCompoundStatement(struct NCC_ASTNode* tree, struct CodeGener
 
     Begin
 
-    boolean parsedSuccessfully = False;
-
     // Create a new scope and load it with existing local variables (if any),
     pushNewScope(codeGenerationData);
     if (predefinedLocalVariables) {
@@ -1324,40 +2252,41 @@ static boolean parseCompoundStatement(struct NCC_ASTNode* tree, struct CodeGener
     codeGenerationData->indentationCount++;
 
     // Parse block items,
+    boolean parsedSuccessfully = True;
     while (!Equals("CB")) {
 
         if (Equals("declaration")) {
-            if (!parseLocalVariableDeclaration(currentChild, codeGenerationData)) goto finish;
+            QueueParse(parseLocalVariableDeclaration, currentChild)
         } else if (Equals("statement")) {
-            if (!parseStatement(currentChild, codeGenerationData)) goto finish;
+            QueueParse(parseStatement, currentChild)
         } else {
-            NERROR("CodeGeneration.parseCompoundStatement()", "Unreachable code. Found a %s%s%s.", NTCOLOR(HIGHLIGHT), VALUE, NTCOLOR(STREAM_DEFAULT));
-            goto finish;
+            REPORT_ERROR("CodeGeneration.parseCompoundStatement()", "Unreachable code. Found a %s%s%s.", NTCOLOR(HIGHLIGHT), VALUE, NTCOLOR(STREAM_DEFAULT));
+            parsedSuccessfully = False;
+            break;
         }
 
         NextChild
     }
 
-    codeGenerationData->indentationCount--;
-    Append("}\n")
-    parsedSuccessfully = True;
-
-    finish:
+    if (parsedSuccessfully) QueueTask(TASK_CLOSE_BLOCK)
 
     // Delete scope,
-    popScope(codeGenerationData);
+    QueueTask(TASK_POP_SCOPE)
     return parsedSuccessfully;
 }
 
+static boolean parseFunctionBlock(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
+    return parseCompoundStatement(tree, codeGenerationData, &codeGenerationData->currentFunction->parameters);
+}
+
 static boolean parseExpressionStatement(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
 
     // expression-statement = ${expression}|${ε} ${} ${;}
 
     Begin
-    boolean success = True;
-    if (!Equals(";")) success = parseExpression(currentChild, codeGenerationData);
-    Append(";\n")
-    return success;
+    if (!Equals(";")) ParseOrQueue(parseExpression, currentChild)
+    QueueAppend(";\n")
+    return True;
 }
 
 static boolean parseSelectionStatement(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
@@ -1372,27 +2301,23 @@ static boolean parseSelectionStatement(struct NCC_ASTNode* tree, struct CodeGene
     Append(" (")
     NextChild
 
-    if (!parseExpression(currentChild, codeGenerationData)) return False;
+    ParseOrQueue(parseExpression, currentChild)
     NextChild
 
-    Append(") ")
-    if (!parseStatement(currentChild, codeGenerationData)) return False;
+    QueueAppend(") ")
+    QueueParse(parseStatement, currentChild)
     NextChild
 
     // If no else,
     if (!currentChild) return True;
 
-    // Remove the newline if a compound statement came before the else,
-    if (NCString.endsWith(NString.get(&codeGenerationData->outString), "}\n")) {
-        NString.trimEnd(&codeGenerationData->outString, "\n");
-        Append(" else ")
-    } else {
-        Append("else ")
-    }
+    // Once the statement before it is written,
+    QueueTask(TASK_ELSE)
     NextChild
 
     // Parse the else statement,
-    return parseStatement(currentChild, codeGenerationData);
+    QueueParse(parseStatement, currentChild)
+    return True;
 }
 
 static boolean parseIterationStatement(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
@@ -1411,15 +2336,15 @@ static boolean parseIterationStatement(struct NCC_ASTNode* tree, struct CodeGene
 
         Append("while (")
         NextChild
-        if (!parseExpression(currentChild, codeGenerationData)) return False;
+        ParseOrQueue(parseExpression, currentChild)
 
         NextChild
 
         if (isStatementEmpty(currentChild, codeGenerationData)) {
-            Append(");\n")
+            QueueAppend(");\n")
         } else {
-            Append(") ");
-            return parseStatement(currentChild, codeGenerationData);
+            QueueAppend(") ")
+            QueueParse(parseStatement, currentChild)
         }
         return True;
 
@@ -1430,15 +2355,15 @@ static boolean parseIterationStatement(struct NCC_ASTNode* tree, struct CodeGene
         Append("do ")
         NextChild
 
-        if (!parseStatement(currentChild, codeGenerationData)) return False;
+        QueueParse(parseStatement, currentChild)
         NextChild
 
-        Append("while (")
+        QueueAppend("while (")
         NextChild
 
-        if (!parseExpression(currentChild, codeGenerationData)) return False;
+        QueueParse(parseExpression, currentChild)
 
-        Append(");\n")
+        QueueAppend(");\n")
         return True;
 
     } else if (Equals("for")) {
@@ -1446,7 +2371,8 @@ static boolean parseIterationStatement(struct NCC_ASTNode* tree, struct CodeGene
         // ${for} ${} ${(} ${} ${expression}|${ε} ${} ${;} ${} ${expression}|${ε} ${} ${;} ${} ${expression}|${ε} ${} ${)} ${} ${statement}
         // ${for} ${} ${(} ${} ${declaration}              ${} ${expression}|${ε} ${} ${;} ${} ${expression}|${ε} ${} ${)} ${} ${statement}
 
-        boolean success=False;
+        // The scope is popped once the loop is written (or the walk fails), whichever way this
+        // returns,
         pushNewScope(codeGenerationData);
 
         Append("for (")
@@ -1457,48 +2383,50 @@ static boolean parseIterationStatement(struct NCC_ASTNode* tree, struct CodeGene
             Append(";")
             NextChild
         } else if (Equals("expression")) {
-            if (!parseExpression(currentChild, codeGenerationData)) goto forFinish;
+            QueueParse(parseExpression, currentChild)
             NextChild
 
             // Skip the ;
-            Append(";")
+            QueueAppend(";")
             NextChild
         } else if (Equals("declaration")) {
-            if (!parseLocalVariableDeclaration(currentChild, codeGenerationData)) goto forFinish;
+            // Nothing's queued yet, so the variables are declared right away,
+            if (!parseLocalVariableDeclaration(currentChild, codeGenerationData)) {
+                QueueTask(TASK_POP_SCOPE)
+                return False;
+            }
             NextChild
             NString.trimEnd(&codeGenerationData->outString, "\n");
         }
 
         // Now parse the condition expression (if any),
         if (Equals("expression")) {
-            Append(" ")
-            if (!parseExpression(currentChild, codeGenerationData)) goto forFinish;
+            QueueAppend(" ")
+            QueueParse(parseExpression, currentChild)
             NextChild
         }
 
         // Skip the ;
-        Append(";")
+        QueueAppend(";")
         NextChild
 
         // Then parse the increment expression (if any),
         if (Equals("expression")) {
-            Append(" ")
-            if (!parseExpression(currentChild, codeGenerationData)) goto forFinish;
+            QueueAppend(" ")
+            QueueParse(parseExpression, currentChild)
             NextChild
         }
 
         if (isStatementEmpty(currentChild, codeGenerationData)) {
-            Append(");\n")
+            QueueAppend(");\n")
         } else {
-            Append(") ")
+            QueueAppend(") ")
             // Parse the statement,
-            if (!parseStatement(currentChild, codeGenerationData)) goto forFinish;
+            QueueParse(parseStatement, currentChild)
         }
 
-        success = True;
-        forFinish:
-        popScope(codeGenerationData);
-        return success;
+        QueueTask(TASK_POP_SCOPE)
+        return True;
     }
 
     return False; // Unreachable.
@@ -1519,14 +2447,59 @@ static boolean parseJumpStatement(struct NCC_ASTNode* tree, struct CodeGeneratio
 
     if (Equals("expression")) {
         Append(" ")
-        if (!parseExpression(currentChild, codeGenerationData)) return False;
+        ParseOrQueue(parseExpression, currentChild)
     } else if (Equals("identifier")) {
         Append(" ")
         Append(VALUE)
     }
 
-    Append(";\n")
+    QueueAppend(";\n")
+
+    return True;
+}
+
+static boolean parseDeallocationStatement(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
 
+    // deallocation-statement = ${delete} ${} ${cast-expression} ${} ${;}
+
+    Begin
+    NextChild
+    codeGenerationData->usesRuntime = True;
+
+    // Arrays of structure-of-arrays classes are containers, each of their member arrays is deleted
+    // ("delete particles" becomes "{ struct _Particle_soa_ _soa_ = particles; addaatDelete(_soa_.x);
+    // ... }"),
+    struct VariableType type;
+    struct ClassInfo* structureOfArraysClass = 0;
+    struct NCC_ASTNode** unaryExpression = NVector.get(&currentChild->childNodes, 0);
+    if (unaryExpression && NCString.equals(NString.get(&(*unaryExpression)->name), "unary-expression")) {
+        struct NCC_ASTNode** postFixExpression = NVector.get(&(*unaryExpression)->childNodes, 0);
+        if (postFixExpression && NCString.equals(NString.get(&(*postFixExpression)->name), "postfix-expression") &&
+            getPostFixExpressionType(*postFixExpression, codeGenerationData, &type)) {
+            structureOfArraysClass = getStructureOfArraysClass(&type, codeGenerationData);
+        }
+    }
+    if (structureOfArraysClass) {
+        Append("{ ")
+        appendVariableTypeCode(&type, codeGenerationData);
+        Append(" _soa_ = ")
+        ParseOrQueue(parseCastExpression, currentChild)
+        QueueAppend(";")
+        int32_t membersCount = NVector.size(&structureOfArraysClass->members);
+        for (int32_t i=0; i<membersCount; i++) {
+            struct VariableInfo* member = *(struct VariableInfo**) NVector.get(&structureOfArraysClass->members, i);
+            if (member->isStatic) continue;
+            QueueAppend(" addaatDelete(_soa_.")
+            QueueAppend(NString.get(&member->name))
+            QueueAppend(");")
+        }
+        QueueAppend(" }\n")
+        return True;
+    }
+
+    Append("addaatDelete(")
+    ParseOrQueue(parseCastExpression, currentChild)
+    QueueAppend(");\n")
     return True;
 }
 
@@ -1537,9 +2510,11 @@ static boolean parseStatement(struct NCC_ASTNode* tree, struct CodeGenerationDat
     //               {expression-statement}
     //                {selection-statement}
     //                {iteration-statement}
-    //                     {jump-statement}}
+    //                     {jump-statement}
+    //             {deallocation-statement}}
 
     Begin
+    if (!enterNesting(tree, codeGenerationData)) return False;
 
     boolean success=False;
     if (Equals("labeled-statement")) {
@@ -1554,8 +2529,11 @@ static boolean parseStatement(struct NCC_ASTNode* tree, struct CodeGenerationDat
         success = parseIterationStatement(currentChild, codeGenerationData);
     } else if (Equals("jump-statement")) {
         success = parseJumpStatement(currentChild, codeGenerationData);
+    } else if (Equals("deallocation-statement")) {
+        success = parseDeallocationStatement(currentChild, codeGenerationData);
     }
 
+    QueueTask(TASK_LEAVE_NESTING)
     return success;
 }
 
@@ -1567,6 +2545,15 @@ static boolean parseStatement(struct NCC_ASTNode* tree, struct CodeGenerationDat
 //int foo(a,b) int a, b; {
 //}
 
+// Switches the output between the code and the class definitions. The next append restates its
+// color, whichever it goes to,
+static void swapClassesCode(struct CodeGenerationData* codeGenerationData) {
+    struct NString code = codeGenerationData->outString;
+    codeGenerationData->outString = codeGenerationData->classesCode;
+    codeGenerationData->classesCode = code;
+    codeGenerationData->lastUsedColor = 0;
+}
+
 static boolean parseExternalDeclaration(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
 
     // external-declaration = #{{function-declaration}
@@ -1583,12 +2570,24 @@ static boolean parseExternalDeclaration(struct NCC_ASTNode* tree, struct CodeGen
     } else if (Equals("declaration")) {
         parsedSuccessfully = parseVariableDeclaration(currentChild, codeGenerationData, &codeGenerationData->globalVariables, True);
     } else if (Equals("class-declaration")) {
+        if (codeGenerationData->hoistClasses) swapClassesCode(codeGenerationData);
         parsedSuccessfully = parseClassDeclaration(currentChild, codeGenerationData);
+        if (codeGenerationData->hoistClasses) swapClassesCode(codeGenerationData);
     }
 
     return parsedSuccessfully;
 }
 
+static boolean isTranslationUnit(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
+
+    // We have to check because this gets called from outside,
+    if (!NCString.equals(NString.get(&tree->name), "translation-unit")) {
+        REPORT_ERROR("CodeGeneration.parseTranslationUnit()", "Expecting translation unit, found: %s%s%s.", NTCOLOR(HIGHLIGHT), NString.get(&tree->name), NTCOLOR(STREAM_DEFAULT));
+        return False;
+    }
+    return True;
+}
+
 static boolean parseTranslationUnit(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData) {
 
     // translation-unit =
@@ -1596,51 +2595,405 @@ static boolean parseTranslationUnit(struct NCC_ASTNode* tree, struct CodeGenerat
     //                     ${} ${external-declaration}
     //                 }^*} ${}
 
-    // We have to check because this gets called from outside,
-    if (!NCString.equals(NString.get(&tree->name), "translation-unit")) {
-        NERROR("CodeGeneration.parseTranslationUnit()", "Expecting translation unit, found: %s%s%s.", NTCOLOR(HIGHLIGHT), NString.get(&tree->name), NTCOLOR(STREAM_DEFAULT));
-        return False;
-    }
+    if (!isTranslationUnit(tree, codeGenerationData)) return False;
 
     Begin
 
+    int32_t declarationIndex = 0;
     while (currentChild) {
-        if (!parseExternalDeclaration(currentChild, codeGenerationData)) return False;
+        TIMING_BEGIN_WITH_ARGUMENT("external-declaration", "index", declarationIndex++)
+        boolean parsed = parseExternalDeclaration(currentChild, codeGenerationData);
+        TIMING_END
+        if (!parsed) return False;
         NextChild
     }
 
     return True;
 }
 
-boolean generateCode(struct NCC_ASTNode* tree, struct NString* outString) {
+// Benchmark reports and cached translations are keyed on this. Bump it by hand whenever the
+// generated code changes, be it here, in Preprocessing.c, LazyFunctions.c or Utf8.c, or in NOMoneCC.
+// The cache also keys on the translator's build, so a missed bump can't serve stale code,
+const char* getCodeGenerationVersion() {
+    return "CodeGeneration 2";
+}
+
+static void appendGlobalVariablesCode(struct CodeGenerationData* codeGenerationData, int32_t firstVariableIndex) {
+    int32_t globalVariablesCount = NVector.size(&codeGenerationData->globalVariables);
+    for (int32_t i=firstVariableIndex; i<globalVariablesCount; i++) {
+        struct VariableInfo* variable = *(struct VariableInfo**) NVector.get(&codeGenerationData->globalVariables, i);
+        if (codeGenerationData->externVariables) Append("extern ")
+        appendVariableDeclarationCode(variable, codeGenerationData, "", "");
+        Append("\n")
+    }
+    if (globalVariablesCount > firstVariableIndex) Append("\n")
+}
+
+boolean generateCode(struct NCC_ASTNode* tree, const struct CodeGenerationOptions* options, struct NString* outString) {
 
     // TODO: Update class-specifier rule to set a new listener ?
 
     // Generate code,
     boolean codeGeneratedSuccessfully = False;
     struct CodeGenerationData codeGenerationData;
-    initializeCodeGenerationData(&codeGenerationData);
-    if (!parseTranslationUnit(tree, &codeGenerationData)) goto finish;
+    initializeCodeGenerationData(&codeGenerationData, options);
+    codeGenerationData.hoistClasses = True;
+    int32_t workersCount = options ? options->workersCount : 0;
+    boolean parsed = (workersCount > 1) ?
+            parseTranslationUnitInParallel(tree, &codeGenerationData, workersCount) :
+            parseTranslationUnit(tree, &codeGenerationData);
+    if (!parsed) goto finish;
     codeGeneratedSuccessfully = True;
 
     // Copy generated code onto output,
     NString.set(outString, "%s", NString.get(&codeGenerationData.outString));
 
-    // Generate global variables code,
-    NString.set(&codeGenerationData.outString, "");
-    int32_t globalVariablesCount = NVector.size(&codeGenerationData.globalVariables);
-    for (int32_t i=0; i<globalVariablesCount; i++) {
-        struct VariableInfo* variable = *(struct VariableInfo**) NVector.get(&codeGenerationData.globalVariables, i);
-        appendVariableDeclarationCode(variable, &codeGenerationData, "", "");
-        codeAppend(&codeGenerationData, "\n");
-    }
-    if (globalVariablesCount) codeAppend(&codeGenerationData, "\n");
+    // Generate global variables code, after the classes,
+    NString.set(&codeGenerationData.outString, "%s", NString.get(&codeGenerationData.classesCode));
+    appendGlobalVariablesCode(&codeGenerationData, 0);
 
-    // Prepend to the rest of the code,
+    // Prepend to the rest of the code, after the runtime if it's used,
     NString.append(&codeGenerationData.outString, "%s", NString.get(outString));
-    NString.set(outString, "%s", NString.get(&codeGenerationData.outString));
+    NString.set(outString, "%s%s", codeGenerationData.usesRuntime ? RUNTIME_INCLUDE : "", NString.get(&codeGenerationData.outString));
 
     finish:
     destroyCodeGenerationData(&codeGenerationData);
     return codeGeneratedSuccessfully;
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Streaming
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct CodeGenerationData* createCodeGenerationData(const struct CodeGenerationOptions* options) {
+    struct CodeGenerationData* codeGenerationData = NMALLOC(sizeof(struct CodeGenerationData), "CodeGeneration.createCodeGenerationData() codeGenerationData");
+    initializeCodeGenerationData(codeGenerationData, options);
+    return codeGenerationData;
+}
+
+void destroyAndDeleteCodeGenerationData(struct CodeGenerationData* codeGenerationData) {
+    destroyCodeGenerationData(codeGenerationData);
+    NFREE(codeGenerationData, "CodeGeneration.destroyAndDeleteCodeGenerationData() codeGenerationData");
+}
+
+boolean generateExternalDeclarationCode(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, struct NString* outString) {
+
+    // We have to check because this gets called from outside,
+    if (!NCString.equals(NString.get(&tree->name), "external-declaration")) {
+        REPORT_ERROR("CodeGeneration.generateExternalDeclarationCode()", "Expecting external declaration, found: %s%s%s.", NTCOLOR(HIGHLIGHT), NString.get(&tree->name), NTCOLOR(STREAM_DEFAULT));
+        return False;
+    }
+
+    // Generate the declaration code on its own,
+    NString.set(&codeGenerationData->outString, "");
+    if (!parseExternalDeclaration(tree, codeGenerationData)) return False;
+    NString.set(outString, "%s", NString.get(&codeGenerationData->outString));
+
+    // Global variables can't be hoisted to the top of the file anymore, since whatever came before
+    // is already written. Declare the ones this declaration introduced right before its code. The
+    // same goes for the runtime, included before the first declaration that uses it,
+    boolean includeRuntime = codeGenerationData->usesRuntime && !codeGenerationData->runtimeIncluded;
+    if (includeRuntime) codeGenerationData->runtimeIncluded = True;
+    NString.set(&codeGenerationData->outString, "%s", includeRuntime ? RUNTIME_INCLUDE : "");
+    appendGlobalVariablesCode(codeGenerationData, codeGenerationData->flushedGlobalVariablesCount);
+    codeGenerationData->flushedGlobalVariablesCount = NVector.size(&codeGenerationData->globalVariables);
+
+    NString.append(&codeGenerationData->outString, "%s", NString.get(outString));
+    NString.set(outString, "%s", NString.get(&codeGenerationData->outString));
+    NString.set(&codeGenerationData->outString, "");
+
+    return True;
+}
+
+boolean generateFunctionHeadDeclarationCode(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, struct NString* outString) {
+
+    // We have to check because this gets called from outside,
+    if (!NCString.equals(NString.get(&tree->name), "function-head")) {
+        REPORT_ERROR("CodeGeneration.generateFunctionHeadDeclarationCode()", "Expecting function head, found: %s%s%s.", NTCOLOR(HIGHLIGHT), NString.get(&tree->name), NTCOLOR(STREAM_DEFAULT));
+        return False;
+    }
+
+    NString.set(&codeGenerationData->outString, "");
+    if (!declareGlobalFunction(tree, codeGenerationData)) return False;
+    Append("\n")
+    NString.set(outString, "%s", NString.get(&codeGenerationData->outString));
+    NString.set(&codeGenerationData->outString, "");
+    return True;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel function bodies
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Nothing a function body generates is seen by the declarations after it, except for its scope ids
+// (which number the static locals) and its static locals (which join the global variables). So
+// the symbols are collected first, in order, and the bodies generated afterwards, over forked
+// workers that see all the symbols as they were collected. Each body starts from the scope id and
+// global variables index it would've started from, so the code is the same as generating in order.
+
+struct FunctionBodyJob {
+    struct NCC_ASTNode* body;
+    struct FunctionInfo* function;
+    boolean temporaryFunction;
+    int32_t firstScopeId;         // The scopes count before the body.
+    int32_t globalVariablesIndex; // Where its static locals go among the global variables.
+    struct NString precedingCode; // Collected since the previous body.
+};
+
+struct ParallelGenerationData {
+    struct CodeGenerationData* codeGenerationData;
+    struct NVector jobs; // struct FunctionBodyJob.
+};
+
+// The scopes a body pushes while its code is generated: one per compound-statement, and one per
+// for loop. Walked with a stack, since nothing bounds this walk's depth the way enterNesting()
+// bounds code generation's. Expressions and declarations hold no statements, so they're skipped,
+static int32_t countScopes(struct NCC_ASTNode* tree) {
+
+    int32_t scopesCount = 0;
+    struct NVector stack;
+    NVector.initialize(&stack, 0, sizeof(struct NCC_ASTNode*));
+    NVector.pushBack(&stack, &tree);
+
+    struct NCC_ASTNode* node;
+    while (NVector.popBack(&stack, &node)) {
+        const char* name = NString.get(&node->name);
+        if (NCString.equals(name, "expression") || NCString.equals(name, "declaration")) continue;
+
+        if (NCString.equals(name, "compound-statement")) {
+            scopesCount++;
+        } else if (NCString.equals(name, "iteration-statement")) {
+            struct NCC_ASTNode** firstChild = NVector.get(&node->childNodes, 0);
+            if (firstChild && NCString.equals(NString.get(&(*firstChild)->name), "for")) scopesCount++;
+        }
+
+        for (int32_t i=NVector.size(&node->childNodes)-1; i>=0; i--) NVector.pushBack(&stack, NVector.get(&node->childNodes, i));
+    }
+
+    NVector.destroy(&stack);
+    return scopesCount;
+}
+
+// Symbols and everything besides the function bodies. Stops at the first declaration that fails,
+// just as generating in order would (the bodies before it may still fail first),
+static boolean collectFunctionBodies(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, struct NVector* outJobs) {
+
+    Begin
+
+    int32_t declarationIndex = 0;
+    while (currentChild) {
+        TIMING_BEGIN_WITH_ARGUMENT("external-declaration", "index", declarationIndex++)
+
+        boolean parsed;
+        struct NCC_ASTNode* declarationTree = *(struct NCC_ASTNode**) NVector.get(&currentChild->childNodes, 0);
+        if (NCString.equals(NString.get(&declarationTree->name), "function-definition")) {
+
+            // function-definition = ${function-head} ${} ${compound-statement}
+            struct NCC_ASTNode* functionHeadTree = *(struct NCC_ASTNode**) NVector.get(&declarationTree->childNodes, 0);
+            struct NCC_ASTNode* bodyTree = *(struct NCC_ASTNode**) NVector.get(&declarationTree->childNodes, 1);
+
+            struct FunctionBodyJob job;
+            job.function = defineGlobalFunction(functionHeadTree, bodyTree, codeGenerationData, &job.temporaryFunction);
+            parsed = job.function != 0;
+            if (parsed) {
+                job.body = bodyTree;
+                job.firstScopeId = codeGenerationData->scopesCount;
+                job.globalVariablesIndex = NVector.size(&codeGenerationData->globalVariables);
+                NString.initialize(&job.precedingCode, "%s", NString.get(&codeGenerationData->outString));
+                NString.set(&codeGenerationData->outString, "");
+                NVector.pushBack(outJobs, &job);
+                codeGenerationData->scopesCount += countScopes(bodyTree);
+            }
+        } else {
+            parsed = parseExternalDeclaration(currentChild, codeGenerationData);
+        }
+
+        TIMING_END
+        if (!parsed) return False;
+        NextChild
+    }
+
+    return True;
+}
+
+// Runs in a worker (or here, for the jobs no worker delivered). Leaves the code generation data as
+// it found it,
+static void generateFunctionBody(int32_t jobIndex, struct JobBuffer* outResult, void* data) {
+
+    struct ParallelGenerationData* parallelGenerationData = data;
+    struct CodeGenerationData* codeGenerationData = parallelGenerationData->codeGenerationData;
+    struct FunctionBodyJob* job = NVector.get(&parallelGenerationData->jobs, jobIndex);
+
+    // Generate as if right after the function's head,
+    NString.set(&codeGenerationData->outString, "");
+    codeGenerationData->indentationCount = 0;
+    codeGenerationData->nestingDepth = 0;
+    codeGenerationData->scopesCount = job->firstScopeId;
+    int32_t globalVariablesCount = NVector.size(&codeGenerationData->globalVariables);
+    int32_t deferredErrorsCount = NVector.size(&codeGenerationData->deferredErrors);
+    boolean usesRuntime = codeGenerationData->usesRuntime;
+    codeGenerationData->usesRuntime = False;
+    boolean success = parseFunctionBody(job->body, job->function, codeGenerationData);
+
+    // Result: success, errors, code, static locals and whether the runtime is used,
+    writeJobInt32(outResult, success);
+
+    int32_t errorsCount = NVector.size(&codeGenerationData->deferredErrors) - deferredErrorsCount;
+    writeJobInt32(outResult, errorsCount);
+    struct DeferredError deferredError;
+    for (int32_t i=0; i<errorsCount; i++) {
+        struct DeferredError* newError = NVector.get(&codeGenerationData->deferredErrors, deferredErrorsCount + i);
+        writeJobString(outResult, NString.get(&newError->tag));
+        writeJobString(outResult, NString.get(&newError->message));
+    }
+    while (NVector.size(&codeGenerationData->deferredErrors) > deferredErrorsCount) {
+        NVector.popBack(&codeGenerationData->deferredErrors, &deferredError);
+        NString.destroy(&deferredError.tag);
+        NString.destroy(&deferredError.message);
+    }
+
+    writeJobString(outResult, NString.get(&codeGenerationData->outString));
+
+    int32_t newGlobalVariablesCount = NVector.size(&codeGenerationData->globalVariables) - globalVariablesCount;
+    writeJobInt32(outResult, newGlobalVariablesCount);
+    struct VariableInfo* variable;
+    for (int32_t i=0; i<newGlobalVariablesCount; i++) {
+        variable = *(struct VariableInfo**) NVector.get(&codeGenerationData->globalVariables, globalVariablesCount + i);
+        writeJobString(outResult, NString.get(&variable->name));
+        writeJobInt32(outResult, variable->type.type);
+        writeJobInt32(outResult, variable->type.classIndex);
+        writeJobInt32(outResult, variable->type.arrayDepth);
+        writeJobInt32(outResult, variable->type.weak);
+        writeJobInt32(outResult, variable->isStatic);
+    }
+    while (NVector.size(&codeGenerationData->globalVariables) > globalVariablesCount) {
+        NVector.popBack(&codeGenerationData->globalVariables, &variable);
+        destroyAndDeleteVariableInfo(variable);
+    }
+
+    writeJobInt32(outResult, codeGenerationData->usesRuntime);
+    codeGenerationData->usesRuntime = usesRuntime;
+
+    NString.set(&codeGenerationData->outString, "");
+}
+
+static void reportDeferredErrors(struct CodeGenerationData* codeGenerationData, int32_t firstErrorIndex) {
+    codeGenerationData->deferErrors = False;
+    int32_t errorsCount = NVector.size(&codeGenerationData->deferredErrors);
+    for (int32_t i=firstErrorIndex; i<errorsCount; i++) {
+        struct DeferredError* deferredError = NVector.get(&codeGenerationData->deferredErrors, i);
+        reportFormattedError(codeGenerationData, NString.get(&deferredError->tag), NString.get(&deferredError->message));
+    }
+}
+
+// Puts the bodies' code and static locals where generating in order would have. The results are
+// read past their success and (lack of) errors,
+static void mergeFunctionBodies(struct CodeGenerationData* codeGenerationData, struct NVector* jobs, struct JobBuffer* results) {
+
+    struct NString code;
+    NString.initialize(&code, "");
+    struct NVector globalVariables;
+    NVector.initialize(&globalVariables, 0, sizeof(struct VariableInfo*));
+
+    int32_t globalVariablesIndex = 0;
+    int32_t jobsCount = NVector.size(jobs);
+    for (int32_t i=0; i<jobsCount; i++) {
+        struct FunctionBodyJob* job = NVector.get(jobs, i);
+
+        // What was collected before the body,
+        NString.append(&code, "%s", NString.get(&job->precedingCode));
+        for (; globalVariablesIndex<job->globalVariablesIndex; globalVariablesIndex++) {
+            NVector.pushBack(&globalVariables, NVector.get(&codeGenerationData->globalVariables, globalVariablesIndex));
+        }
+
+        // The body,
+        struct JobBuffer* result = &results[i];
+        NString.append(&code, "%s", readJobString(result));
+        int32_t newGlobalVariablesCount = readJobInt32(result);
+        for (int32_t j=0; j<newGlobalVariablesCount; j++) {
+            struct VariableInfo* variable = NMALLOC(sizeof(struct VariableInfo), "CodeGeneration.mergeFunctionBodies() variable");
+            NString.initialize(&variable->name, "%s", readJobString(result));
+            variable->type.type = readJobInt32(result);
+            variable->type.classIndex = readJobInt32(result);
+            variable->type.arrayDepth = readJobInt32(result);
+            variable->type.weak = readJobInt32(result);
+            variable->isStatic = readJobInt32(result);
+            NVector.pushBack(&globalVariables, &variable);
+        }
+        if (readJobInt32(result)) codeGenerationData->usesRuntime = True;
+    }
+
+    // What was collected after the last body,
+    NString.append(&code, "%s", NString.get(&codeGenerationData->outString));
+    int32_t globalVariablesCount = NVector.size(&codeGenerationData->globalVariables);
+    for (; globalVariablesIndex<globalVariablesCount; globalVariablesIndex++) {
+        NVector.pushBack(&globalVariables, NVector.get(&codeGenerationData->globalVariables, globalVariablesIndex));
+    }
+
+    // Replace the collected ones,
+    NString.set(&codeGenerationData->outString, "%s", NString.get(&code));
+    NVector.clear(&codeGenerationData->globalVariables);
+    globalVariablesCount = NVector.size(&globalVariables);
+    for (int32_t i=0; i<globalVariablesCount; i++) NVector.pushBack(&codeGenerationData->globalVariables, NVector.get(&globalVariables, i));
+
+    NString.destroy(&code);
+    NVector.destroy(&globalVariables);
+}
+
+static boolean parseTranslationUnitInParallel(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, int32_t workersCount) {
+
+    if (!isTranslationUnit(tree, codeGenerationData)) return False;
+
+    struct ParallelGenerationData parallelGenerationData;
+    parallelGenerationData.codeGenerationData = codeGenerationData;
+    NVector.initialize(&parallelGenerationData.jobs, 0, sizeof(struct FunctionBodyJob));
+
+    // Symbols. Errors are held back until it's known that no body before them failed,
+    codeGenerationData->deferErrors = True;
+    TIMING_BEGIN("collect-symbols")
+    boolean success = collectFunctionBodies(tree, codeGenerationData, &parallelGenerationData.jobs);
+    TIMING_END
+
+    // Bodies,
+    int32_t jobsCount = NVector.size(&parallelGenerationData.jobs);
+    struct JobBuffer* results = NMALLOC((jobsCount ? jobsCount : 1) * sizeof(struct JobBuffer), "CodeGeneration.parseTranslationUnitInParallel() results");
+    TIMING_BEGIN("generate-function-bodies")
+    runParallelJobs(jobsCount, workersCount, generateFunctionBody, &parallelGenerationData, results);
+    TIMING_END
+
+    // Report the first failure in source order, a body's or else the collection's,
+    int32_t collectionErrorsCount = NVector.size(&codeGenerationData->deferredErrors);
+    int32_t failedJobIndex = -1;
+    for (int32_t i=0; (i<jobsCount) && (failedJobIndex < 0); i++) {
+        struct JobBuffer* result = &results[i];
+        if (!readJobInt32(result)) failedJobIndex = i;
+        int32_t errorsCount = readJobInt32(result);
+        for (int32_t j=0; j<errorsCount; j++) {
+            const char* tag = readJobString(result);
+            const char* message = readJobString(result);
+            if (failedJobIndex != i) continue;
+            struct DeferredError* deferredError = NVector.emplaceBack(&codeGenerationData->deferredErrors);
+            NString.initialize(&deferredError->tag, "%s", tag);
+            NString.initialize(&deferredError->message, "%s", message);
+        }
+    }
+    if (failedJobIndex >= 0) success = False;
+    reportDeferredErrors(codeGenerationData, (failedJobIndex >= 0) ? collectionErrorsCount : 0);
+
+    if (success) {
+        TIMING_BEGIN("merge-function-bodies")
+        mergeFunctionBodies(codeGenerationData, &parallelGenerationData.jobs, results);
+        TIMING_END
+    }
+
+    // Clean up,
+    for (int32_t i=0; i<jobsCount; i++) {
+        struct FunctionBodyJob* job = NVector.get(&parallelGenerationData.jobs, i);
+        if (job->temporaryFunction) destroyAndDeleteFunctionInfo(job->function);
+        NString.destroy(&job->precedingCode);
+        destroyJobBuffer(&results[i]);
+    }
+    NFREE(results, "CodeGeneration.parseTranslationUnitInParallel() results");
+    NVector.destroy(&parallelGenerationData.jobs);
+    return success;
+}
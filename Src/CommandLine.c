@@ -0,0 +1,63 @@
+
+//
+// Reading command-line arguments.
+//
+// The 18th of October, 2026.
+//
+
+#include <CommandLine.h>
+
+#include <NSystemUtils.h>
+#include <NString.h>
+#include <NVector.h>
+#include <NCString.h>
+#include <AllocationProfiler.h> // After NSystemUtils.h, to reroute NMALLOC/NFREE.
+
+#ifdef DESKTOP
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+void loadCommandLineArguments(struct NVector* outArguments) {
+
+    NVector.initialize(outArguments, 0, sizeof(struct NString*));
+
+    #ifdef DESKTOP
+    // The kernel keeps the null-separated arguments of every process,
+    int fileDescriptor = open("/proc/self/cmdline", O_RDONLY);
+    if (fileDescriptor < 0) return;
+
+    // Read it all (its size isn't known upfront),
+    int32_t capacity = 1024, size = 0;
+    char* arguments = NMALLOC(capacity, "CommandLine.loadCommandLineArguments() arguments");
+    ssize_t readBytesCount;
+    while ((readBytesCount = read(fileDescriptor, &arguments[size], capacity - size - 1)) > 0) {
+        size += readBytesCount;
+        if (size == capacity - 1) {
+            char* largerArguments = NMALLOC(capacity*2, "CommandLine.loadCommandLineArguments() largerArguments");
+            NSystemUtils.memcpy(largerArguments, arguments, size);
+            NFREE(arguments, "CommandLine.loadCommandLineArguments() arguments 1");
+            arguments = largerArguments;
+            capacity *= 2;
+        }
+    }
+    arguments[size] = 0;
+    close(fileDescriptor);
+
+    // Split, skipping the executable name,
+    int32_t index = NCString.length(arguments) + 1;
+    while (index < size) {
+        struct NString* argument = NString.create("%s", &arguments[index]);
+        NVector.pushBack(outArguments, &argument);
+        index += NString.length(argument) + 1;
+    }
+    NFREE(arguments, "CommandLine.loadCommandLineArguments() arguments 2");
+    #endif
+}
+
+void destroyCommandLineArguments(struct NVector* arguments) {
+    for (int32_t i=NVector.size(arguments)-1; i>=0; i--) {
+        NString.destroyAndFree(*(struct NString**) NVector.get(arguments, i));
+    }
+    NVector.destroy(arguments);
+}
@@ -0,0 +1,1064 @@
+
+//
+// Grammar analysis. NCC compiles rule texts into matchers we can't inspect, so the texts are
+// recorded while the language is defined and parsed again here, following NCC's rule syntax:
+//
+//   - Spaces and tabs separate elements, everything else is matched literally unless escaped
+//     with a backslash or one of: a-z (range), * (anything), {...} (group), ${rule}
+//     (substitution), #{{rule1} {rule2} == or != {rule3}} (longest match selection).
+//   - a|b chooses between the elements right before and after it, and binds tighter than
+//     sequencing. ^* repeats the element right before it.
+//
+// The findings are places where the matcher (re-)matches a rule from the same offset more than
+// once:
+//
+//   - shared-prefix:     alternatives that start with the same elements re-match them.
+//   - left-corner:       an alternative starts with a rule that another alternative already
+//                        matched from the same offset, at some depth.
+//   - selection-overlap: longest match selections try every option, so rules shared by the
+//                        options' starts are matched once per option.
+//   - nullable-repeat:   a ^* over something that can match nothing.
+//   - left-recursion:    a rule that can reach itself without consuming anything.
+//
+// The cost of a finding is the number of rules reachable from what's re-matched, times the
+// number of extra times it's matched. It's a static estimate of the repeated work. A finding is
+// exponential when what's re-matched reaches the finding's rule again, so that the re-matches
+// compound with every nesting level (parenthesized expressions, nested statements).
+//
+// The 18th of October, 2026.
+//
+
+#include <GrammarAnalyzer.h>
+#include <ReportFormatting.h>
+
+#include <NSystemUtils.h>
+#include <NString.h>
+#include <NVector.h>
+#include <NCString.h>
+#include <NError.h>
+#include <AllocationProfiler.h> // After NSystemUtils.h, to reroute NMALLOC/NFREE.
+
+#include <stdlib.h>
+
+enum GrammarExpressionType {
+    EXPRESSION_LITERAL = 0,  // A range of characters.
+    EXPRESSION_ANYTHING,
+    EXPRESSION_SUBSTITUTION,
+    EXPRESSION_SELECTION,    // Children are the substitutions of the options.
+    EXPRESSION_SEQUENCE,
+    EXPRESSION_CHOICE,
+    EXPRESSION_REPEAT
+};
+
+struct GrammarExpression {
+    int32_t type;
+    uint8_t rangeStart, rangeEnd;
+    struct NString ruleName;
+    int32_t ruleIndex;
+    boolean conditional;     // A selection with an == or != condition.
+    struct NVector children; // struct GrammarExpression*.
+};
+
+struct GrammarRule {
+    struct NString name, text;
+    struct GrammarExpression* expression;
+    boolean nullable;
+    boolean claimedExclusive; // Defined as an ordered choice, its alternatives must be exclusive.
+    uint8_t first[32];       // A bit per character.
+    uint8_t* leftCorners;    // A bit per rule, the rules that may be matched from this rule's offset.
+    uint8_t* reachableRules; // A bit per rule, including this one.
+    int32_t reachableRulesCount;
+};
+
+enum GrammarFindingKind {
+    FINDING_LEFT_RECURSION = 0,
+    FINDING_NULLABLE_REPEAT,
+    FINDING_SHARED_PREFIX,
+    FINDING_LEFT_CORNER,
+    FINDING_SELECTION_OVERLAP
+};
+
+#define MIN_LISTED_FINDING_COST 1
+
+static const char* findingKindNames[] = { "left-recursion", "nullable-repeat", "shared-prefix", "left-corner", "selection-overlap" };
+
+struct GrammarFinding {
+    int32_t kind;
+    int64_t cost;
+    boolean exponential;
+    struct GrammarRule* rule;
+    struct NString detail;
+};
+
+struct GrammarAnalyzer {
+    struct NVector rules;    // struct GrammarRule*.
+    struct NVector findings; // struct GrammarFinding*.
+    int32_t ruleBitsSize;    // Bytes per rule bit set.
+};
+
+struct RuleTextParser {
+    const char* text;
+    int32_t offset;
+    boolean failed;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper functions
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static boolean getBit(const uint8_t* bits, int32_t index) {
+    return (bits[index >> 3] >> (index & 7)) & 1;
+}
+
+static void setBit(uint8_t* bits, int32_t index) {
+    bits[index >> 3] |= 1 << (index & 7);
+}
+
+// Returns True if target changed,
+static boolean mergeBits(uint8_t* target, const uint8_t* source, int32_t bytesCount) {
+    boolean changed = False;
+    for (int32_t i=0; i<bytesCount; i++) {
+        uint8_t merged = target[i] | source[i];
+        if (merged != target[i]) changed = True;
+        target[i] = merged;
+    }
+    return changed;
+}
+
+static int32_t countBits(const uint8_t* bits, int32_t bytesCount) {
+    int32_t count = 0;
+    for (int32_t i=0; i<bytesCount; i++) {
+        for (uint8_t byte = bits[i]; byte; byte &= byte - 1) count++;
+    }
+    return count;
+}
+
+static struct GrammarRule* getRule(struct GrammarAnalyzer* analyzer, int32_t index) {
+    return *(struct GrammarRule**) NVector.get(&analyzer->rules, index);
+}
+
+static int32_t findRule(struct GrammarAnalyzer* analyzer, const char* ruleName) {
+    int32_t rulesCount = NVector.size(&analyzer->rules);
+    for (int32_t i=0; i<rulesCount; i++) {
+        if (NCString.equals(NString.get(&getRule(analyzer, i)->name), ruleName)) return i;
+    }
+    return -1;
+}
+
+static struct GrammarExpression* getChild(struct GrammarExpression* expression, int32_t index) {
+    return *(struct GrammarExpression**) NVector.get(&expression->children, index);
+}
+
+static struct GrammarExpression* createExpression(int32_t type) {
+    struct GrammarExpression* expression = NMALLOC(sizeof(struct GrammarExpression), "GrammarAnalyzer.createExpression() expression");
+    NSystemUtils.memset(expression, 0, sizeof(struct GrammarExpression));
+    expression->type = type;
+    expression->ruleIndex = -1;
+    NString.initialize(&expression->ruleName, "");
+    NVector.initialize(&expression->children, 0, sizeof(struct GrammarExpression*));
+    return expression;
+}
+
+static void deleteExpression(struct GrammarExpression* expression) {
+    int32_t childrenCount = NVector.size(&expression->children);
+    for (int32_t i=0; i<childrenCount; i++) deleteExpression(getChild(expression, i));
+    NVector.destroy(&expression->children);
+    NString.destroy(&expression->ruleName);
+    NFREE(expression, "GrammarAnalyzer.deleteExpression() expression");
+}
+
+static boolean expressionsEqual(struct GrammarExpression* expression1, struct GrammarExpression* expression2) {
+    if (expression1->type != expression2->type) return False;
+    if ((expression1->rangeStart != expression2->rangeStart) || (expression1->rangeEnd != expression2->rangeEnd)) return False;
+    if (!NCString.equals(NString.get(&expression1->ruleName), NString.get(&expression2->ruleName))) return False;
+    int32_t childrenCount = NVector.size(&expression1->children);
+    if (childrenCount != NVector.size(&expression2->children)) return False;
+    for (int32_t i=0; i<childrenCount; i++) {
+        if (!expressionsEqual(getChild(expression1, i), getChild(expression2, i))) return False;
+    }
+    return True;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Rule text parsing
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static struct GrammarExpression* parseSequence(struct RuleTextParser* parser, char terminator);
+
+static void skipSpaces(struct RuleTextParser* parser) {
+    while ((parser->text[parser->offset] == ' ') || (parser->text[parser->offset] == '\t')) parser->offset++;
+}
+
+// Reads up to the closing brace, the opening one already skipped,
+static void parseRuleName(struct RuleTextParser* parser, struct NString* outName) {
+    char character[2] = { 0, 0 };
+    NString.set(outName, "");
+    for (character[0] = parser->text[parser->offset]; character[0] != '}'; character[0] = parser->text[++parser->offset]) {
+        if (!character[0]) {
+            parser->failed = True;
+            return;
+        }
+        NString.append(outName, "%s", character);
+    }
+    parser->offset++;
+}
+
+static uint8_t parseCharacter(struct RuleTextParser* parser) {
+    if (parser->text[parser->offset] == '\\') parser->offset++;
+    uint8_t character = (uint8_t) parser->text[parser->offset];
+    if (character) {
+        parser->offset++;
+    } else {
+        parser->failed = True;
+    }
+    return character;
+}
+
+static struct GrammarExpression* parseSelection(struct RuleTextParser* parser) {
+    struct GrammarExpression* selection = createExpression(EXPRESSION_SELECTION);
+    parser->offset += 2;
+
+    // Options, up to the closing brace or the condition (which only filters them),
+    boolean inCondition = False;
+    while (!parser->failed) {
+        skipSpaces(parser);
+        char character = parser->text[parser->offset];
+        if (character == '}') {
+            parser->offset++;
+            break;
+        } else if (character == '{') {
+            parser->offset++;
+            struct GrammarExpression* option = createExpression(EXPRESSION_SUBSTITUTION);
+            parseRuleName(parser, &option->ruleName);
+            if (inCondition) {
+                deleteExpression(option);
+            } else {
+                NVector.pushBack(&selection->children, &option);
+            }
+        } else if (((character == '=') || (character == '!')) && (parser->text[parser->offset+1] == '=')) {
+            parser->offset += 2;
+            inCondition = True;
+            selection->conditional = True;
+        } else {
+            parser->failed = True;
+        }
+    }
+    return selection;
+}
+
+static struct GrammarExpression* parseElement(struct RuleTextParser* parser) {
+    const char* text = &parser->text[parser->offset];
+    struct GrammarExpression* element;
+    if ((text[0] == '$') && (text[1] == '{')) {
+        element = createExpression(EXPRESSION_SUBSTITUTION);
+        parser->offset += 2;
+        parseRuleName(parser, &element->ruleName);
+    } else if ((text[0] == '#') && (text[1] == '{')) {
+        element = parseSelection(parser);
+    } else if (text[0] == '{') {
+        parser->offset++;
+        element = parseSequence(parser, '}');
+        if (parser->text[parser->offset] == '}') {
+            parser->offset++;
+        } else {
+            parser->failed = True;
+        }
+
+        // A group of one is just its element,
+        if (NVector.size(&element->children) == 1) {
+            struct GrammarExpression* onlyChild = getChild(element, 0);
+            NVector.clear(&element->children);
+            deleteExpression(element);
+            element = onlyChild;
+        }
+    } else if (text[0] == '*') {
+        element = createExpression(EXPRESSION_ANYTHING);
+        parser->offset++;
+    } else {
+        element = createExpression(EXPRESSION_LITERAL);
+        element->rangeStart = element->rangeEnd = parseCharacter(parser);
+        if ((parser->text[parser->offset] == '-') && parser->text[parser->offset+1]) {
+            parser->offset++;
+            element->rangeEnd = parseCharacter(parser);
+        }
+    }
+
+    // Repeat,
+    if ((parser->text[parser->offset] == '^') && (parser->text[parser->offset+1] == '*')) {
+        parser->offset += 2;
+        struct GrammarExpression* repeat = createExpression(EXPRESSION_REPEAT);
+        NVector.pushBack(&repeat->children, &element);
+        element = repeat;
+    }
+    return element;
+}
+
+static struct GrammarExpression* parseSequence(struct RuleTextParser* parser, char terminator) {
+    struct GrammarExpression* sequence = createExpression(EXPRESSION_SEQUENCE);
+    while (!parser->failed) {
+        skipSpaces(parser);
+        char character = parser->text[parser->offset];
+        if (!character || (character == terminator)) break;
+
+        struct GrammarExpression* element = parseElement(parser);
+
+        // Choices bind the elements right before and after them,
+        skipSpaces(parser);
+        while (!parser->failed && (parser->text[parser->offset] == '|')) {
+            parser->offset++;
+            skipSpaces(parser);
+            if (element->type != EXPRESSION_CHOICE) {
+                struct GrammarExpression* choice = createExpression(EXPRESSION_CHOICE);
+                NVector.pushBack(&choice->children, &element);
+                element = choice;
+            }
+            struct GrammarExpression* alternative = parseElement(parser);
+            NVector.pushBack(&element->children, &alternative);
+            skipSpaces(parser);
+        }
+        NVector.pushBack(&sequence->children, &element);
+    }
+    return sequence;
+}
+
+static boolean resolveSubstitutions(struct GrammarAnalyzer* analyzer, struct GrammarRule* rule, struct GrammarExpression* expression) {
+    boolean success = True;
+    if (expression->type == EXPRESSION_SUBSTITUTION) {
+        expression->ruleIndex = findRule(analyzer, NString.get(&expression->ruleName));
+        if (expression->ruleIndex < 0) {
+            NERROR("GrammarAnalyzer.resolveSubstitutions()", "Rule %s%s%s references an undefined rule: %s%s%s",
+                    NTCOLOR(HIGHLIGHT), NString.get(&rule->name), NTCOLOR(STREAM_DEFAULT),
+                    NTCOLOR(HIGHLIGHT), NString.get(&expression->ruleName), NTCOLOR(STREAM_DEFAULT));
+            success = False;
+        }
+    }
+    int32_t childrenCount = NVector.size(&expression->children);
+    for (int32_t i=0; i<childrenCount; i++) {
+        if (!resolveSubstitutions(analyzer, rule, getChild(expression, i))) success = False;
+    }
+    return success;
+}
+
+static void appendExpression(struct NString* outString, struct GrammarExpression* expression) {
+    int32_t childrenCount = NVector.size(&expression->children);
+    switch (expression->type) {
+        case EXPRESSION_LITERAL: {
+            char character[2] = { (char) expression->rangeStart, 0 };
+            NString.append(outString, "%s", character);
+            if (expression->rangeEnd != expression->rangeStart) {
+                character[0] = (char) expression->rangeEnd;
+                NString.append(outString, "-%s", character);
+            }
+            break;
+        }
+        case EXPRESSION_ANYTHING:
+            NString.append(outString, "*");
+            break;
+        case EXPRESSION_SUBSTITUTION:
+            NString.append(outString, "${%s}", NString.get(&expression->ruleName));
+            break;
+        case EXPRESSION_SELECTION:
+            NString.append(outString, "#{");
+            for (int32_t i=0; i<childrenCount; i++) NString.append(outString, "{%s}", NString.get(&getChild(expression, i)->ruleName));
+            NString.append(outString, "}");
+            break;
+        case EXPRESSION_SEQUENCE:
+            NString.append(outString, "{");
+            for (int32_t i=0; i<childrenCount; i++) {
+                if (i) NString.append(outString, " ");
+                appendExpression(outString, getChild(expression, i));
+            }
+            NString.append(outString, "}");
+            break;
+        case EXPRESSION_CHOICE:
+            for (int32_t i=0; i<childrenCount; i++) {
+                if (i) NString.append(outString, "|");
+                appendExpression(outString, getChild(expression, i));
+            }
+            break;
+        case EXPRESSION_REPEAT:
+            appendExpression(outString, getChild(expression, 0));
+            NString.append(outString, "^*");
+            break;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Nullable rules, FIRST sets and left corners
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static boolean isNullable(struct GrammarAnalyzer* analyzer, struct GrammarExpression* expression) {
+    int32_t childrenCount = NVector.size(&expression->children);
+    switch (expression->type) {
+        case EXPRESSION_LITERAL: return False;
+        case EXPRESSION_ANYTHING: return True;
+        case EXPRESSION_REPEAT: return True;
+        case EXPRESSION_SUBSTITUTION: return getRule(analyzer, expression->ruleIndex)->nullable;
+        case EXPRESSION_SEQUENCE:
+            for (int32_t i=0; i<childrenCount; i++) if (!isNullable(analyzer, getChild(expression, i))) return False;
+            return True;
+        default: // Choices and selections,
+            for (int32_t i=0; i<childrenCount; i++) if (isNullable(analyzer, getChild(expression, i))) return True;
+            return False;
+    }
+}
+
+static void collectFirst(struct GrammarAnalyzer* analyzer, struct GrammarExpression* expression, uint8_t* outFirst) {
+    int32_t childrenCount = NVector.size(&expression->children);
+    switch (expression->type) {
+        case EXPRESSION_LITERAL:
+            for (int32_t i=expression->rangeStart; i<=expression->rangeEnd; i++) setBit(outFirst, i);
+            return;
+        case EXPRESSION_ANYTHING:
+            NSystemUtils.memset(outFirst, 0xff, 32);
+            return;
+        case EXPRESSION_SUBSTITUTION:
+            mergeBits(outFirst, getRule(analyzer, expression->ruleIndex)->first, 32);
+            return;
+        case EXPRESSION_SEQUENCE:
+            for (int32_t i=0; i<childrenCount; i++) {
+                collectFirst(analyzer, getChild(expression, i), outFirst);
+                if (!isNullable(analyzer, getChild(expression, i))) return;
+            }
+            return;
+        default:
+            for (int32_t i=0; i<childrenCount; i++) collectFirst(analyzer, getChild(expression, i), outFirst);
+    }
+}
+
+// The rules that may be matched from the expression's offset. With closure, their left corners
+// too,
+static void collectLeftCorners(struct GrammarAnalyzer* analyzer, struct GrammarExpression* expression, boolean closure, uint8_t* outRules) {
+    int32_t childrenCount = NVector.size(&expression->children);
+    switch (expression->type) {
+        case EXPRESSION_LITERAL:
+        case EXPRESSION_ANYTHING:
+            return;
+        case EXPRESSION_SUBSTITUTION:
+            setBit(outRules, expression->ruleIndex);
+            if (closure) mergeBits(outRules, getRule(analyzer, expression->ruleIndex)->leftCorners, analyzer->ruleBitsSize);
+            return;
+        case EXPRESSION_SEQUENCE:
+            for (int32_t i=0; i<childrenCount; i++) {
+                collectLeftCorners(analyzer, getChild(expression, i), closure, outRules);
+                if (!isNullable(analyzer, getChild(expression, i))) return;
+            }
+            return;
+        default:
+            for (int32_t i=0; i<childrenCount; i++) collectLeftCorners(analyzer, getChild(expression, i), closure, outRules);
+    }
+}
+
+// All the rules reachable from the expression, at any offset,
+static void collectReachableRules(struct GrammarAnalyzer* analyzer, struct GrammarExpression* expression, uint8_t* outRules) {
+    if (expression->type == EXPRESSION_SUBSTITUTION) {
+        mergeBits(outRules, getRule(analyzer, expression->ruleIndex)->reachableRules, analyzer->ruleBitsSize);
+    }
+    int32_t childrenCount = NVector.size(&expression->children);
+    for (int32_t i=0; i<childrenCount; i++) collectReachableRules(analyzer, getChild(expression, i), outRules);
+}
+
+static void collectReferencedRules(struct GrammarExpression* expression, uint8_t* outRules) {
+    if (expression->type == EXPRESSION_SUBSTITUTION) setBit(outRules, expression->ruleIndex);
+    int32_t childrenCount = NVector.size(&expression->children);
+    for (int32_t i=0; i<childrenCount; i++) collectReferencedRules(getChild(expression, i), outRules);
+}
+
+static void computeFixedPoints(struct GrammarAnalyzer* analyzer) {
+
+    int32_t rulesCount = NVector.size(&analyzer->rules);
+    boolean changed;
+    do {
+        changed = False;
+        for (int32_t i=0; i<rulesCount; i++) {
+            struct GrammarRule* rule = getRule(analyzer, i);
+            if (!rule->nullable && isNullable(analyzer, rule->expression)) {
+                rule->nullable = True;
+                changed = True;
+            }
+
+            uint8_t first[32];
+            NSystemUtils.memcpy(first, rule->first, 32);
+            collectFirst(analyzer, rule->expression, first);
+            if (mergeBits(rule->first, first, 32)) changed = True;
+
+            uint8_t* leftCorners = NMALLOC(analyzer->ruleBitsSize, "GrammarAnalyzer.computeFixedPoints() leftCorners");
+            NSystemUtils.memset(leftCorners, 0, analyzer->ruleBitsSize);
+            collectLeftCorners(analyzer, rule->expression, True, leftCorners);
+            if (mergeBits(rule->leftCorners, leftCorners, analyzer->ruleBitsSize)) changed = True;
+            NFREE(leftCorners, "GrammarAnalyzer.computeFixedPoints() leftCorners");
+        }
+    } while (changed);
+
+    // Reachable rules,
+    for (int32_t i=0; i<rulesCount; i++) {
+        struct GrammarRule* rule = getRule(analyzer, i);
+        setBit(rule->reachableRules, i);
+        collectReferencedRules(rule->expression, rule->reachableRules);
+    }
+    do {
+        changed = False;
+        for (int32_t i=0; i<rulesCount; i++) {
+            struct GrammarRule* rule = getRule(analyzer, i);
+            for (int32_t j=0; j<rulesCount; j++) {
+                if (getBit(rule->reachableRules, j) && mergeBits(rule->reachableRules, getRule(analyzer, j)->reachableRules, analyzer->ruleBitsSize)) changed = True;
+            }
+        }
+    } while (changed);
+    for (int32_t i=0; i<rulesCount; i++) {
+        struct GrammarRule* rule = getRule(analyzer, i);
+        rule->reachableRulesCount = countBits(rule->reachableRules, analyzer->ruleBitsSize);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Exclusivity proofs
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Alternatives are exclusive if no input can be matched by more than one of them from the same
+// offset. Then trying them in order and stopping at the first success gives the same tree as
+// matching all of them to pick the longest.
+//
+// Two element lists are proven exclusive once, past the elements they share, what remains of
+// both can't match nothing and their FIRST sets don't intersect. Otherwise, the first remaining
+// element (substitution, group, choice or unconditional selection) is expanded, and every case
+// has to be proven. Shared elements are assumed to match the same text in both.
+
+#define EXCLUSIVITY_PROOF_DEPTH 16
+
+static void appendElements(struct NVector* outElements, struct GrammarExpression* expression) {
+    if (expression->type == EXPRESSION_SEQUENCE) {
+        int32_t childrenCount = NVector.size(&expression->children);
+        for (int32_t i=0; i<childrenCount; i++) {
+            struct GrammarExpression* child = getChild(expression, i);
+            NVector.pushBack(outElements, &child);
+        }
+    } else {
+        NVector.pushBack(outElements, &expression);
+    }
+}
+
+static struct GrammarExpression* getListElement(struct NVector* elements, int32_t index) {
+    return *(struct GrammarExpression**) NVector.get(elements, index);
+}
+
+// FIRST set of the elements from start on. Returns whether they can match nothing,
+static boolean collectListFirst(struct GrammarAnalyzer* analyzer, struct NVector* elements, int32_t start, uint8_t* outFirst) {
+    NSystemUtils.memset(outFirst, 0, 32);
+    int32_t elementsCount = NVector.size(elements);
+    for (int32_t i=start; i<elementsCount; i++) {
+        collectFirst(analyzer, getListElement(elements, i), outFirst);
+        if (!isNullable(analyzer, getListElement(elements, i))) return False;
+    }
+    return True;
+}
+
+static boolean isExpandable(struct GrammarExpression* expression) {
+    return (expression->type == EXPRESSION_SUBSTITUTION) ||
+           (expression->type == EXPRESSION_SEQUENCE) ||
+           (expression->type == EXPRESSION_CHOICE) ||
+           ((expression->type == EXPRESSION_SELECTION) && !expression->conditional);
+}
+
+// Whether the substitution may be matched from the expression's offset,
+static boolean startsWithRule(struct GrammarAnalyzer* analyzer, struct GrammarExpression* expression, struct GrammarExpression* substitution) {
+    if (substitution->type != EXPRESSION_SUBSTITUTION) return False;
+    uint8_t* leftCorners = NMALLOC(analyzer->ruleBitsSize, "GrammarAnalyzer.startsWithRule() leftCorners");
+    NSystemUtils.memset(leftCorners, 0, analyzer->ruleBitsSize);
+    collectLeftCorners(analyzer, expression, True, leftCorners);
+    boolean startsWith = getBit(leftCorners, substitution->ruleIndex);
+    NFREE(leftCorners, "GrammarAnalyzer.startsWithRule() leftCorners");
+    return startsWith;
+}
+
+static boolean proveListsExclusive(struct GrammarAnalyzer* analyzer, struct NVector* elements1, int32_t start1, struct NVector* elements2, int32_t start2, int32_t depth);
+
+// Expands the element at start1, and proves every case against the second list,
+static boolean proveExpansionExclusive(struct GrammarAnalyzer* analyzer, struct NVector* elements1, int32_t start1, struct NVector* elements2, int32_t start2, int32_t depth) {
+
+    struct GrammarExpression* expanded = getListElement(elements1, start1);
+    int32_t casesCount = (expanded->type == EXPRESSION_CHOICE) || (expanded->type == EXPRESSION_SELECTION) ? NVector.size(&expanded->children) : 1;
+
+    struct NVector caseElements;
+    NVector.initialize(&caseElements, 0, sizeof(struct GrammarExpression*));
+    boolean proven = True;
+    for (int32_t i=0; (i<casesCount) && proven; i++) {
+        NVector.clear(&caseElements);
+        if (expanded->type == EXPRESSION_SUBSTITUTION) {
+            appendElements(&caseElements, getRule(analyzer, expanded->ruleIndex)->expression);
+        } else if (expanded->type == EXPRESSION_SEQUENCE) {
+            appendElements(&caseElements, expanded);
+        } else {
+            appendElements(&caseElements, getChild(expanded, i));
+        }
+        int32_t elementsCount = NVector.size(elements1);
+        for (int32_t j=start1+1; j<elementsCount; j++) {
+            struct GrammarExpression* element = getListElement(elements1, j);
+            NVector.pushBack(&caseElements, &element);
+        }
+        proven = proveListsExclusive(analyzer, &caseElements, 0, elements2, start2, depth-1);
+    }
+    NVector.destroy(&caseElements);
+    return proven;
+}
+
+static boolean proveListsExclusive(struct GrammarAnalyzer* analyzer, struct NVector* elements1, int32_t start1, struct NVector* elements2, int32_t start2, int32_t depth) {
+
+    // Skip the shared elements,
+    int32_t elementsCount1 = NVector.size(elements1), elementsCount2 = NVector.size(elements2);
+    while ((start1 < elementsCount1) && (start2 < elementsCount2) &&
+           expressionsEqual(getListElement(elements1, start1), getListElement(elements2, start2))) {
+        start1++;
+        start2++;
+    }
+
+    // Distinguishable by the next character,
+    uint8_t first1[32], first2[32];
+    boolean nullable1 = collectListFirst(analyzer, elements1, start1, first1);
+    boolean nullable2 = collectListFirst(analyzer, elements2, start2, first2);
+    if (nullable1 || nullable2) return False; // One may match a prefix of what the other matches.
+    boolean intersecting = False;
+    for (int32_t i=0; i<32; i++) if (first1[i] & first2[i]) intersecting = True;
+    if (!intersecting) return True;
+
+    // Expand. If one element starts with the other, it's the higher level one. Expand it to meet
+    // the other where they'd share elements,
+    if (!depth) return False;
+    struct GrammarExpression* element1 = getListElement(elements1, start1);
+    struct GrammarExpression* element2 = getListElement(elements2, start2);
+    boolean expandSecond = !isExpandable(element1) || (isExpandable(element2) && startsWithRule(analyzer, element2, element1));
+    if (expandSecond) {
+        return isExpandable(element2) && proveExpansionExclusive(analyzer, elements2, start2, elements1, start1, depth);
+    }
+    return proveExpansionExclusive(analyzer, elements1, start1, elements2, start2, depth);
+}
+
+static boolean proveExclusive(struct GrammarAnalyzer* analyzer, struct GrammarExpression* alternative1, struct GrammarExpression* alternative2) {
+    struct NVector elements1, elements2;
+    NVector.initialize(&elements1, 0, sizeof(struct GrammarExpression*));
+    NVector.initialize(&elements2, 0, sizeof(struct GrammarExpression*));
+    appendElements(&elements1, alternative1);
+    appendElements(&elements2, alternative2);
+    boolean proven = proveListsExclusive(analyzer, &elements1, 0, &elements2, 0, EXCLUSIVITY_PROOF_DEPTH);
+    NVector.destroy(&elements1);
+    NVector.destroy(&elements2);
+    return proven;
+}
+
+// Proves the alternatives in the mask pairwise exclusive. Reports the first pair that isn't if
+// outUnprovenPair is given,
+static boolean proveAlternativesExclusive(struct GrammarAnalyzer* analyzer, struct GrammarExpression* alternatives, uint64_t mask, struct NString* outUnprovenPair) {
+    int32_t alternativesCount = NVector.size(&alternatives->children);
+    if (alternativesCount > 64) alternativesCount = 64;
+    for (int32_t i=0; i<alternativesCount; i++) {
+        if (!(mask & ((uint64_t) 1 << i))) continue;
+        for (int32_t j=i+1; j<alternativesCount; j++) {
+            if (!(mask & ((uint64_t) 1 << j))) continue;
+            if (proveExclusive(analyzer, getChild(alternatives, i), getChild(alternatives, j))) continue;
+            if (outUnprovenPair) {
+                appendExpression(outUnprovenPair, getChild(alternatives, i));
+                NString.append(outUnprovenPair, " and ");
+                appendExpression(outUnprovenPair, getChild(alternatives, j));
+            }
+            return False;
+        }
+    }
+    return True;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Findings
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static struct GrammarFinding* addFinding(struct GrammarAnalyzer* analyzer, int32_t kind, struct GrammarRule* rule, int64_t cost, boolean exponential) {
+    struct GrammarFinding* finding = NMALLOC(sizeof(struct GrammarFinding), "GrammarAnalyzer.addFinding() finding");
+    finding->kind = kind;
+    finding->rule = rule;
+    finding->cost = cost;
+    finding->exponential = exponential;
+    NString.initialize(&finding->detail, "");
+    NVector.pushBack(&analyzer->findings, &finding);
+    return finding;
+}
+
+// Elements of an alternative, a sequence's children or the alternative itself,
+static int32_t getElementsCount(struct GrammarExpression* alternative) {
+    return (alternative->type == EXPRESSION_SEQUENCE) ? NVector.size(&alternative->children) : 1;
+}
+
+static struct GrammarExpression* getElement(struct GrammarExpression* alternative, int32_t index) {
+    return (alternative->type == EXPRESSION_SEQUENCE) ? getChild(alternative, index) : alternative;
+}
+
+static int32_t getSharedPrefixLength(struct GrammarExpression* alternative1, struct GrammarExpression* alternative2) {
+    int32_t elementsCount1 = getElementsCount(alternative1);
+    int32_t elementsCount2 = getElementsCount(alternative2);
+    int32_t length = 0;
+    while ((length < elementsCount1) && (length < elementsCount2) &&
+           expressionsEqual(getElement(alternative1, length), getElement(alternative2, length))) length++;
+    return length;
+}
+
+static void analyzeChoice(struct GrammarAnalyzer* analyzer, int32_t ruleIndex, struct GrammarExpression* choice) {
+
+    struct GrammarRule* rule = getRule(analyzer, ruleIndex);
+    int32_t alternativesCount = NVector.size(&choice->children);
+    boolean* grouped = NMALLOC(alternativesCount * sizeof(boolean), "GrammarAnalyzer.analyzeChoice() grouped");
+    NSystemUtils.memset(grouped, 0, alternativesCount * sizeof(boolean));
+    uint8_t* rules = NMALLOC(analyzer->ruleBitsSize, "GrammarAnalyzer.analyzeChoice() rules");
+
+    // Shared prefixes. Alternatives sharing their first element with an earlier one are grouped
+    // with it, and the group reported once with the prefix all of them share,
+    for (int32_t i=0; i<alternativesCount; i++) {
+        if (grouped[i]) continue;
+        struct GrammarExpression* alternative = getChild(choice, i);
+        int32_t groupSize = 1, prefixLength = getElementsCount(alternative);
+        for (int32_t j=i+1; j<alternativesCount; j++) {
+            int32_t sharedLength = getSharedPrefixLength(alternative, getChild(choice, j));
+            if (!sharedLength) continue;
+            grouped[j] = True;
+            groupSize++;
+            if (sharedLength < prefixLength) prefixLength = sharedLength;
+        }
+        if (groupSize == 1) continue;
+
+        NSystemUtils.memset(rules, 0, analyzer->ruleBitsSize);
+        for (int32_t j=0; j<prefixLength; j++) collectReachableRules(analyzer, getElement(alternative, j), rules);
+        int64_t cost = (int64_t) countBits(rules, analyzer->ruleBitsSize) * (groupSize - 1);
+        struct GrammarFinding* finding = addFinding(analyzer, FINDING_SHARED_PREFIX, rule, cost, getBit(rules, ruleIndex));
+        NString.append(&finding->detail, "%d alternatives start with: ", groupSize);
+        for (int32_t j=0; j<prefixLength; j++) {
+            if (j) NString.append(&finding->detail, " ");
+            appendExpression(&finding->detail, getElement(alternative, j));
+        }
+    }
+
+    // Left corners. An alternative starting with a rule that another alternative matches from the
+    // same offset re-matches it (alternatives with shared prefixes are already reported),
+    uint8_t* leftCorners = NMALLOC(analyzer->ruleBitsSize, "GrammarAnalyzer.analyzeChoice() leftCorners");
+    int32_t rulesCount = NVector.size(&analyzer->rules);
+    for (int32_t j=0; j<alternativesCount; j++) {
+        NSystemUtils.memset(rules, 0, analyzer->ruleBitsSize);
+        collectLeftCorners(analyzer, getChild(choice, j), False, rules);
+        for (int32_t leftCorner=0; leftCorner<rulesCount; leftCorner++) {
+            if (!getBit(rules, leftCorner)) continue;
+            struct GrammarRule* leftCornerRule = getRule(analyzer, leftCorner);
+            if (!countBits(leftCornerRule->first, 32)) continue; // Only matches nothing, like ${ε}.
+            for (int32_t i=0; i<alternativesCount; i++) {
+                if ((i == j) || getSharedPrefixLength(getChild(choice, i), getChild(choice, j))) continue;
+                NSystemUtils.memset(leftCorners, 0, analyzer->ruleBitsSize);
+                collectLeftCorners(analyzer, getChild(choice, i), True, leftCorners);
+                if (!getBit(leftCorners, leftCorner)) continue;
+
+                struct GrammarFinding* finding = addFinding(
+                        analyzer, FINDING_LEFT_CORNER, rule, leftCornerRule->reachableRulesCount, getBit(leftCornerRule->reachableRules, ruleIndex));
+                NString.append(&finding->detail, "alternative %d re-matches ${%s}, already matched under alternative %d: ", j+1, NString.get(&leftCornerRule->name), i+1);
+                appendExpression(&finding->detail, getElement(getChild(choice, i), 0));
+                break;
+            }
+        }
+    }
+
+    NFREE(leftCorners, "GrammarAnalyzer.analyzeChoice() leftCorners");
+    NFREE(rules, "GrammarAnalyzer.analyzeChoice() rules");
+    NFREE(grouped, "GrammarAnalyzer.analyzeChoice() grouped");
+}
+
+static void analyzeSelection(struct GrammarAnalyzer* analyzer, int32_t ruleIndex, struct GrammarExpression* selection) {
+
+    // Which options may match each rule from the selection's offset,
+    int32_t optionsCount = NVector.size(&selection->children);
+    if (optionsCount > 64) optionsCount = 64;
+    int32_t rulesCount = NVector.size(&analyzer->rules);
+    uint64_t* coverages = NMALLOC(rulesCount * sizeof(uint64_t), "GrammarAnalyzer.analyzeSelection() coverages");
+    NSystemUtils.memset(coverages, 0, rulesCount * sizeof(uint64_t));
+    uint8_t* leftCorners = NMALLOC(analyzer->ruleBitsSize, "GrammarAnalyzer.analyzeSelection() leftCorners");
+    for (int32_t i=0; i<optionsCount; i++) {
+        NSystemUtils.memset(leftCorners, 0, analyzer->ruleBitsSize);
+        collectLeftCorners(analyzer, getChild(selection, i), True, leftCorners);
+        for (int32_t j=0; j<rulesCount; j++) if (getBit(leftCorners, j)) coverages[j] |= (uint64_t) 1 << i;
+    }
+
+    // Per set of options sharing rules, report the most expensive rule they share,
+    for (int32_t i=0; i<rulesCount; i++) {
+        uint64_t coverage = coverages[i];
+        int32_t sharingOptionsCount = countBits((uint8_t*) &coverage, sizeof(uint64_t));
+        if (sharingOptionsCount < 2) continue;
+
+        int32_t mostExpensiveRuleIndex = i;
+        boolean alreadyReported = False;
+        for (int32_t j=0; j<rulesCount; j++) {
+            if (coverages[j] != coverage) continue;
+            if (j < i) alreadyReported = True;
+            if (getRule(analyzer, j)->reachableRulesCount > getRule(analyzer, mostExpensiveRuleIndex)->reachableRulesCount) mostExpensiveRuleIndex = j;
+        }
+        if (alreadyReported) continue;
+
+        struct GrammarRule* sharedRule = getRule(analyzer, mostExpensiveRuleIndex);
+        struct GrammarFinding* finding = addFinding(
+                analyzer, FINDING_SELECTION_OVERLAP, getRule(analyzer, ruleIndex),
+                (int64_t) sharedRule->reachableRulesCount * (sharingOptionsCount - 1), getBit(sharedRule->reachableRules, ruleIndex));
+        NString.append(&finding->detail, "${%s} is matched by each of:", NString.get(&sharedRule->name));
+        for (int32_t j=0; j<optionsCount; j++) {
+            if (coverage & ((uint64_t) 1 << j)) NString.append(&finding->detail, " {%s}", NString.get(&getChild(selection, j)->ruleName));
+        }
+        if (!selection->conditional && proveAlternativesExclusive(analyzer, selection, coverage, 0)) {
+            NString.append(&finding->detail, " (proven exclusive, can be an ordered choice)");
+        }
+    }
+
+    NFREE(leftCorners, "GrammarAnalyzer.analyzeSelection() leftCorners");
+    NFREE(coverages, "GrammarAnalyzer.analyzeSelection() coverages");
+}
+
+static void analyzeExpression(struct GrammarAnalyzer* analyzer, int32_t ruleIndex, struct GrammarExpression* expression) {
+
+    if (expression->type == EXPRESSION_CHOICE) {
+        analyzeChoice(analyzer, ruleIndex, expression);
+    } else if (expression->type == EXPRESSION_SELECTION) {
+        analyzeSelection(analyzer, ruleIndex, expression);
+    } else if ((expression->type == EXPRESSION_REPEAT) && isNullable(analyzer, getChild(expression, 0))) {
+        struct GrammarFinding* finding = addFinding(analyzer, FINDING_NULLABLE_REPEAT, getRule(analyzer, ruleIndex), 0, True);
+        NString.append(&finding->detail, "repeats something that can match nothing: ");
+        appendExpression(&finding->detail, expression);
+    }
+
+    int32_t childrenCount = NVector.size(&expression->children);
+    for (int32_t i=0; i<childrenCount; i++) analyzeExpression(analyzer, ruleIndex, getChild(expression, i));
+}
+
+static int compareFindings(const void* finding1Pointer, const void* finding2Pointer) {
+    struct GrammarFinding* finding1 = *(struct GrammarFinding**) finding1Pointer;
+    struct GrammarFinding* finding2 = *(struct GrammarFinding**) finding2Pointer;
+
+    // Unbounded first, then exponential, then by cost,
+    boolean unbounded1 = finding1->kind <= FINDING_NULLABLE_REPEAT, unbounded2 = finding2->kind <= FINDING_NULLABLE_REPEAT;
+    if (unbounded1 != unbounded2) return unbounded1 ? -1 : 1;
+    if (finding1->exponential != finding2->exponential) return finding1->exponential ? -1 : 1;
+    return (finding1->cost < finding2->cost) - (finding1->cost > finding2->cost);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Report
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void appendCharacter(struct NString* outString, int32_t character) {
+    if ((character > ' ') && (character < 0x7f) && (character != '\\')) {
+        char text[2] = { (char) character, 0 };
+        NString.append(outString, "%s", text);
+    } else {
+        const char* digits = "0123456789abcdef";
+        char text[5] = { '\\', 'x', digits[character >> 4], digits[character & 15], 0 };
+        NString.append(outString, "%s", text);
+    }
+}
+
+static void appendCharacterSet(struct NString* outString, const uint8_t* characters) {
+    int32_t count = countBits(characters, 32);
+    if (count == 256) {
+        NString.append(outString, "any");
+        return;
+    }
+
+    for (int32_t start=0; start<256; start++) {
+        if (!getBit(characters, start)) continue;
+        int32_t end = start;
+        while ((end < 255) && getBit(characters, end+1)) end++;
+        appendCharacter(outString, start);
+        if (end > start) {
+            NString.append(outString, (end > start+1) ? "-" : " ");
+            appendCharacter(outString, end);
+        }
+        NString.append(outString, " ");
+        start = end;
+    }
+}
+
+static const char* getDisplayName(struct GrammarRule* rule) {
+    const char* name = NString.get(&rule->name);
+    return *name ? name : "\"\"";
+}
+
+static void logFirstSets(struct GrammarAnalyzer* analyzer) {
+
+    struct NString table;
+    NString.initialize(&table, "Nullable rules and FIRST sets:\n");
+    int32_t rulesCount = NVector.size(&analyzer->rules);
+    for (int32_t i=0; i<rulesCount; i++) {
+        struct GrammarRule* rule = getRule(analyzer, i);
+        appendPadded(&table, getDisplayName(rule), 36, False);
+        appendPadded(&table, rule->nullable ? "nullable" : "", 10, False);
+        appendCharacterSet(&table, rule->first);
+        NString.append(&table, "\n");
+    }
+    NLOGI("", "%s", NString.get(&table));
+    NString.destroy(&table);
+}
+
+static void logFindings(struct GrammarAnalyzer* analyzer) {
+
+    int32_t findingsCount = NVector.size(&analyzer->findings);
+    if (findingsCount) qsort(NVector.get(&analyzer->findings, 0), findingsCount, sizeof(struct GrammarFinding*), compareFindings);
+
+    // Re-matching a single token (or a few characters) is cheaper than avoiding it, these are
+    // counted but not listed,
+    int32_t listedFindingsCount = 0;
+    for (int32_t i=0; i<findingsCount; i++) {
+        struct GrammarFinding* finding = *(struct GrammarFinding**) NVector.get(&analyzer->findings, i);
+        if ((finding->kind <= FINDING_NULLABLE_REPEAT) || (finding->cost > MIN_LISTED_FINDING_COST)) listedFindingsCount++;
+    }
+
+    struct NString table, cell;
+    NString.initialize(&table, "%d findings, by estimated re-match cost (rules reachable from what's re-matched, times the extra matches):\n", findingsCount);
+    NString.initialize(&cell, "");
+    const char* headers[] = { "cost", "", "kind", "rule", "detail" };
+    const int32_t widths[] = { 8, 15, 19, 32, 0 };
+    for (int32_t i=0; i<5; i++) appendPadded(&table, headers[i], widths[i], !i);
+    NString.append(&table, "\n");
+
+    for (int32_t i=0; i<listedFindingsCount; i++) {
+        struct GrammarFinding* finding = *(struct GrammarFinding**) NVector.get(&analyzer->findings, i);
+        NString.set(&cell, "");
+        if (finding->kind <= FINDING_NULLABLE_REPEAT) {
+            NString.append(&cell, "-");
+        } else {
+            appendInteger64(&cell, finding->cost);
+        }
+        appendPadded(&table, NString.get(&cell), widths[0], True);
+        appendPadded(&table, (finding->kind <= FINDING_NULLABLE_REPEAT) ? "  unbounded" : (finding->exponential ? "  exponential" : ""), widths[1], False);
+        appendPadded(&table, findingKindNames[finding->kind], widths[2], False);
+        appendPadded(&table, getDisplayName(finding->rule), widths[3], False);
+        NString.append(&table, "%s\n", NString.get(&finding->detail));
+    }
+    if (listedFindingsCount < findingsCount) {
+        NString.append(&table, "%d more with a cost of %d or less (single tokens and characters).\n", findingsCount - listedFindingsCount, MIN_LISTED_FINDING_COST);
+    }
+
+    NLOGI("", "%s", NString.get(&table));
+    NString.destroy(&table);
+    NString.destroy(&cell);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Grammar analyzer
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct GrammarAnalyzer* createGrammarAnalyzer() {
+    struct GrammarAnalyzer* analyzer = NMALLOC(sizeof(struct GrammarAnalyzer), "GrammarAnalyzer.createGrammarAnalyzer() analyzer");
+    NVector.initialize(&analyzer->rules, 0, sizeof(struct GrammarRule*));
+    NVector.initialize(&analyzer->findings, 0, sizeof(struct GrammarFinding*));
+    analyzer->ruleBitsSize = 0;
+    return analyzer;
+}
+
+void destroyAndDeleteGrammarAnalyzer(struct GrammarAnalyzer* analyzer) {
+
+    int32_t rulesCount = NVector.size(&analyzer->rules);
+    for (int32_t i=0; i<rulesCount; i++) {
+        struct GrammarRule* rule = getRule(analyzer, i);
+        NString.destroy(&rule->name);
+        NString.destroy(&rule->text);
+        if (rule->expression) deleteExpression(rule->expression);
+        if (rule->leftCorners) NFREE(rule->leftCorners, "GrammarAnalyzer.destroyAndDeleteGrammarAnalyzer() rule->leftCorners");
+        if (rule->reachableRules) NFREE(rule->reachableRules, "GrammarAnalyzer.destroyAndDeleteGrammarAnalyzer() rule->reachableRules");
+        NFREE(rule, "GrammarAnalyzer.destroyAndDeleteGrammarAnalyzer() rule");
+    }
+    NVector.destroy(&analyzer->rules);
+
+    int32_t findingsCount = NVector.size(&analyzer->findings);
+    for (int32_t i=0; i<findingsCount; i++) {
+        struct GrammarFinding* finding = *(struct GrammarFinding**) NVector.get(&analyzer->findings, i);
+        NString.destroy(&finding->detail);
+        NFREE(finding, "GrammarAnalyzer.destroyAndDeleteGrammarAnalyzer() finding");
+    }
+    NVector.destroy(&analyzer->findings);
+
+    NFREE(analyzer, "GrammarAnalyzer.destroyAndDeleteGrammarAnalyzer() analyzer");
+}
+
+void recordGrammarRule(struct GrammarAnalyzer* analyzer, const char* ruleName, const char* ruleText) {
+    int32_t ruleIndex = findRule(analyzer, ruleName);
+    if (ruleIndex >= 0) {
+        NString.set(&getRule(analyzer, ruleIndex)->text, "%s", ruleText);
+        return;
+    }
+
+    struct GrammarRule* rule = NMALLOC(sizeof(struct GrammarRule), "GrammarAnalyzer.recordGrammarRule() rule");
+    NSystemUtils.memset(rule, 0, sizeof(struct GrammarRule));
+    NString.initialize(&rule->name, "%s", ruleName);
+    NString.initialize(&rule->text, "%s", ruleText);
+    NVector.pushBack(&analyzer->rules, &rule);
+}
+
+boolean analyzeGrammar(struct GrammarAnalyzer* analyzer) {
+
+    // Parse,
+    boolean success = True;
+    int32_t rulesCount = NVector.size(&analyzer->rules);
+    analyzer->ruleBitsSize = (rulesCount + 7) / 8;
+    for (int32_t i=0; i<rulesCount; i++) {
+        struct GrammarRule* rule = getRule(analyzer, i);
+        struct RuleTextParser parser = { NString.get(&rule->text), 0, False };
+        rule->expression = parseSequence(&parser, 0);
+        if (parser.failed) {
+            NERROR("GrammarAnalyzer.analyzeGrammar()", "Couldn't parse rule %s%s%s near offset %d",
+                    NTCOLOR(HIGHLIGHT), NString.get(&rule->name), NTCOLOR(STREAM_DEFAULT), parser.offset);
+            success = False;
+        }
+        rule->leftCorners = NMALLOC(analyzer->ruleBitsSize, "GrammarAnalyzer.analyzeGrammar() rule->leftCorners");
+        rule->reachableRules = NMALLOC(analyzer->ruleBitsSize, "GrammarAnalyzer.analyzeGrammar() rule->reachableRules");
+        NSystemUtils.memset(rule->leftCorners, 0, analyzer->ruleBitsSize);
+        NSystemUtils.memset(rule->reachableRules, 0, analyzer->ruleBitsSize);
+    }
+    for (int32_t i=0; i<rulesCount; i++) {
+        struct GrammarRule* rule = getRule(analyzer, i);
+        if (!resolveSubstitutions(analyzer, rule, rule->expression)) success = False;
+    }
+    if (!success) return False;
+
+    // Analyze,
+    computeFixedPoints(analyzer);
+    for (int32_t i=0; i<rulesCount; i++) {
+        struct GrammarRule* rule = getRule(analyzer, i);
+        if (getBit(rule->leftCorners, i)) {
+            struct GrammarFinding* finding = addFinding(analyzer, FINDING_LEFT_RECURSION, rule, 0, True);
+            NString.append(&finding->detail, "reaches itself without consuming anything");
+        }
+        analyzeExpression(analyzer, i, rule->expression);
+    }
+
+    // Ordered choices,
+    for (int32_t i=0; i<rulesCount; i++) {
+        struct GrammarRule* rule = getRule(analyzer, i);
+        if (!rule->claimedExclusive) continue;
+
+        struct GrammarExpression* alternatives = rule->expression;
+        if ((alternatives->type == EXPRESSION_SEQUENCE) && (NVector.size(&alternatives->children) == 1)) alternatives = getChild(alternatives, 0);
+        struct NString unprovenPair;
+        NString.initialize(&unprovenPair, "");
+        if ((alternatives->type != EXPRESSION_CHOICE) && ((alternatives->type != EXPRESSION_SELECTION) || alternatives->conditional)) {
+            NERROR("GrammarAnalyzer.analyzeGrammar()", "Ordered choice %s%s%s isn't a list of alternatives.", NTCOLOR(HIGHLIGHT), getDisplayName(rule), NTCOLOR(STREAM_DEFAULT));
+            success = False;
+        } else if (!proveAlternativesExclusive(analyzer, alternatives, ~(uint64_t) 0, &unprovenPair)) {
+            NERROR("GrammarAnalyzer.analyzeGrammar()", "Ordered choice %s%s%s has alternatives that couldn't be proven exclusive: %s%s%s",
+                    NTCOLOR(HIGHLIGHT), getDisplayName(rule), NTCOLOR(STREAM_DEFAULT), NTCOLOR(HIGHLIGHT), NString.get(&unprovenPair), NTCOLOR(STREAM_DEFAULT));
+            success = False;
+        } else {
+            NLOGI("GrammarAnalyzer", "Ordered choice %s%s%s: alternatives proven exclusive.", NTCOLOR(HIGHLIGHT), getDisplayName(rule), NTCOLOR(STREAM_DEFAULT));
+        }
+        NString.destroy(&unprovenPair);
+    }
+
+    // Report,
+    int32_t nullableRulesCount = 0;
+    for (int32_t i=0; i<rulesCount; i++) if (getRule(analyzer, i)->nullable) nullableRulesCount++;
+    logFirstSets(analyzer);
+    NLOGI("GrammarAnalyzer", "%d rules, %d nullable.", rulesCount, nullableRulesCount);
+    logFindings(analyzer);
+    return success;
+}
+
+void recordOrderedChoice(struct GrammarAnalyzer* analyzer, const char* ruleName) {
+    int32_t ruleIndex = findRule(analyzer, ruleName);
+    if (ruleIndex >= 0) getRule(analyzer, ruleIndex)->claimedExclusive = True;
+}
@@ -0,0 +1,79 @@
+/////////////////////////////////////////////////////////
+// Compact binary AST files. Written right after matching,
+// and mapped back by tools as is, with nothing to parse.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+struct NCC_ASTNode;
+
+// File layout (native byte order, all fields 4 bytes aligned):
+//   header
+//   nodes    : struct ASTFileNode[nodesCount]
+//   children : uint32_t[childrenCount], node indices. Each node's children are a contiguous range,
+//   strings  : null-terminated, deduplicated names and values,
+#define AST_FILE_MAGIC 0x54534141 // "AAST".
+#define AST_FILE_VERSION 1
+
+struct ASTFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t rootNodeIndex;
+    uint32_t nodesCount;
+    uint32_t nodesOffset;
+    uint32_t childrenCount;
+    uint32_t childrenOffset;
+    uint32_t stringsSize;
+    uint32_t stringsOffset;
+};
+
+struct ASTFileNode {
+    uint32_t nameOffset;          // Into the strings.
+    uint32_t valueOffset;         // Into the strings.
+    uint32_t valueLength;
+    uint32_t firstChildOffset;    // Into the children.
+    uint32_t childrenCount;
+};
+
+////////////////////////////////////////
+// Writing
+////////////////////////////////////////
+
+struct ASTWriter;
+
+struct ASTWriter* createASTWriter();
+void destroyAndDeleteASTWriter(struct ASTWriter* writer);
+
+// Copies the tree, so it can be deleted right after (useful when streaming),
+void addASTWriterTree(struct ASTWriter* writer, struct NCC_ASTNode* tree);
+
+// If rootName is 0, the single added tree is the root. Otherwise, a root node with this name is
+// created with all the added trees as its children,
+boolean writeASTFile(struct ASTWriter* writer, const char* rootName, const char* filePath);
+
+////////////////////////////////////////
+// Reading
+////////////////////////////////////////
+
+struct ASTFile {
+    const struct ASTFileHeader* header;
+    const struct ASTFileNode* nodes;
+    const uint32_t* children;
+    const char* strings;
+
+    void* data;
+    int32_t dataSize;
+    boolean mapped;
+};
+
+// Maps the file (reads it where mapping isn't available). Every node is checked once here, so
+// the accessors below stay within the file for child indices under the node's childrenCount,
+boolean loadASTFile(const char* filePath, struct ASTFile* outFile);
+void unloadASTFile(struct ASTFile* file);
+
+const struct ASTFileNode* getASTFileRoot(const struct ASTFile* file);
+const struct ASTFileNode* getASTFileChild(const struct ASTFile* file, const struct ASTFileNode* node, int32_t childIndex);
+const char* getASTFileNodeName(const struct ASTFile* file, const struct ASTFileNode* node);
+const char* getASTFileNodeValue(const struct ASTFile* file, const struct ASTFileNode* node);
@@ -0,0 +1,50 @@
+/////////////////////////////////////////////////////////
+// Embeddable translator (libaddaat). The grammar is
+// defined once per translator, which then translates
+// code from memory to memory, any number of times,
+// without touching files or logging anything.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+// Only standard types, so that embedders need no other headers,
+#include <stdint.h>
+
+// Translation results,
+#define ADDAAT_SUCCESS             0
+#define ADDAAT_SYNTAX_ERROR        1
+#define ADDAAT_SEMANTIC_ERROR      2
+#define ADDAAT_NESTING_TOO_DEEP    3
+#define ADDAAT_OUTPUT_TOO_SMALL    4
+#define ADDAAT_INTERNAL_ERROR      5
+
+struct AddaatDiagnostic {
+    int32_t kind;           // ADDAAT_SYNTAX_ERROR, ADDAAT_SEMANTIC_ERROR, ADDAAT_NESTING_TOO_DEEP or ADDAAT_INTERNAL_ERROR.
+    int32_t offset;         // Bytes into the code. Semantic errors point at their external-declaration.
+    int32_t line, column;   // Starting from 1.
+    const char* rule;       // The innermost rule that failed to match, syntax errors only, otherwise 0.
+    const char* message;    // No terminal colors.
+};
+
+struct AddaatTranslator;
+
+// Defines the grammar. maxNestingDepth bounds how deeply the code may nest, 0 for unlimited. When
+// bounded, every translation runs on a thread with a stack sized for the limit, otherwise it runs
+// on the caller's stack,
+struct AddaatTranslator* createAddaatTranslator(int32_t maxNestingDepth);
+void destroyAndDeleteAddaatTranslator(struct AddaatTranslator* translator);
+
+// Translates codeLength bytes of code (or up to its terminating zero if codeLength is negative)
+// into outputBuffer, zero terminated. outputLength receives the generated code's length (without
+// the terminator) even when the buffer is too small, in which case nothing is written and
+// copyLastAddaatTranslation() can fetch it once a big enough buffer is available. Translators
+// share the matcher's global state, so only one translation may run at a time in a process,
+int32_t translateAddaat(struct AddaatTranslator* translator, const char* code, int32_t codeLength, char* outputBuffer, int32_t outputBufferSize, int32_t* outputLength);
+
+// Copies the last successful translation. Returns ADDAAT_OUTPUT_TOO_SMALL if it doesn't fit,
+int32_t copyLastAddaatTranslation(struct AddaatTranslator* translator, char* outputBuffer, int32_t outputBufferSize);
+
+// The last translation's diagnostics. They're owned by the translator, and remain valid until the
+// next translation,
+int32_t getAddaatDiagnosticsCount(struct AddaatTranslator* translator);
+const struct AddaatDiagnostic* getAddaatDiagnostic(struct AddaatTranslator* translator, int32_t index);
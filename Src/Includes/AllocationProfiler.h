@@ -0,0 +1,59 @@
+/////////////////////////////////////////////////////////
+// Allocation profiling by NMALLOC tag. Include this after
+// NSystemUtils.h, and it reroutes NMALLOC/NFREE through
+// the profiler, which then forwards to the originals.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+// Follows memory profiling unless set explicitly,
+#ifndef ADDAAT_PROFILE_ALLOCATIONS
+    #if defined(NPROFILE_MEMORY) && NPROFILE_MEMORY
+        #define ADDAAT_PROFILE_ALLOCATIONS 1
+    #else
+        #define ADDAAT_PROFILE_ALLOCATIONS 0
+    #endif
+#endif
+
+void* profiledMalloc(int32_t size, const char* tag);
+void profiledFree(void* address, const char* tag);
+
+#if ADDAAT_PROFILE_ALLOCATIONS && !defined(ALLOCATION_PROFILER_IMPLEMENTATION)
+    #undef NMALLOC
+    #undef NFREE
+    #define NMALLOC(size, tag) profiledMalloc(size, tag)
+    #define NFREE(address, tag) profiledFree(address, tag)
+#endif
+
+// Whole statements, like the timing macros (see Timing.h),
+#if ADDAAT_PROFILE_ALLOCATIONS
+    #define MEMORY_PHASE_BEGIN(name) \
+        do { if (memoryPhasesEnabled) beginMemoryPhase(name); } while (0);
+    #define MEMORY_PHASE_END \
+        do { if (memoryPhasesEnabled) endMemoryPhase(); } while (0);
+#else
+    #define MEMORY_PHASE_BEGIN(name) do {} while (0);
+    #define MEMORY_PHASE_END do {} while (0);
+#endif
+
+extern boolean memoryPhasesEnabled;
+
+// Phases get the peak of the bytes allocated through NMALLOC and, where the platform reports it,
+// the peak resident set size while they ran. Phases with the same name are aggregated. Names are
+// kept as pointers, so they should be string literals,
+void beginMemoryPhase(const char* name);
+void endMemoryPhase();
+
+// The process' peak resident set size in kilobytes, or -1 if unavailable. Resetting it (where
+// the platform allows) lets peaks be measured per phase,
+int64_t readPeakResidentKilobytes();
+boolean resetPeakResidentSize();
+
+// Per tag counts, bytes, peak live bytes and a histogram of lifetimes, then the phases,
+void logAllocationReport();
+
+// Starts measuring phases (tags are always counted). On desktop, SIGUSR1 then logs a report at
+// the next phase end,
+void enableMemoryPhases();
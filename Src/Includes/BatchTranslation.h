@@ -0,0 +1,20 @@
+/////////////////////////////////////////////////////////
+// Translating many files with a pool of workers sharing
+// one, already defined, grammar.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+struct NCC;
+struct NVector;
+
+typedef boolean (*BatchFileTranslator)(struct NCC* ncc, const char* filePath, void* translatorData);
+
+// Input paths (const char*) can be .addaat files or directories (searched recursively). Reports
+// per-file results and a summary. Returns True only if every file translated successfully,
+boolean translateBatch(struct NCC* ncc, struct NVector* inputPaths, int32_t workersCount, BatchFileTranslator translator, void* translatorData);
+
+// The number of processors available, or 1 if unknown,
+int32_t getAvailableProcessorsCount();
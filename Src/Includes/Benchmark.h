@@ -0,0 +1,44 @@
+/////////////////////////////////////////////////////////
+// Throughput benchmark. Translates each input file several
+// times, and writes the measurements as JSON. Optionally
+// gates on a baseline report.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+struct NCC;
+struct NVector;
+struct NString;
+struct NCC_ASTNode;
+
+// Filled by the translator. Parsing covers everything before the tree is complete (validation,
+// preprocessing and matching). Durations are in nanoseconds,
+struct TranslationMeasurements {
+    int64_t parseDuration, codeGenerationDuration;
+    int64_t parsePeakResidentKilobytes, codeGenerationPeakResidentKilobytes;
+    int64_t astNodesCount;
+};
+
+// Runs the same translation as any other input file gets, measuring it,
+typedef boolean (*BenchmarkTranslator)(struct NCC* ncc, const char* code, struct NString* outCode, struct TranslationMeasurements* outMeasurements, void* data);
+
+struct BenchmarkOptions {
+    int32_t runsCount;
+    const char* reportFilePath;
+    BenchmarkTranslator translator;
+    void* translatorData;
+
+    // Compares each file (by path) against a previous report, failing if a stage's throughput
+    // dropped by more than throughputThreshold percent (with non-overlapping confidence intervals),
+    // or its peak resident size grew by more than memoryThreshold percent,
+    const char* baselineFilePath;
+    int32_t throughputThreshold;
+    int32_t memoryThreshold;
+};
+
+int64_t countASTNodes(struct NCC_ASTNode* tree);
+
+// inputFiles holds const char* paths,
+boolean runBenchmark(struct NCC* ncc, struct NVector* inputFiles, const struct BenchmarkOptions* options);
@@ -3,5 +3,40 @@
 
 struct NCC_ASTNode;
 struct NString;
+struct CodeGenerationData;
 
-boolean generateCode(struct NCC_ASTNode* tree, struct NString* outString);
\ No newline at end of file
+struct CodeGenerationOptions {
+    boolean colorize; // Terminal colors in the generated code.
+    int32_t maxNestingDepth; // Statements and cast-expressions within each other, 0 for unlimited.
+
+    // Semantic errors are logged, unless there's a reporter to hand them to instead. The message
+    // is formatted as it would've been logged,
+    void (*reportError)(const char* message, void* data);
+    void* reportErrorData;
+
+    // When above 1, the symbols are collected first, then the function bodies are generated over
+    // this many forked workers. The generated code and errors are the same as generating in order.
+    // Experimental: the workers are forked for every call, which small files may not make up for,
+    // and no speedup has been measured yet (make codegen-jobs-benchmark compares the two),
+    int32_t workersCount;
+
+    // Logs each class's size, padding, cache line span and member offsets as it's defined,
+    boolean printClassLayouts;
+
+    // Declares the global variables and class statics extern instead of defining them, for headers
+    // that go with code generated (and compiled) separately,
+    boolean externVariables;
+};
+
+const char* getCodeGenerationVersion();
+boolean generateCode(struct NCC_ASTNode* tree, const struct CodeGenerationOptions* options, struct NString* outString);
+
+// Streaming, one external-declaration at a time. Symbols persist in the code generation data
+// between calls, so the trees can be deleted as soon as their code is generated,
+struct CodeGenerationData* createCodeGenerationData(const struct CodeGenerationOptions* options);
+void destroyAndDeleteCodeGenerationData(struct CodeGenerationData* codeGenerationData);
+boolean generateExternalDeclarationCode(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, struct NString* outString);
+
+// Lazy function bodies. Declares a function from its definition's function-head alone, so that its
+// body needn't be matched until its code is generated,
+boolean generateFunctionHeadDeclarationCode(struct NCC_ASTNode* tree, struct CodeGenerationData* codeGenerationData, struct NString* outString);
@@ -0,0 +1,16 @@
+/////////////////////////////////////////////////////////
+// Command-line arguments.
+// NMain() doesn't receive them, so they are read back
+// from the running process where the platform allows.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+struct NVector;
+
+// Fills the vector with a struct NString* per argument, skipping the executable name. Leaves it
+// empty if arguments aren't available on this platform,
+void loadCommandLineArguments(struct NVector* outArguments);
+void destroyCommandLineArguments(struct NVector* arguments);
@@ -0,0 +1,26 @@
+/////////////////////////////////////////////////////////
+// Static analysis of the grammar. Records the rule texts
+// as they are defined, then reports nullable rules,
+// FIRST sets, and the places that make the matcher
+// re-match the same text.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+struct GrammarAnalyzer;
+
+struct GrammarAnalyzer* createGrammarAnalyzer();
+void destroyAndDeleteGrammarAnalyzer(struct GrammarAnalyzer* analyzer);
+
+// Adds a rule, or replaces the text of an already recorded one,
+void recordGrammarRule(struct GrammarAnalyzer* analyzer, const char* ruleName, const char* ruleText);
+
+// Marks an already recorded rule as an ordered choice. The analysis fails if its alternatives
+// can't be proven exclusive,
+void recordOrderedChoice(struct GrammarAnalyzer* analyzer, const char* ruleName);
+
+// Logs the analysis. Returns False if a rule text couldn't be parsed, references an undefined
+// rule, or is an ordered choice that couldn't be proven exclusive,
+boolean analyzeGrammar(struct GrammarAnalyzer* analyzer);
@@ -0,0 +1,42 @@
+/////////////////////////////////////////////////////////
+// A minimal JSON reader, for the files Addaat writes
+// itself (benchmark reports and baselines). Values
+// point into the parsed text, which must outlive them.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+struct NString;
+
+enum JSONValueType {
+    JSON_NULL = 0,
+    JSON_BOOLEAN,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+};
+
+struct JSONValue;
+
+// Returns 0 (after reporting the offset) if the text isn't valid JSON,
+struct JSONValue* parseJSON(const char* text);
+void deleteJSONValue(struct JSONValue* value);
+
+int32_t getJSONValueType(struct JSONValue* value);
+boolean getJSONBoolean(struct JSONValue* value);
+
+// Numbers are read as value*10^decimalsCount, extra decimals are truncated,
+int64_t getJSONFixedPoint(struct JSONValue* value, int32_t decimalsCount);
+
+// Sets outString to the unescaped string,
+void getJSONString(struct JSONValue* value, struct NString* outString);
+
+// Arrays,
+int32_t getJSONArraySize(struct JSONValue* value);
+struct JSONValue* getJSONArrayElement(struct JSONValue* value, int32_t index);
+
+// Objects. Returns 0 if the key is missing or the value isn't an object,
+struct JSONValue* getJSONMember(struct JSONValue* value, const char* key);
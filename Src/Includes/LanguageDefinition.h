@@ -6,9 +6,30 @@
 
 #pragma once
 
+#include <NVector.h>
+
 struct NCC;
+struct GrammarAnalyzer;
 typedef struct NCC_Rule NCC_Rule;
 
 void definePreprocessing(struct NCC* ncc);
+const char* getLanguageDefinitionVersion();
 void defineLanguage(struct NCC* ncc);
-NCC_Rule *getRootRule(struct NCC* ncc);
\ No newline at end of file
+void defineProfiledLanguage(struct NCC* ncc);
+void defineAnalyzedLanguage(struct NCC* ncc, struct GrammarAnalyzer* analyzer);
+void defineUnorderedLanguage(struct NCC* ncc);
+NCC_Rule *getRootRule(struct NCC* ncc);
+NCC_Rule *getExternalDeclarationRule(struct NCC* ncc);
+NCC_Rule *getIgnorablesRule(struct NCC* ncc);
+NCC_Rule *getFunctionHeadRule(struct NCC* ncc);
+
+// What a failed match leaves behind in the NCC, for error reporting. Matching keeps it in the NCC
+// itself, so an NCC is matched from one thread (or forked process) at a time,
+struct MatchingErrorInfo {
+    int32_t maxMatchLength;
+    struct NVector ruleStack; // const char*, innermost rule first.
+};
+
+int32_t getMaxMatchLength(struct NCC* ncc);
+void takeMatchingErrorInfo(struct NCC* ncc, struct MatchingErrorInfo* outInfo);
+void discardMatchingErrorInfo(struct NCC* ncc);
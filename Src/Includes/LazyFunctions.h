@@ -0,0 +1,23 @@
+/////////////////////////////////////////////////////////
+// Lazy function bodies. A function-definition's head is
+// matched, but its body is only found (by a balanced
+// brace scan) and kept as a range of the source, to be
+// matched if and when its code is generated.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+struct NCC;
+typedef struct NCC_ASTNode_Data NCC_ASTNode_Data;
+
+struct LazyFunction {
+    int32_t offset, length; // The whole function-definition.
+    int32_t bodyOffset;     // Its compound-statement, which runs to the end of the definition.
+};
+
+// Matches a function-definition at the offset without matching its body. Returns False if it's not
+// a function-definition (or its body never closes), in which case it should be matched as a whole.
+// Otherwise, outHeadTree holds the function-head's tree,
+boolean matchLazyFunction(struct NCC* ncc, const char* code, int32_t offset, int32_t codeLength, struct LazyFunction* outFunction, NCC_ASTNode_Data* outHeadTree);
@@ -0,0 +1,63 @@
+/////////////////////////////////////////////////////////
+// Limits on how deeply the input may nest. Matching
+// recurses once (or more) per level, so the input is
+// scanned for its depth before matching, and the
+// translation runs on a stack sized for the limit.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+#define DEFAULT_MAX_NESTING_DEPTH 1024
+
+struct NestingLevel;
+
+// Tracks (), [] and {} nesting, skipping comments, string and character literals. Also counts
+// what nests without brackets: statements under unbraced if, else, while, for, do and switch
+// bodies (else if chains included) or after labels, right-recursive assignments and conditionals,
+// and runs of unary operators. Can be fed the code in chunks,
+struct NestingScanner {
+    int32_t maxDepth; // 0 for unlimited.
+    int32_t depth;    // Open brackets, plus the levels without brackets inside each of them.
+    int32_t deepestDepth;
+    int32_t state;
+    char previousCharacter;
+    int32_t line, column;
+    boolean logErrors; // True unless cleared after initializing.
+
+    // Levels without brackets, inside the innermost open bracket,
+    int32_t statementLevels, expressionLevels, unaryLevels, conditionalsCount;
+    boolean statementEnded; // By a ';' or a '}'. Unless an else follows, the levels end with it.
+
+    // The word being scanned (only the first characters matter), and the last code characters,
+    char word[8];
+    int32_t wordLength;
+    char recentCharacters[3];
+
+    // The levels without brackets around each open bracket,
+    struct NestingLevel* outerLevels;
+    int32_t outerLevelsCount, outerLevelsCapacity;
+};
+
+void initializeNestingScanner(struct NestingScanner* scanner, int32_t maxDepth);
+void destroyNestingScanner(struct NestingScanner* scanner);
+
+// Continues from where the previous call stopped. Reports the line and column, and returns False
+// as soon as the nesting exceeds the limit. The line and column are left at the offending token,
+boolean scanNesting(struct NestingScanner* scanner, const char* text, int32_t length);
+
+// Scans the whole code at once,
+boolean checkNestingDepth(const char* code, int32_t maxDepth);
+
+// The deepest nesting, without reporting anything,
+int32_t measureNestingDepth(const char* text, int32_t length);
+
+// The length of the block that opens at the text's first character, up to and including the
+// bracket that closes it. -1 if the text doesn't start with a bracket, or it never closes,
+int32_t measureBlockLength(const char* text, int32_t length);
+
+// Runs the function on a thread whose stack fits maxDepth nesting levels. Only the stack pages
+// actually touched become resident, so the memory used follows the input's nesting rather than
+// the limit. Returns False if the thread couldn't be started,
+boolean runWithNestingStack(void (*function)(void* data), void* data, int32_t maxDepth);
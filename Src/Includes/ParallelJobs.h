@@ -0,0 +1,35 @@
+/////////////////////////////////////////////////////////
+// Independent jobs over a pool of forked workers, each
+// job's result sent back as a byte buffer. Jobs are
+// indexed, and the results come back in their order.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+// Results are written and read in the same order, one value after the other,
+struct JobBuffer {
+    char* data;
+    int32_t size, capacity;
+    int32_t readOffset;
+};
+
+void initializeJobBuffer(struct JobBuffer* buffer);
+void destroyJobBuffer(struct JobBuffer* buffer);
+
+void writeJobBytes(struct JobBuffer* buffer, const void* bytes, int32_t size);
+void writeJobInt32(struct JobBuffer* buffer, int32_t value);
+void writeJobString(struct JobBuffer* buffer, const char* text);
+
+// Reading past the end gives zeros and empty strings. Strings point into the buffer,
+int32_t readJobInt32(struct JobBuffer* buffer);
+const char* readJobString(struct JobBuffer* buffer);
+
+typedef void (*ParallelJob)(int32_t jobIndex, struct JobBuffer* outResult, void* data);
+
+// Workers are forked from this process, so jobs see everything as it was when this was called
+// (and whatever they change is lost with them). Jobs a worker doesn't deliver (it couldn't be
+// forked, or died) are run in this process afterwards, so a job must give the same result either
+// way. outResults has a buffer per job, initialized here, to be destroyed by the caller,
+void runParallelJobs(int32_t jobsCount, int32_t workersCount, ParallelJob job, void* data, struct JobBuffer* outResults);
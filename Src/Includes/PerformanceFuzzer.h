@@ -0,0 +1,35 @@
+/////////////////////////////////////////////////////////
+// Performance fuzzing. Mutates seed inputs looking for
+// the ones that take the matcher the most steps per
+// byte, then minimizes and saves the worst of them.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+struct NCC;
+struct NVector;
+
+struct PerformanceFuzzerOptions {
+    int32_t durationSeconds;
+    int32_t seed;
+    int32_t maxInputLength;     // Bytes.
+    int32_t slowInputsCount;    // Kept, minimized and saved.
+    int32_t maxNestingDepth;    // Deeper mutations are skipped, 0 for unlimited.
+
+    // Saves slow-<rank>.addaat files, slow-inputs.json (their step counts) and slow-inputs.txt (the
+    // rule paths most steps went through),
+    const char* outputDirectory;
+
+    // When checking, fails if an input now takes more than stepsThreshold percent more steps than
+    // recorded,
+    int32_t stepsThreshold;
+};
+
+// The NCC must be defined with the rule profiler's listeners (defineProfiledLanguage()), since the
+// steps are the profiled rule attempts. seedFiles holds const char* paths,
+boolean runPerformanceFuzzer(struct NCC* ncc, struct NVector* seedFiles, const struct PerformanceFuzzerOptions* options);
+
+// Matches the saved slow inputs again, comparing their steps to the recorded ones,
+boolean checkSlowInputs(struct NCC* ncc, const struct PerformanceFuzzerOptions* options);
@@ -0,0 +1,61 @@
+/////////////////////////////////////////////////////////
+// Preprocessing ahead of the matcher. Splices continued
+// lines, drops comments and squeezes white-spaces into
+// a compact copy of the code, keeping a map back to the
+// original offsets, lines and columns for diagnostics.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+#include <NVector.h>
+
+// Can be fed the code in chunks. The preprocessed code is appended to code, which stays zero
+// terminated. Characters that depend on what follows (a '/' or '\' at the end of a chunk, or a
+// white-space) are held back until it's known,
+struct Preprocessor {
+
+    // Preprocessed code,
+    char* code;
+    int32_t length, capacity;
+
+    // Where the original offsets stop following the preprocessed ones,
+    struct NVector offsetMap; // struct PreprocessedOffset.
+
+    // Position of the next original character,
+    int32_t originalOffset, line, column;
+
+    // Line splicing, a '\' (or "\\\r") waiting for the new-line that removes it,
+    int32_t heldCharactersCount;
+    int32_t heldOffset, heldLine, heldColumn;
+
+    // Comments, literals and white-spaces,
+    int32_t state;
+    boolean escaped;
+    char previousCharacter;
+    boolean slashHeld;
+    int32_t slashOffset, slashLine, slashColumn;
+    boolean spaceHeld;
+    int32_t spaceOffset, spaceLine, spaceColumn;
+
+    // Last appended character's original position,
+    int32_t lastOffset, lastLine;
+};
+
+struct PreprocessedOffset {
+    int32_t preprocessedOffset;
+    int32_t originalOffset, line, column;
+};
+
+void initializePreprocessor(struct Preprocessor* preprocessor);
+void destroyPreprocessor(struct Preprocessor* preprocessor);
+
+// Continues from where the previous call stopped,
+void preprocessCode(struct Preprocessor* preprocessor, const char* text, int32_t length);
+
+// Appends whatever was held back. Call once the input has ended,
+void finishPreprocessing(struct Preprocessor* preprocessor);
+
+// Maps an offset in the preprocessed code to the original code. The end of the preprocessed code
+// maps to right after its last character,
+void getOriginalPosition(const struct Preprocessor* preprocessor, int32_t preprocessedOffset, int32_t* outOffset, int32_t* outLine, int32_t* outColumn);
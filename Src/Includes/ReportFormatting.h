@@ -0,0 +1,22 @@
+/////////////////////////////////////////////////////////
+// Helpers for the reports and tables printed at the end
+// of a run. NString formatting only covers 32 bit
+// integers and no fixed widths.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+struct NString;
+
+void appendInteger64(struct NString* outString, int64_t value);
+
+// Appends value/10^decimalsCount, keeping all the decimals,
+void appendFixedPoint(struct NString* outString, int64_t value, int32_t decimalsCount);
+
+// Appends the text, padded with spaces to the given width,
+void appendPadded(struct NString* outString, const char* text, int32_t width, boolean alignRight);
+
+// Appends the text as a quoted JSON string. Control characters become spaces,
+void appendJSONString(struct NString* outString, const char* text);
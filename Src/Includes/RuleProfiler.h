@@ -0,0 +1,38 @@
+/////////////////////////////////////////////////////////
+// Per-rule matcher profiling. Pushing rules are defined
+// with these listeners instead of NCC's AST listeners,
+// which they forward to after recording.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+typedef struct NCC_ASTNode_Data NCC_ASTNode_Data;
+typedef struct NCC_MatchingData NCC_MatchingData;
+typedef struct NCC_Rule NCC_Rule;
+struct NString;
+
+void initializeRuleProfiler();
+void destroyRuleProfiler();
+
+void profiledCreateASTNode(NCC_ASTNode_Data* outNode, NCC_ASTNode_Data* astParentNode);
+void profiledDeleteASTNode(NCC_ASTNode_Data* node, NCC_ASTNode_Data* astParentNode);
+boolean profiledMatchASTNode(NCC_MatchingData* matchingData);
+
+// Logs the rules that took the most time,
+void logRuleProfile(int32_t rulesCount);
+
+// Clears the statistics (keeping the rules), to profile a single input,
+void resetRuleProfile();
+
+// Pushing rule attempts since the last reset. Each is a step of the matcher,
+int64_t getRuleAttemptsCount();
+
+// Visits every rule attempted since the last reset,
+typedef void (*RuleProfileVisitor)(NCC_Rule* rule, int64_t attemptsCount, int64_t successesCount, void* data);
+void visitRuleProfile(RuleProfileVisitor visitor, void* data);
+
+// Appends the rules with the most attempts, each with the path of rules most of its attempts came
+// through, from the root down,
+void appendHotRulePaths(struct NString* outText, int32_t rulesCount);
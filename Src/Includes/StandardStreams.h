@@ -0,0 +1,20 @@
+/////////////////////////////////////////////////////////
+// Standard streams, for running inside pipelines.
+// Generated code goes to the real standard output, while
+// everything logged is moved to the standard error.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+// Points the standard output at the standard error, so that logs can't mix with the generated
+// code. Returns a descriptor of the original standard output to write the code to, or -1 if it
+// can't be done on this platform,
+int32_t detachStandardOutput();
+
+// Reads whatever is available, blocking until there is some. Returns the number of bytes read,
+// 0 at the end of the input, or -1 on failure,
+int32_t readStandardInput(char* buffer, int32_t maxLength);
+
+boolean writeToFileDescriptor(int32_t fileDescriptor, const char* data, int32_t length);
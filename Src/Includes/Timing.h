@@ -0,0 +1,46 @@
+/////////////////////////////////////////////////////////
+// Per-phase timing. Phases nest, and are reported as a
+// summary table or as Chrome trace events (load them in
+// chrome://tracing or ui.perfetto.dev).
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+// When 0, the timing macros compile to nothing. When 1, a disabled timer costs a single branch.
+// Either way, each is a whole statement (no semicolon after it), safe in an unbraced if/else,
+#ifndef ADDAAT_TIMING
+#define ADDAAT_TIMING 1
+#endif
+
+#if ADDAAT_TIMING
+    #define TIMING_BEGIN(name) \
+        do { if (timingEnabled) beginTimingPhase(name, 0, 0); } while (0);
+    #define TIMING_BEGIN_WITH_ARGUMENT(name, argumentName, argumentValue) \
+        do { if (timingEnabled) beginTimingPhase(name, argumentName, argumentValue); } while (0);
+    #define TIMING_END \
+        do { if (timingEnabled) endTimingPhase(); } while (0);
+#else
+    #define TIMING_BEGIN(name) do {} while (0);
+    #define TIMING_BEGIN_WITH_ARGUMENT(name, argumentName, argumentValue) do {} while (0);
+    #define TIMING_END do {} while (0);
+#endif
+
+extern boolean timingEnabled;
+
+// Nanoseconds, from an arbitrary starting point,
+int64_t getMonotonicTime();
+
+// Returns False if timing was compiled out,
+boolean enableTiming();
+void destroyTiming();
+
+// Names are kept as pointers, so they should be string literals,
+void beginTimingPhase(const char* name, const char* argumentName, int32_t argumentValue);
+void endTimingPhase();
+
+// Count, total, average and maximum duration per phase name. Nested phases are included in
+// their parents' durations,
+void logTimingSummary();
+boolean writeTimingTrace(const char* filePath);
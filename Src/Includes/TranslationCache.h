@@ -0,0 +1,31 @@
+/////////////////////////////////////////////////////////
+// Persistent, content-addressed cache of generated code.
+// Entries are keyed by the input bytes, the grammar and
+// code generation versions, the translator's build and
+// the translation options.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+struct NString;
+struct TranslationCache;
+
+// Statistics are shared with forked workers, so create the cache before forking,
+struct TranslationCache* createTranslationCache(const char* directoryPath, int64_t maximumSizeInBytes);
+void destroyAndDeleteTranslationCache(struct TranslationCache* cache);
+
+// A hash of the translator's executable, so that entries never outlive the build that generated
+// them, even if a change to the output forgot its version bump. False if it couldn't be read,
+boolean getTranslatorBuildIdentifier(struct NString* outIdentifier);
+
+void computeTranslationCacheKey(const char* code, int32_t codeLength, const char* configuration, struct NString* outKey);
+
+// Returns True and fills outCode on a hit. Hits also mark the entry as recently used,
+boolean getCachedTranslation(struct TranslationCache* cache, const char* key, struct NString* outCode);
+void putCachedTranslation(struct TranslationCache* cache, const char* key, const char* code, int32_t codeLength);
+
+// Evicts the least recently used entries until the cache fits its maximum size,
+void trimTranslationCache(struct TranslationCache* cache);
+void logTranslationCacheStatistics(struct TranslationCache* cache);
@@ -0,0 +1,34 @@
+/////////////////////////////////////////////////////////
+// Resident translation server over a local Unix domain
+// socket, and its client.
+//
+// Protocol (integers are 32-bit little-endian):
+//   Request: 'P' or 'S', length, then the path or source.
+//   Reply  : status ('0' success, '1' failure, 'T' timed
+//            out), length, generated code, length, then
+//            the diagnostics.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+struct NCC;
+struct NString;
+
+#define TRANSLATION_REQUEST_PATH   'P'
+#define TRANSLATION_REQUEST_SOURCE 'S'
+
+#define TRANSLATION_REPLY_SUCCEEDED '0'
+#define TRANSLATION_REPLY_FAILED    '1'
+#define TRANSLATION_REPLY_TIMED_OUT 'T'
+
+typedef boolean (*ServerTranslator)(struct NCC* ncc, const char* code, struct NString* outCode, void* translatorData);
+
+// Serves until interrupted (SIGINT or SIGTERM). Each request is handled in its own forked
+// process, sharing the already defined grammar, and is killed after timeoutSeconds,
+boolean runTranslationServer(struct NCC* ncc, const char* socketPath, int32_t timeoutSeconds, ServerTranslator translator, void* translatorData);
+
+// Sends a path (or, if sendSource is set, the file's content) and writes the generated code to
+// stdout and the diagnostics to stderr,
+boolean runTranslationClient(const char* socketPath, const char* filePath, boolean sendSource);
@@ -0,0 +1,15 @@
+/////////////////////////////////////////////////////////
+// Checks that two definitions of the grammar match the
+// same trees, like the ordered and unordered ones.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+struct NCC;
+struct NVector;
+
+// Matches each input file (const char* paths) with both, and logs the first difference per file.
+// Returns False if any file's trees differ,
+boolean compareGrammarTrees(struct NCC* ncc, struct NCC* referenceNcc, struct NVector* inputFiles);
@@ -0,0 +1,39 @@
+/////////////////////////////////////////////////////////
+// UTF-8 source code. The input is validated before it's
+// matched, so that invalid sequences are reported where
+// they are, rather than as whatever rule fails on them,
+// and identifiers may use any Unicode XID characters.
+/////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <NTypes.h>
+
+// Can be fed the code in chunks, sequences may be split between them,
+struct Utf8Validator {
+    int32_t offset;               // Of the next byte.
+    int32_t line, lineOffset;     // The current line, and the offset it starts at.
+    int32_t remainingBytesCount;  // Continuation bytes the current sequence still needs.
+    uint8_t nextMinimum, nextMaximum; // The range of the next continuation byte.
+    int32_t sequenceOffset, sequenceLine, sequenceColumn; // Where the current sequence started.
+    boolean logErrors; // True unless cleared after initializing.
+};
+
+void initializeUtf8Validator(struct Utf8Validator* validator);
+
+// Continues from where the previous call stopped. Reports the line and column, and returns False
+// at the first invalid sequence. The sequence's offset, line and column are left in the validator,
+boolean validateUtf8(struct Utf8Validator* validator, const char* text, int32_t length);
+
+// Once the input ends. Returns False if it ended in the middle of a sequence,
+boolean finishUtf8Validation(struct Utf8Validator* validator);
+
+// Validates the whole code at once,
+boolean checkUtf8(const char* code, int32_t length);
+
+// Decodes the sequence at the start of the text. Returns its length, or 0 if it's not valid,
+int32_t decodeUtf8(const char* text, int32_t length, uint32_t* outCodePoint);
+
+// Unicode identifier classes (UAX #31), in XIDTables.c,
+boolean isXIDStart(uint32_t codePoint);
+boolean isXIDContinue(uint32_t codePoint);
@@ -0,0 +1,233 @@
+
+//
+// A minimal JSON reader. Strings and numbers aren't converted while parsing, they keep pointing
+// into the text, and are only converted when read.
+//
+// The 18th of October, 2026.
+//
+
+#include <JSON.h>
+
+#include <NSystemUtils.h>
+#include <NString.h>
+#include <NVector.h>
+#include <NCString.h>
+#include <NError.h>
+#include <AllocationProfiler.h> // After NSystemUtils.h, to reroute NMALLOC/NFREE.
+
+struct JSONValue {
+    int32_t type;
+    const char* text;    // Numbers: the literal. Strings: the contents, escapes included.
+    int32_t textLength;
+    boolean booleanValue;
+    struct NVector elements; // struct JSONValue*. Objects alternate keys and values.
+};
+
+struct JSONParser {
+    const char* text;
+    int32_t offset;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper functions
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static struct JSONValue* createJSONValue(int32_t type) {
+    struct JSONValue* value = NMALLOC(sizeof(struct JSONValue), "JSON.createJSONValue() value");
+    NSystemUtils.memset(value, 0, sizeof(struct JSONValue));
+    value->type = type;
+    if ((type == JSON_ARRAY) || (type == JSON_OBJECT)) NVector.initialize(&value->elements, 0, sizeof(struct JSONValue*));
+    return value;
+}
+
+static void skipWhiteSpace(struct JSONParser* parser) {
+    for (char character = parser->text[parser->offset];
+         (character == ' ') || (character == '\t') || (character == '\n') || (character == '\r');
+         character = parser->text[++parser->offset]);
+}
+
+static boolean skipLiteral(struct JSONParser* parser, const char* literal) {
+    if (!NCString.startsWith(&parser->text[parser->offset], literal)) return False;
+    parser->offset += NCString.length(literal);
+    return True;
+}
+
+static struct JSONValue* parseValue(struct JSONParser* parser);
+
+static struct JSONValue* parseString(struct JSONParser* parser) {
+    int32_t startOffset = ++parser->offset;
+    for (char character = parser->text[parser->offset]; character != '"'; character = parser->text[parser->offset]) {
+        if ((uint8_t) character < ' ') return 0;  // Unterminated, or a raw control character.
+        parser->offset += (character == '\\') ? 2 : 1;
+    }
+    struct JSONValue* value = createJSONValue(JSON_STRING);
+    value->text = &parser->text[startOffset];
+    value->textLength = parser->offset++ - startOffset;
+    return value;
+}
+
+static struct JSONValue* parseNumber(struct JSONParser* parser) {
+    int32_t startOffset = parser->offset;
+    for (char character = parser->text[parser->offset];
+         ((character >= '0') && (character <= '9')) || (character == '-') || (character == '+') || (character == '.') || (character == 'e') || (character == 'E');
+         character = parser->text[++parser->offset]);
+    if (parser->offset == startOffset) return 0;
+    struct JSONValue* value = createJSONValue(JSON_NUMBER);
+    value->text = &parser->text[startOffset];
+    value->textLength = parser->offset - startOffset;
+    return value;
+}
+
+static struct JSONValue* parseContainer(struct JSONParser* parser, int32_t type) {
+    char closingCharacter = (type == JSON_ARRAY) ? ']' : '}';
+    struct JSONValue* container = createJSONValue(type);
+    parser->offset++;
+    skipWhiteSpace(parser);
+    if (parser->text[parser->offset] == closingCharacter) {
+        parser->offset++;
+        return container;
+    }
+
+    while (True) {
+
+        // Key,
+        if (type == JSON_OBJECT) {
+            skipWhiteSpace(parser);
+            struct JSONValue* key = (parser->text[parser->offset] == '"') ? parseString(parser) : 0;
+            if (!key) break;
+            NVector.pushBack(&container->elements, &key);
+            skipWhiteSpace(parser);
+            if (parser->text[parser->offset++] != ':') break;
+        }
+
+        // Value,
+        struct JSONValue* element = parseValue(parser);
+        if (!element) break;
+        NVector.pushBack(&container->elements, &element);
+
+        // Separator,
+        skipWhiteSpace(parser);
+        char character = parser->text[parser->offset++];
+        if (character == closingCharacter) return container;
+        if (character != ',') break;
+    }
+
+    deleteJSONValue(container);
+    return 0;
+}
+
+static struct JSONValue* parseValue(struct JSONParser* parser) {
+    skipWhiteSpace(parser);
+    char character = parser->text[parser->offset];
+    if (character == '{') return parseContainer(parser, JSON_OBJECT);
+    if (character == '[') return parseContainer(parser, JSON_ARRAY);
+    if (character == '"') return parseString(parser);
+    if (skipLiteral(parser, "null")) return createJSONValue(JSON_NULL);
+    if (skipLiteral(parser, "true")) {
+        struct JSONValue* value = createJSONValue(JSON_BOOLEAN);
+        value->booleanValue = True;
+        return value;
+    }
+    if (skipLiteral(parser, "false")) return createJSONValue(JSON_BOOLEAN);
+    return parseNumber(parser);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// JSON
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct JSONValue* parseJSON(const char* text) {
+    struct JSONParser parser = { text, 0 };
+    struct JSONValue* value = parseValue(&parser);
+    if (value) {
+        skipWhiteSpace(&parser);
+        if (!text[parser.offset]) return value;
+        deleteJSONValue(value);
+    }
+    NERROR("JSON.parseJSON()", "Invalid JSON near offset: %s%d%s", NTCOLOR(HIGHLIGHT), parser.offset, NTCOLOR(STREAM_DEFAULT));
+    return 0;
+}
+
+void deleteJSONValue(struct JSONValue* value) {
+    if ((value->type == JSON_ARRAY) || (value->type == JSON_OBJECT)) {
+        int32_t elementsCount = NVector.size(&value->elements);
+        for (int32_t i=0; i<elementsCount; i++) deleteJSONValue(*(struct JSONValue**) NVector.get(&value->elements, i));
+        NVector.destroy(&value->elements);
+    }
+    NFREE(value, "JSON.deleteJSONValue() value");
+}
+
+int32_t getJSONValueType(struct JSONValue* value) {
+    return value->type;
+}
+
+boolean getJSONBoolean(struct JSONValue* value) {
+    return (value->type == JSON_BOOLEAN) && value->booleanValue;
+}
+
+int64_t getJSONFixedPoint(struct JSONValue* value, int32_t decimalsCount) {
+    if (value->type != JSON_NUMBER) return 0;
+
+    int64_t integer = 0;
+    int32_t index = 0, fractionDigitsCount = -1;
+    boolean negative = value->text[0] == '-';
+    if (negative) index++;
+    for (; index < value->textLength; index++) {
+        char character = value->text[index];
+        if (character == '.') {
+            fractionDigitsCount = 0;
+        } else if ((character >= '0') && (character <= '9')) {
+            if (fractionDigitsCount == decimalsCount) continue;
+            integer = integer*10 + (character - '0');
+            if (fractionDigitsCount >= 0) fractionDigitsCount++;
+        } else {
+            break; // Exponents aren't written by Addaat.
+        }
+    }
+    if (fractionDigitsCount < 0) fractionDigitsCount = 0;
+    for (; fractionDigitsCount < decimalsCount; fractionDigitsCount++) integer *= 10;
+    return negative ? -integer : integer;
+}
+
+void getJSONString(struct JSONValue* value, struct NString* outString) {
+    NString.set(outString, "");
+    if (value->type != JSON_STRING) return;
+
+    char character[2] = { 0, 0 };
+    for (int32_t i=0; i<value->textLength; i++) {
+        character[0] = value->text[i];
+        if ((character[0] == '\\') && (i+1 < value->textLength)) {
+            switch (value->text[++i]) {
+                case 'n': character[0] = '\n'; break;
+                case 't': character[0] = '\t'; break;
+                case 'r': character[0] = '\r'; break;
+                case 'u': character[0] = '?'; i += 4; break; // Not written by Addaat.
+                default: character[0] = value->text[i];
+            }
+        }
+        NString.append(outString, "%s", character);
+    }
+}
+
+int32_t getJSONArraySize(struct JSONValue* value) {
+    return (value->type == JSON_ARRAY) ? NVector.size(&value->elements) : 0;
+}
+
+struct JSONValue* getJSONArrayElement(struct JSONValue* value, int32_t index) {
+    if ((value->type != JSON_ARRAY) || (index < 0) || (index >= NVector.size(&value->elements))) return 0;
+    return *(struct JSONValue**) NVector.get(&value->elements, index);
+}
+
+struct JSONValue* getJSONMember(struct JSONValue* value, const char* key) {
+    if (value->type != JSON_OBJECT) return 0;
+
+    int32_t keyLength = NCString.length(key);
+    int32_t elementsCount = NVector.size(&value->elements);
+    for (int32_t i=0; i+1<elementsCount; i+=2) {
+        struct JSONValue* currentKey = *(struct JSONValue**) NVector.get(&value->elements, i);
+        if ((currentKey->textLength == keyLength) && NCString.startsWith(currentKey->text, key)) {
+            return *(struct JSONValue**) NVector.get(&value->elements, i+1);
+        }
+    }
+    return 0;
+}
@@ -7,10 +7,16 @@
 //
 
 #include <LanguageDefinition.h>
+#include <RuleProfiler.h>
+#include <GrammarAnalyzer.h>
+#include <Utf8.h>
 
 #include <NCC.h>
 #include <NSystemUtils.h>
 
+#include <stdarg.h>
+#include <stdio.h>
+
 // TODO: (performance improvement) reduce pushing rules as much as possible (like parenthesis, commas and such, they are not useful). \
          Remember to update code-generation to reflect changes...
 
@@ -21,25 +27,117 @@ static boolean printListener(NCC_MatchingData* matchingData) {
     return True;
 }
 
+// Bump by hand whenever the grammar's behavior changes in a way the rule texts don't show (the
+// matching callbacks, NOMoneCC itself, Utf8.c). Rule text changes are picked up by the hash. The
+// cache also keys on the translator's build, so a missed bump can't serve stale code,
+#define LANGUAGE_DEFINITION_VERSION 1
+
+// FNV-1a over every rule name and text, set when the language is defined,
+static uint32_t rulesHash = 2166136261u;
+
+// Cached translations are keyed on this, so they never outlive a grammar change,
+const char* getLanguageDefinitionVersion() {
+    static char version[64];
+    snprintf(version, sizeof(version), "LanguageDefinition %d, rules %08x", LANGUAGE_DEFINITION_VERSION, rulesHash);
+    return version;
+}
+
+// Multi-byte identifier characters. The rules only match well-formed sequences, and these make
+// sure the code point is in the identifier class too,
+static boolean matchIdentifierStartCharacter(NCC_MatchingData* matchingData) {
+    uint32_t codePoint;
+    return (decodeUtf8(matchingData->matchedText, matchingData->matchLength, &codePoint) == matchingData->matchLength) && isXIDStart(codePoint);
+}
+
+static boolean matchIdentifierContinueCharacter(NCC_MatchingData* matchingData) {
+    uint32_t codePoint;
+    return (decodeUtf8(matchingData->matchedText, matchingData->matchLength, &codePoint) == matchingData->matchLength) && isXIDContinue(codePoint);
+}
+
 typedef struct RuleDefinitionData {
     struct NCC* ncc;
     NCC_RuleData plainRuleData, pushingRuleData;
+    NCC_RuleData identifierStartRuleData, identifierContinueRuleData;
+    struct GrammarAnalyzer* analyzer; // If set, gets a copy of every rule text.
+    boolean orderedChoices;           // If not, ordered choices are defined as longest-match selections.
+    uint32_t rulesHash;
 } RuleDefinitionData;
 
+static void hashRuleText(RuleDefinitionData* rdd, const char* ruleName, const char* ruleText) {
+    uint32_t hash = rdd->rulesHash;
+    for (const char* c=ruleName; ; c++) { hash = (hash ^ (uint8_t) *c) * 16777619u; if (!*c) break; }
+    for (const char* c=ruleText; ; c++) { hash = (hash ^ (uint8_t) *c) * 16777619u; if (!*c) break; }
+    rdd->rulesHash = hash;
+}
+
 static void addRule(RuleDefinitionData* rdd, const char* ruleName, const char* ruleText) {
     NCC_addRule(rdd->ncc, rdd->plainRuleData.set(&rdd->plainRuleData, ruleName, ruleText));
+    if (rdd->analyzer) recordGrammarRule(rdd->analyzer, ruleName, ruleText);
+    hashRuleText(rdd, ruleName, ruleText);
+}
+
+static void addRuleWithData(RuleDefinitionData* rdd, NCC_RuleData* ruleData, const char* ruleName, const char* ruleText) {
+    NCC_addRule(rdd->ncc, ruleData->set(ruleData, ruleName, ruleText));
+    if (rdd->analyzer) recordGrammarRule(rdd->analyzer, ruleName, ruleText);
+    hashRuleText(rdd, ruleName, ruleText);
 }
 
 static void addPushingRule(RuleDefinitionData* rdd, const char* ruleName, const char* ruleText) {
     NCC_addRule(rdd->ncc, rdd->pushingRuleData.set(&rdd->pushingRuleData, ruleName, ruleText));
+    if (rdd->analyzer) recordGrammarRule(rdd->analyzer, ruleName, ruleText);
+    hashRuleText(rdd, ruleName, ruleText);
 }
 
 static void updateRule(RuleDefinitionData* rdd, const char* ruleName, const char* ruleText) {
     NCC_Rule* rule = NCC_getRule(rdd->ncc, ruleName);
     NCC_updateRuleText(rdd->ncc, rule, ruleText);
+    if (rdd->analyzer) recordGrammarRule(rdd->analyzer, ruleName, ruleText);
+    hashRuleText(rdd, ruleName, ruleText);
 }
 
-void defineLanguage(struct NCC* ncc) {
+// Ordered choice over rules: they are tried in order, and the first to match wins. Only for rules
+// that can't both match from the same offset (--analyze-grammar proves it), where the result is
+// the same as a longest-match selection's, without matching the remaining rules,
+static void getOrderedChoiceText(RuleDefinitionData* rdd, va_list ruleNames, struct NString* outText) {
+    NString.set(outText, rdd->orderedChoices ? "" : "#{");
+    boolean first = True;
+    for (const char* ruleName = va_arg(ruleNames, const char*); ruleName; ruleName = va_arg(ruleNames, const char*)) {
+        if (rdd->orderedChoices) {
+            NString.append(outText, first ? "${%s}" : " | ${%s}", ruleName);
+        } else {
+            NString.append(outText, first ? "{%s}" : " {%s}", ruleName);
+        }
+        first = False;
+    }
+    if (!rdd->orderedChoices) NString.append(outText, "}");
+}
+
+// The rule names are terminated by a 0,
+static void addOrderedChoice(RuleDefinitionData* rdd, const char* ruleName, ...) {
+    struct NString text;
+    NString.initialize(&text, "");
+    va_list ruleNames;
+    va_start(ruleNames, ruleName);
+    getOrderedChoiceText(rdd, ruleNames, &text);
+    va_end(ruleNames);
+    addRule(rdd, ruleName, NString.get(&text));
+    if (rdd->analyzer) recordOrderedChoice(rdd->analyzer, ruleName);
+    NString.destroy(&text);
+}
+
+static void updateOrderedChoice(RuleDefinitionData* rdd, const char* ruleName, ...) {
+    struct NString text;
+    NString.initialize(&text, "");
+    va_list ruleNames;
+    va_start(ruleNames, ruleName);
+    getOrderedChoiceText(rdd, ruleNames, &text);
+    va_end(ruleNames);
+    updateRule(rdd, ruleName, NString.get(&text));
+    if (rdd->analyzer) recordOrderedChoice(rdd->analyzer, ruleName);
+    NString.destroy(&text);
+}
+
+static void defineRules(struct NCC* ncc, boolean profiled, boolean orderedChoices, struct GrammarAnalyzer* analyzer) {
 
     // Notes:
     // ======
@@ -68,13 +166,18 @@ void defineLanguage(struct NCC* ncc) {
     //            { ${additive-expression} >> ${shift-expression}}
     //
 
-    // TODO: do we need a ${} when all unnecessary whitespaces should be removed during pre-processing?
-    //       ${} could necessary for code coloring, and not for compiling. This should be more obvious
-    //       upon implementation.
+    // ${} matches the white-spaces and comments between tokens. Preprocessed code has none of them
+    // but single spaces, and definePreprocessing() cuts ${} down to an optional space.
 
-    RuleDefinitionData rdd = { .ncc = ncc };
-    NCC_initializeRuleData(&rdd.  plainRuleData, "", "",                 0,                 0,                0);
-    NCC_initializeRuleData(&rdd.pushingRuleData, "", "", NCC_createASTNode, NCC_deleteASTNode, NCC_matchASTNode);
+    RuleDefinitionData rdd = { .ncc = ncc, .analyzer = analyzer, .orderedChoices = orderedChoices, .rulesHash = 2166136261u };
+    NCC_initializeRuleData(&rdd.  plainRuleData, "", "", 0, 0, 0);
+    if (profiled) {
+        NCC_initializeRuleData(&rdd.pushingRuleData, "", "", profiledCreateASTNode, profiledDeleteASTNode, profiledMatchASTNode);
+    } else {
+        NCC_initializeRuleData(&rdd.pushingRuleData, "", "",     NCC_createASTNode,     NCC_deleteASTNode,     NCC_matchASTNode);
+    }
+    NCC_initializeRuleData(&rdd.   identifierStartRuleData, "", "", 0, 0,    matchIdentifierStartCharacter);
+    NCC_initializeRuleData(&rdd.identifierContinueRuleData, "", "", 0, 0, matchIdentifierContinueCharacter);
 
     // =====================================
     // Lexical rules,
@@ -97,7 +200,7 @@ void defineLanguage(struct NCC* ncc) {
     addPushingRule(&rdd,       ">>",       ">>");
     addPushingRule(&rdd,        "=",        "=");
     addPushingRule(&rdd,       "+=",       "+=");
-    addPushingRule(&rdd,       "-=",  "\\-\\-=");
+    addPushingRule(&rdd,       "-=",      "\\-=");
     addPushingRule(&rdd,       "*=",     "\\*=");
     addPushingRule(&rdd,       "/=",       "/=");
     addPushingRule(&rdd,       "%=",       "%=");
@@ -152,9 +255,18 @@ void defineLanguage(struct NCC* ncc) {
     addPushingRule(&rdd,   "signed",   "signed");
     addPushingRule(&rdd, "unsigned", "unsigned");
     addPushingRule(&rdd,   "static",   "static");
-
-    // Keywords,
-    addPushingRule(&rdd, "keyword", "#{{class} {enum} {if} {else} {while} {do} {for} {continue} {break} {return} {switch} {case} {default} {goto} {void} {char} {short} {int} {long} {float} {double} {signed} {unsigned} {static}}");
+    addPushingRule(&rdd,   "packed",   "packed");
+    addPushingRule(&rdd,   "stable",   "stable");
+    addPushingRule(&rdd,      "soa",      "soa");
+    addPushingRule(&rdd,      "new",      "new");
+    addPushingRule(&rdd,   "delete",   "delete");
+    addPushingRule(&rdd,  "managed",  "managed");
+    addPushingRule(&rdd,     "weak",     "weak");
+
+    // Keywords. new, managed and weak aren't, they're only followed by a type where they mean
+    // something, so they remain valid identifiers (like the class layouts). delete is, or "delete
+    // (x);" and "delete -x;" would be both statements and expressions,
+    addPushingRule(&rdd, "keyword", "#{{class} {enum} {if} {else} {while} {do} {for} {continue} {break} {return} {switch} {case} {default} {goto} {void} {char} {short} {int} {long} {float} {double} {signed} {unsigned} {static} {delete}}");
 
     // Spaces and comments,
     addRule       (&rdd, "ε", "");
@@ -176,9 +288,17 @@ void defineLanguage(struct NCC* ncc) {
     addRule       (&rdd, "hex-quad", "${hexadecimal-digit}${hexadecimal-digit}${hexadecimal-digit}${hexadecimal-digit}");
     addRule       (&rdd, "universal-character-name", "{\\\\u ${hex-quad}} | {\\\\U ${hex-quad} ${hex-quad}}");
 
+    // UTF-8 characters (the input is validated before matching, these only tell the sequences
+    // apart). The identifier ones are only matched if their code points are XID_Start or
+    // XID_Continue (UAX #31). ASCII is tried first, so it costs ASCII identifiers nothing,
+    addRule       (&rdd, "utf8-continuation", "\x80-\xBF");
+    addRule       (&rdd, "utf8-character", "{\xC2-\xDF ${utf8-continuation}} | {\xE0-\xEF ${utf8-continuation} ${utf8-continuation}} | {\xF0-\xF4 ${utf8-continuation} ${utf8-continuation} ${utf8-continuation}}");
+    addRuleWithData(&rdd, &rdd.   identifierStartRuleData, "utf8-identifier-start"   , "${utf8-character}");
+    addRuleWithData(&rdd, &rdd.identifierContinueRuleData, "utf8-identifier-continue", "${utf8-character}");
+
     // Identifier,
-    addRule       (&rdd, "identifier-non-digit", "${non-digit} | ${universal-character-name}"); // TODO: This doesn't look right! This won't identify true unicode characters.
-    addPushingRule(&rdd, "identifier-content", "${identifier-non-digit} {${digit} | ${identifier-non-digit}}^*");
+    addRule       (&rdd, "identifier-non-digit", "${non-digit} | ${universal-character-name} | ${utf8-identifier-start}");
+    addPushingRule(&rdd, "identifier-content", "${identifier-non-digit} {${digit} | ${non-digit} | ${universal-character-name} | ${utf8-identifier-continue}}^*");
     addPushingRule(&rdd, "identifier", "#{{keyword} {identifier-content} == {identifier-content}}");
 
     // Constants,
@@ -267,8 +387,10 @@ void defineLanguage(struct NCC* ncc) {
     addPushingRule(&rdd, "unary-expression", "STUB!");
     addRule       (&rdd, "unary-operator", "STUB!");
     addPushingRule(&rdd, "cast-expression", "STUB!");
+    addPushingRule(&rdd, "allocation-expression", "STUB!");
     updateRule    (&rdd, "unary-expression",
                              "${postfix-expression} | "
+                             "${allocation-expression} | "
                              "{ ${++}             ${} ${unary-expression} } | "
                              "{ ${--}             ${} ${unary-expression} } | "
                              "{ ${unary-operator} ${} ${cast-expression}  }");
@@ -276,6 +398,13 @@ void defineLanguage(struct NCC* ncc) {
     // Unary operator,
     updateRule    (&rdd, "unary-operator", "#{{+}{-}{~}{!} {++}{--} != {++}{--}}");
 
+    // Allocation expression. Allocates an array of the type, of the count in brackets or of one
+    // element. New arrays live until they're deleted, managed ones until they're unreachable,
+    addPushingRule(&rdd, "type-specifier", "STUB!");
+    updateRule    (&rdd, "allocation-expression",
+                             "${new}|${managed} ${ } ${type-specifier} "
+                             "{${} ${[} ${} ${expression} ${} ${]}}|${ε}");
+
     // Cast expression,
     updateRule    (&rdd, "cast-expression",
                              "${unary-expression} | "
@@ -354,8 +483,7 @@ void defineLanguage(struct NCC* ncc) {
                              "{${unary-expression} ${} ${assignment-operator} ${} ${assignment-expression}}");
 
     // Assignment operator,
-    updateRule    (&rdd, "assignment-operator",
-                            "#{{=} {*=} {/=} {%=} {+=} {-=} {<<=} {>>=} {&=} {^=} {|=}}");
+    updateOrderedChoice(&rdd, "assignment-operator", "=", "*=", "/=", "%=", "+=", "-=", "<<=", ">>=", "&=", "^=", "|=", (const char*) 0);
 
     // Expression,
     updateRule    (&rdd, "expression",
@@ -385,14 +513,19 @@ void defineLanguage(struct NCC* ncc) {
 
     // Declaration specifiers,
     addRule       (&rdd, "storage-class-specifier", "STUB!");
-    addPushingRule(&rdd, "type-specifier", "STUB!");
+    addRule       (&rdd, "type-qualifier", "STUB!");
     updateRule    (&rdd, "declaration-specifiers",
-                             "{${storage-class-specifier} ${}}|${ε} ${type-specifier}");
+                             "{${storage-class-specifier} ${}}|${ε} {${type-qualifier} ${}}|${ε} ${type-specifier}");
 
     // Storage class specifier,
     updateRule    (&rdd, "storage-class-specifier",
                              "#{{static} {identifier} != {identifier}}");
 
+    // Type qualifier. A weak reference doesn't keep its object alive, and reads as 0 once it's
+    // deleted or collected,
+    updateRule    (&rdd, "type-qualifier",
+                             "#{{weak} {identifier} != {identifier}}");
+
     // Type specifier,
     addPushingRule(&rdd, "class-specifier", "STUB!");
     addRule       (&rdd, "enum-specifier", "STUB!");
@@ -411,13 +544,17 @@ void defineLanguage(struct NCC* ncc) {
     updateRule    (&rdd, "array-specifier",
                              "${[} ${} ${]}");
 
-    // Class specifier,
+    // Class specifier (a bare identifier would always be rejected by the type-specifier's
+    // "!= {identifier}"),
     updateRule    (&rdd, "class-specifier",
-                             "${identifier}");
+                             "${class} ${ } ${identifier}");
 
-    // Class declaration,
+    // Class declaration. The layout modifiers only mean something before "class", so they aren't
+    // keywords, and remain valid identifiers,
     addRule       (&rdd, "declaration-list", "STUB!");
+    addRule       (&rdd, "class-layout", "#{{packed} {stable} {soa}}");
     addPushingRule(&rdd, "class-declaration",
+                            "{${class-layout} ${ }}|${ε} "
                             "${class} ${} ${identifier} "
                             "{${} ${;}} |"
                             "{${} ${OB} {${} ${declaration-list}}|${ε} ${} ${CB}}");
@@ -454,13 +591,15 @@ void defineLanguage(struct NCC* ncc) {
     addPushingRule(&rdd,  "selection-statement", "STUB!");
     addPushingRule(&rdd,  "iteration-statement", "STUB!");
     addPushingRule(&rdd,       "jump-statement", "STUB!");
+    addPushingRule(&rdd, "deallocation-statement", "STUB!");
     addPushingRule(&rdd, "statement",
                             "#{   {labeled-statement}"
                             "    {compound-statement}"
                             "  {expression-statement}"
                             "   {selection-statement}"
                             "   {iteration-statement}"
-                            "        {jump-statement}}");
+                            "        {jump-statement}"
+                            "{deallocation-statement}}");
 
     // Labeled statement,
     updateRule    (&rdd, "labeled-statement",
@@ -507,6 +646,10 @@ void defineLanguage(struct NCC* ncc) {
                             "{ ${break}    ${}                        ${;} } | "
                             "{ ${return}   ${} ${expression}|${ε} ${} ${;} }");
 
+    // Deallocation statement (only for new arrays),
+    updateRule    (&rdd, "deallocation-statement",
+                            "${delete} ${} ${cast-expression} ${} ${;}");
+
     // -------------------------------------
     // External definitions,
     // -------------------------------------
@@ -520,10 +663,13 @@ void defineLanguage(struct NCC* ncc) {
                                             we consider early termination a feature now?
 
     // External declaration,
+    // Function declarations and definitions share their heads, then differ by ; and {. As an
+    // ordered choice, the head of a definition isn't matched again as a declaration's,
     addPushingRule(&rdd, "function-declaration", "STUB!");
     addPushingRule(&rdd, "function-definition", "STUB!");
+    addOrderedChoice(&rdd, "function-definition-or-declaration", "function-definition", "function-declaration", (const char*) 0);
     updateRule    (&rdd, "external-declaration",
-                            "#{{function-declaration} {function-definition} {declaration} {class-declaration}}");
+                            "#{{function-definition-or-declaration} {declaration} {class-declaration}}");
 
     // Parameter declaration,
     addPushingRule(&rdd, "parameter-declaration",
@@ -549,11 +695,71 @@ void defineLanguage(struct NCC* ncc) {
     updateRule    (&rdd, "function-definition",
                             "${function-head} ${} ${compound-statement}");
 
+    // The unordered grammar's texts differ, but it matches the same trees,
+    if (orderedChoices) rulesHash = rdd.rulesHash;
+
     // Cleanup,
     NCC_destroyRuleData(&rdd.  plainRuleData);
     NCC_destroyRuleData(&rdd.pushingRuleData);
 }
 
+// Adapts an already defined language to preprocessed code (see Preprocessing.h), where comments
+// and continued lines are gone, and white-spaces are down to a single space where they're needed,
+void definePreprocessing(struct NCC* ncc) {
+    RuleDefinitionData rdd = { .ncc = ncc };
+    updateRule(&rdd, "",  "\\ |${ε}");
+    updateRule(&rdd, " ", "\\ ");
+}
+
+void defineLanguage(struct NCC* ncc) {
+    defineRules(ncc, False, True, 0);
+}
+
+// Same grammar, with every pushing rule reporting to the rule profiler,
+void defineProfiledLanguage(struct NCC* ncc) {
+    defineRules(ncc, True, True, 0);
+}
+
+// Same grammar, with every rule text recorded for analysis,
+void defineAnalyzedLanguage(struct NCC* ncc, struct GrammarAnalyzer* analyzer) {
+    defineRules(ncc, False, True, analyzer);
+}
+
+// Same grammar, with longest-match selections instead of ordered choices. Matches the same trees,
+// only slower,
+void defineUnorderedLanguage(struct NCC* ncc) {
+    defineRules(ncc, False, False, 0);
+}
+
 NCC_Rule *getRootRule(struct NCC* ncc) {
     return NCC_getRule(ncc, "translation-unit");
-}
\ No newline at end of file
+}
+
+NCC_Rule *getExternalDeclarationRule(struct NCC* ncc) {
+    return NCC_getRule(ncc, "external-declaration");
+}
+
+NCC_Rule *getIgnorablesRule(struct NCC* ncc) {
+    return NCC_getRule(ncc, "");
+}
+
+NCC_Rule *getFunctionHeadRule(struct NCC* ncc) {
+    return NCC_getRule(ncc, "function-head");
+}
+
+int32_t getMaxMatchLength(struct NCC* ncc) {
+    return ncc->maxMatchLength;
+}
+
+// Moves the rule stack out of the NCC, leaving it empty for the next match,
+void takeMatchingErrorInfo(struct NCC* ncc, struct MatchingErrorInfo* outInfo) {
+    outInfo->maxMatchLength = ncc->maxMatchLength;
+    NVector.initialize(&outInfo->ruleStack, 0, sizeof(const char*));
+    const char* ruleName;
+    while (NVector.popBack(&ncc->maxMatchRuleStack, &ruleName)) NVector.pushBack(&outInfo->ruleStack, &ruleName);
+}
+
+// For failures that aren't errors,
+void discardMatchingErrorInfo(struct NCC* ncc) {
+    NVector.clear(&ncc->maxMatchRuleStack);
+}
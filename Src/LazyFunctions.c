@@ -0,0 +1,49 @@
+
+//
+// Lazy function bodies. Most of a file is usually function bodies, and most of the matching time
+// goes into them. Passes that only need the symbols (indexing, header generation, dependency
+// scanning) match the function heads, and skip the bodies with the nesting scanner, which already
+// knows about comments, string and character literals.
+//
+// The 18th of October, 2026.
+//
+
+#include <LazyFunctions.h>
+#include <LanguageDefinition.h>
+#include <NestingLimits.h>
+
+#include <NCC.h>
+#include <NSystemUtils.h>
+
+boolean matchLazyFunction(struct NCC* ncc, const char* code, int32_t offset, int32_t codeLength, struct LazyFunction* outFunction, NCC_ASTNode_Data* outHeadTree) {
+
+    // function-definition = ${function-head} ${} ${compound-statement}
+    NCC_MatchingResult matchingResult;
+    outHeadTree->node = 0;
+    if (!NCC_match(ncc, getFunctionHeadRule(ncc), &code[offset], &matchingResult, outHeadTree) || !outHeadTree->node) {
+        discardMatchingErrorInfo(ncc); // Not an error, the declaration is matched as a whole next.
+        return False;
+    }
+    int32_t functionOffset = offset;
+    offset += matchingResult.matchLength;
+
+    // Skip white-spaces and comments,
+    NCC_ASTNode_Data ignorablesTree;
+    if (NCC_match(ncc, getIgnorablesRule(ncc), &code[offset], &matchingResult, &ignorablesTree)) {
+        if (ignorablesTree.node) NCC_deleteASTNode(&ignorablesTree, 0);
+        offset += matchingResult.matchLength;
+    }
+
+    // Find where the body ends, without matching it,
+    int32_t bodyLength = (code[offset] == '{') ? measureBlockLength(&code[offset], codeLength - offset) : -1;
+    if (bodyLength < 0) {
+        NCC_deleteASTNode(outHeadTree, 0);
+        outHeadTree->node = 0;
+        return False;
+    }
+
+    outFunction->offset = functionOffset;
+    outFunction->length = offset + bodyLength - functionOffset;
+    outFunction->bodyOffset = offset;
+    return True;
+}
@@ -0,0 +1,381 @@
+
+//
+// Nesting limits. NCC matches recursively, so a deeply nested input uses the stack in proportion
+// to its nesting. Rather than crash on the default 8 MB stack, the input is scanned (iteratively)
+// for its nesting depth, rejected cleanly past the limit, and the translation runs on a stack
+// reserved for the limit. The depth counts what recurses without brackets too (see
+// NestingLimits.h), so that no input recurses past what the scan measured. Code generation walks
+// the tree off the heap, and bounds its own nesting by the same limit.
+//
+// The 18th of October, 2026.
+//
+
+#include <NestingLimits.h>
+
+#include <NSystemUtils.h>
+#include <NCString.h>
+#include <NError.h>
+
+#ifdef DESKTOP
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+// Base stack, plus enough per nesting level for the matcher (around 18 rule levels between
+// nested parentheses),
+#define BASE_STACK_SIZE (8 * 1024 * 1024)
+#define STACK_SIZE_PER_NESTING_LEVEL (64 * 1024)
+
+#define SCANNER_STATE_CODE          0
+#define SCANNER_STATE_LINE_COMMENT  1
+#define SCANNER_STATE_BLOCK_COMMENT 2
+#define SCANNER_STATE_STRING        3
+#define SCANNER_STATE_CHARACTER     4
+
+struct NestingLevel {
+    int32_t statementLevels, expressionLevels, unaryLevels, conditionalsCount;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper functions
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static boolean isWordCharacter(char character) {
+    return ((character >= 'a') && (character <= 'z')) ||
+           ((character >= 'A') && (character <= 'Z')) ||
+           ((character >= '0') && (character <= '9')) ||
+            (character == '_') || ((uint8_t) character >= 0x80);
+}
+
+static boolean wordEquals(struct NestingScanner* scanner, const char* keyword) {
+    int32_t keywordLength = NCString.length(keyword);
+    if (scanner->wordLength != keywordLength) return False;
+    for (int32_t i=0; i<keywordLength; i++) if (scanner->word[i] != keyword[i]) return False;
+    return True;
+}
+
+// Adds a level to the given count. Returns False past the limit,
+static boolean deepen(struct NestingScanner* scanner, int32_t* levels) {
+    if (levels) (*levels)++;
+    if (++scanner->depth > scanner->deepestDepth) scanner->deepestDepth = scanner->depth;
+    if (scanner->maxDepth && (scanner->depth > scanner->maxDepth)) {
+        if (scanner->logErrors) NERROR("NestingLimits.scanNesting()", "Nesting deeper than %s%d%s levels at line: %d, column: %d. Raise the limit with %s--max-nesting-depth%s.",
+                                        NTCOLOR(HIGHLIGHT), scanner->maxDepth, NTCOLOR(STREAM_DEFAULT), scanner->line, scanner->column, NTCOLOR(HIGHLIGHT), NTCOLOR(STREAM_DEFAULT));
+        return False;
+    }
+    return True;
+}
+
+static void endLevels(struct NestingScanner* scanner, int32_t* levels) {
+    scanner->depth -= *levels;
+    *levels = 0;
+}
+
+static boolean openBracket(struct NestingScanner* scanner) {
+
+    if (scanner->outerLevelsCount == scanner->outerLevelsCapacity) {
+        int32_t newCapacity = scanner->outerLevelsCapacity ? scanner->outerLevelsCapacity*2 : 64;
+        struct NestingLevel* newLevels = NMALLOC(newCapacity * sizeof(struct NestingLevel), "NestingLimits.openBracket() newLevels");
+        if (scanner->outerLevels) {
+            NSystemUtils.memcpy(newLevels, scanner->outerLevels, scanner->outerLevelsCount * sizeof(struct NestingLevel));
+            NFREE(scanner->outerLevels, "NestingLimits.openBracket() scanner->outerLevels");
+        }
+        scanner->outerLevels = newLevels;
+        scanner->outerLevelsCapacity = newCapacity;
+    }
+
+    // The levels outside stay counted in the depth until the bracket closes,
+    struct NestingLevel* outerLevel = &scanner->outerLevels[scanner->outerLevelsCount++];
+    outerLevel->statementLevels = scanner->statementLevels;
+    outerLevel->expressionLevels = scanner->expressionLevels;
+    outerLevel->unaryLevels = scanner->unaryLevels;
+    outerLevel->conditionalsCount = scanner->conditionalsCount;
+    scanner->statementLevels = scanner->expressionLevels = scanner->unaryLevels = scanner->conditionalsCount = 0;
+    return deepen(scanner, 0);
+}
+
+static void closeBracket(struct NestingScanner* scanner) {
+    if (!scanner->outerLevelsCount) return;
+    endLevels(scanner, &scanner->statementLevels);
+    endLevels(scanner, &scanner->expressionLevels);
+    endLevels(scanner, &scanner->unaryLevels);
+    scanner->depth--;
+
+    struct NestingLevel* outerLevel = &scanner->outerLevels[--scanner->outerLevelsCount];
+    scanner->statementLevels = outerLevel->statementLevels;
+    scanner->expressionLevels = outerLevel->expressionLevels;
+    scanner->unaryLevels = outerLevel->unaryLevels;
+    scanner->conditionalsCount = outerLevel->conditionalsCount;
+}
+
+// Once a statement ends, its levels go with it, unless an else continues it,
+static void continueStatement(struct NestingScanner* scanner, boolean isElse) {
+    if (!scanner->statementEnded) return;
+    scanner->statementEnded = False;
+    if (!isElse) endLevels(scanner, &scanner->statementLevels);
+}
+
+static boolean scanWord(struct NestingScanner* scanner) {
+    boolean isElse = wordEquals(scanner, "else");
+    continueStatement(scanner, isElse);
+    if (isElse || wordEquals(scanner, "if") || wordEquals(scanner, "while") || wordEquals(scanner, "for") || wordEquals(scanner, "do") || wordEquals(scanner, "switch")) {
+        return deepen(scanner, &scanner->statementLevels);
+    }
+    return True;
+}
+
+static boolean scanPunctuation(struct NestingScanner* scanner, char character) {
+
+    continueStatement(scanner, False);
+
+    // Unary operators nest until their operand comes. Binary ones are counted too, as they can't
+    // be told apart here, but they end just as fast,
+    if ((character == '+') || (character == '-') || (character == '!') || (character == '~') || (character == '*') || (character == '&')) {
+        if (!deepen(scanner, &scanner->unaryLevels)) return False;
+    } else {
+        endLevels(scanner, &scanner->unaryLevels);
+    }
+
+    switch (character) {
+        case '(': case '[': case '{':
+            return openBracket(scanner);
+        case ')': case ']':
+            closeBracket(scanner);
+            break;
+        case '}':
+            closeBracket(scanner);
+            scanner->statementEnded = True;
+            break;
+        case ';':
+            endLevels(scanner, &scanner->expressionLevels);
+            scanner->conditionalsCount = 0;
+            scanner->statementEnded = True;
+            break;
+        case ',':
+            endLevels(scanner, &scanner->expressionLevels);
+            scanner->conditionalsCount = 0;
+            break;
+        case '?':
+            scanner->conditionalsCount++;
+            return deepen(scanner, &scanner->expressionLevels);
+        case ':':
+            // Either closes a conditional, or ends a label (case and default included),
+            if (scanner->conditionalsCount) {
+                scanner->conditionalsCount--;
+            } else {
+                return deepen(scanner, &scanner->statementLevels);
+            }
+            break;
+    }
+    return True;
+}
+
+// Called on the character after an '=', which tells whether it was an assignment operator (=, +=,
+// <<=, ...) rather than a comparison (==, !=, <=, >=),
+static boolean isAssignment(struct NestingScanner* scanner, char nextCharacter) {
+    char before = scanner->recentCharacters[1];
+    if ((nextCharacter == '=') || (before == '=') || (before == '!')) return False;
+    if ((before == '<') || (before == '>')) return scanner->recentCharacters[2] == before;
+    return True;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Scanning
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void initializeNestingScanner(struct NestingScanner* scanner, int32_t maxDepth) {
+    NSystemUtils.memset(scanner, 0, sizeof(struct NestingScanner));
+    scanner->maxDepth = maxDepth;
+    scanner->state = SCANNER_STATE_CODE;
+    scanner->line = 1;
+    scanner->column = 1;
+    scanner->logErrors = True;
+}
+
+void destroyNestingScanner(struct NestingScanner* scanner) {
+    if (scanner->outerLevels) NFREE(scanner->outerLevels, "NestingLimits.destroyNestingScanner() scanner->outerLevels");
+    scanner->outerLevels = 0;
+    scanner->outerLevelsCount = scanner->outerLevelsCapacity = 0;
+}
+
+static boolean scanCodeCharacter(struct NestingScanner* scanner, char* character) {
+
+    char previousCharacter = scanner->previousCharacter;
+
+    // An assignment nests what follows it,
+    if ((scanner->recentCharacters[0] == '=') && isAssignment(scanner, *character)) {
+        if (!deepen(scanner, &scanner->expressionLevels)) return False;
+    }
+    scanner->recentCharacters[2] = scanner->recentCharacters[1];
+    scanner->recentCharacters[1] = scanner->recentCharacters[0];
+    scanner->recentCharacters[0] = *character;
+
+    // A '/' is only a token once it's known not to start a comment,
+    if (previousCharacter == '/') {
+        if (*character == '/') {
+            scanner->state = SCANNER_STATE_LINE_COMMENT;
+            return True;
+        } else if (*character == '*') {
+            scanner->state = SCANNER_STATE_BLOCK_COMMENT;
+            *character = 0; // So that "/*/" doesn't end the comment.
+            return True;
+        }
+        if (!scanPunctuation(scanner, '/')) return False;
+    }
+
+    // Words end at the first character that isn't theirs,
+    if (isWordCharacter(*character)) {
+        if (!scanner->wordLength) endLevels(scanner, &scanner->unaryLevels);
+        if (scanner->wordLength < (int32_t) sizeof(scanner->word)) scanner->word[scanner->wordLength] = *character;
+        scanner->wordLength++;
+    } else if (scanner->wordLength) {
+        boolean scanned = scanWord(scanner);
+        scanner->wordLength = 0;
+        if (!scanned) return False;
+    }
+
+    switch (*character) {
+        case ' ': case '\t': case '\r': case '\n': case '\\': case '/':
+            return True;
+        case '"':
+            scanner->state = SCANNER_STATE_STRING;
+            return scanPunctuation(scanner, *character);
+        case '\'':
+            scanner->state = SCANNER_STATE_CHARACTER;
+            return scanPunctuation(scanner, *character);
+    }
+    return isWordCharacter(*character) || scanPunctuation(scanner, *character);
+}
+
+boolean scanNesting(struct NestingScanner* scanner, const char* text, int32_t length) {
+
+    for (int32_t i=0; i<length; i++) {
+        char character = text[i];
+        char previousCharacter = scanner->previousCharacter;
+
+        switch (scanner->state) {
+            case SCANNER_STATE_CODE:
+                if (!scanCodeCharacter(scanner, &character)) return False;
+                break;
+
+            case SCANNER_STATE_LINE_COMMENT:
+                // Line comments continue past escaped new lines,
+                if ((character == '\n') && (previousCharacter != '\\')) scanner->state = SCANNER_STATE_CODE;
+                break;
+
+            case SCANNER_STATE_BLOCK_COMMENT:
+                if ((previousCharacter == '*') && (character == '/')) {
+                    scanner->state = SCANNER_STATE_CODE;
+                    character = 0; // So that "*//" doesn't start a line comment.
+                }
+                break;
+
+            case SCANNER_STATE_STRING:
+            case SCANNER_STATE_CHARACTER:
+                if (previousCharacter == '\\') {
+                    character = 0; // Escaped, and so that "\\" doesn't escape what follows.
+                } else if (character == ((scanner->state == SCANNER_STATE_STRING) ? '"' : '\'')) {
+                    scanner->state = SCANNER_STATE_CODE;
+                }
+                break;
+        }
+
+        // Position,
+        if (text[i] == '\n') {
+            scanner->line++;
+            scanner->column = 1;
+        } else {
+            scanner->column++;
+        }
+        scanner->previousCharacter = character;
+    }
+
+    return True;
+}
+
+boolean checkNestingDepth(const char* code, int32_t maxDepth) {
+    if (!maxDepth) return True;
+    struct NestingScanner scanner;
+    initializeNestingScanner(&scanner, maxDepth);
+    boolean withinLimit = scanNesting(&scanner, code, NCString.length(code));
+    destroyNestingScanner(&scanner);
+    return withinLimit;
+}
+
+int32_t measureNestingDepth(const char* text, int32_t length) {
+    struct NestingScanner scanner;
+    initializeNestingScanner(&scanner, 0);
+    scanNesting(&scanner, text, length);
+    destroyNestingScanner(&scanner);
+    return scanner.deepestDepth;
+}
+
+int32_t measureBlockLength(const char* text, int32_t length) {
+    struct NestingScanner scanner;
+    initializeNestingScanner(&scanner, 0);
+    int32_t blockLength = -1;
+    for (int32_t i=0; i<length; i++) {
+        scanNesting(&scanner, &text[i], 1);
+        if (!scanner.outerLevelsCount) {
+            if (i) blockLength = i+1;
+            break;
+        }
+    }
+    destroyNestingScanner(&scanner);
+    return blockLength;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Stack
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef DESKTOP
+struct NestingStackCall {
+    void (*function)(void* data);
+    void* data;
+};
+
+static void* nestingStackThreadStart(void* callData) {
+    struct NestingStackCall* call = callData;
+    call->function(call->data);
+    return 0;
+}
+#endif
+
+boolean runWithNestingStack(void (*function)(void* data), void* data, int32_t maxDepth) {
+
+    // Unlimited nesting gets no special treatment, the platform's stack is as good as any,
+    #ifdef DESKTOP
+    if (!maxDepth) {
+        function(data);
+        return True;
+    }
+
+    // The thread only runs while this one waits, so NCC's and the standard library's global
+    // state is never touched concurrently,
+    struct NestingStackCall call = { function, data };
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstacksize(&attributes, (size_t) BASE_STACK_SIZE + (size_t) maxDepth * STACK_SIZE_PER_NESTING_LEVEL);
+    pthread_t thread;
+    int32_t result = pthread_create(&thread, &attributes, nestingStackThreadStart, &call);
+    pthread_attr_destroy(&attributes);
+    if (result) {
+        NERROR("NestingLimits.runWithNestingStack()", "Couldn't reserve a stack for %s%d%s nesting levels. Lower the limit with %s--max-nesting-depth%s.",
+                NTCOLOR(HIGHLIGHT), maxDepth, NTCOLOR(STREAM_DEFAULT), NTCOLOR(HIGHLIGHT), NTCOLOR(STREAM_DEFAULT));
+        return False;
+    }
+
+    // Signals sent to the process (interrupting the server, reporting allocations) should reach the
+    // thread doing the work, as they would have without it,
+    sigset_t allSignals, previousSignals;
+    sigfillset(&allSignals);
+    pthread_sigmask(SIG_BLOCK, &allSignals, &previousSignals);
+    pthread_join(thread, 0);
+    pthread_sigmask(SIG_SETMASK, &previousSignals, 0);
+    return True;
+    #else
+    function(data);
+    return True;
+    #endif
+}
@@ -0,0 +1,216 @@
+
+//
+// Parallel jobs. For the same reasons as batch translation (NCC and the standard library keep
+// mutable global state), workers are forked processes rather than threads. Each takes the next
+// job from a counter in an anonymous shared mapping, collects its results, and writes them all to
+// its pipe once there are no jobs left. Every result is framed by its job index and size.
+//
+// The 18th of October, 2026.
+//
+
+#include <ParallelJobs.h>
+
+#include <NSystemUtils.h>
+#include <NCString.h>
+#include <AllocationProfiler.h> // After NSystemUtils.h, to reroute NMALLOC/NFREE.
+
+#ifdef DESKTOP
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Job buffers
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void initializeJobBuffer(struct JobBuffer* buffer) {
+    buffer->data = 0;
+    buffer->size = 0;
+    buffer->capacity = 0;
+    buffer->readOffset = 0;
+}
+
+void destroyJobBuffer(struct JobBuffer* buffer) {
+    if (buffer->data) NFREE(buffer->data, "ParallelJobs.destroyJobBuffer() buffer->data");
+    initializeJobBuffer(buffer);
+}
+
+void writeJobBytes(struct JobBuffer* buffer, const void* bytes, int32_t size) {
+    if (buffer->size + size > buffer->capacity) {
+        int32_t newCapacity = buffer->capacity ? buffer->capacity * 2 : 256;
+        while (buffer->size + size > newCapacity) newCapacity *= 2;
+        char* newData = NMALLOC(newCapacity, "ParallelJobs.writeJobBytes() newData");
+        if (buffer->data) {
+            NSystemUtils.memcpy(newData, buffer->data, buffer->size);
+            NFREE(buffer->data, "ParallelJobs.writeJobBytes() buffer->data");
+        }
+        buffer->data = newData;
+        buffer->capacity = newCapacity;
+    }
+    NSystemUtils.memcpy(&buffer->data[buffer->size], bytes, size);
+    buffer->size += size;
+}
+
+void writeJobInt32(struct JobBuffer* buffer, int32_t value) {
+    writeJobBytes(buffer, &value, sizeof(int32_t));
+}
+
+void writeJobString(struct JobBuffer* buffer, const char* text) {
+    int32_t length = NCString.length(text);
+    writeJobInt32(buffer, length);
+    writeJobBytes(buffer, text, length+1);
+}
+
+int32_t readJobInt32(struct JobBuffer* buffer) {
+    if (buffer->readOffset + (int32_t) sizeof(int32_t) > buffer->size) return 0;
+    int32_t value;
+    NSystemUtils.memcpy(&value, &buffer->data[buffer->readOffset], sizeof(int32_t));
+    buffer->readOffset += sizeof(int32_t);
+    return value;
+}
+
+const char* readJobString(struct JobBuffer* buffer) {
+    int32_t length = readJobInt32(buffer);
+    if ((length < 0) || (buffer->readOffset + length + 1 > buffer->size)) return "";
+    const char* text = &buffer->data[buffer->readOffset];
+    buffer->readOffset += length + 1;
+    return text;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Workers
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef DESKTOP
+static boolean writeAll(int32_t fileDescriptor, const char* bytes, int32_t size) {
+    while (size > 0) {
+        ssize_t writtenBytesCount = write(fileDescriptor, bytes, size);
+        if (writtenBytesCount <= 0) return False;
+        bytes += writtenBytesCount;
+        size -= (int32_t) writtenBytesCount;
+    }
+    return True;
+}
+
+static void readAll(int32_t fileDescriptor, struct JobBuffer* outBuffer) {
+    char chunk[65536];
+    ssize_t readBytesCount;
+    while ((readBytesCount = read(fileDescriptor, chunk, sizeof(chunk))) > 0) {
+        writeJobBytes(outBuffer, chunk, (int32_t) readBytesCount);
+    }
+}
+
+static void runWorker(int32_t outputFileDescriptor, volatile int32_t* nextJobIndex, int32_t jobsCount, ParallelJob job, void* data) {
+
+    struct JobBuffer output, result;
+    initializeJobBuffer(&output);
+    initializeJobBuffer(&result);
+
+    while (True) {
+        int32_t jobIndex = __atomic_fetch_add(nextJobIndex, 1, __ATOMIC_RELAXED);
+        if (jobIndex >= jobsCount) break;
+
+        result.size = 0;
+        job(jobIndex, &result, data);
+        writeJobInt32(&output, jobIndex);
+        writeJobInt32(&output, result.size);
+        if (result.size) writeJobBytes(&output, result.data, result.size);
+    }
+
+    // Results are only written once the jobs are done, so that the parent reading one pipe at a
+    // time never holds a worker back,
+    writeAll(outputFileDescriptor, output.data, output.size);
+    destroyJobBuffer(&output);
+    destroyJobBuffer(&result);
+}
+
+// A worker that died mid-write leaves a truncated last frame, which is dropped,
+static void collectResults(struct JobBuffer* workerOutput, int32_t jobsCount, struct JobBuffer* outResults, boolean* delivered) {
+    while (workerOutput->readOffset + 2 * (int32_t) sizeof(int32_t) <= workerOutput->size) {
+        int32_t jobIndex = readJobInt32(workerOutput);
+        int32_t size = readJobInt32(workerOutput);
+        if ((jobIndex < 0) || (jobIndex >= jobsCount) || (size < 0) || (workerOutput->readOffset + size > workerOutput->size)) return;
+        if (size) writeJobBytes(&outResults[jobIndex], &workerOutput->data[workerOutput->readOffset], size);
+        workerOutput->readOffset += size;
+        delivered[jobIndex] = True;
+    }
+}
+
+static void runWorkers(int32_t jobsCount, int32_t workersCount, ParallelJob job, void* data, struct JobBuffer* outResults, boolean* delivered) {
+
+    volatile int32_t* nextJobIndex = mmap(0, sizeof(int32_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (nextJobIndex == MAP_FAILED) return;
+    *nextJobIndex = 0;
+
+    // Fork the workers (if a fork fails, the remaining workers will just have more to do),
+    int32_t* fileDescriptors = NMALLOC(workersCount * sizeof(int32_t), "ParallelJobs.runWorkers() fileDescriptors");
+    int32_t forkedWorkersCount = 0;
+    fflush(stdout);
+    fflush(stderr);
+    for (int32_t i=0; i<workersCount; i++) {
+        int pipeFileDescriptors[2];
+        if (pipe(pipeFileDescriptors)) break;
+
+        pid_t processId = fork();
+        if (processId == 0) {
+            close(pipeFileDescriptors[0]);
+            for (int32_t j=0; j<forkedWorkersCount; j++) close(fileDescriptors[j]);
+            runWorker(pipeFileDescriptors[1], nextJobIndex, jobsCount, job, data);
+            close(pipeFileDescriptors[1]);
+            fflush(stdout);
+            fflush(stderr);
+            _exit(0);
+        }
+
+        close(pipeFileDescriptors[1]);
+        if (processId > 0) {
+            fileDescriptors[forkedWorkersCount++] = pipeFileDescriptors[0];
+        } else {
+            close(pipeFileDescriptors[0]);
+        }
+    }
+
+    // Collect the results, then wait for the workers,
+    struct JobBuffer workerOutput;
+    initializeJobBuffer(&workerOutput);
+    for (int32_t i=0; i<forkedWorkersCount; i++) {
+        workerOutput.size = 0;
+        workerOutput.readOffset = 0;
+        readAll(fileDescriptors[i], &workerOutput);
+        close(fileDescriptors[i]);
+        collectResults(&workerOutput, jobsCount, outResults, delivered);
+    }
+    destroyJobBuffer(&workerOutput);
+    while (forkedWorkersCount && (wait(0) > 0));
+
+    NFREE(fileDescriptors, "ParallelJobs.runWorkers() fileDescriptors");
+    munmap((void*) nextJobIndex, sizeof(int32_t));
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel jobs
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void runParallelJobs(int32_t jobsCount, int32_t workersCount, ParallelJob job, void* data, struct JobBuffer* outResults) {
+
+    boolean* delivered = NMALLOC((jobsCount ? jobsCount : 1) * sizeof(boolean), "ParallelJobs.runParallelJobs() delivered");
+    for (int32_t i=0; i<jobsCount; i++) {
+        initializeJobBuffer(&outResults[i]);
+        delivered[i] = False;
+    }
+
+    #ifdef DESKTOP
+    if (workersCount > jobsCount) workersCount = jobsCount;
+    if (workersCount > 1) runWorkers(jobsCount, workersCount, job, data, outResults, delivered);
+    #endif
+
+    // Whatever wasn't delivered is run here,
+    for (int32_t i=0; i<jobsCount; i++) {
+        if (!delivered[i]) job(i, &outResults[i], data);
+    }
+
+    NFREE(delivered, "ParallelJobs.runParallelJobs() delivered");
+}
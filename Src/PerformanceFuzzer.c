@@ -0,0 +1,561 @@
+
+//
+// Performance fuzzing. A local, dependency free equivalent of a coverage guided fuzzer, whose
+// objective is matcher steps (profiled rule attempts) per input byte instead of crashes.
+//
+// Coverage is which rules were attempted and how many times, in power of two buckets (like AFL's
+// hit counts). Mutations that reach new coverage join the corpus, and the ones with the most steps
+// per byte join the slow inputs. When the time is up, the slow inputs are minimized (as long as
+// their steps per byte don't drop), saved, and reported with the rule paths behind their steps.
+// Step counts are deterministic, so the saved inputs make noise free regression benchmarks.
+//
+// The 18th of October, 2026.
+//
+
+#include <PerformanceFuzzer.h>
+#include <LanguageDefinition.h>
+#include <RuleProfiler.h>
+#include <NestingLimits.h>
+#include <ReportFormatting.h>
+#include <Timing.h>
+#include <JSON.h>
+
+#include <NCC.h>
+#include <NSystemUtils.h>
+#include <NString.h>
+#include <NVector.h>
+#include <NCString.h>
+#include <NError.h>
+#include <AllocationProfiler.h> // After NSystemUtils.h, to reroute NMALLOC/NFREE.
+
+#include <stdlib.h>
+
+#define FEATURE_MAP_SIZE (1 << 16)          // Bits.
+#define MAX_CORPUS_SIZE 4096
+#define MIN_SCORED_LENGTH 16                // Shorter inputs have noisy steps per byte.
+#define MAX_STACKED_MUTATIONS 4
+#define MAX_MUTATED_RANGE 64
+#define MAX_MINIMIZATION_RUNS 2000          // Per input.
+#define HOT_RULES_COUNT 5
+#define PROGRESS_INTERVAL 10000000000ll     // Nanoseconds.
+
+struct FuzzInput {
+    char* text;
+    int32_t length;
+    int64_t steps;
+    int64_t score; // Steps per byte, in thousandths.
+};
+
+struct Fuzzer {
+    struct NCC* ncc;
+    NCC_Rule* rootRule;
+    const struct PerformanceFuzzerOptions* options;
+    uint64_t randomState;
+
+    struct NVector corpus;      // struct FuzzInput.
+    struct NVector slowInputs;  // struct FuzzInput, slowest first.
+
+    uint8_t* featureMap;
+    int32_t featuresCount;
+    int32_t newFeaturesCount;   // Of the last execution.
+    int64_t executionsCount;
+
+    char* candidate;            // maxInputLength+1 bytes.
+};
+
+// Fragments the grammar cares about, so that mutations reach past the tokenizing rules,
+static const char* dictionary[] = {
+        "(", ")", "{", "}", "[", "]", ";", ",", ".", "=", "+=", "<<=", "+", "-", "*", "/", "%", "<<", "<",
+        "==", "&&", "||", "&", "|", "^", "!", "~", "++", "--", "?", ":", " ", "\n", "a", "b1", "0", "1.5e3",
+        "0x1F", "'c'", "'\\n'", "\"s\"", "\"\\\"\"", "// c\n", "/* c */", "/*", "*/", "\\",
+        "int ", "char ", "float ", "void ", "class ", "static ", "if (a) ", "else ", "while (a) ",
+        "do ", "for (;;) ", "return ", "break;", "continue;", "goto l;", "l: ", "int a;", "a = b;",
+        "void f() {}", "class C { int a; }" };
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper functions
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// xorshift64*, so that a seed always replays the same run,
+static uint32_t nextRandom(struct Fuzzer* fuzzer) {
+    uint64_t x = fuzzer->randomState;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    fuzzer->randomState = x;
+    return (uint32_t) ((x * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+static int32_t randomBelow(struct Fuzzer* fuzzer, int32_t limit) {
+    return (int32_t) (nextRandom(fuzzer) % (uint32_t) limit);
+}
+
+static int64_t getScore(int64_t steps, int32_t length) {
+    return length ? steps * 1000 / length : 0;
+}
+
+// Returns the steps. The text must be 0 terminated,
+static int64_t execute(struct NCC* ncc, NCC_Rule* rootRule, const char* text) {
+    resetRuleProfile();
+    NCC_MatchingResult matchingResult;
+    NCC_ASTNode_Data tree;
+    boolean matched = NCC_match(ncc, rootRule, text, &matchingResult, &tree);
+    if (matched && tree.node) NCC_deleteASTNode(&tree, 0);
+    return getRuleAttemptsCount();
+}
+
+static uint32_t getBucket(int64_t count) {
+    uint32_t bucket = 0;
+    while (count) {
+        bucket++;
+        count >>= 1;
+    }
+    return bucket;
+}
+
+static void markFeature(struct Fuzzer* fuzzer, uint64_t feature) {
+    uint32_t index = (uint32_t) ((feature * 0x9e3779b97f4a7c15ull) >> 48);
+    uint8_t mask = 1 << (index & 7);
+    if (fuzzer->featureMap[index >> 3] & mask) return;
+    fuzzer->featureMap[index >> 3] |= mask;
+    fuzzer->featuresCount++;
+    fuzzer->newFeaturesCount++;
+}
+
+static void markRuleFeatures(NCC_Rule* rule, int64_t attemptsCount, int64_t successesCount, void* fuzzerData) {
+    struct Fuzzer* fuzzer = fuzzerData;
+    uint64_t ruleHash = (uint64_t) (uintptr_t) rule;
+    markFeature(fuzzer, ruleHash * 64 + getBucket(attemptsCount));
+    markFeature(fuzzer, ruleHash * 64 + 32 + getBucket(successesCount));
+}
+
+static void addInput(struct NVector* inputs, const char* text, int32_t length, int64_t steps) {
+    struct FuzzInput* input = NVector.emplaceBack(inputs);
+    input->text = NMALLOC(length+1, "PerformanceFuzzer.addInput() input->text");
+    NSystemUtils.memcpy(input->text, text, length);
+    input->text[length] = 0;
+    input->length = length;
+    input->steps = steps;
+    input->score = getScore(steps, length);
+}
+
+static void destroyInputs(struct NVector* inputs) {
+    struct FuzzInput input;
+    while (NVector.popBack(inputs, &input)) NFREE(input.text, "PerformanceFuzzer.destroyInputs() input.text");
+    NVector.destroy(inputs);
+}
+
+static int compareScores(const void* input1, const void* input2) {
+    int64_t score1 = ((const struct FuzzInput*) input1)->score;
+    int64_t score2 = ((const struct FuzzInput*) input2)->score;
+    return (score1 < score2) ? 1 : (score1 > score2) ? -1 : 0;
+}
+
+static void considerSlowInput(struct Fuzzer* fuzzer, const char* text, int32_t length, int64_t steps) {
+
+    if (length < MIN_SCORED_LENGTH) return;
+    int64_t score = getScore(steps, length);
+    int32_t slowInputsCount = NVector.size(&fuzzer->slowInputs);
+    if ((slowInputsCount == fuzzer->options->slowInputsCount) &&
+        (score <= ((struct FuzzInput*) NVector.getLast(&fuzzer->slowInputs))->score)) return;
+
+    // The same steps over the same length is most likely the same input,
+    for (int32_t i=0; i<slowInputsCount; i++) {
+        struct FuzzInput* input = NVector.get(&fuzzer->slowInputs, i);
+        if ((input->steps == steps) && (input->length == length)) return;
+    }
+
+    // Insert in order, dropping the fastest if full,
+    addInput(&fuzzer->slowInputs, text, length, steps);
+    qsort(NVector.get(&fuzzer->slowInputs, 0), slowInputsCount+1, sizeof(struct FuzzInput), compareScores);
+    if (slowInputsCount+1 > fuzzer->options->slowInputsCount) {
+        struct FuzzInput fastestInput;
+        NVector.popBack(&fuzzer->slowInputs, &fastestInput);
+        NFREE(fastestInput.text, "PerformanceFuzzer.considerSlowInput() fastestInput.text");
+    }
+}
+
+// Runs the input, keeping it if it's new coverage or slow. Returns the steps,
+static int64_t tryInput(struct Fuzzer* fuzzer, const char* text, int32_t length) {
+    int64_t steps = execute(fuzzer->ncc, fuzzer->rootRule, text);
+    fuzzer->executionsCount++;
+    fuzzer->newFeaturesCount = 0;
+    visitRuleProfile(markRuleFeatures, fuzzer);
+    if (fuzzer->newFeaturesCount && (NVector.size(&fuzzer->corpus) < MAX_CORPUS_SIZE)) addInput(&fuzzer->corpus, text, length, steps);
+    considerSlowInput(fuzzer, text, length, steps);
+    return steps;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Mutations
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Return the new length, which stays the same if the bytes don't fit,
+static int32_t insertBytes(char* buffer, int32_t length, int32_t maxLength, int32_t position, const char* bytes, int32_t count) {
+    if (length + count > maxLength) return length;
+
+    // Copied first, the bytes could be part of the buffer,
+    char copiedBytes[MAX_MUTATED_RANGE];
+    NSystemUtils.memcpy(copiedBytes, bytes, count);
+    for (int32_t i=length-1; i>=position; i--) buffer[i+count] = buffer[i];
+    NSystemUtils.memcpy(&buffer[position], copiedBytes, count);
+    return length + count;
+}
+
+static int32_t deleteBytes(char* buffer, int32_t length, int32_t position, int32_t count) {
+    for (int32_t i=position+count; i<length; i++) buffer[i-count] = buffer[i];
+    return length - count;
+}
+
+static int32_t getRandomRangeLength(struct Fuzzer* fuzzer, int32_t position, int32_t length) {
+    int32_t maxCount = length - position;
+    if (maxCount > MAX_MUTATED_RANGE) maxCount = MAX_MUTATED_RANGE;
+    return 1 + randomBelow(fuzzer, maxCount);
+}
+
+// Mutates a copy of the parent into the candidate buffer, returns its length,
+static int32_t mutate(struct Fuzzer* fuzzer, struct FuzzInput* parent) {
+
+    int32_t maxLength = fuzzer->options->maxInputLength;
+    char* candidate = fuzzer->candidate;
+    int32_t length = parent->length;
+    NSystemUtils.memcpy(candidate, parent->text, length);
+
+    int32_t mutationsCount = 1 + randomBelow(fuzzer, MAX_STACKED_MUTATIONS);
+    for (int32_t i=0; i<mutationsCount; i++) {
+        int32_t position = randomBelow(fuzzer, length+1);
+        switch (randomBelow(fuzzer, 5)) {
+            case 0: {
+                const char* token = dictionary[randomBelow(fuzzer, sizeof(dictionary) / sizeof(dictionary[0]))];
+                length = insertBytes(candidate, length, maxLength, position, token, NCString.length(token));
+                break;
+            }
+            case 1:
+                if (position < length) length = deleteBytes(candidate, length, position, getRandomRangeLength(fuzzer, position, length));
+                break;
+            case 2:
+                // Repeating a piece grows whatever it's nested in,
+                if (position < length) {
+                    int32_t count = getRandomRangeLength(fuzzer, position, length);
+                    length = insertBytes(candidate, length, maxLength, randomBelow(fuzzer, length+1), &candidate[position], count);
+                }
+                break;
+            case 3:
+                if (position < length) candidate[position] = randomBelow(fuzzer, 16) ? (char) (' ' + randomBelow(fuzzer, 95)) : '\n';
+                break;
+            default: {
+                struct FuzzInput* donor = NVector.get(&fuzzer->corpus, randomBelow(fuzzer, NVector.size(&fuzzer->corpus)));
+                if (!donor->length) break;
+                int32_t donorPosition = randomBelow(fuzzer, donor->length);
+                int32_t count = getRandomRangeLength(fuzzer, donorPosition, donor->length);
+                length = insertBytes(candidate, length, maxLength, position, &donor->text[donorPosition], count);
+                break;
+            }
+        }
+    }
+
+    candidate[length] = 0;
+    return length;
+}
+
+// Removes pieces, halving their size down to single bytes, as long as the steps per byte don't drop,
+static void minimize(struct Fuzzer* fuzzer, struct FuzzInput* input) {
+
+    char* text = fuzzer->candidate;
+    char* trial = NMALLOC(input->length+1, "PerformanceFuzzer.minimize() trial");
+    NSystemUtils.memcpy(text, input->text, input->length+1);
+    int32_t length = input->length;
+    int64_t steps = input->steps;
+    int64_t score = input->score;
+
+    int32_t runsCount = 0;
+    for (int32_t pieceLength = length/2; (pieceLength > 0) && (runsCount < MAX_MINIMIZATION_RUNS); pieceLength /= 2) {
+        int32_t position = 0;
+        while ((position + pieceLength <= length) && (length - pieceLength >= MIN_SCORED_LENGTH) && (runsCount < MAX_MINIMIZATION_RUNS)) {
+            NSystemUtils.memcpy(trial, text, position);
+            NSystemUtils.memcpy(&trial[position], &text[position + pieceLength], length - position - pieceLength + 1);
+            int64_t trialSteps = execute(fuzzer->ncc, fuzzer->rootRule, trial);
+            runsCount++;
+            if (getScore(trialSteps, length - pieceLength) >= score) {
+                length -= pieceLength;
+                NSystemUtils.memcpy(text, trial, length+1);
+                steps = trialSteps;
+                score = getScore(steps, length);
+            } else {
+                position += pieceLength;
+            }
+        }
+    }
+    fuzzer->executionsCount += runsCount;
+    NFREE(trial, "PerformanceFuzzer.minimize() trial");
+
+    NFREE(input->text, "PerformanceFuzzer.minimize() input->text");
+    input->text = NMALLOC(length+1, "PerformanceFuzzer.minimize() input->text");
+    NSystemUtils.memcpy(input->text, text, length+1);
+    input->length = length;
+    input->steps = steps;
+    input->score = score;
+}
+
+// Different inputs often minimize to the same one,
+static void removeDuplicateInputs(struct NVector* inputs) {
+    int32_t keptInputsCount = 0;
+    int32_t inputsCount = NVector.size(inputs);
+    for (int32_t i=0; i<inputsCount; i++) {
+        struct FuzzInput* input = NVector.get(inputs, i);
+        boolean duplicate = False;
+        for (int32_t j=0; j<keptInputsCount; j++) {
+            struct FuzzInput* keptInput = NVector.get(inputs, j);
+            if ((keptInput->length == input->length) && NCString.equals(keptInput->text, input->text)) duplicate = True;
+        }
+        if (duplicate) {
+            NFREE(input->text, "PerformanceFuzzer.removeDuplicateInputs() input->text");
+        } else {
+            *(struct FuzzInput*) NVector.get(inputs, keptInputsCount++) = *input;
+        }
+    }
+
+    struct FuzzInput removedInput;
+    while (NVector.size(inputs) > keptInputsCount) NVector.popBack(inputs, &removedInput);
+}
+
+// Reads a whole file, or returns 0 if it couldn't,
+static char* readWholeFile(const char* filePath, int32_t* outLength, const char* allocationTag) {
+    int32_t fileSize = NSystemUtils.getFileSize(filePath, False);
+    if (fileSize < 0) return 0;
+    char* text = NMALLOC(fileSize+1, allocationTag);
+    NSystemUtils.readFromFile(filePath, False, 0, 0, text);
+    text[fileSize] = 0;
+    *outLength = fileSize;
+    return text;
+}
+
+static void logProgress(struct Fuzzer* fuzzer, int64_t elapsedTime) {
+    struct NString line;
+    NString.initialize(&line, "%d s: ", (int32_t) (elapsedTime / 1000000000));
+    appendInteger64(&line, fuzzer->executionsCount);
+    NString.append(&line, " executions, corpus: %d, features: %d, slowest: ", NVector.size(&fuzzer->corpus), fuzzer->featuresCount);
+    struct FuzzInput* slowestInput = NVector.size(&fuzzer->slowInputs) ? NVector.get(&fuzzer->slowInputs, 0) : 0;
+    appendFixedPoint(&line, slowestInput ? slowestInput->score : 0, 3);
+    NString.append(&line, " steps per byte");
+    NLOGI("PerformanceFuzzer", "%s", NString.get(&line));
+    NString.destroy(&line);
+}
+
+// Writes the slow inputs, their step counts, and the report,
+static boolean saveSlowInputs(struct Fuzzer* fuzzer, int64_t elapsedTime) {
+
+    const struct PerformanceFuzzerOptions* options = fuzzer->options;
+    struct NString path, json, report;
+    NString.initialize(&path, "");
+    NString.initialize(&json, "{\n    \"languageDefinition\": ");
+    appendJSONString(&json, getLanguageDefinitionVersion());
+    NString.append(&json, ",\n    \"seed\": %d,\n    \"seconds\": %d,\n    \"executions\": ", options->seed, (int32_t) (elapsedTime / 1000000000));
+    appendInteger64(&json, fuzzer->executionsCount);
+    NString.append(&json, ",\n    \"inputs\": [");
+    NString.initialize(&report, "Slowest inputs by matcher steps per byte, with the rule paths most steps went through:\n");
+
+    boolean success = True;
+    int32_t slowInputsCount = NVector.size(&fuzzer->slowInputs);
+    for (int32_t i=0; i<slowInputsCount; i++) {
+        struct FuzzInput* input = NVector.get(&fuzzer->slowInputs, i);
+        NString.set(&path, "%s/slow-%d.addaat", options->outputDirectory, i+1);
+        if (!NSystemUtils.writeToFile(NString.get(&path), input->text, input->length, False)) {
+            NERROR("PerformanceFuzzer.saveSlowInputs()", "Couldn't write: %s%s%s", NTCOLOR(HIGHLIGHT), NString.get(&path), NTCOLOR(STREAM_DEFAULT));
+            success = False;
+        }
+
+        NString.append(&json, "%s\n      { \"file\": \"slow-%d.addaat\", \"bytes\": %d, \"steps\": ", i ? "," : "", i+1, input->length);
+        appendInteger64(&json, input->steps);
+        NString.append(&json, ", \"stepsPerByte\": ");
+        appendFixedPoint(&json, input->score, 3);
+        NString.append(&json, " }");
+
+        // Profiled once more, for the paths,
+        NString.append(&report, "\n#%d slow-%d.addaat: %d bytes, ", i+1, i+1, input->length);
+        appendInteger64(&report, input->steps);
+        NString.append(&report, " steps, ");
+        appendFixedPoint(&report, input->score, 3);
+        NString.append(&report, " steps per byte\n");
+        execute(fuzzer->ncc, fuzzer->rootRule, input->text);
+        appendHotRulePaths(&report, HOT_RULES_COUNT);
+    }
+    NString.append(&json, "\n    ]\n}\n");
+
+    NString.set(&path, "%s/slow-inputs.json", options->outputDirectory);
+    if (!NSystemUtils.writeToFile(NString.get(&path), NString.get(&json), NString.length(&json), False)) success = False;
+    NString.set(&path, "%s/slow-inputs.txt", options->outputDirectory);
+    if (!NSystemUtils.writeToFile(NString.get(&path), NString.get(&report), NString.length(&report), False)) success = False;
+    if (!success) NERROR("PerformanceFuzzer.saveSlowInputs()", "Couldn't save to: %s%s%s", NTCOLOR(HIGHLIGHT), options->outputDirectory, NTCOLOR(STREAM_DEFAULT));
+    NLOGI("", "%s", NString.get(&report));
+
+    NString.destroy(&path);
+    NString.destroy(&json);
+    NString.destroy(&report);
+    return success;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Fuzzing
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boolean runPerformanceFuzzer(struct NCC* ncc, struct NVector* seedFiles, const struct PerformanceFuzzerOptions* options) {
+
+    struct Fuzzer fuzzer;
+    fuzzer.ncc = ncc;
+    fuzzer.rootRule = getRootRule(ncc);
+    fuzzer.options = options;
+    fuzzer.randomState = ((uint64_t) options->seed * 0x9e3779b97f4a7c15ull) | 1;
+    NVector.initialize(&fuzzer.corpus, 0, sizeof(struct FuzzInput));
+    NVector.initialize(&fuzzer.slowInputs, 0, sizeof(struct FuzzInput));
+    fuzzer.featureMap = NMALLOC(FEATURE_MAP_SIZE / 8, "PerformanceFuzzer.runPerformanceFuzzer() fuzzer.featureMap");
+    NSystemUtils.memset(fuzzer.featureMap, 0, FEATURE_MAP_SIZE / 8);
+    fuzzer.featuresCount = 0;
+    fuzzer.executionsCount = 0;
+    fuzzer.candidate = NMALLOC(options->maxInputLength+1, "PerformanceFuzzer.runPerformanceFuzzer() fuzzer.candidate");
+
+    // Seeds (too long ones are cut), all kept whatever their coverage,
+    int32_t seedFilesCount = NVector.size(seedFiles);
+    for (int32_t i=0; i<seedFilesCount; i++) {
+        int32_t length;
+        char* text = readWholeFile(*(const char**) NVector.get(seedFiles, i), &length, "PerformanceFuzzer.runPerformanceFuzzer() text");
+        if (!text) continue;
+        if (length > options->maxInputLength) {
+            length = options->maxInputLength;
+            text[length] = 0;
+        }
+        int64_t steps = tryInput(&fuzzer, text, length);
+        if (!fuzzer.newFeaturesCount) addInput(&fuzzer.corpus, text, length, steps);
+        NFREE(text, "PerformanceFuzzer.runPerformanceFuzzer() text");
+    }
+    if (!NVector.size(&fuzzer.corpus)) addInput(&fuzzer.corpus, "", 0, execute(ncc, fuzzer.rootRule, ""));
+
+    // Mutate until the time is up,
+    int64_t startTime = getMonotonicTime();
+    int64_t durationTime = (int64_t) options->durationSeconds * 1000000000;
+    int64_t elapsedTime = 0, lastProgressTime = 0;
+    while (elapsedTime < durationTime) {
+
+        // Slow inputs are picked half the time, slowness builds on slowness,
+        int32_t slowInputsCount = NVector.size(&fuzzer.slowInputs);
+        struct FuzzInput* parent = (slowInputsCount && randomBelow(&fuzzer, 2)) ?
+                NVector.get(&fuzzer.slowInputs, randomBelow(&fuzzer, slowInputsCount)) :
+                NVector.get(&fuzzer.corpus    , randomBelow(&fuzzer, NVector.size(&fuzzer.corpus)));
+        int32_t length = mutate(&fuzzer, parent);
+
+        // What's nested too deep would be rejected before matching anyway,
+        if (!options->maxNestingDepth || (measureNestingDepth(fuzzer.candidate, length) <= options->maxNestingDepth)) {
+            tryInput(&fuzzer, fuzzer.candidate, length);
+        }
+
+        elapsedTime = getMonotonicTime() - startTime;
+        if (elapsedTime - lastProgressTime >= PROGRESS_INTERVAL) {
+            logProgress(&fuzzer, elapsedTime);
+            lastProgressTime = elapsedTime;
+        }
+    }
+    logProgress(&fuzzer, elapsedTime);
+
+    // Minimize, then save,
+    int32_t slowInputsCount = NVector.size(&fuzzer.slowInputs);
+    for (int32_t i=0; i<slowInputsCount; i++) minimize(&fuzzer, NVector.get(&fuzzer.slowInputs, i));
+    removeDuplicateInputs(&fuzzer.slowInputs);
+    qsort(NVector.get(&fuzzer.slowInputs, 0), NVector.size(&fuzzer.slowInputs), sizeof(struct FuzzInput), compareScores);
+    boolean success = saveSlowInputs(&fuzzer, elapsedTime);
+
+    // Clean up,
+    destroyInputs(&fuzzer.corpus);
+    destroyInputs(&fuzzer.slowInputs);
+    NFREE(fuzzer.featureMap, "PerformanceFuzzer.runPerformanceFuzzer() fuzzer.featureMap");
+    NFREE(fuzzer.candidate, "PerformanceFuzzer.runPerformanceFuzzer() fuzzer.candidate");
+    return success;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Checking
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boolean checkSlowInputs(struct NCC* ncc, const struct PerformanceFuzzerOptions* options) {
+
+    // Load the recorded steps,
+    struct NString path, fileName, table, cell;
+    NString.initialize(&path, "%s/slow-inputs.json", options->outputDirectory);
+    int32_t length;
+    char* jsonText = readWholeFile(NString.get(&path), &length, "PerformanceFuzzer.checkSlowInputs() jsonText");
+    struct JSONValue* json = jsonText ? parseJSON(jsonText) : 0;
+    struct JSONValue* inputs = json ? getJSONMember(json, "inputs") : 0;
+    if (!inputs) {
+        NERROR("PerformanceFuzzer.checkSlowInputs()", "No recorded slow inputs in: %s%s%s", NTCOLOR(HIGHLIGHT), NString.get(&path), NTCOLOR(STREAM_DEFAULT));
+        if (json) deleteJSONValue(json);
+        if (jsonText) NFREE(jsonText, "PerformanceFuzzer.checkSlowInputs() jsonText");
+        NString.destroy(&path);
+        return False;
+    }
+
+    NString.initialize(&fileName, "");
+    NString.initialize(&cell, "");
+    NString.initialize(&table, "Slow inputs, matcher steps against the recorded ones:\n");
+    const char* headers[] = { "file", "bytes", "recorded", "steps", "change", "verdict" };
+    const int32_t widths[] = { 24, 10, 14, 14, 12, 10 };
+    for (int32_t i=0; i<6; i++) appendPadded(&table, headers[i], widths[i], i > 0);
+    NString.append(&table, "\n");
+
+    // Match each again,
+    NCC_Rule* rootRule = getRootRule(ncc);
+    int32_t regressionsCount = 0;
+    int32_t inputsCount = getJSONArraySize(inputs);
+    for (int32_t i=0; i<inputsCount; i++) {
+        struct JSONValue* input = getJSONArrayElement(inputs, i);
+        getJSONString(getJSONMember(input, "file"), &fileName);
+        int64_t recordedSteps = getJSONFixedPoint(getJSONMember(input, "steps"), 0);
+        NString.set(&path, "%s/%s", options->outputDirectory, NString.get(&fileName));
+
+        char* text = readWholeFile(NString.get(&path), &length, "PerformanceFuzzer.checkSlowInputs() text");
+        int64_t steps = text ? execute(ncc, rootRule, text) : -1;
+        if (text) NFREE(text, "PerformanceFuzzer.checkSlowInputs() text");
+
+        // Steps are deterministic, so any change is real. Only growth past the threshold fails,
+        const char* verdict = "ok";
+        if (steps < 0) {
+            verdict = "MISSING";
+            regressionsCount++;
+        } else if (steps * 100 > recordedSteps * (100 + options->stepsThreshold)) {
+            verdict = "SLOWER";
+            regressionsCount++;
+        } else if (steps < recordedSteps) {
+            verdict = "faster";
+        }
+
+        appendPadded(&table, NString.get(&fileName), widths[0], False);
+        NString.set(&cell, "%d", length);
+        appendPadded(&table, text ? NString.get(&cell) : "-", widths[1], True);
+        NString.set(&cell, "");
+        appendInteger64(&cell, recordedSteps);
+        appendPadded(&table, NString.get(&cell), widths[2], True);
+        NString.set(&cell, "");
+        if (steps >= 0) appendInteger64(&cell, steps);
+        appendPadded(&table, NString.get(&cell), widths[3], True);
+        NString.set(&cell, "");
+        if ((steps >= 0) && recordedSteps) {
+            appendFixedPoint(&cell, (steps - recordedSteps) * 1000 / recordedSteps, 1);
+            NString.append(&cell, "%s", "%");
+        }
+        appendPadded(&table, NString.get(&cell), widths[4], True);
+        appendPadded(&table, verdict, widths[5], True);
+        NString.append(&table, "\n");
+    }
+    NLOGI("", "%s", NString.get(&table));
+
+    if (regressionsCount) {
+        NERROR("PerformanceFuzzer.checkSlowInputs()", "%s%d%s slow input(s) take more than %d percent more steps than recorded.",
+                NTCOLOR(HIGHLIGHT), regressionsCount, NTCOLOR(STREAM_DEFAULT), options->stepsThreshold);
+    }
+
+    deleteJSONValue(json);
+    NFREE(jsonText, "PerformanceFuzzer.checkSlowInputs() jsonText");
+    NString.destroy(&path);
+    NString.destroy(&fileName);
+    NString.destroy(&table);
+    NString.destroy(&cell);
+    return !regressionsCount;
+}
@@ -0,0 +1,277 @@
+
+//
+// Preprocessing. Every ${} in the grammar matches white-spaces and comments, one ignorable at a
+// time, at every token boundary. Doing it once, in a single pass, leaves the matcher with at most
+// one space between tokens:
+//   - Continued lines are spliced first, anywhere (as in C, even in comments and literals).
+//   - Comments become white-space.
+//   - White-spaces become a single space, or nothing next to brackets, braces, parentheses, ';',
+//     ',' and '?'. Elsewhere the space is kept, so that tokens never merge ("a - -b", "int a").
+//   - String and character literals are copied as they are.
+// New-lines never survive, so each run of characters taken as is shares its original line.
+//
+// The 18th of October, 2026.
+//
+
+#include <Preprocessing.h>
+
+#include <NSystemUtils.h>
+#include <NCString.h>
+#include <AllocationProfiler.h> // After NSystemUtils.h, to reroute NMALLOC/NFREE.
+
+#define PREPROCESSOR_STATE_CODE          0
+#define PREPROCESSOR_STATE_LINE_COMMENT  1
+#define PREPROCESSOR_STATE_BLOCK_COMMENT 2
+#define PREPROCESSOR_STATE_STRING        3
+#define PREPROCESSOR_STATE_CHARACTER     4
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Output
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void appendCharacter(struct Preprocessor* preprocessor, char character, int32_t offset, int32_t line, int32_t column) {
+
+    // Runs of characters taken as is need no entries,
+    if ((offset != preprocessor->lastOffset + 1) || (line != preprocessor->lastLine)) {
+        struct PreprocessedOffset* entry = NVector.emplaceBack(&preprocessor->offsetMap);
+        entry->preprocessedOffset = preprocessor->length;
+        entry->originalOffset = offset;
+        entry->line = line;
+        entry->column = column;
+    }
+    preprocessor->lastOffset = offset;
+    preprocessor->lastLine = line;
+
+    if (preprocessor->length + 2 > preprocessor->capacity) {
+        int32_t newCapacity = preprocessor->capacity * 2;
+        char* newCode = NMALLOC(newCapacity, "Preprocessing.appendCharacter() newCode");
+        NSystemUtils.memcpy(newCode, preprocessor->code, preprocessor->length);
+        NFREE(preprocessor->code, "Preprocessing.appendCharacter() preprocessor->code");
+        preprocessor->code = newCode;
+        preprocessor->capacity = newCapacity;
+    }
+    preprocessor->code[preprocessor->length++] = character;
+    preprocessor->code[preprocessor->length] = 0;
+}
+
+static boolean isSeparator(char character) {
+    switch (character) {
+        case '(': case ')': case '[': case ']': case '{': case '}': case ';': case ',': case '?':
+            return True;
+        default:
+            return False;
+    }
+}
+
+// A code character, preceded by the held space if it's needed,
+static void appendCodeCharacter(struct Preprocessor* preprocessor, char character, int32_t offset, int32_t line, int32_t column) {
+    if (preprocessor->spaceHeld) {
+        preprocessor->spaceHeld = False;
+        if (preprocessor->length && !isSeparator(preprocessor->code[preprocessor->length-1]) && !isSeparator(character)) {
+            appendCharacter(preprocessor, ' ', preprocessor->spaceOffset, preprocessor->spaceLine, preprocessor->spaceColumn);
+        }
+    }
+    appendCharacter(preprocessor, character, offset, line, column);
+}
+
+static void holdSpace(struct Preprocessor* preprocessor, int32_t offset, int32_t line, int32_t column) {
+    if (preprocessor->spaceHeld) return;
+    preprocessor->spaceHeld = True;
+    preprocessor->spaceOffset = offset;
+    preprocessor->spaceLine = line;
+    preprocessor->spaceColumn = column;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Comments, literals and white-spaces
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void processCharacter(struct Preprocessor* preprocessor, char character, int32_t offset, int32_t line, int32_t column) {
+
+    switch (preprocessor->state) {
+        case PREPROCESSOR_STATE_CODE:
+
+            // A held '/' is either a comment start or a code character,
+            if (preprocessor->slashHeld) {
+                preprocessor->slashHeld = False;
+                if (character == '/') {
+                    preprocessor->state = PREPROCESSOR_STATE_LINE_COMMENT;
+                    holdSpace(preprocessor, preprocessor->slashOffset, preprocessor->slashLine, preprocessor->slashColumn);
+                    return;
+                } else if (character == '*') {
+                    preprocessor->state = PREPROCESSOR_STATE_BLOCK_COMMENT;
+                    preprocessor->previousCharacter = 0; // So that "/*/" doesn't end the comment.
+                    holdSpace(preprocessor, preprocessor->slashOffset, preprocessor->slashLine, preprocessor->slashColumn);
+                    return;
+                }
+                appendCodeCharacter(preprocessor, '/', preprocessor->slashOffset, preprocessor->slashLine, preprocessor->slashColumn);
+            }
+
+            if (character == '/') {
+                preprocessor->slashHeld = True;
+                preprocessor->slashOffset = offset;
+                preprocessor->slashLine = line;
+                preprocessor->slashColumn = column;
+            } else if ((character == ' ') || (character == '\t') || (character == '\r') || (character == '\n')) {
+                holdSpace(preprocessor, offset, line, column);
+            } else {
+                appendCodeCharacter(preprocessor, character, offset, line, column);
+                if (character == '"') {
+                    preprocessor->state = PREPROCESSOR_STATE_STRING;
+                    preprocessor->escaped = False;
+                } else if (character == '\'') {
+                    preprocessor->state = PREPROCESSOR_STATE_CHARACTER;
+                    preprocessor->escaped = False;
+                }
+            }
+            break;
+
+        case PREPROCESSOR_STATE_LINE_COMMENT:
+            if (character == '\n') preprocessor->state = PREPROCESSOR_STATE_CODE;
+            break;
+
+        case PREPROCESSOR_STATE_BLOCK_COMMENT:
+            if ((preprocessor->previousCharacter == '*') && (character == '/')) preprocessor->state = PREPROCESSOR_STATE_CODE;
+            preprocessor->previousCharacter = character;
+            break;
+
+        case PREPROCESSOR_STATE_STRING:
+        case PREPROCESSOR_STATE_CHARACTER:
+
+            // Unterminated literals end with their line, and fail to match as they would have,
+            if (character == '\n') {
+                preprocessor->state = PREPROCESSOR_STATE_CODE;
+                holdSpace(preprocessor, offset, line, column);
+                break;
+            }
+
+            appendCharacter(preprocessor, character, offset, line, column);
+            if (preprocessor->escaped) {
+                preprocessor->escaped = False;
+            } else if (character == '\\') {
+                preprocessor->escaped = True;
+            } else if (character == ((preprocessor->state == PREPROCESSOR_STATE_STRING) ? '"' : '\'')) {
+                preprocessor->state = PREPROCESSOR_STATE_CODE;
+            }
+            break;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Interface
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void initializePreprocessor(struct Preprocessor* preprocessor) {
+
+    preprocessor->capacity = 4096;
+    preprocessor->code = NMALLOC(preprocessor->capacity, "Preprocessing.initializePreprocessor() preprocessor->code");
+    preprocessor->code[0] = 0;
+    preprocessor->length = 0;
+    NVector.initialize(&preprocessor->offsetMap, 0, sizeof(struct PreprocessedOffset));
+
+    preprocessor->originalOffset = 0;
+    preprocessor->line = 1;
+    preprocessor->column = 1;
+
+    preprocessor->heldCharactersCount = 0;
+
+    preprocessor->state = PREPROCESSOR_STATE_CODE;
+    preprocessor->escaped = False;
+    preprocessor->previousCharacter = 0;
+    preprocessor->slashHeld = False;
+    preprocessor->spaceHeld = False;
+
+    preprocessor->lastOffset = -2;
+    preprocessor->lastLine = 0;
+}
+
+void destroyPreprocessor(struct Preprocessor* preprocessor) {
+    NFREE(preprocessor->code, "Preprocessing.destroyPreprocessor() preprocessor->code");
+    NVector.destroy(&preprocessor->offsetMap);
+}
+
+static void releaseHeldCharacters(struct Preprocessor* preprocessor) {
+    if (preprocessor->heldCharactersCount > 0) processCharacter(preprocessor, '\\', preprocessor->heldOffset    , preprocessor->heldLine, preprocessor->heldColumn    );
+    if (preprocessor->heldCharactersCount > 1) processCharacter(preprocessor, '\r', preprocessor->heldOffset + 1, preprocessor->heldLine, preprocessor->heldColumn + 1);
+    preprocessor->heldCharactersCount = 0;
+}
+
+void preprocessCode(struct Preprocessor* preprocessor, const char* text, int32_t length) {
+
+    for (int32_t i=0; i<length; i++) {
+        char character = text[i];
+        int32_t offset = preprocessor->originalOffset, line = preprocessor->line, column = preprocessor->column;
+
+        // Position,
+        preprocessor->originalOffset++;
+        if (character == '\n') {
+            preprocessor->line++;
+            preprocessor->column = 1;
+        } else {
+            preprocessor->column++;
+        }
+
+        // Splice continued lines ("\\\n" or "\\\r\n"),
+        if (preprocessor->heldCharactersCount) {
+            if (character == '\n') {
+                preprocessor->heldCharactersCount = 0;
+                continue;
+            } else if ((character == '\r') && (preprocessor->heldCharactersCount == 1)) {
+                preprocessor->heldCharactersCount = 2;
+                continue;
+            }
+            releaseHeldCharacters(preprocessor);
+        }
+        if (character == '\\') {
+            preprocessor->heldCharactersCount = 1;
+            preprocessor->heldOffset = offset;
+            preprocessor->heldLine = line;
+            preprocessor->heldColumn = column;
+            continue;
+        }
+
+        processCharacter(preprocessor, character, offset, line, column);
+    }
+}
+
+void finishPreprocessing(struct Preprocessor* preprocessor) {
+    releaseHeldCharacters(preprocessor);
+    if ((preprocessor->state == PREPROCESSOR_STATE_CODE) && preprocessor->slashHeld) {
+        preprocessor->slashHeld = False;
+        appendCodeCharacter(preprocessor, '/', preprocessor->slashOffset, preprocessor->slashLine, preprocessor->slashColumn);
+    }
+
+    // Trailing white-spaces are dropped,
+    preprocessor->spaceHeld = False;
+}
+
+void getOriginalPosition(const struct Preprocessor* preprocessor, int32_t preprocessedOffset, int32_t* outOffset, int32_t* outLine, int32_t* outColumn) {
+
+    // Nothing appended, everything was ignorable,
+    int32_t entriesCount = NVector.size(&preprocessor->offsetMap);
+    if (!entriesCount) {
+        *outOffset = preprocessor->originalOffset;
+        *outLine = preprocessor->line;
+        *outColumn = preprocessor->column;
+        return;
+    }
+
+    // The last entry that starts at or before the offset,
+    int32_t low = 0, high = entriesCount - 1;
+    while (low < high) {
+        int32_t middle = (low + high + 1) / 2;
+        struct PreprocessedOffset* entry = NVector.get(&preprocessor->offsetMap, middle);
+        if (entry->preprocessedOffset <= preprocessedOffset) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+
+    struct PreprocessedOffset* entry = NVector.get(&preprocessor->offsetMap, low);
+    int32_t distance = preprocessedOffset - entry->preprocessedOffset;
+    if (distance < 0) distance = 0;
+    *outOffset = entry->originalOffset + distance;
+    *outLine = entry->line;
+    *outColumn = entry->column + distance;
+}
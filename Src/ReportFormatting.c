@@ -0,0 +1,62 @@
+
+//
+// Helpers for the reports and tables printed at the end of a run.
+//
+// The 18th of October, 2026.
+//
+
+#include <ReportFormatting.h>
+
+#include <NString.h>
+#include <NCString.h>
+
+void appendInteger64(struct NString* outString, int64_t value) {
+    char text[24];
+    int32_t index = sizeof(text) - 1;
+    text[index] = 0;
+    boolean negative = value < 0;
+    if (negative) value = -value;
+    do {
+        text[--index] = '0' + (value % 10);
+        value /= 10;
+    } while (value);
+    if (negative) text[--index] = '-';
+    NString.append(outString, "%s", &text[index]);
+}
+
+void appendFixedPoint(struct NString* outString, int64_t value, int32_t decimalsCount) {
+    int64_t divisor = 1;
+    for (int32_t i=0; i<decimalsCount; i++) divisor *= 10;
+    if (value < 0) {
+        NString.append(outString, "-");
+        value = -value;
+    }
+    appendInteger64(outString, value / divisor);
+    NString.append(outString, ".");
+    int64_t fraction = value % divisor;
+    for (divisor /= 10; divisor > 0; divisor /= 10) {
+        NString.append(outString, "%d", (int32_t) (fraction / divisor));
+        fraction %= divisor;
+    }
+}
+
+void appendPadded(struct NString* outString, const char* text, int32_t width, boolean alignRight) {
+    int32_t paddingLength = width - NCString.length(text);
+    if (!alignRight) NString.append(outString, "%s", text);
+    for (int32_t i=0; i<paddingLength; i++) NString.append(outString, " ");
+    if (alignRight) NString.append(outString, "%s", text);
+}
+
+void appendJSONString(struct NString* outString, const char* text) {
+    NString.append(outString, "\"");
+    for (; *text; text++) {
+        char character[2] = { *text, 0 };
+        if ((*text == '"') || (*text == '\\')) NString.append(outString, "\\");
+        if ((uint8_t) *text < ' ') {
+            NString.append(outString, " ");
+        } else {
+            NString.append(outString, "%s", character);
+        }
+    }
+    NString.append(outString, "\"");
+}
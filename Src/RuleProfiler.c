@@ -0,0 +1,386 @@
+
+//
+// Per-rule matcher profiling. A rule's attempt starts at its create listener, and ends at its
+// match listener (success) or its delete listener (failure). Delete listener calls on nodes that
+// already matched mean that a parent backtracked, throwing their text away.
+//
+// Only pushing rules have listeners. Plain rules are matched inside them, so their time shows in
+// their pushing parents' self time.
+//
+// The 18th of October, 2026.
+//
+
+#include <RuleProfiler.h>
+#include <ReportFormatting.h>
+#include <Timing.h>
+
+#include <NCC.h>
+#include <NSystemUtils.h>
+#include <NString.h>
+#include <NVector.h>
+#include <AllocationProfiler.h> // After NSystemUtils.h, to reroute NMALLOC/NFREE.
+
+#include <stdlib.h>
+
+#define MAX_HOT_PATH_LENGTH 24
+
+struct RuleStatistics {
+    NCC_Rule* rule;
+    int64_t attemptsCount;
+    int64_t successesCount;
+    int64_t consumedBytes;
+    int64_t discardedBytes;   // Matched, then thrown away by a backtracking parent.
+    int64_t pushedNodesCount;
+    int64_t inclusiveTime;    // Nanoseconds. Recursive activations are counted once.
+    int64_t selfTime;
+    int32_t activeCount;
+};
+
+// Attempts of a rule directly within another's (root rules have no parent),
+struct RuleEdge {
+    struct RuleStatistics* parent;
+    struct RuleStatistics* child;
+    int64_t attemptsCount;
+};
+
+struct RuleActivation {
+    struct RuleStatistics* statistics;
+    void* node;
+    int64_t startTime;
+    int64_t childrenTime;
+};
+
+static struct NVector ruleStatistics;   // struct RuleStatistics*.
+static struct NVector activations;      // struct RuleActivation.
+
+// Open addressing, rule pointers to statistics,
+static struct RuleStatistics** slots;
+static int32_t slotsCount;
+
+// Same, parent and child statistics to edges,
+static struct NVector ruleEdges;        // struct RuleEdge*.
+static struct RuleEdge** edgeSlots;
+static int32_t edgeSlotsCount;
+
+static int64_t totalAttemptsCount;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper functions
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static int32_t getSlotIndex(NCC_Rule* rule) {
+    uint64_t hash = (uint64_t) (uintptr_t) rule * 0x9e3779b97f4a7c15ull;
+    return (int32_t) (hash >> 40) & (slotsCount - 1);
+}
+
+static void growSlots() {
+    int32_t oldSlotsCount = slotsCount;
+    struct RuleStatistics** oldSlots = slots;
+
+    slotsCount = oldSlotsCount ? oldSlotsCount*2 : 512;
+    slots = NMALLOC(slotsCount * sizeof(struct RuleStatistics*), "RuleProfiler.growSlots() slots");
+    NSystemUtils.memset(slots, 0, slotsCount * sizeof(struct RuleStatistics*));
+
+    for (int32_t i=0; i<oldSlotsCount; i++) {
+        if (!oldSlots[i]) continue;
+        int32_t slotIndex = getSlotIndex(oldSlots[i]->rule);
+        while (slots[slotIndex]) slotIndex = (slotIndex+1) & (slotsCount-1);
+        slots[slotIndex] = oldSlots[i];
+    }
+    if (oldSlots) NFREE(oldSlots, "RuleProfiler.growSlots() oldSlots");
+}
+
+static struct RuleStatistics* getRuleStatistics(NCC_Rule* rule) {
+
+    int32_t slotIndex = getSlotIndex(rule);
+    while (slots[slotIndex]) {
+        if (slots[slotIndex]->rule == rule) return slots[slotIndex];
+        slotIndex = (slotIndex+1) & (slotsCount-1);
+    }
+
+    // First time seen,
+    struct RuleStatistics* statistics = NMALLOC(sizeof(struct RuleStatistics), "RuleProfiler.getRuleStatistics() statistics");
+    NSystemUtils.memset(statistics, 0, sizeof(struct RuleStatistics));
+    statistics->rule = rule;
+    NVector.pushBack(&ruleStatistics, &statistics);
+    slots[slotIndex] = statistics;
+
+    // Keep the load factor under a half,
+    if (NVector.size(&ruleStatistics)*2 > slotsCount) growSlots();
+    return statistics;
+}
+
+static int32_t getEdgeSlotIndex(struct RuleStatistics* parent, struct RuleStatistics* child) {
+    uint64_t hash = ((uint64_t) (uintptr_t) parent * 31 + (uint64_t) (uintptr_t) child) * 0x9e3779b97f4a7c15ull;
+    return (int32_t) (hash >> 40) & (edgeSlotsCount - 1);
+}
+
+static void growEdgeSlots() {
+    int32_t oldEdgeSlotsCount = edgeSlotsCount;
+    struct RuleEdge** oldEdgeSlots = edgeSlots;
+
+    edgeSlotsCount = oldEdgeSlotsCount ? oldEdgeSlotsCount*2 : 1024;
+    edgeSlots = NMALLOC(edgeSlotsCount * sizeof(struct RuleEdge*), "RuleProfiler.growEdgeSlots() edgeSlots");
+    NSystemUtils.memset(edgeSlots, 0, edgeSlotsCount * sizeof(struct RuleEdge*));
+
+    for (int32_t i=0; i<oldEdgeSlotsCount; i++) {
+        if (!oldEdgeSlots[i]) continue;
+        int32_t slotIndex = getEdgeSlotIndex(oldEdgeSlots[i]->parent, oldEdgeSlots[i]->child);
+        while (edgeSlots[slotIndex]) slotIndex = (slotIndex+1) & (edgeSlotsCount-1);
+        edgeSlots[slotIndex] = oldEdgeSlots[i];
+    }
+    if (oldEdgeSlots) NFREE(oldEdgeSlots, "RuleProfiler.growEdgeSlots() oldEdgeSlots");
+}
+
+static struct RuleEdge* getRuleEdge(struct RuleStatistics* parent, struct RuleStatistics* child) {
+
+    int32_t slotIndex = getEdgeSlotIndex(parent, child);
+    while (edgeSlots[slotIndex]) {
+        if ((edgeSlots[slotIndex]->parent == parent) && (edgeSlots[slotIndex]->child == child)) return edgeSlots[slotIndex];
+        slotIndex = (slotIndex+1) & (edgeSlotsCount-1);
+    }
+
+    // First time seen,
+    struct RuleEdge* edge = NMALLOC(sizeof(struct RuleEdge), "RuleProfiler.getRuleEdge() edge");
+    edge->parent = parent;
+    edge->child = child;
+    edge->attemptsCount = 0;
+    NVector.pushBack(&ruleEdges, &edge);
+    edgeSlots[slotIndex] = edge;
+
+    if (NVector.size(&ruleEdges)*2 > edgeSlotsCount) growEdgeSlots();
+    return edge;
+}
+
+static void beginActivation(NCC_Rule* rule, void* node) {
+    struct RuleStatistics* statistics = getRuleStatistics(rule);
+    statistics->attemptsCount++;
+    statistics->activeCount++;
+    totalAttemptsCount++;
+
+    struct RuleActivation* parentActivation = NVector.getLast(&activations);
+    getRuleEdge(parentActivation ? parentActivation->statistics : 0, statistics)->attemptsCount++;
+
+    struct RuleActivation* activation = NVector.emplaceBack(&activations);
+    activation->statistics = statistics;
+    activation->node = node;
+    activation->childrenTime = 0;
+    activation->startTime = getMonotonicTime();
+}
+
+static void endActivation(boolean success, int32_t matchLength) {
+    int64_t endTime = getMonotonicTime();
+    struct RuleActivation activation;
+    if (!NVector.popBack(&activations, &activation)) return;
+
+    struct RuleStatistics* statistics = activation.statistics;
+    int64_t duration = endTime - activation.startTime;
+    statistics->selfTime += duration - activation.childrenTime;
+    if (!--statistics->activeCount) statistics->inclusiveTime += duration;
+    if (success) {
+        statistics->successesCount++;
+        statistics->consumedBytes += matchLength;
+    }
+
+    struct RuleActivation* parentActivation = NVector.getLast(&activations);
+    if (parentActivation) parentActivation->childrenTime += duration;
+}
+
+// True if the delete listener is ending the innermost activation (a failure), rather than
+// discarding an older node,
+static boolean isActiveNode(NCC_ASTNode_Data* node) {
+    struct RuleActivation* activation = NVector.getLast(&activations);
+    return activation && (activation->statistics->rule == node->rule) && (activation->node == node->node);
+}
+
+static void recordDiscardedTree(struct NCC_ASTNode* tree) {
+    if (tree->rule) getRuleStatistics(tree->rule)->discardedBytes += NString.length(&tree->value);
+    int32_t childrenCount = NVector.size(&tree->childNodes);
+    for (int32_t i=0; i<childrenCount; i++) recordDiscardedTree(*(struct NCC_ASTNode**) NVector.get(&tree->childNodes, i));
+}
+
+// The edge that most of the rule's attempts came through, or 0 if none did,
+static struct RuleEdge* getHeaviestEdgeInto(struct RuleStatistics* child) {
+    struct RuleEdge* heaviestEdge = 0;
+    int32_t edgesCount = NVector.size(&ruleEdges);
+    for (int32_t i=0; i<edgesCount; i++) {
+        struct RuleEdge* edge = *(struct RuleEdge**) NVector.get(&ruleEdges, i);
+        if ((edge->child == child) && (!heaviestEdge || (edge->attemptsCount > heaviestEdge->attemptsCount))) heaviestEdge = edge;
+    }
+    return heaviestEdge;
+}
+
+static void freeRuleEdges() {
+    for (int32_t i=NVector.size(&ruleEdges)-1; i>=0; i--) {
+        NFREE(*(struct RuleEdge**) NVector.get(&ruleEdges, i), "RuleProfiler.freeRuleEdges() edge");
+    }
+    NVector.clear(&ruleEdges);
+    NSystemUtils.memset(edgeSlots, 0, edgeSlotsCount * sizeof(struct RuleEdge*));
+}
+
+static int compareAttempts(const void* statistics1, const void* statistics2) {
+    int64_t attempts1 = (*(struct RuleStatistics**) statistics1)->attemptsCount;
+    int64_t attempts2 = (*(struct RuleStatistics**) statistics2)->attemptsCount;
+    return (attempts1 < attempts2) ? 1 : (attempts1 > attempts2) ? -1 : 0;
+}
+
+static int compareInclusiveTimes(const void* statistics1, const void* statistics2) {
+    int64_t time1 = (*(struct RuleStatistics**) statistics1)->inclusiveTime;
+    int64_t time2 = (*(struct RuleStatistics**) statistics2)->inclusiveTime;
+    return (time1 < time2) ? 1 : (time1 > time2) ? -1 : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Profiler
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void initializeRuleProfiler() {
+    NVector.initialize(&ruleStatistics, 0, sizeof(struct RuleStatistics*));
+    NVector.initialize(&activations, 0, sizeof(struct RuleActivation));
+    slots = 0;
+    slotsCount = 0;
+    growSlots();
+    NVector.initialize(&ruleEdges, 0, sizeof(struct RuleEdge*));
+    edgeSlots = 0;
+    edgeSlotsCount = 0;
+    growEdgeSlots();
+    totalAttemptsCount = 0;
+}
+
+void destroyRuleProfiler() {
+    for (int32_t i=NVector.size(&ruleStatistics)-1; i>=0; i--) {
+        NFREE(*(struct RuleStatistics**) NVector.get(&ruleStatistics, i), "RuleProfiler.destroyRuleProfiler() statistics");
+    }
+    NVector.destroy(&ruleStatistics);
+    NVector.destroy(&activations);
+    NFREE(slots, "RuleProfiler.destroyRuleProfiler() slots");
+    freeRuleEdges();
+    NVector.destroy(&ruleEdges);
+    NFREE(edgeSlots, "RuleProfiler.destroyRuleProfiler() edgeSlots");
+}
+
+void resetRuleProfile() {
+    int32_t profiledRulesCount = NVector.size(&ruleStatistics);
+    for (int32_t i=0; i<profiledRulesCount; i++) {
+        struct RuleStatistics* statistics = *(struct RuleStatistics**) NVector.get(&ruleStatistics, i);
+        NCC_Rule* rule = statistics->rule;
+        NSystemUtils.memset(statistics, 0, sizeof(struct RuleStatistics));
+        statistics->rule = rule;
+    }
+    NVector.clear(&activations);
+    freeRuleEdges();
+    totalAttemptsCount = 0;
+}
+
+int64_t getRuleAttemptsCount() {
+    return totalAttemptsCount;
+}
+
+void visitRuleProfile(RuleProfileVisitor visitor, void* data) {
+    int32_t profiledRulesCount = NVector.size(&ruleStatistics);
+    for (int32_t i=0; i<profiledRulesCount; i++) {
+        struct RuleStatistics* statistics = *(struct RuleStatistics**) NVector.get(&ruleStatistics, i);
+        if (statistics->attemptsCount) visitor(statistics->rule, statistics->attemptsCount, statistics->successesCount, data);
+    }
+}
+
+void appendHotRulePaths(struct NString* outText, int32_t rulesCount) {
+
+    int32_t profiledRulesCount = NVector.size(&ruleStatistics);
+    if (rulesCount > profiledRulesCount) rulesCount = profiledRulesCount;
+    qsort(NVector.get(&ruleStatistics, 0), profiledRulesCount, sizeof(struct RuleStatistics*), compareAttempts);
+
+    for (int32_t i=0; i<rulesCount; i++) {
+        struct RuleStatistics* statistics = *(struct RuleStatistics**) NVector.get(&ruleStatistics, i);
+        if (!statistics->attemptsCount) break;
+        NString.append(outText, "    ");
+        appendInteger64(outText, statistics->attemptsCount);
+        NString.append(outText, " attempts, ");
+        appendInteger64(outText, statistics->attemptsCount - statistics->successesCount);
+        NString.append(outText, " failed: ");
+
+        // Up the heaviest edges, the root first. Recursion shows as a repeated rule,
+        struct NVector path;
+        NVector.initialize(&path, 0, sizeof(struct RuleStatistics*));
+        struct RuleStatistics* pathRule = statistics;
+        for (int32_t depth=0; pathRule && (depth < MAX_HOT_PATH_LENGTH); depth++) {
+            boolean repeated = False;
+            for (int32_t j=NVector.size(&path)-1; j>=0; j--) {
+                if (*(struct RuleStatistics**) NVector.get(&path, j) == pathRule) repeated = True;
+            }
+            NVector.pushBack(&path, &pathRule);
+            if (repeated) break;
+            struct RuleEdge* edge = getHeaviestEdgeInto(pathRule);
+            pathRule = edge ? edge->parent : 0;
+        }
+        if (pathRule) NString.append(outText, "... > ");
+        for (int32_t j=NVector.size(&path)-1; j>=0; j--) {
+            const char* ruleName = NString.get(&(*(struct RuleStatistics**) NVector.get(&path, j))->rule->ruleName);
+            NString.append(outText, j ? "%s > " : "%s\n", *ruleName ? ruleName : "\"\"");
+        }
+        NVector.destroy(&path);
+    }
+}
+
+void profiledCreateASTNode(NCC_ASTNode_Data* outNode, NCC_ASTNode_Data* astParentNode) {
+    NCC_createASTNode(outNode, astParentNode);
+    beginActivation(outNode->rule, outNode->node);
+}
+
+void profiledDeleteASTNode(NCC_ASTNode_Data* node, NCC_ASTNode_Data* astParentNode) {
+    if (isActiveNode(node)) {
+        endActivation(False, 0);
+    } else if (node->node) {
+        recordDiscardedTree(node->node);
+    }
+    NCC_deleteASTNode(node, astParentNode);
+}
+
+boolean profiledMatchASTNode(NCC_MatchingData* matchingData) {
+    boolean accepted = NCC_matchASTNode(matchingData);
+    if (accepted) getRuleStatistics(matchingData->node.rule)->pushedNodesCount++;
+    endActivation(accepted, matchingData->matchLength);
+    return accepted;
+}
+
+void logRuleProfile(int32_t rulesCount) {
+
+    int32_t profiledRulesCount = NVector.size(&ruleStatistics);
+    if (rulesCount > profiledRulesCount) rulesCount = profiledRulesCount;
+    qsort(NVector.get(&ruleStatistics, 0), profiledRulesCount, sizeof(struct RuleStatistics*), compareInclusiveTimes);
+
+    // Print a table (times in milliseconds),
+    struct NString table, cell;
+    NString.initialize(&table, "Top %d rules by inclusive time (ms). Profiling overhead is included:\n", rulesCount);
+    NString.initialize(&cell, "");
+    const char* headers[] = { "rule", "attempts", "successes", "failures", "consumed", "discarded", "nodes", "inclusive", "self" };
+    const int32_t widths[] = { 32, 12, 12, 12, 12, 12, 10, 12, 12 };
+    for (int32_t i=0; i<9; i++) appendPadded(&table, headers[i], widths[i], i > 0);
+    NString.append(&table, "\n");
+
+    for (int32_t i=0; i<rulesCount; i++) {
+        struct RuleStatistics* statistics = *(struct RuleStatistics**) NVector.get(&ruleStatistics, i);
+        int64_t values[] = {
+                statistics->attemptsCount, statistics->successesCount, statistics->attemptsCount - statistics->successesCount,
+                statistics->consumedBytes, statistics->discardedBytes, statistics->pushedNodesCount };
+
+        const char* ruleName = NString.get(&statistics->rule->ruleName);
+        appendPadded(&table, *ruleName ? ruleName : "\"\"", widths[0], False);
+        for (int32_t j=0; j<6; j++) {
+            NString.set(&cell, "");
+            appendInteger64(&cell, values[j]);
+            appendPadded(&table, NString.get(&cell), widths[j+1], True);
+        }
+        NString.set(&cell, "");
+        appendFixedPoint(&cell, statistics->inclusiveTime / 1000, 3);
+        appendPadded(&table, NString.get(&cell), widths[7], True);
+        NString.set(&cell, "");
+        appendFixedPoint(&cell, statistics->selfTime / 1000, 3);
+        appendPadded(&table, NString.get(&cell), widths[8], True);
+        NString.append(&table, "\n");
+    }
+
+    NLOGI("", "%s", NString.get(&table));
+    NString.destroy(&table);
+    NString.destroy(&cell);
+}
@@ -0,0 +1,65 @@
+
+//
+// Standard streams, for running inside pipelines.
+//
+// The 18th of October, 2026.
+//
+
+#include <StandardStreams.h>
+
+#include <NError.h>
+
+#ifdef DESKTOP
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+int32_t detachStandardOutput() {
+
+    #ifdef DESKTOP
+    // Whatever is still buffered belongs to the original standard output,
+    fflush(stdout);
+    int32_t outputFileDescriptor = dup(STDOUT_FILENO);
+    if (outputFileDescriptor < 0) return -1;
+    if (dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+        close(outputFileDescriptor);
+        return -1;
+    }
+    return outputFileDescriptor;
+    #else
+    NERROR("StandardStreams.detachStandardOutput()", "Pipe mode is only supported on desktop.");
+    return -1;
+    #endif
+}
+
+int32_t readStandardInput(char* buffer, int32_t maxLength) {
+
+    #ifdef DESKTOP
+    while (True) {
+        ssize_t readBytesCount = read(STDIN_FILENO, buffer, maxLength);
+        if ((readBytesCount < 0) && (errno == EINTR)) continue;
+        return (int32_t) readBytesCount;
+    }
+    #else
+    return -1;
+    #endif
+}
+
+boolean writeToFileDescriptor(int32_t fileDescriptor, const char* data, int32_t length) {
+
+    #ifdef DESKTOP
+    while (length > 0) {
+        ssize_t writtenBytesCount = write(fileDescriptor, data, length);
+        if (writtenBytesCount < 0) {
+            if (errno == EINTR) continue;
+            return False;
+        }
+        data += writtenBytesCount;
+        length -= writtenBytesCount;
+    }
+    return True;
+    #else
+    return False;
+    #endif
+}
@@ -0,0 +1,207 @@
+
+//
+// Per-phase timing. Every phase is kept as an event, and summaries are computed from the events
+// at the end.
+//
+// The 18th of October, 2026.
+//
+
+#include <Timing.h>
+#include <ReportFormatting.h>
+
+#include <NSystemUtils.h>
+#include <NString.h>
+#include <NVector.h>
+#include <NCString.h>
+#include <NError.h>
+
+#include <time.h>
+
+#ifdef DESKTOP
+#include <unistd.h>
+#endif
+
+struct TimingEvent {
+    const char* name;
+    const char* argumentName;
+    int32_t argumentValue;
+    int64_t startTime;   // Nanoseconds.
+    int64_t duration;
+};
+
+struct TimingPhaseSummary {
+    const char* name;
+    int32_t count;
+    int64_t totalDuration, maximumDuration;
+};
+
+boolean timingEnabled = False;
+static struct NVector events;        // struct TimingEvent.
+static struct NVector openEvents;    // int32_t, indices of the events that haven't ended yet.
+static int64_t firstEventTime;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Timing
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int64_t getMonotonicTime() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (int64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+boolean enableTiming() {
+    #if ADDAAT_TIMING
+    if (timingEnabled) return True;
+    NVector.initialize(&events, 1024, sizeof(struct TimingEvent));
+    NVector.initialize(&openEvents, 0, sizeof(int32_t));
+    firstEventTime = getMonotonicTime();
+    timingEnabled = True;
+    return True;
+    #else
+    NERROR("Timing.enableTiming()", "Timing was compiled out. Rebuild with %sADDAAT_TIMING=1%s.", NTCOLOR(HIGHLIGHT), NTCOLOR(STREAM_DEFAULT));
+    return False;
+    #endif
+}
+
+void destroyTiming() {
+    if (!timingEnabled) return;
+    NVector.destroy(&events);
+    NVector.destroy(&openEvents);
+    timingEnabled = False;
+}
+
+void beginTimingPhase(const char* name, const char* argumentName, int32_t argumentValue) {
+    struct TimingEvent* event = NVector.emplaceBack(&events);
+    event->name = name;
+    event->argumentName = argumentName;
+    event->argumentValue = argumentValue;
+    event->duration = -1;
+
+    int32_t eventIndex = NVector.size(&events) - 1;
+    NVector.pushBack(&openEvents, &eventIndex);
+
+    // Last, so that the bookkeeping isn't counted,
+    event->startTime = getMonotonicTime();
+}
+
+void endTimingPhase() {
+    int64_t endTime = getMonotonicTime();
+    int32_t eventIndex;
+    if (!NVector.popBack(&openEvents, &eventIndex)) {
+        NERROR("Timing.endTimingPhase()", "No phase to end.");
+        return;
+    }
+    struct TimingEvent* event = NVector.get(&events, eventIndex);
+    event->duration = endTime - event->startTime;
+}
+
+void logTimingSummary() {
+    if (!timingEnabled) return;
+
+    // Group by name, keeping the order of first appearance,
+    struct NVector summaries;
+    NVector.initialize(&summaries, 0, sizeof(struct TimingPhaseSummary));
+    int64_t wallTime = 0;
+    int32_t eventsCount = NVector.size(&events);
+    for (int32_t i=0; i<eventsCount; i++) {
+        struct TimingEvent* event = NVector.get(&events, i);
+        if (event->duration < 0) continue;
+        int64_t eventEndTime = event->startTime - firstEventTime + event->duration;
+        if (eventEndTime > wallTime) wallTime = eventEndTime;
+
+        struct TimingPhaseSummary* summary = 0;
+        int32_t summariesCount = NVector.size(&summaries);
+        for (int32_t j=0; j<summariesCount; j++) {
+            struct TimingPhaseSummary* currentSummary = NVector.get(&summaries, j);
+            if (NCString.equals(currentSummary->name, event->name)) {
+                summary = currentSummary;
+                break;
+            }
+        }
+        if (!summary) {
+            summary = NVector.emplaceBack(&summaries);
+            NSystemUtils.memset(summary, 0, sizeof(struct TimingPhaseSummary));
+            summary->name = event->name;
+        }
+        summary->count++;
+        summary->totalDuration += event->duration;
+        if (event->duration > summary->maximumDuration) summary->maximumDuration = event->duration;
+    }
+
+    // Print a table (durations in milliseconds),
+    struct NString table, cell;
+    NString.initialize(&table, "Timing (ms, nested phases included in their parents):\n");
+    NString.initialize(&cell, "");
+    const char* headers[] = { "phase", "count", "total", "average", "maximum", "% of wall" };
+    const int32_t widths[] = { 24, 8, 12, 12, 12, 10 };
+    for (int32_t i=0; i<6; i++) {
+        NString.set(&cell, "%s", headers[i]);
+        appendPadded(&table, NString.get(&cell), widths[i], i > 0);
+    }
+    NString.append(&table, "\n");
+
+    int32_t summariesCount = NVector.size(&summaries);
+    for (int32_t i=0; i<summariesCount; i++) {
+        struct TimingPhaseSummary* summary = NVector.get(&summaries, i);
+        NString.set(&cell, "%s", summary->name);
+        appendPadded(&table, NString.get(&cell), widths[0], False);
+        NString.set(&cell, "%d", summary->count);
+        appendPadded(&table, NString.get(&cell), widths[1], True);
+        NString.set(&cell, "");
+        appendFixedPoint(&cell, summary->totalDuration / 1000, 3);
+        appendPadded(&table, NString.get(&cell), widths[2], True);
+        NString.set(&cell, "");
+        appendFixedPoint(&cell, summary->totalDuration / summary->count / 1000, 3);
+        appendPadded(&table, NString.get(&cell), widths[3], True);
+        NString.set(&cell, "");
+        appendFixedPoint(&cell, summary->maximumDuration / 1000, 3);
+        appendPadded(&table, NString.get(&cell), widths[4], True);
+        NString.set(&cell, "");
+        appendFixedPoint(&cell, wallTime ? (summary->totalDuration * 1000 / wallTime) : 0, 1);
+        appendPadded(&table, NString.get(&cell), widths[5], True);
+        NString.append(&table, "\n");
+    }
+    NString.append(&table, "Wall time: ");
+    appendFixedPoint(&table, wallTime / 1000, 3);
+    NString.append(&table, " ms\n");
+
+    NLOGI("", "%s", NString.get(&table));
+    NString.destroy(&table);
+    NString.destroy(&cell);
+    NVector.destroy(&summaries);
+}
+
+boolean writeTimingTrace(const char* filePath) {
+    if (!timingEnabled) return False;
+
+    int32_t processId = 0;
+    #ifdef DESKTOP
+    processId = getpid();
+    #endif
+
+    // Complete ("X") events, timestamps in microseconds,
+    struct NString trace;
+    NString.initialize(&trace, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    boolean firstEvent = True;
+    int32_t eventsCount = NVector.size(&events);
+    for (int32_t i=0; i<eventsCount; i++) {
+        struct TimingEvent* event = NVector.get(&events, i);
+        if (event->duration < 0) continue;
+
+        if (!firstEvent) NString.append(&trace, ",\n");
+        firstEvent = False;
+        NString.append(&trace, "  {\"name\": \"%s\", \"cat\": \"addaat\", \"ph\": \"X\", \"pid\": %d, \"tid\": 0, \"ts\": ", event->name, processId);
+        appendFixedPoint(&trace, event->startTime - firstEventTime, 3);
+        NString.append(&trace, ", \"dur\": ");
+        appendFixedPoint(&trace, event->duration, 3);
+        if (event->argumentName) NString.append(&trace, ", \"args\": {\"%s\": %d}", event->argumentName, event->argumentValue);
+        NString.append(&trace, "}");
+    }
+    NString.append(&trace, "\n]}\n");
+
+    boolean success = NSystemUtils.writeToFile(filePath, NString.get(&trace), NString.length(&trace), False);
+    if (!success) NERROR("Timing.writeTimingTrace()", "Couldn't write: %s%s%s", NTCOLOR(HIGHLIGHT), filePath, NTCOLOR(STREAM_DEFAULT));
+    NString.destroy(&trace);
+    return success;
+}
@@ -0,0 +1,267 @@
+
+//
+// On-disk translation cache. Each entry is a file named after its key, and the files'
+// modification times double as the LRU order.
+//
+// The 18th of October, 2026.
+//
+
+#include <TranslationCache.h>
+
+#include <NSystemUtils.h>
+#include <NString.h>
+#include <NVector.h>
+#include <NCString.h>
+#include <NError.h>
+#include <AllocationProfiler.h> // After NSystemUtils.h, to reroute NMALLOC/NFREE.
+
+#ifdef DESKTOP
+#include <stdio.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+struct TranslationCacheStatistics {
+    volatile int64_t hitsCount;
+    volatile int64_t missesCount;
+    volatile int64_t storesCount;
+    volatile int64_t evictionsCount;
+    volatile int64_t hitBytes;
+};
+
+struct TranslationCache {
+    struct NString directoryPath;
+    int64_t maximumSize;
+    struct TranslationCacheStatistics* statistics;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper functions
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void atomicIncrement(volatile int64_t* value, int64_t amount) {
+    __atomic_fetch_add(value, amount, __ATOMIC_RELAXED);
+}
+
+static void appendHexadecimal(struct NString* outString, uint64_t value) {
+    static const char digits[] = "0123456789abcdef";
+    char text[17];
+    for (int32_t i=15; i>=0; i--) {
+        text[i] = digits[value & 0xf];
+        value >>= 4;
+    }
+    text[16] = 0;
+    NString.append(outString, "%s", text);
+}
+
+static void getEntryPath(struct TranslationCache* cache, const char* key, struct NString* outPath) {
+    NString.set(outPath, "%s/%s.c", NString.get(&cache->directoryPath), key);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Cache
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct TranslationCache* createTranslationCache(const char* directoryPath, int64_t maximumSizeInBytes) {
+
+    #ifdef DESKTOP
+    if (mkdir(directoryPath, 0755) && (access(directoryPath, W_OK) != 0)) {
+        NERROR("TranslationCache.createTranslationCache()", "Couldn't create cache directory: %s%s%s", NTCOLOR(HIGHLIGHT), directoryPath, NTCOLOR(STREAM_DEFAULT));
+        return 0;
+    }
+
+    struct TranslationCacheStatistics* statistics = mmap(0, sizeof(struct TranslationCacheStatistics), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (statistics == MAP_FAILED) return 0;
+    NSystemUtils.memset(statistics, 0, sizeof(struct TranslationCacheStatistics));
+
+    struct TranslationCache* cache = NMALLOC(sizeof(struct TranslationCache), "TranslationCache.createTranslationCache() cache");
+    NString.initialize(&cache->directoryPath, "%s", directoryPath);
+    cache->maximumSize = maximumSizeInBytes;
+    cache->statistics = statistics;
+    return cache;
+    #else
+    NERROR("TranslationCache.createTranslationCache()", "Translation caching is only available on desktop.");
+    return 0;
+    #endif
+}
+
+void destroyAndDeleteTranslationCache(struct TranslationCache* cache) {
+    #ifdef DESKTOP
+    munmap(cache->statistics, sizeof(struct TranslationCacheStatistics));
+    #endif
+    NString.destroy(&cache->directoryPath);
+    NFREE(cache, "TranslationCache.destroyAndDeleteTranslationCache() cache");
+}
+
+void computeTranslationCacheKey(const char* code, int32_t codeLength, const char* configuration, struct NString* outKey) {
+
+    // Two independent 64-bit hashes (FNV-1a and a multiply-rotate one) over the code, then the
+    // configuration, with a separator byte between them,
+    uint64_t fnvHash = 0xcbf29ce484222325ULL;
+    uint64_t rotatingHash = 0x9e3779b97f4a7c15ULL ^ (uint64_t) codeLength;
+    for (int32_t i=0; i<codeLength; i++) {
+        uint8_t byte = (uint8_t) code[i];
+        fnvHash = (fnvHash ^ byte) * 0x100000001b3ULL;
+        rotatingHash = ((rotatingHash ^ byte) * 0xff51afd7ed558ccdULL);
+        rotatingHash ^= rotatingHash >> 29;
+    }
+    fnvHash = (fnvHash ^ 0xff) * 0x100000001b3ULL;
+    for (const char* character = configuration; *character; character++) {
+        uint8_t byte = (uint8_t) *character;
+        fnvHash = (fnvHash ^ byte) * 0x100000001b3ULL;
+        rotatingHash = ((rotatingHash ^ byte) * 0xff51afd7ed558ccdULL);
+        rotatingHash ^= rotatingHash >> 29;
+    }
+
+    NString.set(outKey, "");
+    appendHexadecimal(outKey, fnvHash);
+    appendHexadecimal(outKey, rotatingHash);
+}
+
+boolean getTranslatorBuildIdentifier(struct NString* outIdentifier) {
+
+    #ifdef DESKTOP
+    int fileDescriptor = open("/proc/self/exe", O_RDONLY);
+    if (fileDescriptor < 0) return False;
+
+    // FNV-1a over the whole executable,
+    int32_t bufferSize = 64 * 1024;
+    uint8_t* buffer = NMALLOC(bufferSize, "TranslationCache.getTranslatorBuildIdentifier() buffer");
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    ssize_t readBytesCount;
+    while ((readBytesCount = read(fileDescriptor, buffer, bufferSize)) > 0) {
+        for (ssize_t i=0; i<readBytesCount; i++) hash = (hash ^ buffer[i]) * 0x100000001b3ULL;
+    }
+    NFREE(buffer, "TranslationCache.getTranslatorBuildIdentifier() buffer");
+    close(fileDescriptor);
+    if (readBytesCount < 0) return False;
+
+    NString.set(outIdentifier, "");
+    appendHexadecimal(outIdentifier, hash);
+    return True;
+    #else
+    return False;
+    #endif
+}
+
+boolean getCachedTranslation(struct TranslationCache* cache, const char* key, struct NString* outCode) {
+
+    boolean hit = False;
+    #ifdef DESKTOP
+    struct NString entryPath;
+    NString.initialize(&entryPath, "");
+    getEntryPath(cache, key, &entryPath);
+
+    struct stat entryStat;
+    if (!stat(NString.get(&entryPath), &entryStat)) {
+        int32_t entrySize = (int32_t) entryStat.st_size;
+        char* code = NMALLOC(entrySize+1, "TranslationCache.getCachedTranslation() code");
+        NSystemUtils.readFromFile(NString.get(&entryPath), False, 0, 0, code);
+        code[entrySize] = 0;
+        NString.set(outCode, "%s", code);
+        NFREE(code, "TranslationCache.getCachedTranslation() code");
+
+        // Mark as recently used,
+        utime(NString.get(&entryPath), 0);
+        atomicIncrement(&cache->statistics->hitBytes, entrySize);
+        hit = True;
+    }
+    NString.destroy(&entryPath);
+    #endif
+
+    atomicIncrement(hit ? &cache->statistics->hitsCount : &cache->statistics->missesCount, 1);
+    return hit;
+}
+
+void putCachedTranslation(struct TranslationCache* cache, const char* key, const char* code, int32_t codeLength) {
+
+    #ifdef DESKTOP
+    // Write to a temporary file first, then rename, so that concurrent readers never see
+    // partial entries,
+    struct NString entryPath, temporaryPath;
+    NString.initialize(&entryPath, "");
+    getEntryPath(cache, key, &entryPath);
+    NString.initialize(&temporaryPath, "%s.%d.tmp", NString.get(&entryPath), (int32_t) getpid());
+
+    if (NSystemUtils.writeToFile(NString.get(&temporaryPath), code, codeLength, False) &&
+        !rename(NString.get(&temporaryPath), NString.get(&entryPath))) {
+        atomicIncrement(&cache->statistics->storesCount, 1);
+    } else {
+        unlink(NString.get(&temporaryPath));
+    }
+
+    NString.destroy(&temporaryPath);
+    NString.destroy(&entryPath);
+    #endif
+}
+
+#ifdef DESKTOP
+struct CacheEntry {
+    struct NString* path;
+    int64_t size;
+    int64_t lastUseTime;
+};
+
+static int compareCacheEntries(const void* entry1, const void* entry2) {
+    int64_t time1 = ((const struct CacheEntry*) entry1)->lastUseTime;
+    int64_t time2 = ((const struct CacheEntry*) entry2)->lastUseTime;
+    return (time1 > time2) - (time1 < time2);
+}
+#endif
+
+void trimTranslationCache(struct TranslationCache* cache) {
+
+    #ifdef DESKTOP
+    DIR* directory = opendir(NString.get(&cache->directoryPath));
+    if (!directory) return;
+
+    // List entries,
+    struct NVector entries;
+    NVector.initialize(&entries, 0, sizeof(struct CacheEntry));
+    int64_t totalSize = 0;
+    struct dirent* directoryEntry;
+    while ((directoryEntry = readdir(directory))) {
+        if (!NCString.endsWith(directoryEntry->d_name, ".c")) continue;
+
+        struct CacheEntry entry;
+        entry.path = NString.create("%s/%s", NString.get(&cache->directoryPath), directoryEntry->d_name);
+        struct stat entryStat;
+        if (stat(NString.get(entry.path), &entryStat)) {
+            NString.destroyAndFree(entry.path);
+            continue;
+        }
+        entry.size = entryStat.st_size;
+        entry.lastUseTime = (int64_t) entryStat.st_mtim.tv_sec * 1000000000 + entryStat.st_mtim.tv_nsec;
+        totalSize += entry.size;
+        NVector.pushBack(&entries, &entry);
+    }
+    closedir(directory);
+
+    // Evict, least recently used first,
+    int32_t entriesCount = NVector.size(&entries);
+    if (totalSize > cache->maximumSize) qsort(NVector.get(&entries, 0), entriesCount, sizeof(struct CacheEntry), compareCacheEntries);
+    for (int32_t i=0; i<entriesCount; i++) {
+        struct CacheEntry* entry = NVector.get(&entries, i);
+        if ((totalSize > cache->maximumSize) && !unlink(NString.get(entry->path))) {
+            totalSize -= entry->size;
+            atomicIncrement(&cache->statistics->evictionsCount, 1);
+        }
+        NString.destroyAndFree(entry->path);
+    }
+    NVector.destroy(&entries);
+    #endif
+}
+
+void logTranslationCacheStatistics(struct TranslationCache* cache) {
+    struct TranslationCacheStatistics* statistics = cache->statistics;
+    int64_t lookupsCount = statistics->hitsCount + statistics->missesCount;
+    int32_t hitRatePercent = lookupsCount ? (int32_t) ((statistics->hitsCount * 100) / lookupsCount) : 0;
+    NLOGI("TranslationCache", "Hits: %d (%d%s, %d KB), misses: %d, stores: %d, evictions: %d.",
+            (int32_t) statistics->hitsCount, hitRatePercent, "%", (int32_t) (statistics->hitBytes / 1024),
+            (int32_t) statistics->missesCount, (int32_t) statistics->storesCount, (int32_t) statistics->evictionsCount);
+}
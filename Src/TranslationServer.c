@@ -0,0 +1,363 @@
+
+//
+// Translation server. Keeps a defined grammar warm, and forks a handler per request so that
+// requests run concurrently and a stuck one can't take the server down with it.
+//
+// The 18th of October, 2026.
+//
+
+#include <TranslationServer.h>
+
+#include <NSystemUtils.h>
+#include <NString.h>
+#include <NCString.h>
+#include <NError.h>
+#include <AllocationProfiler.h> // After NSystemUtils.h, to reroute NMALLOC/NFREE.
+
+#ifdef DESKTOP
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#endif
+
+#ifdef DESKTOP
+
+// Neither side accepts larger blocks. Well within the int32 sizes everything below works with,
+#define MAX_BLOCK_LENGTH (64 * 1024 * 1024)
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper functions
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static boolean writeAll(int fileDescriptor, const void* data, int32_t size) {
+    const char* bytes = data;
+    while (size > 0) {
+        ssize_t writtenBytesCount = write(fileDescriptor, bytes, size);
+        if (writtenBytesCount < 0) {
+            if (errno == EINTR) continue;
+            return False;
+        }
+        bytes += writtenBytesCount;
+        size -= writtenBytesCount;
+    }
+    return True;
+}
+
+static boolean readAll(int fileDescriptor, void* data, int32_t size) {
+    char* bytes = data;
+    while (size > 0) {
+        ssize_t readBytesCount = read(fileDescriptor, bytes, size);
+        if (readBytesCount < 0) {
+            if (errno == EINTR) continue;
+            return False;
+        }
+        if (!readBytesCount) return False;
+        bytes += readBytesCount;
+        size -= readBytesCount;
+    }
+    return True;
+}
+
+static boolean writeLength(int fileDescriptor, uint32_t length) {
+    uint8_t bytes[4] = { length, length >> 8, length >> 16, length >> 24 };
+    return writeAll(fileDescriptor, bytes, 4);
+}
+
+static boolean readLength(int fileDescriptor, uint32_t* outLength) {
+    uint8_t bytes[4];
+    if (!readAll(fileDescriptor, bytes, 4)) return False;
+    *outLength = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+    return True;
+}
+
+static boolean writeBlock(int fileDescriptor, const char* data, uint32_t length) {
+    return writeLength(fileDescriptor, length) && writeAll(fileDescriptor, data, length);
+}
+
+// Returns a null-terminated block, or 0,
+static char* readBlock(int fileDescriptor, uint32_t* outLength, const char* tag) {
+    if (!readLength(fileDescriptor, outLength)) return 0;
+    if (*outLength > MAX_BLOCK_LENGTH) {
+        NERROR("TranslationServer.readBlock()", "Block too large: %s%u%s bytes.", NTCOLOR(HIGHLIGHT), *outLength, NTCOLOR(STREAM_DEFAULT));
+        return 0;
+    }
+    char* block = NMALLOC((int32_t) *outLength + 1, tag);
+    if (!readAll(fileDescriptor, block, *outLength)) {
+        NFREE(block, tag);
+        return 0;
+    }
+    block[*outLength] = 0;
+    return block;
+}
+
+// Removes what's at the socket path only if it's a socket nobody's listening on anymore (a server
+// that didn't exit cleanly). Anything else, a live server's socket or a file, is left alone,
+static boolean claimSocketPath(const char* socketPath, const struct sockaddr_un* address) {
+
+    struct stat pathStat;
+    if (lstat(socketPath, &pathStat)) return errno == ENOENT;
+    if (!S_ISSOCK(pathStat.st_mode)) return False;
+
+    int probeDescriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probeDescriptor < 0) return False;
+    boolean stale = connect(probeDescriptor, (const struct sockaddr*) address, sizeof(struct sockaddr_un)) && (errno == ECONNREFUSED);
+    close(probeDescriptor);
+    return stale && !unlink(socketPath);
+}
+
+static int createSocket(const char* socketPath, struct sockaddr_un* outAddress) {
+
+    if (NCString.length(socketPath) >= (int32_t) sizeof(outAddress->sun_path)) {
+        NERROR("TranslationServer.createSocket()", "Socket path too long: %s%s%s", NTCOLOR(HIGHLIGHT), socketPath, NTCOLOR(STREAM_DEFAULT));
+        return -1;
+    }
+
+    int socketDescriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socketDescriptor < 0) {
+        NERROR("TranslationServer.createSocket()", "Couldn't create socket.");
+        return -1;
+    }
+
+    NSystemUtils.memset(outAddress, 0, sizeof(struct sockaddr_un));
+    outAddress->sun_family = AF_UNIX;
+    NSystemUtils.memcpy(outAddress->sun_path, socketPath, NCString.length(socketPath));
+    return socketDescriptor;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Server
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static volatile sig_atomic_t serverInterrupted = 0;
+static volatile int requestClientDescriptor = -1;
+
+static void onServerInterrupted(int signalNumber) {
+    serverInterrupted = 1;
+}
+
+static void onRequestTimedOut(int signalNumber) {
+
+    // Only async-signal-safe calls from here,
+    static const char reply[] = {
+        TRANSLATION_REPLY_TIMED_OUT,
+        0, 0, 0, 0,
+        18, 0, 0, 0, 'R', 'e', 'q', 'u', 'e', 's', 't', ' ', 't', 'i', 'm', 'e', 'd', ' ', 'o', 'u', 't', '\n' };
+    if (requestClientDescriptor >= 0) writeAll(requestClientDescriptor, reply, sizeof(reply));
+    _exit(1);
+}
+
+static void handleRequest(struct NCC* ncc, int clientDescriptor, int32_t timeoutSeconds, ServerTranslator translator, void* translatorData) {
+
+    requestClientDescriptor = clientDescriptor;
+    signal(SIGALRM, onRequestTimedOut);
+    alarm(timeoutSeconds);
+
+    // Everything logged while handling the request becomes its diagnostics,
+    FILE* diagnosticsFile = tmpfile();
+    if (diagnosticsFile) {
+        fflush(stdout);
+        fflush(stderr);
+        dup2(fileno(diagnosticsFile), STDOUT_FILENO);
+        dup2(fileno(diagnosticsFile), STDERR_FILENO);
+    }
+
+    // Read request,
+    char requestType;
+    uint32_t payloadLength;
+    const char* payloadTag = "TranslationServer.handleRequest() payload";
+    if (!readAll(clientDescriptor, &requestType, 1)) return;
+    char* payload = readBlock(clientDescriptor, &payloadLength, payloadTag);
+    if (!payload) return;
+
+    // Get the code,
+    char* code = 0;
+    if (requestType == TRANSLATION_REQUEST_SOURCE) {
+        code = payload;
+        payload = 0;
+    } else if (requestType == TRANSLATION_REQUEST_PATH) {
+        struct stat fileStat;
+        if (stat(payload, &fileStat) || !S_ISREG(fileStat.st_mode)) {
+            NERROR("TranslationServer.handleRequest()", "Couldn't read file: %s%s%s", NTCOLOR(HIGHLIGHT), payload, NTCOLOR(STREAM_DEFAULT));
+        } else if (fileStat.st_size > MAX_BLOCK_LENGTH) {
+            NERROR("TranslationServer.handleRequest()", "File too large: %s%s%s", NTCOLOR(HIGHLIGHT), payload, NTCOLOR(STREAM_DEFAULT));
+        } else {
+            code = NMALLOC(fileStat.st_size + 1, payloadTag);
+            NSystemUtils.readFromFile(payload, False, 0, 0, code);
+            code[fileStat.st_size] = 0;
+        }
+    } else {
+        NERROR("TranslationServer.handleRequest()", "Unknown request type: %d", (int32_t) requestType);
+    }
+    if (payload) NFREE(payload, payloadTag);
+
+    // Translate,
+    struct NString generatedCode;
+    NString.initialize(&generatedCode, "");
+    boolean success = code && translator(ncc, code, &generatedCode, translatorData);
+    if (code) NFREE(code, payloadTag);
+
+    // Collect diagnostics,
+    char* diagnostics = 0;
+    uint32_t diagnosticsLength = 0;
+    const char* diagnosticsTag = "TranslationServer.handleRequest() diagnostics";
+    if (diagnosticsFile) {
+        fflush(stdout);
+        fflush(stderr);
+        diagnosticsLength = (uint32_t) ftell(diagnosticsFile);
+        diagnostics = NMALLOC(diagnosticsLength + 1, diagnosticsTag);
+        rewind(diagnosticsFile);
+        diagnosticsLength = fread(diagnostics, 1, diagnosticsLength, diagnosticsFile);
+    }
+
+    // Reply,
+    alarm(0);
+    char status = success ? TRANSLATION_REPLY_SUCCEEDED : TRANSLATION_REPLY_FAILED;
+    writeAll(clientDescriptor, &status, 1);
+    writeBlock(clientDescriptor, NString.get(&generatedCode), NString.length(&generatedCode));
+    writeBlock(clientDescriptor, diagnostics ? diagnostics : "", diagnosticsLength);
+
+    if (diagnostics) NFREE(diagnostics, diagnosticsTag);
+    NString.destroy(&generatedCode);
+}
+
+boolean runTranslationServer(struct NCC* ncc, const char* socketPath, int32_t timeoutSeconds, ServerTranslator translator, void* translatorData) {
+
+    struct sockaddr_un address;
+    int serverDescriptor = createSocket(socketPath, &address);
+    if (serverDescriptor < 0) return False;
+
+    // Take over stale sockets left by servers that didn't exit cleanly,
+    if (!claimSocketPath(socketPath, &address)) {
+        NERROR("TranslationServer.runTranslationServer()", "Path in use: %s%s%s", NTCOLOR(HIGHLIGHT), socketPath, NTCOLOR(STREAM_DEFAULT));
+        close(serverDescriptor);
+        return False;
+    }
+    if (bind(serverDescriptor, (struct sockaddr*) &address, sizeof(address)) || listen(serverDescriptor, 64)) {
+        NERROR("TranslationServer.runTranslationServer()", "Couldn't listen on: %s%s%s", NTCOLOR(HIGHLIGHT), socketPath, NTCOLOR(STREAM_DEFAULT));
+        close(serverDescriptor);
+        return False;
+    }
+
+    // Interrupt accept() instead of restarting it, so that we get to clean up,
+    struct sigaction interruptAction;
+    NSystemUtils.memset(&interruptAction, 0, sizeof(interruptAction));
+    interruptAction.sa_handler = onServerInterrupted;
+    sigaction(SIGINT , &interruptAction, 0);
+    sigaction(SIGTERM, &interruptAction, 0);
+    signal(SIGPIPE, SIG_IGN);
+    NLOGI("TranslationServer", "Listening on %s%s%s", NTCOLOR(HIGHLIGHT), socketPath, NTCOLOR(STREAM_DEFAULT));
+
+    int32_t requestsCount = 0;
+    while (!serverInterrupted) {
+
+        // Reap finished handlers,
+        while (waitpid(-1, 0, WNOHANG) > 0);
+
+        int clientDescriptor = accept(serverDescriptor, 0, 0);
+        if (clientDescriptor < 0) continue;
+
+        // Don't let the handler inherit (and repeat) pending output,
+        fflush(stdout);
+        fflush(stderr);
+        pid_t processId = fork();
+        if (processId == 0) {
+            close(serverDescriptor);
+            handleRequest(ncc, clientDescriptor, timeoutSeconds, translator, translatorData);
+            close(clientDescriptor);
+            _exit(0);
+        }
+        if (processId < 0) NERROR("TranslationServer.runTranslationServer()", "Couldn't fork a request handler.");
+        close(clientDescriptor);
+        requestsCount++;
+    }
+
+    // Clean up,
+    while (wait(0) > 0);
+    close(serverDescriptor);
+    unlink(socketPath);
+    NLOGI("TranslationServer", "Served %d request(s).", requestsCount);
+    return True;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Client
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boolean runTranslationClient(const char* socketPath, const char* filePath, boolean sendSource) {
+
+    struct sockaddr_un address;
+    int socketDescriptor = createSocket(socketPath, &address);
+    if (socketDescriptor < 0) return False;
+    if (connect(socketDescriptor, (struct sockaddr*) &address, sizeof(address))) {
+        NERROR("TranslationServer.runTranslationClient()", "Couldn't connect to: %s%s%s", NTCOLOR(HIGHLIGHT), socketPath, NTCOLOR(STREAM_DEFAULT));
+        close(socketDescriptor);
+        return False;
+    }
+
+    // Send request,
+    boolean sent;
+    if (sendSource) {
+        struct stat fileStat;
+        if (stat(filePath, &fileStat)) {
+            NERROR("TranslationServer.runTranslationClient()", "Couldn't read file: %s%s%s", NTCOLOR(HIGHLIGHT), filePath, NTCOLOR(STREAM_DEFAULT));
+            close(socketDescriptor);
+            return False;
+        }
+        if (fileStat.st_size > MAX_BLOCK_LENGTH) {
+            NERROR("TranslationServer.runTranslationClient()", "File too large to send: %s%s%s", NTCOLOR(HIGHLIGHT), filePath, NTCOLOR(STREAM_DEFAULT));
+            close(socketDescriptor);
+            return False;
+        }
+        char* code = NMALLOC(fileStat.st_size + 1, "TranslationServer.runTranslationClient() code");
+        NSystemUtils.readFromFile(filePath, False, 0, 0, code);
+        char requestType = TRANSLATION_REQUEST_SOURCE;
+        sent = writeAll(socketDescriptor, &requestType, 1) && writeBlock(socketDescriptor, code, fileStat.st_size);
+        NFREE(code, "TranslationServer.runTranslationClient() code");
+    } else {
+        // The server might be running somewhere else,
+        char* absolutePath = realpath(filePath, 0);
+        char requestType = TRANSLATION_REQUEST_PATH;
+        const char* path = absolutePath ? absolutePath : filePath;
+        sent = writeAll(socketDescriptor, &requestType, 1) && writeBlock(socketDescriptor, path, NCString.length(path));
+        free(absolutePath);
+    }
+
+    // Receive reply,
+    char status = TRANSLATION_REPLY_FAILED;
+    uint32_t generatedCodeLength, diagnosticsLength;
+    char *generatedCode = 0, *diagnostics = 0;
+    boolean received = sent &&
+            readAll(socketDescriptor, &status, 1) &&
+            (generatedCode = readBlock(socketDescriptor, &generatedCodeLength, "TranslationServer.runTranslationClient() generatedCode")) &&
+            (diagnostics = readBlock(socketDescriptor, &diagnosticsLength, "TranslationServer.runTranslationClient() diagnostics"));
+    close(socketDescriptor);
+    if (!received) NERROR("TranslationServer.runTranslationClient()", "Connection lost before receiving the reply.");
+
+    // Output,
+    if (diagnostics) writeAll(STDERR_FILENO, diagnostics, diagnosticsLength);
+    if (generatedCode) writeAll(STDOUT_FILENO, generatedCode, generatedCodeLength);
+    if (diagnostics) NFREE(diagnostics, "TranslationServer.runTranslationClient() diagnostics");
+    if (generatedCode) NFREE(generatedCode, "TranslationServer.runTranslationClient() generatedCode");
+
+    return received && (status == TRANSLATION_REPLY_SUCCEEDED);
+}
+
+#else
+
+boolean runTranslationServer(struct NCC* ncc, const char* socketPath, int32_t timeoutSeconds, ServerTranslator translator, void* translatorData) {
+    NERROR("TranslationServer.runTranslationServer()", "The translation server is only available on desktop.");
+    return False;
+}
+
+boolean runTranslationClient(const char* socketPath, const char* filePath, boolean sendSource) {
+    NERROR("TranslationServer.runTranslationClient()", "The translation client is only available on desktop.");
+    return False;
+}
+
+#endif
@@ -0,0 +1,126 @@
+
+//
+// Grammar equivalence checking. Grammar changes meant as optimizations (like ordered choices) must
+// not change the matched trees. Both grammars match the same files, and the trees are compared
+// node by node (names, values and children).
+//
+// The 18th of October, 2026.
+//
+
+#include <TreeComparison.h>
+#include <LanguageDefinition.h>
+
+#include <NCC.h>
+#include <NSystemUtils.h>
+#include <NString.h>
+#include <NVector.h>
+#include <NCString.h>
+#include <NError.h>
+#include <AllocationProfiler.h> // After NSystemUtils.h, to reroute NMALLOC/NFREE.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helper functions
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns False at the first difference. The names from the root down to it are left in outPath
+// (const char* names), and what differs in outDifference,
+static boolean compareTrees(struct NCC_ASTNode* tree, struct NCC_ASTNode* referenceTree, struct NVector* outPath, struct NString* outDifference) {
+
+    const char* name = NString.get(&referenceTree->name);
+    NVector.pushBack(outPath, &name);
+    if (!NCString.equals(NString.get(&tree->name), name)) {
+        NString.set(outDifference, "named %s instead", NString.get(&tree->name));
+        return False;
+    }
+    if (!NCString.equals(NString.get(&tree->value), NString.get(&referenceTree->value))) {
+        NString.set(outDifference, "value \"%s\" instead of \"%s\"", NString.get(&tree->value), NString.get(&referenceTree->value));
+        return False;
+    }
+
+    int32_t childrenCount = NVector.size(&tree->childNodes);
+    int32_t referenceChildrenCount = NVector.size(&referenceTree->childNodes);
+    if (childrenCount != referenceChildrenCount) {
+        NString.set(outDifference, "%d children instead of %d", childrenCount, referenceChildrenCount);
+        return False;
+    }
+    for (int32_t i=0; i<childrenCount; i++) {
+        struct NCC_ASTNode* child = *(struct NCC_ASTNode**) NVector.get(&tree->childNodes, i);
+        struct NCC_ASTNode* referenceChild = *(struct NCC_ASTNode**) NVector.get(&referenceTree->childNodes, i);
+        if (!compareTrees(child, referenceChild, outPath, outDifference)) return False;
+    }
+
+    NVector.popBack(outPath, &name);
+    return True;
+}
+
+// Returns the length of the match, or -1 if it doesn't match the whole code,
+static int32_t matchTree(struct NCC* ncc, const char* code, NCC_ASTNode_Data* outTree) {
+    NCC_MatchingResult matchingResult;
+    outTree->node = 0;
+    if (!NCC_match(ncc, getRootRule(ncc), code, &matchingResult, outTree)) return -1;
+    if (matchingResult.matchLength == NCString.length(code)) return matchingResult.matchLength;
+    if (outTree->node) NCC_deleteASTNode(outTree, 0);
+    outTree->node = 0;
+    return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tree comparison
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+boolean compareGrammarTrees(struct NCC* ncc, struct NCC* referenceNcc, struct NVector* inputFiles) {
+
+    boolean success = True;
+    struct NVector path;
+    struct NString difference;
+    NVector.initialize(&path, 0, sizeof(const char*));
+    NString.initialize(&difference, "");
+    int32_t filesCount = NVector.size(inputFiles);
+    for (int32_t i=0; i<filesCount; i++) {
+        const char* filePath = *(const char**) NVector.get(inputFiles, i);
+
+        // Read,
+        int32_t fileSize = NSystemUtils.getFileSize(filePath, False);
+        if (fileSize < 0) fileSize = 0;
+        char* code = NMALLOC(fileSize+1, "TreeComparison.compareGrammarTrees() code");
+        NSystemUtils.readFromFile(filePath, False, 0, 0, code);
+        code[fileSize] = 0;
+
+        // Match with both, a file neither grammar matches is still the same,
+        NCC_ASTNode_Data tree, referenceTree;
+        int32_t matchLength = matchTree(ncc, code, &tree);
+        int32_t referenceMatchLength = matchTree(referenceNcc, code, &referenceTree);
+        NFREE(code, "TreeComparison.compareGrammarTrees() code");
+
+        boolean same;
+        NVector.clear(&path);
+        if ((matchLength < 0) || (referenceMatchLength < 0)) {
+            same = matchLength == referenceMatchLength;
+            if (!same) NString.set(&difference, "only the %s grammar matches", (matchLength < 0) ? "reference" : "checked");
+        } else if (!tree.node || !referenceTree.node) {
+            same = !tree.node && !referenceTree.node;
+            if (!same) NString.set(&difference, "only one grammar produced a tree");
+        } else {
+            same = compareTrees(tree.node, referenceTree.node, &path, &difference);
+        }
+
+        // Log before deleting the trees, the path points into the reference one,
+        if (same) {
+            NLOGI("TreeComparison", "%s: same trees.", filePath);
+        } else {
+            struct NString pathText;
+            NString.initialize(&pathText, "");
+            int32_t depth = NVector.size(&path);
+            for (int32_t j=0; j<depth; j++) NString.append(&pathText, "/%s", *(const char**) NVector.get(&path, j));
+            NERROR("TreeComparison.compareGrammarTrees()", "%s%s%s: trees differ at %s: %s", NTCOLOR(HIGHLIGHT), filePath, NTCOLOR(STREAM_DEFAULT), NString.get(&pathText), NString.get(&difference));
+            NString.destroy(&pathText);
+            success = False;
+        }
+        if (tree.node) NCC_deleteASTNode(&tree, 0);
+        if (referenceTree.node) NCC_deleteASTNode(&referenceTree, 0);
+    }
+
+    NVector.destroy(&path);
+    NString.destroy(&difference);
+    return success;
+}
@@ -0,0 +1,190 @@
+
+//
+// UTF-8 validation. Every byte of the input goes through here before matching, so most of it
+// (ASCII) is skipped a block at a time: 16 bytes per SSE2 compare, or 8 per word test where SSE2
+// isn't available, counting the new-lines in the block on the way. Multi-byte sequences are
+// checked one byte at a time against the well-formed byte ranges (Unicode, table 3-7), which
+// rules out overlong forms, surrogates and code points past U+10FFFF.
+//
+// The 18th of October, 2026.
+//
+
+#include <Utf8.h>
+
+#include <NSystemUtils.h>
+#include <NError.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Sequences
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Sets how many continuation bytes follow the lead byte, and the range of the first of them. The
+// rest are always in 0x80-0xBF. Returns False if it can't start a sequence,
+static boolean getSequenceRange(uint8_t leadByte, int32_t* outContinuationBytesCount, uint8_t* outMinimum, uint8_t* outMaximum) {
+    *outMinimum = 0x80;
+    *outMaximum = 0xBF;
+    if ((leadByte >= 0xC2) && (leadByte <= 0xDF)) {
+        *outContinuationBytesCount = 1;
+    } else if (leadByte == 0xE0) {
+        *outContinuationBytesCount = 2;
+        *outMinimum = 0xA0; // Overlong otherwise.
+    } else if (leadByte == 0xED) {
+        *outContinuationBytesCount = 2;
+        *outMaximum = 0x9F; // Surrogates otherwise.
+    } else if ((leadByte >= 0xE1) && (leadByte <= 0xEF)) {
+        *outContinuationBytesCount = 2;
+    } else if (leadByte == 0xF0) {
+        *outContinuationBytesCount = 3;
+        *outMinimum = 0x90; // Overlong otherwise.
+    } else if ((leadByte >= 0xF1) && (leadByte <= 0xF3)) {
+        *outContinuationBytesCount = 3;
+    } else if (leadByte == 0xF4) {
+        *outContinuationBytesCount = 3;
+        *outMaximum = 0x8F; // Past U+10FFFF otherwise.
+    } else {
+        return False;
+    }
+    return True;
+}
+
+int32_t decodeUtf8(const char* text, int32_t length, uint32_t* outCodePoint) {
+
+    if (length < 1) return 0;
+    uint8_t leadByte = text[0];
+    if (leadByte < 0x80) {
+        *outCodePoint = leadByte;
+        return 1;
+    }
+
+    int32_t continuationBytesCount;
+    uint8_t minimum, maximum;
+    if (!getSequenceRange(leadByte, &continuationBytesCount, &minimum, &maximum)) return 0;
+    if (length < continuationBytesCount + 1) return 0;
+
+    uint32_t codePoint = leadByte & (0x3F >> continuationBytesCount);
+    for (int32_t i=1; i<=continuationBytesCount; i++) {
+        uint8_t byte = text[i];
+        if ((byte < minimum) || (byte > maximum)) return 0;
+        minimum = 0x80;
+        maximum = 0xBF;
+        codePoint = (codePoint << 6) | (byte & 0x3F);
+    }
+    *outCodePoint = codePoint;
+    return continuationBytesCount + 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Validation
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void initializeUtf8Validator(struct Utf8Validator* validator) {
+    validator->offset = 0;
+    validator->line = 1;
+    validator->lineOffset = 0;
+    validator->remainingBytesCount = 0;
+    validator->nextMinimum = 0x80;
+    validator->nextMaximum = 0xBF;
+    validator->sequenceOffset = 0;
+    validator->sequenceLine = 1;
+    validator->sequenceColumn = 1;
+    validator->logErrors = True;
+}
+
+// Skips the whole ASCII blocks at the start of the text, and returns how many bytes it skipped.
+// Whatever's left is for the byte loop,
+static int32_t skipAscii(struct Utf8Validator* validator, const char* text, int32_t length) {
+
+    int32_t skippedBytesCount = 0;
+
+    #ifdef __SSE2__
+    const __m128i newLines = _mm_set1_epi8('\n');
+    for (; skippedBytesCount + 16 <= length; skippedBytesCount += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*) &text[skippedBytesCount]);
+        if (_mm_movemask_epi8(block)) break; // A byte with its top bit set.
+        uint32_t newLinesMask = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(block, newLines));
+        if (newLinesMask) {
+            validator->line += __builtin_popcount(newLinesMask);
+            validator->lineOffset = validator->offset + skippedBytesCount + (31 - __builtin_clz(newLinesMask)) + 1;
+        }
+    }
+    #else
+    for (; skippedBytesCount + 8 <= length; skippedBytesCount += 8) {
+        uint64_t block;
+        NSystemUtils.memcpy(&block, &text[skippedBytesCount], 8);
+        if (block & 0x8080808080808080ULL) break;
+
+        // The bytes that are '\n' become 0, and only those get their top bit set (exact, since
+        // the top bits are all clear),
+        uint64_t newLines = block ^ 0x0A0A0A0A0A0A0A0AULL;
+        newLines = ~(((newLines & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL) | newLines | 0x7F7F7F7F7F7F7F7FULL);
+        if (newLines) {
+            for (int32_t i=0; i<8; i++) {
+                if (text[skippedBytesCount + i] != '\n') continue;
+                validator->line++;
+                validator->lineOffset = validator->offset + skippedBytesCount + i + 1;
+            }
+        }
+    }
+    #endif
+
+    validator->offset += skippedBytesCount;
+    return skippedBytesCount;
+}
+
+static boolean reportInvalidSequence(struct Utf8Validator* validator, const char* problem) {
+    if (validator->logErrors) NERROR("Utf8.validateUtf8()", "%s UTF-8 sequence at line: %d, column: %d.", problem, validator->sequenceLine, validator->sequenceColumn);
+    return False;
+}
+
+boolean validateUtf8(struct Utf8Validator* validator, const char* text, int32_t length) {
+
+    int32_t i = 0;
+    while (i < length) {
+
+        // Between sequences, ASCII goes a block at a time,
+        if (!validator->remainingBytesCount) {
+            i += skipAscii(validator, &text[i], length - i);
+            if (i == length) break;
+        }
+
+        uint8_t byte = text[i];
+        if (validator->remainingBytesCount) {
+            if ((byte < validator->nextMinimum) || (byte > validator->nextMaximum)) return reportInvalidSequence(validator, "Invalid");
+            validator->nextMinimum = 0x80;
+            validator->nextMaximum = 0xBF;
+            validator->remainingBytesCount--;
+        } else if (byte < 0x80) {
+            if (byte == '\n') {
+                validator->line++;
+                validator->lineOffset = validator->offset + 1;
+            }
+        } else {
+            validator->sequenceOffset = validator->offset;
+            validator->sequenceLine = validator->line;
+            validator->sequenceColumn = validator->offset - validator->lineOffset + 1;
+            if (!getSequenceRange(byte, &validator->remainingBytesCount, &validator->nextMinimum, &validator->nextMaximum)) {
+                validator->remainingBytesCount = 0;
+                return reportInvalidSequence(validator, "Invalid");
+            }
+        }
+        validator->offset++;
+        i++;
+    }
+
+    return True;
+}
+
+boolean finishUtf8Validation(struct Utf8Validator* validator) {
+    if (validator->remainingBytesCount) return reportInvalidSequence(validator, "Incomplete");
+    return True;
+}
+
+boolean checkUtf8(const char* code, int32_t length) {
+    struct Utf8Validator validator;
+    initializeUtf8Validator(&validator);
+    return validateUtf8(&validator, code, length) && finishUtf8Validation(&validator);
+}
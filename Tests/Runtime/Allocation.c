@@ -0,0 +1,29 @@
+//
+// Runs the allocation translation fixture (Tests/Translation/Allocation.c) with the runtime. Its
+// allocations, weak reads and deletes must neither fault nor abort, and the global weak reference
+// it leaves behind must read 0, its array having been deleted.
+//
+// Stand-alone (plain C), built with the runtime.
+//
+// The 18th of October, 2026.
+//
+
+#include <stdint.h>
+
+#include "../Translation/Allocation.c"
+
+#include <stdio.h>
+
+int main() {
+    for (int32_t i=0; i<3; i++) {
+        build();
+        if (addaatGetWeak(cachedValues)) {
+            printf("Allocation: cachedValues still reads its deleted array.\n");
+            return 1;
+        }
+        addaatCollect();
+    }
+
+    printf("Allocation: passed.\n");
+    return 0;
+}
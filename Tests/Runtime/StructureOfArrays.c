@@ -0,0 +1,25 @@
+//
+// Runs the structure-of-arrays translation fixture (Tests/Translation/StructureOfArrays.c) with the
+// runtime. Its allocations, subscripts through member chains and deletes must neither fault nor
+// abort, whether the managed arrays are collected in between or not.
+//
+// Stand-alone (plain C), built with the runtime.
+//
+// The 18th of October, 2026.
+//
+
+#include <stdint.h>
+
+#include "../Translation/StructureOfArrays.c"
+
+#include <stdio.h>
+
+int main() {
+    for (int32_t i=0; i<3; i++) {
+        step();
+        addaatCollect();
+    }
+
+    printf("StructureOfArrays: passed.\n");
+    return 0;
+}
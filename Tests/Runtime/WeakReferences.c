@@ -0,0 +1,113 @@
+//
+// Weak references and deletes (Runtime/AddaatRuntime.h): a weak reference reads as 0 once its
+// object is deleted or collected, and deleting an object twice aborts. Exits with 1 on the first
+// failed check.
+//
+// Stand-alone (plain C), built with the runtime.
+//
+// The 18th of October, 2026.
+//
+
+#include <AddaatRuntime.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+static int32_t failedChecksCount = 0;
+
+static void check(int condition, const char* description) {
+    printf("%s: %s\n", condition ? "passed" : "FAILED", description);
+    if (!condition) failedChecksCount++;
+}
+
+// True if the function aborts. It's run in a forked child, with the runtime's message silenced,
+static int aborts(void (*function)()) {
+    fflush(stdout);
+    pid_t child = fork();
+    if (child < 0) return 0;
+    if (!child) {
+        freopen("/dev/null", "w", stderr);
+        function();
+        _exit(0);
+    }
+    int status;
+    if (waitpid(child, &status, 0) != child) return 0;
+    return WIFSIGNALED(status) && (WTERMSIG(status) == SIGABRT);
+}
+
+// Pointers are found conservatively, so the object is allocated in a frame of its own, and the
+// stack under it is overwritten before collecting, leaving only the weak reference to it,
+static __attribute__((noinline)) AddaatWeak createUnreachableObject() {
+    AddaatWeak weak = {0};
+    int64_t* object = addaatManaged(sizeof(int64_t), 4);
+    object[0] = 7;
+    addaatSetWeak(&weak, object);
+    return weak;
+}
+
+static __attribute__((noinline)) void clearStack() {
+    volatile char stack[16 * 1024];
+    for (int32_t i=0; i<(int32_t) sizeof(stack); i++) stack[i] = 0;
+}
+
+static void deleteTwice() {
+    void* object = addaatNew(16, 1);
+    addaatDelete(object);
+    addaatDelete(object);
+}
+
+static void deleteManaged() {
+    addaatDelete(addaatManaged(16, 1));
+}
+
+int main() {
+
+    // Deleted,
+    AddaatWeak weak = {0};
+    int32_t* object = addaatNew(sizeof(int32_t), 8);
+    check(addaatSetWeak(&weak, object) == object, "addaatSetWeak() returns the object");
+    check(addaatGetWeak(weak) == object, "a weak reference to a new object reads the object");
+    addaatDelete(object);
+    check(!addaatGetWeak(weak), "a weak reference to a deleted object reads 0");
+
+    // A new object in the same place doesn't bring the reference back,
+    int32_t* reusingObject = addaatNew(sizeof(int32_t), 8);
+    check(!addaatGetWeak(weak), "a weak reference stays 0 after its object's memory is reused");
+    addaatDelete(reusingObject);
+
+    // Collected,
+    AddaatWeak collectedWeak = createUnreachableObject();
+    check(addaatGetWeak(collectedWeak) != 0, "a weak reference to a managed object reads the object");
+    clearStack();
+    addaatCollect();
+    check(!addaatGetWeak(collectedWeak), "a weak reference to a collected managed object reads 0");
+
+    // Reachable managed objects aren't collected,
+    AddaatWeak reachableWeak = {0};
+    int64_t* reachableObject = addaatManaged(sizeof(int64_t), 4);
+    reachableObject[3] = 11;
+    addaatSetWeak(&reachableWeak, reachableObject);
+    addaatCollect();
+    check((addaatGetWeak(reachableWeak) == reachableObject) && (reachableObject[3] == 11), "a weak reference to a reachable managed object reads the object");
+
+    // Unset and garbage references,
+    AddaatWeak nullWeak = {0};
+    AddaatWeak garbageWeak = {0x7fffffff, 3};
+    check(!addaatGetWeak(nullWeak), "a zero initialized weak reference reads 0");
+    check(!addaatGetWeak(garbageWeak), "a weak reference to a slot never handed out reads 0");
+
+    // Misuse,
+    check(aborts(deleteTwice), "deleting an object twice aborts");
+    check(aborts(deleteManaged), "deleting a managed object aborts");
+
+    if (failedChecksCount) {
+        printf("WeakReferences: %d check(s) failed.\n", failedChecksCount);
+        return 1;
+    }
+    printf("WeakReferences: passed.\n");
+    return 0;
+}
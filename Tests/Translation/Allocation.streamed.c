@@ -0,0 +1,35 @@
+struct Tree {
+    int32_t size;
+};
+#include <AddaatRuntime.h>
+
+struct Node {
+    int32_t value;
+    AddaatWeak owner;
+};
+AddaatWeak cachedValues;
+
+void build() {
+    struct Node* nodes;
+    struct Tree* tree;
+    struct Node single = {0};
+    AddaatWeak first = {0};
+    int32_t* values;
+    int32_t new;
+    int32_t managed;
+    int32_t weak;
+    nodes = ((struct Node*) addaatNewCleared(sizeof(struct Node), 4));
+    tree = ((struct Tree*) addaatManaged(sizeof(struct Tree), 1));
+    addaatSetWeak(&nodes[1].owner, tree);
+    addaatSetWeak(&single.owner, tree);
+    addaatSetWeak(&first, nodes);
+    values = ((int32_t*) addaatNew(sizeof(int32_t), 16));
+    addaatSetWeak(&cachedValues, values);
+    new = 1;
+    managed = new + 1;
+    weak = managed * 2;
+    nodes[0].value = ((struct Node*) addaatGetWeak(first))[1].value + ((struct Tree*) addaatGetWeak(single.owner))[0].size;
+    nodes[2].value = weak;
+    addaatDelete(values);
+    addaatDelete(nodes);
+}
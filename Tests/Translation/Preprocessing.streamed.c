@@ -0,0 +1,15 @@
+int32_t counter;
+
+char separator;
+
+struct Point {
+    int32_t x;
+    int32_t y;
+};
+void reset() {
+    counter = 0;
+    separator = '/';
+    if (counter < 10) counter += 1;
+    while (counter) counter = counter - 1;
+    "  // Spaces and comment starts in strings stay, /* too */";
+}
@@ -0,0 +1,40 @@
+struct Velocity {
+    float dx;
+    float dy;
+};
+struct Particle {
+    double x;
+    float* history;
+    struct Velocity velocity;
+    char alive;
+};
+struct _Particle_soa_ {
+    char* alive;
+    double* x;
+    float** history;
+    struct Velocity* velocity;
+};
+int32_t _Particle_count_;
+struct Emitter {
+    struct _Particle_soa_ particles;
+    int32_t size;
+};
+struct Emitter emitter;
+
+#include <AddaatRuntime.h>
+
+void step() {
+    int32_t i;
+    struct _Particle_soa_ loose;
+    i = 2;
+    emitter.size = 8;
+    emitter.particles = (*(struct _Particle_soa_*) addaatNewArrays(&(struct _Particle_soa_) {0}, (const size_t[]) {sizeof(char), sizeof(double), sizeof(float*), sizeof(struct Velocity)}, 4, emitter.size));
+    loose = (*(struct _Particle_soa_*) addaatManagedArrays(&(struct _Particle_soa_) {0}, (const size_t[]) {sizeof(char), sizeof(double), sizeof(float*), sizeof(struct Velocity)}, 4, 8));
+    emitter.particles.x[i] = emitter.particles.x[i] + 1;
+    emitter.particles.velocity[i].dx *= 2;
+    loose.alive[i] = 1;
+    loose.history[i] = ((float*) addaatNew(sizeof(float), 4));
+    loose.history[i][0] = 5;
+    addaatDelete(loose.history[i]);
+    { struct _Particle_soa_ _soa_ = emitter.particles; addaatDelete(_soa_.alive); addaatDelete(_soa_.x); addaatDelete(_soa_.history); addaatDelete(_soa_.velocity); }
+}